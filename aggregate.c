@@ -0,0 +1,566 @@
+/**
+ * @file aggregate.c
+ * @author Vladyslav Kolodii
+ * @brief Min/max/sum/percentile aggregation of numeric properties across many BEJ payloads
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "aggregate.h"
+#include "batch_io.h"
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+/// Scalar totals of one path; copied aside before each document so a malformed one can be undone
+typedef struct
+{
+    uint64_t count;
+    uint64_t missing;
+    double min;
+    double max;
+    double sum;
+} PathTotals_t;
+
+// Percentiles come from a log-linear histogram per path: each power of two is
+// split into 2^SKETCH_SUB_BITS buckets, so a bucket's midpoint is within 0.8%
+// of every value in it, and memory stays fixed however many values are folded.
+
+/// Buckets per power of two, as a bit count
+#define SKETCH_SUB_BITS 6
+
+/// Magnitudes below 2^SKETCH_MIN_EXPONENT fall into the zero bucket
+#define SKETCH_MIN_EXPONENT (-20)
+
+/// Magnitudes from 2^SKETCH_MAX_EXPONENT up share the outermost bucket
+#define SKETCH_MAX_EXPONENT 64
+
+/// Buckets on each side of zero
+#define SKETCH_SIDE ((uint32_t)(SKETCH_MAX_EXPONENT - SKETCH_MIN_EXPONENT) << SKETCH_SUB_BITS)
+
+/// Buckets per path: negative values (largest magnitude first), zero, positive values
+#define SKETCH_BUCKETS (2 * SKETCH_SIDE + 1)
+
+struct BejAggregate
+{
+    BejPath_t** paths;
+    size_t path_count;
+};
+
+struct BejAccumulator
+{
+    const BejAggregate_t* aggregate;
+    PathTotals_t* totals;
+    PathTotals_t* saved;        // totals before the document being added
+    uint64_t* buckets;          // SKETCH_BUCKETS counts per path
+    size_t* pending;            // buckets of the document being added, counted once it is whole
+    size_t pending_count;
+    size_t pending_capacity;
+};
+
+// ============================================================================
+// Compiled Paths
+// ============================================================================
+
+static bool is_numeric_format(uint8_t format)
+{
+    return format == BEJ_FORMAT_INTEGER || format == BEJ_FORMAT_REAL;
+}
+
+BejAggregate_t* bej_aggregate_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                      const char* const* paths, size_t path_count,
+                                      const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !paths || path_count == 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    BejAggregate_t* aggregate = (BejAggregate_t*)calloc(1, sizeof(BejAggregate_t));
+    if (aggregate)
+    {
+        aggregate->paths = (BejPath_t**)calloc(path_count, sizeof(BejPath_t*));
+    }
+    if (!aggregate || !aggregate->paths)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate aggregate");
+        free(aggregate);
+        return NULL;
+    }
+    aggregate->path_count = path_count;
+
+    for (size_t i = 0; i < path_count; i++)
+    {
+        aggregate->paths[i] = bej_path_compile(schema_dict, anno_dict, paths[i], diagnostics);
+        if (!aggregate->paths[i])
+        {
+            bej_aggregate_free(aggregate);
+            return NULL;
+        }
+
+        // An array's elements are all described by its child entry
+        const DictionaryEntry_t* entry = bej_path_entry(aggregate->paths[i], schema_dict, anno_dict);
+        uint8_t format = get_msb4(entry->format);
+        if (format == BEJ_FORMAT_ARRAY)
+        {
+            Dictionary_t* dict = bej_path_entry_selector(aggregate->paths[i]) ? anno_dict : schema_dict;
+            const DictionaryEntry_t* element = find_dictionary_entry(dict, (DictionaryEntry_t*)entry, 0, -1);
+            format = element ? get_msb4(element->format) : BEJ_FORMAT_ARRAY;
+        }
+        if (!is_numeric_format(format))
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Aggregate path '%s' is not an integer or real property",
+                         paths[i]);
+            bej_aggregate_free(aggregate);
+            return NULL;
+        }
+    }
+    return aggregate;
+}
+
+void bej_aggregate_free(BejAggregate_t* aggregate)
+{
+    if (!aggregate) return;
+
+    for (size_t i = 0; i < aggregate->path_count; i++)
+    {
+        bej_path_free(aggregate->paths[i]);
+    }
+    free(aggregate->paths);
+    free(aggregate);
+}
+
+// ============================================================================
+// Accumulators
+// ============================================================================
+
+BejAccumulator_t* bej_accumulator_create(const BejAggregate_t* aggregate)
+{
+    if (!aggregate)
+    {
+        return NULL;
+    }
+
+    size_t count = aggregate->path_count;
+    BejAccumulator_t* accumulator = (BejAccumulator_t*)calloc(1, sizeof(BejAccumulator_t));
+    if (accumulator)
+    {
+        accumulator->aggregate = aggregate;
+        accumulator->totals = (PathTotals_t*)calloc(count, sizeof(PathTotals_t));
+        accumulator->saved = (PathTotals_t*)calloc(count, sizeof(PathTotals_t));
+        accumulator->buckets = (uint64_t*)calloc(count * SKETCH_BUCKETS, sizeof(uint64_t));
+    }
+    if (!accumulator || !accumulator->totals || !accumulator->saved || !accumulator->buckets)
+    {
+        bej_accumulator_free(accumulator);
+        return NULL;
+    }
+    return accumulator;
+}
+
+void bej_accumulator_free(BejAccumulator_t* accumulator)
+{
+    if (!accumulator) return;
+
+    free(accumulator->totals);
+    free(accumulator->saved);
+    free(accumulator->buckets);
+    free(accumulator->pending);
+    free(accumulator);
+}
+
+/// Histogram bucket of a value that is not NaN
+static uint32_t sketch_bucket(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int exponent = (int)((bits >> 52) & 0x7FF) - 1023;
+    if (exponent < SKETCH_MIN_EXPONENT)
+    {
+        return SKETCH_SIDE;     // zero, subnormals and tiny magnitudes
+    }
+
+    uint32_t offset = SKETCH_SIDE - 1;
+    if (exponent < SKETCH_MAX_EXPONENT)
+    {
+        uint32_t sub = (uint32_t)(bits >> (52 - SKETCH_SUB_BITS)) & ((1u << SKETCH_SUB_BITS) - 1);
+        offset = ((uint32_t)(exponent - SKETCH_MIN_EXPONENT) << SKETCH_SUB_BITS) | sub;
+    }
+    return (bits >> 63) ? SKETCH_SIDE - 1 - offset : SKETCH_SIDE + 1 + offset;
+}
+
+/// Midpoint of the values a bucket holds
+static double sketch_value(uint32_t bucket)
+{
+    if (bucket == SKETCH_SIDE)
+    {
+        return 0.0;
+    }
+    bool negative = bucket < SKETCH_SIDE;
+    uint32_t offset = negative ? SKETCH_SIDE - 1 - bucket : bucket - SKETCH_SIDE - 1;
+    uint64_t exponent = (uint64_t)((int)(offset >> SKETCH_SUB_BITS) + SKETCH_MIN_EXPONENT + 1023);
+    uint64_t sub = offset & ((1u << SKETCH_SUB_BITS) - 1);
+    uint64_t bits = (exponent << 52) | (sub << (52 - SKETCH_SUB_BITS)) | (1ull << (51 - SKETCH_SUB_BITS));
+    if (negative)
+    {
+        bits |= 1ull << 63;
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// Remember the bucket of one value until its document is known to be well-formed
+static bool add_pending(BejAccumulator_t* accumulator, size_t bucket)
+{
+    if (accumulator->pending_count == accumulator->pending_capacity)
+    {
+        size_t capacity = accumulator->pending_capacity ? accumulator->pending_capacity * 2 : 64;
+        size_t* grown = (size_t*)realloc(accumulator->pending, capacity * sizeof(size_t));
+        if (!grown)
+        {
+            return false;
+        }
+        accumulator->pending = grown;
+        accumulator->pending_capacity = capacity;
+    }
+    accumulator->pending[accumulator->pending_count++] = bucket;
+    return true;
+}
+
+/// Fold one scalar tuple into a path's totals; null and other formats count as missing
+static bool fold_value(BejAccumulator_t* accumulator, size_t path, const SFLV_t* sflv)
+{
+    PathTotals_t* totals = &accumulator->totals[path];
+    BejValue_t value;
+    if (!is_numeric_format(sflv->format))
+    {
+        totals->missing++;
+        return true;
+    }
+    if (!bej_value_from_sflv(sflv, NULL, NULL, &value, NULL))
+    {
+        return false;
+    }
+
+    double number = sflv->format == BEJ_FORMAT_INTEGER ? (double)value.integer : value.real;
+    if (number != number)
+    {
+        totals->missing++;      // NaN has no place in an ordering
+        return true;
+    }
+    if (!add_pending(accumulator, path * SKETCH_BUCKETS + sketch_bucket(number)))
+    {
+        return false;
+    }
+    if (totals->count == 0 || number < totals->min) totals->min = number;
+    if (totals->count == 0 || number > totals->max) totals->max = number;
+    totals->sum += number;
+    totals->count++;
+    return true;
+}
+
+/// Fold the value one path leads to, or every element when it is an array
+static bool fold_path(BejAccumulator_t* accumulator, size_t path, const SFLV_t* root)
+{
+    SFLV_t sflv;
+    bool found;
+    if (!bej_path_find(accumulator->aggregate->paths[path], root, &sflv, &found))
+    {
+        return false;
+    }
+    if (!found)
+    {
+        accumulator->totals[path].missing++;
+        return true;
+    }
+    if (sflv.format != BEJ_FORMAT_ARRAY)
+    {
+        return fold_value(accumulator, path, &sflv);
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv.value, sflv.length);
+    uint64_t count = 0;
+    if (sflv.length > 0 && !read_nnint_from_buffer(&reader, &count))
+    {
+        return false;
+    }
+    while (!buffer_eof(&reader))
+    {
+        SFLV_t element;
+        if (!read_sflv_header_from_buffer(&reader, &element) || !fold_value(accumulator, path, &element))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bej_accumulator_add(BejAccumulator_t* accumulator, const uint8_t* data, uint64_t size)
+{
+    if (!accumulator || !data)
+    {
+        return false;
+    }
+
+    // The reader never writes; it only shares the non-const buffer type
+    BufferReader_t reader;
+    init_buffer_reader(&reader, (uint8_t*)data, size);
+    SFLV_t root;
+    if (!read_bej_header_from_buffer(&reader, NULL) || !read_sflv_header_from_buffer(&reader, &root))
+    {
+        return false;
+    }
+
+    // Histogram buckets are only counted once every path of the document was read
+    const BejAggregate_t* aggregate = accumulator->aggregate;
+    memcpy(accumulator->saved, accumulator->totals, aggregate->path_count * sizeof(PathTotals_t));
+    accumulator->pending_count = 0;
+    for (size_t i = 0; i < aggregate->path_count; i++)
+    {
+        if (!fold_path(accumulator, i, &root))
+        {
+            memcpy(accumulator->totals, accumulator->saved, aggregate->path_count * sizeof(PathTotals_t));
+            return false;
+        }
+    }
+    for (size_t i = 0; i < accumulator->pending_count; i++)
+    {
+        accumulator->buckets[accumulator->pending[i]]++;
+    }
+    return true;
+}
+
+bool bej_accumulator_merge(BejAccumulator_t* into, const BejAccumulator_t* from)
+{
+    if (!into || !from || into->aggregate != from->aggregate)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < into->aggregate->path_count; i++)
+    {
+        PathTotals_t* totals = &into->totals[i];
+        const PathTotals_t* other = &from->totals[i];
+        if (other->count > 0)
+        {
+            uint64_t* buckets = into->buckets + i * SKETCH_BUCKETS;
+            const uint64_t* other_buckets = from->buckets + i * SKETCH_BUCKETS;
+            for (size_t bucket = 0; bucket < SKETCH_BUCKETS; bucket++)
+            {
+                buckets[bucket] += other_buckets[bucket];
+            }
+            if (totals->count == 0 || other->min < totals->min) totals->min = other->min;
+            if (totals->count == 0 || other->max > totals->max) totals->max = other->max;
+        }
+        totals->count += other->count;
+        totals->missing += other->missing;
+        totals->sum += other->sum;
+    }
+    return true;
+}
+
+/// Nearest-rank percentile: the bucket holding the smallest value with at least percent of all values at or below it
+static double sketch_percentile(const uint64_t* buckets, const PathTotals_t* totals, uint64_t percent)
+{
+    uint64_t rank = (totals->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+    for (; bucket + 1 < SKETCH_BUCKETS; bucket++)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+
+    // The exact extremes are known, so a midpoint never lies outside them
+    double value = sketch_value(bucket);
+    return value < totals->min ? totals->min : value > totals->max ? totals->max : value;
+}
+
+bool bej_accumulator_result(BejAccumulator_t* accumulator, size_t path, BejAggregateResult_t* result)
+{
+    if (!accumulator || !result || path >= accumulator->aggregate->path_count)
+    {
+        return false;
+    }
+
+    const PathTotals_t* totals = &accumulator->totals[path];
+    const uint64_t* buckets = accumulator->buckets + path * SKETCH_BUCKETS;
+    memset(result, 0, sizeof(*result));
+    result->count = totals->count;
+    result->missing = totals->missing;
+    if (totals->count == 0)
+    {
+        return true;
+    }
+
+    result->min = totals->min;
+    result->max = totals->max;
+    result->sum = totals->sum;
+    result->mean = totals->sum / (double)totals->count;
+    result->p50 = sketch_percentile(buckets, totals, 50);
+    result->p90 = sketch_percentile(buckets, totals, 90);
+    result->p99 = sketch_percentile(buckets, totals, 99);
+    return true;
+}
+
+// ============================================================================
+// Multi-threaded File Aggregation
+// ============================================================================
+
+/// State shared by all workers of one aggregation run
+typedef struct
+{
+    const BatchFileList_t* files;
+    const BejDiagnostics_t* diagnostics;
+    atomic_size_t next_file;        // work queue: index of the next unclaimed file
+    atomic_size_t files_ok;
+    atomic_size_t files_failed;
+    atomic_uint_least64_t bytes_in;
+} AggregateJob_t;
+
+typedef struct
+{
+    AggregateJob_t* job;
+    BejAccumulator_t* accumulator;  // owned by this worker until it is joined
+} AggregateWorker_t;
+
+static int aggregate_worker(void* arg)
+{
+    AggregateWorker_t* worker = (AggregateWorker_t*)arg;
+    AggregateJob_t* job = worker->job;
+    uint8_t* data = NULL;
+    size_t capacity = 0;
+
+    for (;;)
+    {
+        size_t index = atomic_fetch_add(&job->next_file, 1);
+        if (index >= job->files->count)
+        {
+            break;
+        }
+        const char* path = job->files->paths[index];
+
+        uint64_t size;
+        bool ok = batch_read_file(path, &data, &capacity, &size, job->diagnostics);
+        if (ok)
+        {
+            atomic_fetch_add(&job->bytes_in, size);
+            ok = bej_accumulator_add(worker->accumulator, data, size);
+            if (!ok)
+            {
+                bej_diagnose(job->diagnostics, BEJ_DIAG_ERROR, "Failed to aggregate %s", path);
+            }
+        }
+        atomic_fetch_add(ok ? &job->files_ok : &job->files_failed, 1);
+    }
+
+    free(data);
+    return 0;
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool bej_aggregate_files(const BejAggregate_t* aggregate, const BatchFileList_t* files, int thread_count,
+                         const BejDiagnostics_t* diagnostics, BejAccumulator_t* total, BatchStats_t* stats)
+{
+    if (!aggregate || !files || !total || total->aggregate != aggregate)
+    {
+        return false;
+    }
+
+    AggregateJob_t job;
+    job.files = files;
+    job.diagnostics = diagnostics;
+    atomic_init(&job.next_file, 0);
+    atomic_init(&job.files_ok, 0);
+    atomic_init(&job.files_failed, 0);
+    atomic_init(&job.bytes_in, 0);
+
+    // No point starting more workers than there are files
+    size_t worker_count = thread_count > 1 ? (size_t)thread_count : 1;
+    if (worker_count > files->count)
+    {
+        worker_count = files->count > 0 ? files->count : 1;
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    bool merged = true;
+
+    if (worker_count == 1)
+    {
+        AggregateWorker_t worker = { &job, total };
+        aggregate_worker(&worker);
+    }
+    else
+    {
+        AggregateWorker_t* workers = (AggregateWorker_t*)calloc(worker_count, sizeof(AggregateWorker_t));
+        thrd_t* threads = (thrd_t*)malloc(worker_count * sizeof(thrd_t));
+        size_t started = 0;
+        if (workers && threads)
+        {
+            for (; started < worker_count; started++)
+            {
+                workers[started].job = &job;
+                workers[started].accumulator = bej_accumulator_create(aggregate);
+                if (!workers[started].accumulator
+                    || thrd_create(&threads[started], aggregate_worker, &workers[started]) != thrd_success)
+                {
+                    bej_accumulator_free(workers[started].accumulator);
+                    bej_diagnose(diagnostics, BEJ_DIAG_WARNING,
+                                 "Started only %zu of %zu worker threads", started, worker_count);
+                    break;
+                }
+            }
+        }
+
+        // With no worker running, the calling thread does the work itself
+        if (started == 0)
+        {
+            AggregateWorker_t worker = { &job, total };
+            aggregate_worker(&worker);
+        }
+        for (size_t i = 0; i < started; i++)
+        {
+            thrd_join(threads[i], NULL);
+            merged = bej_accumulator_merge(total, workers[i].accumulator) && merged;
+            bej_accumulator_free(workers[i].accumulator);
+        }
+        free(threads);
+        free(workers);
+    }
+
+    double seconds = elapsed_seconds(&start);
+    if (!merged)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to merge aggregation results");
+    }
+
+    size_t files_ok = atomic_load(&job.files_ok);
+    if (stats)
+    {
+        stats->files_total = files->count;
+        stats->files_ok = files_ok;
+        stats->files_failed = atomic_load(&job.files_failed);
+        stats->bytes_in = atomic_load(&job.bytes_in);
+        stats->bytes_out = 0;
+        stats->seconds = seconds;
+    }
+    return merged && files_ok == files->count;
+}
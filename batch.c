@@ -0,0 +1,498 @@
+/**
+ * @file batch.c
+ * @author Vladyslav Kolodii
+ * @brief Multi-threaded batch decoding of many BEJ files with shared dictionaries
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "batch.h"
+#include "batch_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// File List Functions
+// ============================================================================
+
+void init_file_list(BatchFileList_t* list)
+{
+    if (!list) return;
+
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+void free_file_list(BatchFileList_t* list)
+{
+    if (!list) return;
+
+    for (size_t i = 0; i < list->count; i++)
+    {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    init_file_list(list);
+}
+
+bool file_list_add(BatchFileList_t* list, const char* path)
+{
+    if (!list || !path)
+    {
+        return false;
+    }
+
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        char** grown = (char**)realloc(list->paths, capacity * sizeof(char*));
+        if (!grown)
+        {
+            fprintf(stderr, "Error: Failed to grow input file list\n");
+            return false;
+        }
+        list->paths = grown;
+        list->capacity = capacity;
+    }
+
+    size_t length = strlen(path);
+    char* copy = (char*)malloc(length + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Error: Failed to allocate input path\n");
+        return false;
+    }
+    memcpy(copy, path, length + 1);
+    list->paths[list->count++] = copy;
+    return true;
+}
+
+static int compare_paths(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+#ifdef _WIN32
+
+bool collect_batch_inputs(BatchFileList_t* list, const char* source)
+{
+    char pattern[MAX_PATH];
+    DWORD attributes = GetFileAttributesA(source);
+    bool is_directory = attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+
+    // FindFirstFile expands wildcards itself; a directory becomes "dir\*"
+    int written = is_directory ? snprintf(pattern, sizeof(pattern), "%s\\*", source)
+                               : snprintf(pattern, sizeof(pattern), "%s", source);
+    if (written < 0 || (size_t)written >= sizeof(pattern))
+    {
+        fprintf(stderr, "Error: Input path too long: %s\n", source);
+        return false;
+    }
+
+    // Matches are reported without their directory, so keep the pattern's prefix
+    size_t prefix_length = 0;
+    for (size_t i = 0; pattern[i]; i++)
+    {
+        if (pattern[i] == '\\' || pattern[i] == '/')
+        {
+            prefix_length = i + 1;
+        }
+    }
+
+    WIN32_FIND_DATAA found;
+    HANDLE handle = FindFirstFileA(pattern, &found);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Error: No input files match %s\n", source);
+        return false;
+    }
+
+    size_t first = list->count;
+    bool ok = true;
+    do
+    {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            continue;
+        }
+        char path[MAX_PATH];
+        snprintf(path, sizeof(path), "%.*s%s", (int)prefix_length, pattern, found.cFileName);
+        ok = file_list_add(list, path);
+    } while (ok && FindNextFileA(handle, &found));
+    FindClose(handle);
+
+    qsort(list->paths + first, list->count - first, sizeof(char*), compare_paths);
+    return ok && list->count > first;
+}
+
+int default_thread_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+static bool collect_directory(BatchFileList_t* list, const char* directory)
+{
+    DIR* dir = opendir(directory);
+    if (!dir)
+    {
+        fprintf(stderr, "Error: Cannot open directory %s\n", directory);
+        return false;
+    }
+
+    size_t first = list->count;
+    bool ok = true;
+    struct dirent* item;
+    while (ok && (item = readdir(dir)) != NULL)
+    {
+        if (item->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        char path[4096];
+        int written = snprintf(path, sizeof(path), "%s/%s", directory, item->d_name);
+        if (written < 0 || (size_t)written >= sizeof(path))
+        {
+            continue;
+        }
+
+        struct stat info;
+        if (stat(path, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            ok = file_list_add(list, path);
+        }
+    }
+    closedir(dir);
+
+    // readdir order is arbitrary; sort so runs are reproducible
+    qsort(list->paths + first, list->count - first, sizeof(char*), compare_paths);
+    return ok;
+}
+
+bool collect_batch_inputs(BatchFileList_t* list, const char* source)
+{
+    if (!list || !source)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (stat(source, &info) == 0 && S_ISDIR(info.st_mode))
+    {
+        return collect_directory(list, source);
+    }
+
+    glob_t matches;
+    int status = glob(source, 0, NULL, &matches);
+    if (status != 0)
+    {
+        fprintf(stderr, "Error: No input files match %s\n", source);
+        if (status != GLOB_NOMATCH)
+        {
+            globfree(&matches);
+        }
+        return false;
+    }
+
+    // glob() already returns matches sorted
+    bool ok = true;
+    for (size_t i = 0; ok && i < matches.gl_pathc; i++)
+    {
+        if (stat(matches.gl_pathv[i], &info) == 0 && S_ISREG(info.st_mode))
+        {
+            ok = file_list_add(list, matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+    return ok;
+}
+
+int default_thread_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+#endif
+
+bool read_batch_list_file(BatchFileList_t* list, const char* list_file)
+{
+    if (!list || !list_file)
+    {
+        return false;
+    }
+
+    FILE* fp = fopen(list_file, "r");
+    if (!fp)
+    {
+        fprintf(stderr, "Error: Cannot open list file %s\n", list_file);
+        return false;
+    }
+
+    bool ok = true;
+    char line[4096];
+    while (ok && fgets(line, sizeof(line), fp))
+    {
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length == 0 || line[0] == '#')
+        {
+            continue;
+        }
+        ok = file_list_add(list, line);
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool make_output_path(const char* input, const char* output_dir, BejOutputFormat_t format,
+                      char* output, size_t size)
+{
+    if (!input || !output || size == 0)
+    {
+        return false;
+    }
+
+    const char* extension = ".json";
+    if (format == BEJ_OUTPUT_CBOR)
+    {
+        extension = ".cbor";
+    }
+    else if (format == BEJ_OUTPUT_MSGPACK)
+    {
+        extension = ".msgpack";
+    }
+
+    // Determine which path separator came last
+    const char* last_slash = strrchr(input, '/');
+    const char* last_backslash = strrchr(input, '\\');
+    const char* last_separator = last_slash > last_backslash ? last_slash : last_backslash;
+    const char* file_name = last_separator ? last_separator + 1 : input;
+
+    // Only use the dot if it is part of the file name, not a directory
+    const char* last_dot = strrchr(file_name, '.');
+    size_t base_length = last_dot ? (size_t)(last_dot - input) : strlen(input);
+
+    int written;
+    if (output_dir)
+    {
+        size_t name_length = base_length - (size_t)(file_name - input);
+        written = snprintf(output, size, "%s/%.*s%s", output_dir, (int)name_length, file_name, extension);
+    }
+    else
+    {
+        written = snprintf(output, size, "%.*s%s", (int)base_length, input, extension);
+    }
+    return written >= 0 && (size_t)written < size;
+}
+
+// ============================================================================
+// Batch Decode
+// ============================================================================
+
+/// State shared by all workers of one batch run
+typedef struct
+{
+    const BatchFileList_t* files;
+    const BatchOptions_t* options;
+    atomic_size_t next_file;        // work queue: index of the next unclaimed file
+    atomic_size_t files_ok;
+    atomic_size_t files_failed;
+    atomic_uint_least64_t bytes_in;
+    atomic_uint_least64_t bytes_out;
+    mtx_t ndjson_lock;              // keeps NDJSON records whole
+} BatchJob_t;
+
+static int batch_worker(void* arg)
+{
+    BatchJob_t* job = (BatchJob_t*)arg;
+    const BatchOptions_t* options = job->options;
+    bool ndjson = options->ndjson_output != NULL;
+
+    // Per-thread context, arena and buffers; they are reused for every file this worker claims
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, options->schema_dict, options->anno_dict, NULL, NULL);
+    ctx.arena = &arena;
+    ctx.output_format = ndjson ? BEJ_OUTPUT_JSON : options->output_format;
+    ctx.compact = ndjson;
+    ctx.diagnostics = options->diagnostics;
+    set_output_buffer(&ctx, NULL, 0);
+
+    uint8_t* input_data = NULL;
+    size_t input_capacity = 0;
+
+    for (;;)
+    {
+        size_t index = atomic_fetch_add(&job->next_file, 1);
+        if (index >= job->files->count)
+        {
+            break;
+        }
+        const char* path = job->files->paths[index];
+
+        uint64_t input_size;
+        bool ok = batch_read_file(path, &input_data, &input_capacity, &input_size,
+                                  &options->diagnostics);
+        if (ok)
+        {
+            atomic_fetch_add(&job->bytes_in, input_size);
+
+            ctx.output_length = 0;
+            ctx.output_failed = false;
+            ctx.indent_level = 0;
+            ok = decode_bej_buffer(&ctx, input_data, input_size);
+            if (!ok)
+            {
+                bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to decode %s", path);
+            }
+        }
+
+        if (ok && ndjson)
+        {
+            uint8_t newline = '\n';
+            mtx_lock(&job->ndjson_lock);
+            ok = fwrite(ctx.output_buffer, 1, ctx.output_length, options->ndjson_output) == ctx.output_length
+                 && fwrite(&newline, 1, 1, options->ndjson_output) == 1;
+            mtx_unlock(&job->ndjson_lock);
+        }
+        else if (ok)
+        {
+            char output_path[4096];
+            ok = make_output_path(path, options->output_dir, options->output_format,
+                                  output_path, sizeof(output_path))
+                 && batch_write_file(output_path, ctx.output_buffer, ctx.output_length,
+                                     &options->diagnostics);
+        }
+
+        if (ok)
+        {
+            atomic_fetch_add(&job->files_ok, 1);
+            atomic_fetch_add(&job->bytes_out, ctx.output_length + (ndjson ? 1 : 0));
+        }
+        else
+        {
+            atomic_fetch_add(&job->files_failed, 1);
+        }
+    }
+
+    free(input_data);
+    free(ctx.output_buffer);
+    free_arena(&arena);
+    return 0;
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool bej_decode_batch(const BatchFileList_t* files, const BatchOptions_t* options, BatchStats_t* stats)
+{
+    if (!files || !options)
+    {
+        return false;
+    }
+
+    // io_uring replaces the per-worker syscalls entirely when it is available
+    if (options->io_backend == BATCH_IO_URING
+        || (options->io_backend == BATCH_IO_AUTO && batch_io_uring_supported()))
+    {
+        return bej_decode_batch_uring(files, options, stats);
+    }
+
+    BatchJob_t job;
+    job.files = files;
+    job.options = options;
+    atomic_init(&job.next_file, 0);
+    atomic_init(&job.files_ok, 0);
+    atomic_init(&job.files_failed, 0);
+    atomic_init(&job.bytes_in, 0);
+    atomic_init(&job.bytes_out, 0);
+    if (mtx_init(&job.ndjson_lock, mtx_plain) != thrd_success)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to create NDJSON lock");
+        return false;
+    }
+
+    // No point starting more workers than there are files
+    size_t thread_count = options->thread_count > 1 ? (size_t)options->thread_count : 1;
+    if (thread_count > files->count)
+    {
+        thread_count = files->count > 0 ? files->count : 1;
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    if (thread_count == 1)
+    {
+        batch_worker(&job);
+    }
+    else
+    {
+        thrd_t* threads = (thrd_t*)malloc(thread_count * sizeof(thrd_t));
+        size_t started = 0;
+        if (threads)
+        {
+            for (; started < thread_count; started++)
+            {
+                if (thrd_create(&threads[started], batch_worker, &job) != thrd_success)
+                {
+                    bej_diagnose(&options->diagnostics, BEJ_DIAG_WARNING,
+                                 "Started only %zu of %zu worker threads", started, thread_count);
+                    break;
+                }
+            }
+        }
+
+        // With no worker running, the calling thread does the work itself
+        if (started == 0)
+        {
+            batch_worker(&job);
+        }
+        for (size_t i = 0; i < started; i++)
+        {
+            thrd_join(threads[i], NULL);
+        }
+        free(threads);
+    }
+
+    double seconds = elapsed_seconds(&start);
+    mtx_destroy(&job.ndjson_lock);
+
+    size_t files_ok = atomic_load(&job.files_ok);
+    if (stats)
+    {
+        stats->files_total = files->count;
+        stats->files_ok = files_ok;
+        stats->files_failed = atomic_load(&job.files_failed);
+        stats->bytes_in = atomic_load(&job.bytes_in);
+        stats->bytes_out = atomic_load(&job.bytes_out);
+        stats->seconds = seconds;
+    }
+    return files_ok == files->count;
+}
@@ -0,0 +1,836 @@
+/**
+ * @file batch_io.c
+ * @author Vladyslav Kolodii
+ * @brief File I/O backends for batch decoding: io_uring and pread/pwrite
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "batch_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// liburing is not required: the few ring operations needed here are done
+// directly on the kernel interface
+#if defined(__linux__) && (defined(__GNUC__) || defined(__clang__)) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define BEJ_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+// ============================================================================
+// pread/pwrite File Functions
+// ============================================================================
+
+#ifdef _WIN32
+
+bool batch_read_file(const char* path, uint8_t** data, size_t* capacity, uint64_t* size,
+                     const BejDiagnostics_t* diagnostics)
+{
+    return read_file_into_buffer(path, data, capacity, size, diagnostics);
+}
+
+bool batch_write_file(const char* path, const uint8_t* data, size_t size,
+                      const BejDiagnostics_t* diagnostics)
+{
+    FILE* output = fopen(path, "wb");
+    if (!output)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot create output file %s", path);
+        return false;
+    }
+    bool ok = fwrite(data, 1, size, output) == size;
+    ok = (fclose(output) == 0) && ok;
+    if (!ok)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to write output file %s", path);
+    }
+    return ok;
+}
+
+#else
+
+bool batch_read_file(const char* path, uint8_t** data, size_t* capacity, uint64_t* size,
+                     const BejDiagnostics_t* diagnostics)
+{
+    // No stdio: open + fstat + pread + close, and no user-space copy of the data
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open input file %s", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0 || (uint64_t)(size_t)info.st_size != (uint64_t)info.st_size)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Input file %s is empty or too large", path);
+        close(fd);
+        return false;
+    }
+    size_t file_size = (size_t)info.st_size;
+
+    if (file_size > *capacity)
+    {
+        uint8_t* grown = (uint8_t*)realloc(*data, file_size);
+        if (!grown)
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate input buffer");
+            close(fd);
+            return false;
+        }
+        *data = grown;
+        *capacity = file_size;
+    }
+
+    size_t total = 0;
+    while (total < file_size)
+    {
+        ssize_t count = pread(fd, *data + total, file_size - total, (off_t)total);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        total += (size_t)count;
+    }
+    close(fd);
+
+    if (total != file_size)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read input file %s", path);
+        return false;
+    }
+    *size = (uint64_t)file_size;
+    return true;
+}
+
+bool batch_write_file(const char* path, const uint8_t* data, size_t size,
+                      const BejDiagnostics_t* diagnostics)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot create output file %s", path);
+        return false;
+    }
+
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t count = pwrite(fd, data + total, size - total, (off_t)total);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        total += (size_t)count;
+    }
+
+    bool ok = (close(fd) == 0) && total == size;
+    if (!ok)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to write output file %s", path);
+    }
+    return ok;
+}
+
+#endif
+
+#ifndef BEJ_HAVE_IO_URING
+
+bool batch_io_uring_supported(void)
+{
+    return false;
+}
+
+bool bej_decode_batch_uring(const BatchFileList_t* files, const BatchOptions_t* options, BatchStats_t* stats)
+{
+    (void)files;
+    (void)stats;
+    if (options)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "io_uring is not available in this build");
+    }
+    return false;
+}
+
+#else
+
+// ============================================================================
+// io_uring Queue Functions
+// ============================================================================
+
+/// Mapped submission and completion rings of one io_uring instance
+typedef struct
+{
+    int fd;
+    unsigned entries;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    unsigned pending;           // prepared but not yet submitted
+} UringQueue_t;
+
+static void uring_queue_exit(UringQueue_t* ring)
+{
+    if (ring->sqes && ring->sqes != MAP_FAILED)
+    {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+    {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+static bool uring_queue_init(UringQueue_t* ring, unsigned entries)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    ring->fd = fd;
+
+    // OPENAT and CLOSE arrived together with IORING_FEAT_RW_CUR_POS (5.6)
+    if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        uring_queue_exit(ring);
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size)
+    {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED)
+    {
+        uring_queue_exit(ring);
+        return false;
+    }
+    ring->cq_ring = single_mmap ? ring->sq_ring
+                                : mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        uring_queue_exit(ring);
+        return false;
+    }
+
+    uint8_t* sq = (uint8_t*)ring->sq_ring;
+    uint8_t* cq = (uint8_t*)ring->cq_ring;
+    ring->entries = params.sq_entries;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+/// Next free submission entry, zeroed; the caller keeps the phase within ring->entries
+static struct io_uring_sqe* uring_get_sqe(UringQueue_t* ring)
+{
+    unsigned tail = *ring->sq_tail + ring->pending;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->pending++;
+    return sqe;
+}
+
+/// Submit everything prepared and wait until `count` completions have been handed to `handle`
+static bool uring_submit_and_wait(UringQueue_t* ring, unsigned count,
+                                  void (*handle)(void* user, uint64_t user_data, int32_t result), void* user)
+{
+    // Publish the new tail only after the entries themselves are written
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + ring->pending, __ATOMIC_RELEASE);
+    unsigned to_submit = ring->pending;
+    ring->pending = 0;
+
+    unsigned completed = 0;
+    while (completed < count)
+    {
+        int entered = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, count - completed,
+                                   IORING_ENTER_GETEVENTS, NULL, 0);
+        if (entered < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        to_submit -= (unsigned)entered < to_submit ? (unsigned)entered : to_submit;
+
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+            handle(user, cqe->user_data, cqe->res);
+            completed++;
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+bool batch_io_uring_supported(void)
+{
+    UringQueue_t ring;
+    if (!uring_queue_init(&ring, 2))
+    {
+        return false;
+    }
+    uring_queue_exit(&ring);
+    return true;
+}
+
+// ============================================================================
+// io_uring Batch Decode
+// ============================================================================
+
+/// Initial read buffer; files that fill it completely are re-read with pread
+#define URING_INITIAL_READ_SIZE (64u * 1024u)
+
+/// One file in the current window; buffers are kept across windows
+typedef struct
+{
+    const char* path;
+    int fd;
+    int32_t read_result;
+    int32_t write_result;
+    bool ok;
+    uint8_t* input;
+    size_t input_capacity;
+    uint64_t input_size;
+    uint8_t* output;
+    size_t output_capacity;
+    size_t output_length;
+    char output_path[4096];
+} UringSlot_t;
+
+/// Decode threads that live for the whole batch and take one window at a time
+//
+// The I/O thread posts a window under lock and bumps generation. Claims come
+// from one counter that only grows: window slot i is claim base + i. A worker
+// claims by compare-and-swap only below the end of the window it joined, so a
+// worker that wakes late never takes a claim of a newer window. A window is
+// finished once every claim is taken and active is back to zero.
+typedef struct
+{
+    const BatchOptions_t* options;
+    mtx_t lock;
+    cnd_t posted;               // a new window, or shutdown
+    cnd_t idle;                 // active dropped to zero
+    UringSlot_t* slots;         // window being decoded
+    size_t base;                // claim of the window's first slot
+    size_t count;
+    uint64_t generation;        // bumped for every window
+    size_t active;              // workers inside a window
+    bool shutdown;
+    atomic_size_t next_claim;
+} UringDecodePool_t;
+
+// user_data layout: slot index in the high bits, operation in the low two
+enum { URING_OP_OPEN = 0, URING_OP_IO = 1, URING_OP_CLOSE = 2 };
+
+static void handle_open(void* user, uint64_t user_data, int32_t result)
+{
+    UringSlot_t* slot = &((UringSlot_t*)user)[user_data >> 2];
+    slot->fd = result;
+}
+
+static void handle_read(void* user, uint64_t user_data, int32_t result)
+{
+    UringSlot_t* slot = &((UringSlot_t*)user)[user_data >> 2];
+    if ((user_data & 3) == URING_OP_IO)
+    {
+        slot->read_result = result;
+    }
+}
+
+static void handle_write(void* user, uint64_t user_data, int32_t result)
+{
+    UringSlot_t* slot = &((UringSlot_t*)user)[user_data >> 2];
+    if ((user_data & 3) == URING_OP_IO)
+    {
+        slot->write_result = result;
+    }
+}
+
+/// Queue one OPENAT per slot in [0, count) and wait for all of them
+static bool uring_open_all(UringQueue_t* ring, UringSlot_t* slots, size_t count, bool for_write)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        struct io_uring_sqe* sqe = uring_get_sqe(ring);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uint64_t)(uintptr_t)(for_write ? slots[i].output_path : slots[i].path);
+        sqe->len = for_write ? 0644 : 0;
+        sqe->open_flags = for_write ? (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC);
+        sqe->user_data = ((uint64_t)i << 2) | URING_OP_OPEN;
+    }
+    return uring_submit_and_wait(ring, (unsigned)count, handle_open, slots);
+}
+
+/// Queue a READ or WRITE hard-linked to a CLOSE for every opened slot, and wait for all
+static bool uring_transfer_all(UringQueue_t* ring, UringSlot_t* slots, size_t count, bool write)
+{
+    unsigned expected = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (slots[i].fd < 0)
+        {
+            continue;
+        }
+
+        // The hard link makes the CLOSE run even when the transfer fails
+        struct io_uring_sqe* sqe = uring_get_sqe(ring);
+        sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->flags = IOSQE_IO_HARDLINK;
+        sqe->fd = slots[i].fd;
+        sqe->addr = (uint64_t)(uintptr_t)(write ? slots[i].output : slots[i].input);
+        sqe->len = (uint32_t)(write ? slots[i].output_length : slots[i].input_capacity);
+        sqe->off = 0;
+        sqe->user_data = ((uint64_t)i << 2) | URING_OP_IO;
+
+        sqe = uring_get_sqe(ring);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = slots[i].fd;
+        sqe->user_data = ((uint64_t)i << 2) | URING_OP_CLOSE;
+        expected += 2;
+    }
+    return uring_submit_and_wait(ring, expected, write ? handle_write : handle_read, slots);
+}
+
+/// Decoder context for the batch's output settings, with an arena reset for every file it decodes
+static void init_pool_context(const BatchOptions_t* options, DecoderContext_t* ctx, BejArena_t* arena)
+{
+    bool ndjson = options->ndjson_output != NULL;
+    init_arena(arena, 0);
+    init_decoder_context(ctx, options->schema_dict, options->anno_dict, NULL, NULL);
+    ctx->arena = arena;
+    ctx->output_format = ndjson ? BEJ_OUTPUT_JSON : options->output_format;
+    ctx->compact = ndjson;
+    ctx->diagnostics = options->diagnostics;
+}
+
+/// Claim and decode slots of the window starting at claim base until none are left
+static void uring_decode_slots(UringDecodePool_t* pool, DecoderContext_t* ctx, UringSlot_t* slots,
+                               size_t base, size_t count)
+{
+    size_t claim = atomic_load(&pool->next_claim);
+    while (claim - base < count)
+    {
+        if (!atomic_compare_exchange_weak(&pool->next_claim, &claim, claim + 1))
+        {
+            continue;
+        }
+        UringSlot_t* slot = &slots[claim - base];
+        claim++;
+        if (!slot->ok)
+        {
+            continue;
+        }
+
+        // Decode straight into the slot's own output buffer, growing it if needed
+        set_output_buffer(ctx, slot->output, slot->output_capacity);
+        slot->ok = decode_bej_buffer(ctx, slot->input, slot->input_size);
+        slot->output = ctx->output_buffer;
+        slot->output_capacity = ctx->output_capacity;
+        slot->output_length = ctx->output_length;
+        if (!slot->ok)
+        {
+            bej_diagnose(&pool->options->diagnostics, BEJ_DIAG_ERROR, "Failed to decode %s", slot->path);
+        }
+    }
+}
+
+static int uring_decode_worker(void* arg)
+{
+    UringDecodePool_t* pool = (UringDecodePool_t*)arg;
+    BejArena_t arena;
+    DecoderContext_t ctx;
+    init_pool_context(pool->options, &ctx, &arena);
+
+    uint64_t seen = 0;
+    mtx_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->shutdown && pool->generation == seen)
+        {
+            cnd_wait(&pool->posted, &pool->lock);
+        }
+        if (pool->shutdown)
+        {
+            break;
+        }
+        seen = pool->generation;
+        UringSlot_t* slots = pool->slots;
+        size_t base = pool->base;
+        size_t count = pool->count;
+        pool->active++;
+        mtx_unlock(&pool->lock);
+
+        uring_decode_slots(pool, &ctx, slots, base, count);
+
+        mtx_lock(&pool->lock);
+        if (--pool->active == 0)
+        {
+            cnd_signal(&pool->idle);
+        }
+    }
+    mtx_unlock(&pool->lock);
+    free_arena(&arena);
+    return 0;
+}
+
+/// Hand a window to the workers; they start decoding at once
+static void uring_pool_post(UringDecodePool_t* pool, UringSlot_t* slots, size_t count)
+{
+    mtx_lock(&pool->lock);
+    pool->slots = slots;
+    pool->base = atomic_load(&pool->next_claim);
+    pool->count = count;
+    pool->generation++;
+    cnd_broadcast(&pool->posted);
+    mtx_unlock(&pool->lock);
+}
+
+/// Help decode the posted window, then wait until every worker has left it
+static void uring_pool_finish(UringDecodePool_t* pool, DecoderContext_t* ctx)
+{
+    uring_decode_slots(pool, ctx, pool->slots, pool->base, pool->count);
+    mtx_lock(&pool->lock);
+    while (pool->active > 0)
+    {
+        cnd_wait(&pool->idle, &pool->lock);
+    }
+    mtx_unlock(&pool->lock);
+}
+
+/// Open, read and close every file of a window: all opens in one submission, then all reads
+static bool uring_read_window(UringQueue_t* ring, UringSlot_t* slots, char* const* paths, size_t count,
+                              const BatchOptions_t* options, uint64_t* bytes_in)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        UringSlot_t* slot = &slots[i];
+        slot->path = paths[i];
+        slot->fd = -1;
+        slot->read_result = -1;
+        slot->write_result = -1;
+        slot->ok = false;
+        if (slot->input_capacity < URING_INITIAL_READ_SIZE)
+        {
+            uint8_t* grown = (uint8_t*)realloc(slot->input, URING_INITIAL_READ_SIZE);
+            if (grown)
+            {
+                slot->input = grown;
+                slot->input_capacity = URING_INITIAL_READ_SIZE;
+            }
+        }
+    }
+    if (!uring_open_all(ring, slots, count, false) || !uring_transfer_all(ring, slots, count, false))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        UringSlot_t* slot = &slots[i];
+        if (slot->fd < 0 || slot->read_result <= 0)
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to read input file %s", slot->path);
+            continue;
+        }
+
+        // A full buffer may mean a larger file: fetch the rest the plain way
+        if ((size_t)slot->read_result == slot->input_capacity)
+        {
+            slot->ok = batch_read_file(slot->path, &slot->input, &slot->input_capacity,
+                                       &slot->input_size, &options->diagnostics);
+        }
+        else
+        {
+            slot->input_size = (uint64_t)slot->read_result;
+            slot->ok = true;
+        }
+        *bytes_in += slot->ok ? slot->input_size : 0;
+    }
+    return true;
+}
+
+/// Write a decoded window: NDJSON in input order, or all per-file outputs in one submission
+static bool uring_write_window(UringQueue_t* ring, UringSlot_t* slots, size_t count,
+                               const BatchOptions_t* options, size_t* files_ok, uint64_t* bytes_out)
+{
+    if (options->ndjson_output)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!slots[i].ok)
+            {
+                continue;
+            }
+            uint8_t newline = '\n';
+            slots[i].ok = fwrite(slots[i].output, 1, slots[i].output_length, options->ndjson_output)
+                          == slots[i].output_length
+                          && fwrite(&newline, 1, 1, options->ndjson_output) == 1;
+            *bytes_out += slots[i].ok ? slots[i].output_length + 1 : 0;
+            *files_ok += slots[i].ok ? 1 : 0;
+        }
+        return true;
+    }
+
+    size_t writes = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        // Keep only the slots that will be written at the front of the window
+        UringSlot_t* slot = &slots[i];
+        if (slot->ok && !make_output_path(slot->path, options->output_dir, options->output_format,
+                                          slot->output_path, sizeof(slot->output_path)))
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Output path for %s is too long", slot->path);
+            slot->ok = false;
+        }
+        if (slot->ok && slot->output_length > UINT32_MAX)
+        {
+            slot->ok = batch_write_file(slot->output_path, slot->output, slot->output_length,
+                                        &options->diagnostics);
+            *files_ok += slot->ok ? 1 : 0;
+            *bytes_out += slot->ok ? slot->output_length : 0;
+            continue;
+        }
+        if (slot->ok)
+        {
+            if (writes != i)
+            {
+                UringSlot_t moved = slots[writes];
+                slots[writes] = *slot;
+                *slot = moved;
+            }
+            writes++;
+        }
+    }
+
+    if (!uring_open_all(ring, slots, writes, true) || !uring_transfer_all(ring, slots, writes, true))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < writes; i++)
+    {
+        UringSlot_t* slot = &slots[i];
+        if (slot->fd < 0 || slot->write_result < 0 || (size_t)slot->write_result != slot->output_length)
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to write output file %s",
+                         slot->output_path);
+            continue;
+        }
+        (*files_ok)++;
+        *bytes_out += slot->output_length;
+    }
+    return true;
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool bej_decode_batch_uring(const BatchFileList_t* files, const BatchOptions_t* options, BatchStats_t* stats)
+{
+    if (!files || !options)
+    {
+        return false;
+    }
+
+    size_t depth = options->queue_depth ? options->queue_depth : BATCH_IO_QUEUE_DEPTH;
+    if (depth > 4096)
+    {
+        depth = 4096;
+    }
+
+    // Two entries per file: the transfer and its linked close
+    UringQueue_t ring;
+    if (!uring_queue_init(&ring, (unsigned)depth * 2))
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "io_uring is not available on this system");
+        return false;
+    }
+
+    // Two windows of slots: one is decoded while the other is read
+    size_t thread_count = options->thread_count > 1 ? (size_t)options->thread_count : 1;
+    UringSlot_t* slots = (UringSlot_t*)calloc(depth * 2, sizeof(UringSlot_t));
+    thrd_t* threads = (thrd_t*)malloc(thread_count * sizeof(thrd_t));
+    UringDecodePool_t pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.options = options;
+    atomic_init(&pool.next_claim, 0);
+    bool lock_ok = mtx_init(&pool.lock, mtx_plain) == thrd_success;
+    bool posted_ok = lock_ok && cnd_init(&pool.posted) == thrd_success;
+    bool idle_ok = posted_ok && cnd_init(&pool.idle) == thrd_success;
+    if (!slots || !threads || !idle_ok)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate io_uring batch state");
+        if (posted_ok) cnd_destroy(&pool.posted);
+        if (lock_ok) mtx_destroy(&pool.lock);
+        free(slots);
+        free(threads);
+        uring_queue_exit(&ring);
+        return false;
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    // The workers start once per batch; the I/O thread decodes too between submissions
+    size_t started = 0;
+    while (started + 1 < thread_count
+           && thrd_create(&threads[started], uring_decode_worker, &pool) == thrd_success)
+    {
+        started++;
+    }
+    BejArena_t arena;
+    DecoderContext_t ctx;
+    init_pool_context(options, &ctx, &arena);
+
+    size_t files_ok = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    UringSlot_t* current = slots;
+    UringSlot_t* next = slots + depth;
+    size_t first = 0;
+    size_t count = files->count < depth ? files->count : depth;
+    bool ring_ok = count == 0 || uring_read_window(&ring, current, files->paths, count, options, &bytes_in);
+
+    while (count > 0 && ring_ok)
+    {
+        uring_pool_post(&pool, current, count);
+
+        // The next window is read while the workers decode this one
+        size_t next_first = first + count;
+        size_t next_count = files->count - next_first < depth ? files->count - next_first : depth;
+        bool read_ok = next_count == 0
+                       || uring_read_window(&ring, next, files->paths + next_first, next_count, options, &bytes_in);
+
+        uring_pool_finish(&pool, &ctx);
+        ring_ok = read_ok && uring_write_window(&ring, current, count, options, &files_ok, &bytes_out);
+
+        UringSlot_t* decoded = current;
+        current = next;
+        next = decoded;
+        first = next_first;
+        count = next_count;
+    }
+
+    if (!ring_ok)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "io_uring submission failed");
+    }
+
+    mtx_lock(&pool.lock);
+    pool.shutdown = true;
+    cnd_broadcast(&pool.posted);
+    mtx_unlock(&pool.lock);
+    for (size_t i = 0; i < started; i++)
+    {
+        thrd_join(threads[i], NULL);
+    }
+
+    double seconds = elapsed_seconds(&start);
+    for (size_t i = 0; i < depth * 2; i++)
+    {
+        free(slots[i].input);
+        free(slots[i].output);
+    }
+    free(slots);
+    free(threads);
+    free_arena(&arena);
+    cnd_destroy(&pool.idle);
+    cnd_destroy(&pool.posted);
+    mtx_destroy(&pool.lock);
+    uring_queue_exit(&ring);
+
+    if (stats)
+    {
+        stats->files_total = files->count;
+        stats->files_ok = files_ok;
+        stats->files_failed = files->count - files_ok;
+        stats->bytes_in = bytes_in;
+        stats->bytes_out = bytes_out;
+        stats->seconds = seconds;
+    }
+    return files_ok == files->count;
+}
+
+#endif
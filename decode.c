@@ -12,18 +12,91 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BEJ_HAVE_SSSE3_BASE64 1
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_MSC_VER)
+#define BEJ_LITTLE_ENDIAN 1
+#endif
+
+/// First guess at in-memory output size per input byte; documents that expand more grow the buffer
+#define OUTPUT_BYTES_PER_INPUT_BYTE 3
+
+// ============================================================================
+// Diagnostics Functions
+// ============================================================================
+
+void init_diagnostics(BejDiagnostics_t* diagnostics)
+{
+    if (!diagnostics) return;
+
+    diagnostics->callback = NULL;
+    diagnostics->user = NULL;
+    diagnostics->level = BEJ_DIAG_ERROR;
+}
+
+void bej_diagnose(const BejDiagnostics_t* diagnostics, BejDiagLevel_t level, const char* format, ...)
+{
+    // Cheap early out: silent decodes never format anything
+    if (!diagnostics || !diagnostics->callback || level > diagnostics->level) 
+    {
+        return;
+    }
+
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    diagnostics->callback(diagnostics->user, level, message);
+}
+
+void bej_diagnostics_stderr(void* user, BejDiagLevel_t level, const char* message)
+{
+    (void)user;
+
+    const char* prefix = "";
+    if (level == BEJ_DIAG_ERROR) 
+    {
+        prefix = "Error: ";
+    }
+    else if (level == BEJ_DIAG_WARNING) 
+    {
+        prefix = "Warning: ";
+    }
+    fprintf(stderr, "%s%s\n", prefix, message);
+}
 
 // ============================================================================
 // Dictionary Functions
 // ============================================================================
 
 Dictionary_t* load_dictionary(const char* filename)
+{
+    return load_dictionary_with_diagnostics(filename, NULL);
+}
+
+Dictionary_t* load_dictionary_with_diagnostics(const char* filename, const BejDiagnostics_t* diagnostics)
+{
+    return load_dictionary_with_allocator(filename, diagnostics, NULL);
+}
+
+Dictionary_t* load_dictionary_with_allocator(const char* filename, const BejDiagnostics_t* diagnostics,
+                                             const BejAllocator_t* allocator)
 {
     if (!filename) 
     {
-        fprintf(stderr, "Error: Dictionary filename is NULL\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Dictionary filename is NULL");
         return NULL;
     }
     
@@ -31,78 +104,76 @@ Dictionary_t* load_dictionary(const char* filename)
 
     if (!fp) 
     {
-        fprintf(stderr, "Error: Cannot open dictionary file %s\n", filename);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open dictionary file %s", filename);
         return NULL;
     }
     
-    Dictionary_t* dict = (Dictionary_t*)calloc(1, sizeof(Dictionary_t));
+    Dictionary_t* dict = (Dictionary_t*)bej_alloc(allocator, sizeof(Dictionary_t));
 
     if (!dict) 
     {
-        fprintf(stderr, "Error: Failed to allocate dictionary memory\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate dictionary memory");
         fclose(fp);
         return NULL;
     }
+    memset(dict, 0, sizeof(Dictionary_t));
+    dict->allocator = allocator;
     
     // Read dictionary header: Version (1 byte), Flags (1 byte), EntryCount (2 bytes)
     if (fread(&dict->version_tag, 1, 1, fp) != 1) 
     {
-        fprintf(stderr, "Error: Failed to read dictionary format version tag\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read dictionary format version tag");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
     
     if (fread(&dict->dictionary_flags, 1, 1, fp) != 1) 
     {
-        fprintf(stderr, "Error: Failed to read dictionary flags\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read dictionary flags");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
     
     if (fread(&dict->entry_count, 1, 2, fp) != 2) 
     {
-        fprintf(stderr, "Error: Failed to read entry count\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read entry count");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
 
     if (fread(&dict->schema_version, 1, 4, fp) != 4) 
     {
-        fprintf(stderr, "Error: Failed to read schema version\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read schema version");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
 
     if (fread(&dict->dictionary_size, 1, 4, fp) != 4) 
     {
-        fprintf(stderr, "Error: Failed to read dictionary size\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read dictionary size");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
 
-    fprintf(stdout, 
-            "Version tag: 0x%02x\n"
-            "Dictionary flags: 0x%02x\n"
-            "Entry count: %u\n"
-            "Schema version: 0x%08X\n"
-            "Dictionary size (bytes): %u\n", 
-            dict->version_tag, dict->dictionary_flags, dict->entry_count,
-            dict->schema_version, dict->dictionary_size
-    );
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO,
+                 "Dictionary %s: version tag 0x%02x, flags 0x%02x, %u entries, "
+                 "schema version 0x%08X, %u bytes",
+                 filename, dict->version_tag, dict->dictionary_flags, dict->entry_count,
+                 dict->schema_version, dict->dictionary_size);
     
     long entries_start = ftell(fp);
     long file_size = dict->dictionary_size;
-    uint8_t* file_data = (uint8_t*)malloc(file_size);
+    uint8_t* file_data = (uint8_t*)bej_alloc(allocator, file_size);
     
     if (!file_data) 
     {
-        fprintf(stderr, "Error: Failed to allocate file buffer\n");
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate file buffer");
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
@@ -111,27 +182,57 @@ Dictionary_t* load_dictionary(const char* filename)
 
     if (fread(file_data, 1, file_size, fp) != (size_t)file_size) 
     {
-        fprintf(stderr, "Error: Failed to read dictionary file\n");
-        free(file_data);
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read dictionary file");
+        bej_free(allocator, file_data);
+        bej_free(allocator, dict);
         fclose(fp);
         return NULL;
     }
     
     fclose(fp);
+
+    // FNV-1a over the file, so callers can key compiled queries by dictionary revision
+    dict->content_hash = 14695981039346656037ull;
+    for (long i = 0; i < file_size; i++) 
+    {
+        dict->content_hash = (dict->content_hash ^ file_data[i]) * 1099511628211ull;
+    }
     
     // Allocate entries
-    dict->entries = (DictionaryEntry_t*)calloc(dict->entry_count, sizeof(DictionaryEntry_t));
+    dict->entries = (DictionaryEntry_t*)bej_alloc(allocator, dict->entry_count * sizeof(DictionaryEntry_t));
     if (!dict->entries) 
     {
-        fprintf(stderr, "Error: Failed to allocate dictionary entries\n");
-        free(file_data);
-        free(dict);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate dictionary entries");
+        bej_free(allocator, file_data);
+        bej_free(allocator, dict);
         return NULL;
     }
     
+    // All names share one block, sized by a first pass over the entry table
+    size_t names_size = 0;
+    for (uint32_t i = 0; i < dict->entry_count; i++) 
+    {
+        long pos = entries_start + 10 * (long)i;
+        uint8_t name_len = file_data[pos+7];
+        uint16_t name_pos = file_data[pos+8] | (file_data[pos+9] << 8);
+        if (name_pos + name_len <= file_size && name_len > 0 && name_len < 255) 
+        {
+            names_size += name_len + 1u;
+        }
+    }
+    dict->names = names_size ? (char*)bej_alloc(allocator, names_size) : NULL;
+    if (names_size && !dict->names) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate dictionary names");
+        bej_free(allocator, dict->entries);
+        bej_free(allocator, file_data);
+        bej_free(allocator, dict);
+        return NULL;
+    }
+
     // Parse entries
     long pos = entries_start;
+    char* next_name = dict->names;
     for (uint32_t i = 0; i < dict->entry_count; i++) 
     {
         DictionaryEntry_t* entry = &dict->entries[i];
@@ -148,35 +249,20 @@ Dictionary_t* load_dictionary(const char* filename)
         pos += 10;
         
         uint16_t name_pos = entry->name_offset;
-
-       
-        if (name_pos < file_size) 
+        uint8_t name_len = entry->name_length;
+        if (name_pos + name_len <= file_size && name_len > 0 && name_len < 255) 
         {
-            uint8_t name_len = entry->name_length;
-            if (entry->name_length > 0 && name_len < 255) 
-            {
-                entry->name = (char*)malloc(name_len + 1);
-                if (entry->name) 
-                {
-                    memcpy(entry->name, &file_data[name_pos], name_len);
-                    entry->name[name_len] = '\0';
-                }
-                else
-                {
-                    fprintf(stderr, "Error: Failed to allocate file buffer\n");
-                }
-            } 
-            else 
-            {
-                entry->name = NULL;
-            }
+            entry->name = next_name;
+            memcpy(entry->name, &file_data[name_pos], name_len);
+            entry->name[name_len] = '\0';
+            next_name += name_len + 1u;
         } 
         else 
         {
             entry->name = NULL;
         }
     }
-    free(file_data);
+    bej_free(allocator, file_data);
     return dict;
 }
 
@@ -184,20 +270,11 @@ void free_dictionary(Dictionary_t* dict)
 {
     if (!dict) return;
     
-    if (dict->entries) 
-    {
-        for (uint16_t i = 0; i < dict->entry_count; i++) 
-        {
-            if (dict->entries[i].name) 
-            {
-                free(dict->entries[i].name);
-                dict->entries[i].name = NULL;
-            }
-        }
-        free(dict->entries);
-        dict->entries = NULL;
-    }
-    free(dict);
+    // Entry names point into the shared names block
+    const BejAllocator_t* allocator = dict->allocator;
+    bej_free(allocator, dict->names);
+    bej_free(allocator, dict->entries);
+    bej_free(allocator, dict);
 }
 
 DictionaryEntry_t* find_dictionary_entry(Dictionary_t* dict, DictionaryEntry_t* parent, uint32_t sequence, int8_t format)
@@ -218,6 +295,11 @@ DictionaryEntry_t* find_dictionary_entry(Dictionary_t* dict, DictionaryEntry_t*
         // Convert byte offset to entry index
         start_index = (parent->child_pointer_offset - DICTIONARY_HEADER_SIZE) / DICTIONARY_ENTRY_SIZE;
         search_count = parent->child_count;
+        if (parent->child_pointer_offset < DICTIONARY_HEADER_SIZE || start_index > dict->entry_count
+            || search_count > dict->entry_count - start_index)
+        {
+            return NULL;
+        }
     }
     
     for (uint32_t i = 0; i < search_count; i++) 
@@ -243,11 +325,32 @@ DictionaryEntry_t* find_dictionary_entry(Dictionary_t* dict, DictionaryEntry_t*
     return NULL;
 }
 
+DictionaryEntry_t* find_member_entry(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                     DictionaryEntry_t* parent, const SFLV_t* member)
+{
+    Dictionary_t* dict = member->dict_selector ? anno_dict : schema_dict;
+    if (!dict || !dict->entries || dict->entry_count == 0)
+    {
+        return NULL;
+    }
+
+    // A member from the other dictionary (an annotation in a schema SET) is a child of that dictionary's root
+    bool in_dict = parent && parent >= dict->entries && parent < dict->entries + dict->entry_count;
+    if (!in_dict && (parent || member->dict_selector))
+    {
+        parent = &dict->entries[0];
+    }
+
+    // Any property may be null, whatever format its entry declares
+    int8_t format = member->format == BEJ_FORMAT_NULL ? -1 : (int8_t)member->format;
+    return find_dictionary_entry(dict, parent, member->sequence, format);
+}
+
 // ============================================================================
 // Buffer Reader Functions (Cross-platform replacement for fmemopen)
 // ============================================================================
 
-void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint32_t size)
+void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint64_t size)
 {
     if (!reader) return;
     
@@ -256,19 +359,19 @@ void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint32_t size)
     reader->position = 0;
 }
 
-uint32_t buffer_read(BufferReader_t* reader, void* dest, uint32_t count)
+uint64_t buffer_read(BufferReader_t* reader, void* dest, uint64_t count)
 {
     if (!reader || !dest || reader->position >= reader->size) 
     {
         return 0;
     }
     
-    uint32_t available = reader->size - reader->position;
-    uint32_t to_read = (count < available) ? count : available;
+    uint64_t available = reader->size - reader->position;
+    uint64_t to_read = (count < available) ? count : available;
     
     if (to_read > 0) 
     {
-        memcpy(dest, reader->data + reader->position, to_read);
+        memcpy(dest, reader->data + reader->position, (size_t)to_read);
         reader->position += to_read;
     }
     
@@ -285,7 +388,18 @@ bool buffer_eof(BufferReader_t* reader)
 // NNINT (Non-Negative Integer) Functions
 // ============================================================================
 
-bool read_nnint(FILE* fp, uint32_t* value)
+/// Little-endian integer of `length` (1 to 8) bytes
+static uint64_t nnint_value(const uint8_t* bytes, uint8_t length)
+{
+    uint64_t result = 0;
+    for (uint8_t i = 0; i < length; ++i) 
+    {
+        result |= ((uint64_t)bytes[i]) << (8 * i);
+    }
+    return result;
+}
+
+bool read_nnint(FILE* fp, uint64_t* value)
 {
     if (!fp || !value)
     {
@@ -298,64 +412,51 @@ bool read_nnint(FILE* fp, uint32_t* value)
         return false;
     }
 
-    if (length == 0 || length > 4) 
+    if (length == 0 || length > BEJ_NNINT_MAX_BYTES) 
     {
-        fprintf(stderr, "Error: Invalid NNINT length (%u)\n", length);
         return false;
     }
 
-    uint8_t bytes[4] = {0};
+    uint8_t bytes[BEJ_NNINT_MAX_BYTES];
     if (fread(bytes, 1, length, fp) != length) 
     {
-        fprintf(stderr, "Error: Failed to read NNINT data bytes\n");
         return false;
     }
 
-    // Combine bytes as little-endian integer
-    uint32_t result = 0;
-    for (uint8_t i = 0; i < length; ++i) 
-    {
-        result |= ((uint32_t)bytes[i]) << (8 * i);
-    }
-
-    *value = result;
+    *value = nnint_value(bytes, length);
     return true;
 }
 
-bool read_nnint_from_buffer(BufferReader_t* reader, uint32_t* value)
+bool read_nnint_from_buffer(BufferReader_t* reader, uint64_t* value)
 {
-    if (!reader || !value) 
-    {
-        return false;
-    }
-
-    uint8_t length;
-    if (buffer_read(reader, &length, 1) != 1)
-    {
-        return false;
-    }
-
-    if (length == 0 || length > 4) 
+    if (!reader || !value || reader->position >= reader->size) 
     {
-        fprintf(stderr, "Error: Invalid NNINT length (%u)\n", length);
         return false;
     }
 
-    uint8_t bytes[4] = {0};
-    if (buffer_read(reader, &bytes, length) != length) 
+    const uint8_t* bytes = reader->data + reader->position;
+    uint64_t available = reader->size - reader->position - 1;
+    uint8_t length = bytes[0];
+    if (length == 0 || length > BEJ_NNINT_MAX_BYTES || length > available) 
     {
-        fprintf(stderr, "Error: Failed to read NNINT data bytes\n");
         return false;
     }
 
-    // Combine bytes as little-endian integer
-    uint32_t result = 0;
-    for (uint8_t i = 0; i < length; ++i) 
+#ifdef BEJ_LITTLE_ENDIAN
+    if (available >= 8) 
     {
-        result |= ((uint32_t)bytes[i]) << (8 * i);
+        // Fast path: one unaligned 8-byte load masked to the encoded width,
+        // the same cost for a 1-byte NNINT as for an 8-byte one
+        uint64_t word;
+        memcpy(&word, bytes + 1, sizeof(word));
+        *value = length == 8 ? word : word & ((UINT64_C(1) << (8 * length)) - 1);
+        reader->position += 1u + length;
+        return true;
     }
+#endif
 
-    *value = result;
+    *value = nnint_value(bytes + 1, length);
+    reader->position += 1u + length;
     return true;
 }
 
@@ -363,6 +464,26 @@ bool read_nnint_from_buffer(BufferReader_t* reader, uint32_t* value)
 // SFLV Functions
 // ============================================================================
 
+/// Split an encoded sequence NNINT into its dictionary selector bit and sequence number
+static bool split_sequence(SFLV_t* sflv, uint64_t encoded)
+{
+    // Dictionary encodings do not include the dictionary selector flag bit. 
+    // Separate it from sequence value itself
+    if ((encoded >> 1) > UINT32_MAX) 
+    {
+        return false;
+    }
+    sflv->dict_selector = encoded & 0x1;
+    sflv->sequence = (uint32_t)(encoded >> 1);
+    return true;
+}
+
+/// True when a value of `length` bytes can be held in memory on this platform
+static bool fits_in_memory(uint64_t length)
+{
+    return (uint64_t)(size_t)length == length;
+}
+
 bool read_sflv(FILE* fp, SFLV_t* sflv)
 {
     if (!fp || !sflv) 
@@ -371,21 +492,15 @@ bool read_sflv(FILE* fp, SFLV_t* sflv)
     }
     
     // Read sequence number (nnint) (5.3.6)
-    if (!read_nnint(fp, &sflv->sequence)) 
+    uint64_t sequence;
+    if (!read_nnint(fp, &sequence) || !split_sequence(sflv, sequence)) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV sequence\n");
         return false;
     }
-
-    // Dictionary encodings do not include the dictionary selector flag bit. 
-    // Separate it from sequence value itself
-    sflv->dict_selector = sflv->sequence & 0x1;
-    sflv->sequence = sflv->sequence >> 1;
     
     // Read format byte (5.3.7)
     if (fread(&sflv->format, 1, 1, fp) != 1) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV format\n");
         return false;
     }
 
@@ -395,22 +510,19 @@ bool read_sflv(FILE* fp, SFLV_t* sflv)
     // Read length (nnint) (5.3.8)
     if (!read_nnint(fp, &sflv->length)) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV length\n");
         return false;
     }
     
     // Allocate and read value (5.3.9)
     if (sflv->length > 0) 
     {
-        sflv->value = (uint8_t*)malloc(sflv->length);
+        sflv->value = fits_in_memory(sflv->length) ? (uint8_t*)malloc((size_t)sflv->length) : NULL;
         if (!sflv->value) 
         {
-            fprintf(stderr, "Error: Failed to allocate SFLV value memory\n");
             return false;
         }
-        if (fread(sflv->value, 1, sflv->length, fp) != sflv->length) 
+        if (fread(sflv->value, 1, (size_t)sflv->length, fp) != sflv->length) 
         {
-            fprintf(stderr, "Error: Failed to read SFLV value\n");
             free(sflv->value);
             sflv->value = NULL;
             return false;
@@ -420,8 +532,6 @@ bool read_sflv(FILE* fp, SFLV_t* sflv)
     {
         sflv->value = NULL;
     }
-    printf("SFLV: seq=%u, format=0x%02X, length=%u, dict_selector=%u\n", 
-            sflv->sequence, sflv->format, sflv->length, sflv->dict_selector);
     return true;
 }
 
@@ -433,21 +543,15 @@ bool read_sflv_from_buffer(BufferReader_t* reader, SFLV_t* sflv)
     }
     
     // Read sequence number (nnint) (5.3.6)
-    if (!read_nnint_from_buffer(reader, &sflv->sequence)) 
+    uint64_t sequence;
+    if (!read_nnint_from_buffer(reader, &sequence) || !split_sequence(sflv, sequence)) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV sequence from buffer\n");
         return false;
     }
 
-    // Dictionary encodings do not include the dictionary selector flag bit. 
-    // Separate it from sequence value itself
-    sflv->dict_selector = sflv->sequence & 0x1;
-    sflv->sequence = sflv->sequence >> 1;
-
     // Read format byte (5.3.7)
     if (buffer_read(reader, &sflv->format, 1) != 1) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV format from buffer\n");
         return false;
     }
 
@@ -457,22 +561,19 @@ bool read_sflv_from_buffer(BufferReader_t* reader, SFLV_t* sflv)
     // Read length (nnint) (5.3.8)
     if (!read_nnint_from_buffer(reader, &sflv->length)) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV length from buffer\n");
         return false;
     }
     
     // Allocate and read value (5.3.9)
     if (sflv->length > 0) 
     {
-        sflv->value = (uint8_t*)malloc(sflv->length);
+        sflv->value = fits_in_memory(sflv->length) ? (uint8_t*)malloc((size_t)sflv->length) : NULL;
         if (!sflv->value) 
         {
-            fprintf(stderr, "Error: Failed to allocate SFLV value memory\n");
             return false;
         }
         if (buffer_read(reader, sflv->value, sflv->length) != sflv->length) 
         {
-            fprintf(stderr, "Error: Failed to read SFLV value from buffer\n");
             free(sflv->value);
             sflv->value = NULL;
             return false;
@@ -482,8 +583,41 @@ bool read_sflv_from_buffer(BufferReader_t* reader, SFLV_t* sflv)
     {
         sflv->value = NULL;
     }
-    printf("SFLV_b: seq=%u, format=0x%02X, length=%u, dict_selector=%u\n", 
-            sflv->sequence, sflv->format, sflv->length, sflv->dict_selector);
+    return true;
+}
+
+bool read_sflv_header_from_buffer(BufferReader_t* reader, SFLV_t* sflv)
+{
+    if (!reader || !sflv) 
+    {
+        return false;
+    }
+
+    uint64_t sequence;
+    if (!read_nnint_from_buffer(reader, &sequence) || !split_sequence(sflv, sequence)) 
+    {
+        return false;
+    }
+
+    if (buffer_read(reader, &sflv->format, 1) != 1) 
+    {
+        return false;
+    }
+    sflv->format = (sflv->format >> 4) & 0x0F;
+
+    if (!read_nnint_from_buffer(reader, &sflv->length)) 
+    {
+        return false;
+    }
+
+    if (sflv->length > reader->size - reader->position) 
+    {
+        return false;
+    }
+
+    // The value stays in the caller's buffer: no allocation, no copy
+    sflv->value = sflv->length > 0 ? reader->data + reader->position : NULL;
+    reader->position += sflv->length;
     return true;
 }
 
@@ -504,530 +638,3177 @@ uint8_t get_msb4(uint8_t value)
     return (value >> 4) & 0x0F;
 }
 
-void write_indent(FILE* fp, int level)
+// ============================================================================
+// Allocator Functions
+// ============================================================================
+
+void* bej_alloc(const BejAllocator_t* allocator, size_t size)
 {
-    if (!fp) return;
-    
-    for (int i = 0; i < level; i++) 
-    {
-        fprintf(fp, "\t");
-    }
+    return allocator ? allocator->alloc(allocator->user, size) : malloc(size);
 }
 
-void write_json_string(FILE* fp, const char* str, uint32_t length)
+void* bej_realloc(const BejAllocator_t* allocator, void* memory, size_t size)
 {
-    if (!fp || !str) return;
-    
-    fprintf(fp, "\"");
-    for (uint32_t i = 0; i < length; i++) 
-    {
-        unsigned char c = str[i];
-        switch (c) 
-        {
-            case '"':  fprintf(fp, "\\\""); break;
-            case '\\': fprintf(fp, "\\\\"); break;
-            case '\b': fprintf(fp, "\\b"); break;
-            case '\f': fprintf(fp, "\\f"); break;
-            case '\n': fprintf(fp, "\\n"); break;
-            case '\r': fprintf(fp, "\\r"); break;
-            case '\t': fprintf(fp, "\\t"); break;
-            default:
-                if (c < 0x20) 
-                {
-                    fprintf(fp, "\\u%04x", c);
-                } 
-                else 
-                {
-                    fprintf(fp, "%c", c);
-                }
-                break;
-        }
-    }
-    fprintf(fp, "\"");
+    return allocator ? allocator->realloc(allocator->user, memory, size) : realloc(memory, size);
 }
 
-void init_decoder_context(DecoderContext_t* ctx, Dictionary_t* schema_dict,
-                         Dictionary_t* anno_dict, FILE* input, FILE* output)
+void bej_free(const BejAllocator_t* allocator, void* memory)
 {
-    if (!ctx) return;
-    
-    ctx->schema_dict = schema_dict;
-    ctx->anno_dict = anno_dict;
-    ctx->input_stream = input;
-    ctx->output_stream = output;
-    ctx->indent_level = 0;
+    if (!memory) return;
+
+    if (allocator) 
+    {
+        allocator->free(allocator->user, memory);
+    }
+    else 
+    {
+        free(memory);
+    }
 }
 
 // ============================================================================
-// Decode Functions - Specific Types
+// Arena Allocator
 // ============================================================================
 
-bool decode_integer(DecoderContext_t* ctx, SFLV_t* sflv)
+struct BejArenaBlock
+{
+    BejArenaBlock_t* next;
+    size_t capacity;
+    max_align_t data[];         // max_align_t elements keep the payload aligned for any type
+};
+
+void init_arena(BejArena_t* arena, size_t block_size)
+{
+    if (!arena) return;
+
+    arena->first = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+    arena->block_size = block_size ? block_size : BEJ_ARENA_BLOCK_SIZE;
+    arena->allocator = NULL;
+}
+
+void* arena_alloc(BejArena_t* arena, size_t size)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!arena) 
     {
-        return false;
+        return NULL;
     }
-    
-    int64_t int_value = 0;
-    
-    if (sflv->length > 0 && sflv->length <= 8) 
+
+    const size_t ALIGN = _Alignof(max_align_t);
+    size = size ? (size + ALIGN - 1) & ~(ALIGN - 1) : ALIGN;
+
+    // Blocks kept from earlier documents are tried in order; one too small for
+    // this request is passed over until the next reset
+    while (arena->current && arena->current->capacity - arena->used < size) 
     {
-        // Check if negative (MSB of last byte set)
-        bool is_negative = (sflv->value[sflv->length - 1] & 0x80) != 0;
-        
-        // Reconstruct integer (little-endian)
-        for (uint32_t i = 0; i < sflv->length; i++) 
+        arena->current = arena->current->next;
+        arena->used = 0;
+    }
+
+    if (!arena->current) 
+    {
+        size_t capacity = size > arena->block_size ? size : arena->block_size;
+        BejArenaBlock_t* block = (BejArenaBlock_t*)bej_alloc(arena->allocator, sizeof(BejArenaBlock_t) + capacity);
+        if (!block) 
         {
-            int_value |= ((int64_t)sflv->value[i]) << (i * 8);
+            return NULL;
         }
-        
-        // Sign extend if negative
-        if (is_negative && sflv->length < 8) 
+        block->next = NULL;
+        block->capacity = capacity;
+        if (arena->last) 
         {
-            // Create sign extension mask
-            uint64_t sign_mask = ~((1ULL << (sflv->length * 8)) - 1);
-            int_value |= (int64_t)sign_mask;
+            arena->last->next = block;
+        }
+        else 
+        {
+            arena->first = block;
         }
+        arena->last = block;
+        arena->current = block;
+        arena->used = 0;
     }
-    
-    fprintf(ctx->output_stream, "%lld", (long long)int_value);
-    return true;
+
+    void* memory = (uint8_t*)arena->current->data + arena->used;
+    arena->used += size;
+    return memory;
 }
 
-bool decode_string(DecoderContext_t* ctx, SFLV_t* sflv)
+void arena_reset(BejArena_t* arena)
+{
+    if (!arena) return;
+
+    arena->current = arena->first;
+    arena->used = 0;
+}
+
+void free_arena(BejArena_t* arena)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!arena) return;
+
+    BejArenaBlock_t* block = arena->first;
+    while (block) 
     {
-        return false;
+        BejArenaBlock_t* next = block->next;
+        bej_free(arena->allocator, block);
+        block = next;
     }
-    
-    if (sflv->value && sflv->length > 0) 
-    {
-        write_json_string(ctx->output_stream, (const char*)sflv->value, sflv->length);
-    } 
-    else 
+    arena->first = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+}
+
+// ============================================================================
+// Projection ($select)
+// ============================================================================
+
+/// Node of a projection being compiled; children are linked to their parent, not yet contiguous
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t parent;
+    bool whole;             // selected with everything below it
+} ProjectionDraft_t;
+
+/// Locate the entries directly below parent; false if it has none or the table is inconsistent
+static bool dictionary_children(const Dictionary_t* dict, const DictionaryEntry_t* parent,
+                                uint32_t* start, uint32_t* count)
+{
+    const uint32_t DICTIONARY_HEADER_SIZE = 12;
+    const uint32_t DICTIONARY_ENTRY_SIZE = 10;
+
+    if (parent->child_count == 0 || parent->child_pointer_offset < DICTIONARY_HEADER_SIZE) 
     {
-        fprintf(ctx->output_stream, "\"\"");
+        return false;
     }
-    
-    return true;
+    *start = (parent->child_pointer_offset - DICTIONARY_HEADER_SIZE) / DICTIONARY_ENTRY_SIZE;
+    *count = parent->child_count;
+    return *start + *count <= dict->entry_count;
 }
 
-bool decode_real(DecoderContext_t* ctx, SFLV_t* sflv)
+DictionaryEntry_t* find_dictionary_entry_by_name(Dictionary_t* dict, DictionaryEntry_t* parent,
+                                                 const char* name, size_t length)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!dict || !dict->entries || !parent || !name) 
     {
-        return false;
+        return NULL;
     }
-    
-    if (sflv->length == 4 && sflv->value) 
+
+    uint32_t start;
+    uint32_t count;
+    if (get_msb4(parent->format) == BEJ_FORMAT_ARRAY) 
     {
-        // 32-bit float
-        float f_value;
-        memcpy(&f_value, sflv->value, 4);
-        fprintf(ctx->output_stream, "%.7g", f_value);
-    } 
-    else if (sflv->length == 8 && sflv->value) 
+        if (!dictionary_children(dict, parent, &start, &count)) 
+        {
+            return NULL;
+        }
+        parent = &dict->entries[start];
+    }
+    // A SET's children are its properties, an ENUM's its options
+    uint8_t parent_format = get_msb4(parent->format);
+    if ((parent_format != BEJ_FORMAT_SET && parent_format != BEJ_FORMAT_ENUM) 
+        || !dictionary_children(dict, parent, &start, &count)) 
     {
-        // 64-bit double
-        double d_value;
-        memcpy(&d_value, sflv->value, 8);
-        fprintf(ctx->output_stream, "%.15g", d_value);
-    } 
-    else if (sflv->length == 1 && sflv->value) 
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) 
     {
-        // Some encodings use 1-byte REAL
-        fprintf(ctx->output_stream, "%u", (unsigned int)sflv->value[0]);
-    } 
-    else if (sflv->length == 2 && sflv->value) 
+        DictionaryEntry_t* entry = &dict->entries[start + i];
+        if (entry->name && strncmp(entry->name, name, length) == 0 && entry->name[length] == '\0') 
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/// Add the path at select (up to the next ',') to the drafts; returns the position after it
+static const char* draft_projection_path(Dictionary_t* dict, const char* select, ProjectionDraft_t* drafts,
+                                         uint32_t* draft_count, const BejDiagnostics_t* diagnostics)
+{
+    const char* path_end = select + strcspn(select, ",");
+    const char* segment = (*select == '/') ? select + 1 : select;   // leading slash is optional
+    DictionaryEntry_t* entry = &dict->entries[0];
+    uint32_t node = 0;
+
+    for (;;)
+    {
+        size_t length = 0;
+        while (segment + length < path_end && segment[length] != '/') 
+        {
+            length++;
+        }
+        bool has_properties = get_msb4(entry->format) != BEJ_FORMAT_ENUM;   // not enum options
+        entry = (length && has_properties) ? find_dictionary_entry_by_name(dict, entry, segment, length) : NULL;
+        if (!entry) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Unknown property '%.*s' in $select path '%.*s'",
+                         (int)length, segment, (int)(path_end - select), select);
+            return NULL;
+        }
+
+        uint32_t child = 1;
+        while (child < *draft_count 
+               && (drafts[child].parent != node || drafts[child].sequence != entry->sequence_number)) 
+        {
+            child++;
+        }
+        if (child == *draft_count) 
+        {
+            drafts[child].sequence = entry->sequence_number;
+            drafts[child].parent = node;
+            drafts[child].whole = false;
+            (*draft_count)++;
+        }
+        node = child;
+
+        segment += length;
+        if (segment == path_end) 
+        {
+            break;
+        }
+        segment++;      // past the '/'
+    }
+
+    drafts[node].whole = true;
+    return path_end;
+}
+
+BejProjection_t* bej_compile_projection(Dictionary_t* schema_dict, const char* select,
+                                        const BejAllocator_t* allocator, const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0 || !select) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    // Every segment adds at most one node, plus the root
+    size_t capacity = 2;
+    for (const char* c = select; *c; c++) 
+    {
+        capacity += (*c == ',' || *c == '/');
+    }
+    ProjectionDraft_t* drafts = (ProjectionDraft_t*)bej_alloc(allocator, capacity * sizeof(ProjectionDraft_t));
+    uint32_t* order = (uint32_t*)bej_alloc(allocator, capacity * sizeof(uint32_t));
+    BejProjection_t* projection = (BejProjection_t*)bej_alloc(allocator, sizeof(BejProjection_t));
+    BejProjectionNode_t* nodes = (BejProjectionNode_t*)bej_alloc(allocator, capacity * sizeof(BejProjectionNode_t));
+    bool ok = drafts && order && projection && nodes;
+    if (!ok) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate projection");
+    }
+
+    uint32_t draft_count = 1;
+    if (ok) 
+    {
+        drafts[0].sequence = 0;
+        drafts[0].parent = 0;
+        drafts[0].whole = false;
+        order[0] = 0;
+    }
+    for (const char* path = select; ok; path++) 
+    {
+        path = draft_projection_path(schema_dict, path, drafts, &draft_count, diagnostics);
+        ok = path != NULL;
+        if (!ok || *path == '\0') 
+        {
+            break;
+        }
+    }
+
+    // Breadth-first, so the children of every node are contiguous; nothing
+    // below a wholly selected node is kept
+    uint32_t node_count = 1;
+    for (uint32_t position = 0; ok && position < node_count; position++) 
+    {
+        const ProjectionDraft_t* draft = &drafts[order[position]];
+        BejProjectionNode_t* node = &nodes[position];
+        node->sequence = draft->sequence;
+        node->first_child = node_count;
+        node->child_count = 0;
+        for (uint32_t i = 1; i < draft_count && !draft->whole; i++) 
+        {
+            if (drafts[i].parent == order[position]) 
+            {
+                order[node_count++] = i;
+                node->child_count++;
+            }
+        }
+    }
+
+    bej_free(allocator, drafts);
+    bej_free(allocator, order);
+    if (!ok) 
+    {
+        bej_free(allocator, nodes);
+        bej_free(allocator, projection);
+        return NULL;
+    }
+    projection->nodes = nodes;
+    projection->node_count = node_count;
+    projection->allocator = allocator;
+    return projection;
+}
+
+void bej_free_projection(BejProjection_t* projection)
+{
+    if (!projection) return;
+
+    const BejAllocator_t* allocator = projection->allocator;
+    bej_free(allocator, projection->nodes);
+    bej_free(allocator, projection);
+}
+
+/// Whether a SET member passes node; *selected becomes the node filtering its own members (NULL: keep all)
+static bool projection_select(const BejProjection_t* projection, const BejProjectionNode_t* node,
+                              const SFLV_t* member, const BejProjectionNode_t** selected)
+{
+    // As with Redfish $select, annotations such as @odata.id stay with a selected object
+    if (member->dict_selector) 
+    {
+        *selected = NULL;
+        return true;
+    }
+
+    const BejProjectionNode_t* children = &projection->nodes[node->first_child];
+    for (uint32_t i = 0; i < node->child_count; i++) 
+    {
+        if (children[i].sequence == member->sequence) 
+        {
+            *selected = children[i].child_count ? &children[i] : NULL;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Output Sink Functions
+// ============================================================================
+
+/// True when the context has somewhere to send output
+static bool has_output(DecoderContext_t* ctx)
+{
+    return ctx->output_sink != BEJ_SINK_STREAM || ctx->output_stream != NULL;
+}
+
+/// Count a request for `size` bytes made on behalf of the current document
+static void stats_acquire(BejDecodeStats_t* stats, uint64_t size)
+{
+    stats->allocations++;
+    stats->bytes_allocated += size;
+    stats->live_bytes += size;
+    if (stats->live_bytes > stats->peak_live_bytes) 
+    {
+        stats->peak_live_bytes = stats->live_bytes;
+    }
+}
+
+/// Count `size` bytes given back
+static void stats_release(BejDecodeStats_t* stats, uint64_t size)
+{
+    // Buffers handed in by the caller were never acquired
+    stats->live_bytes -= size < stats->live_bytes ? size : stats->live_bytes;
+}
+
+/// Start the statistics of a new document
+static void reset_stats(DecoderContext_t* ctx)
+{
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    ctx->depth = 0;
+}
+
+/// Make room for `length` more bytes in a buffer sink, doubling its capacity
+static bool reserve_output(DecoderContext_t* ctx, size_t length)
+{
+    size_t needed = ctx->output_length + length;
+    if (needed <= ctx->output_capacity) 
+    {
+        return true;
+    }
+
+    size_t capacity = ctx->output_capacity ? ctx->output_capacity : 256;
+    while (capacity < needed) 
+    {
+        capacity *= 2;
+    }
+
+    uint8_t* grown = (uint8_t*)bej_realloc(ctx->allocator, ctx->output_buffer, capacity);
+    if (!grown) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to grow output buffer to %zu bytes",
+                     capacity);
+        ctx->output_failed = true;
+        return false;
+    }
+    stats_acquire(&ctx->stats, capacity);
+    stats_release(&ctx->stats, ctx->output_capacity);
+    ctx->output_buffer = grown;
+    ctx->output_capacity = capacity;
+    return true;
+}
+
+static void out_write(DecoderContext_t* ctx, const void* data, size_t length)
+{
+    switch (ctx->output_sink) 
+    {
+        case BEJ_SINK_STREAM:
+            if (fwrite(data, 1, length, ctx->output_stream) != length) 
+            {
+                ctx->output_failed = true;
+            }
+            break;
+
+        case BEJ_SINK_BUFFER:
+            if (!reserve_output(ctx, length)) 
+            {
+                return;
+            }
+            memcpy(ctx->output_buffer + ctx->output_length, data, length);
+            break;
+
+        case BEJ_SINK_MEASURE:
+            break;
+    }
+    ctx->output_length += length;
+}
+
+static void out_putc(DecoderContext_t* ctx, char c)
+{
+    out_write(ctx, &c, 1);
+}
+
+static void out_puts(DecoderContext_t* ctx, const char* str)
+{
+    out_write(ctx, str, strlen(str));
+}
+
+/// Formatted output; only used for numbers, which always fit the scratch buffer
+static void out_printf(DecoderContext_t* ctx, const char* format, ...)
+{
+    char text[64];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (length > 0) 
+    {
+        out_write(ctx, text, (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1);
+    }
+}
+
+/// Number of decimal digits in value
+static size_t decimal_digits(uint64_t value)
+{
+    size_t digits = 1;
+    while (value >= 10) 
+    {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+/// Decimal integer; the sizing pass only counts its digits
+static void out_integer(DecoderContext_t* ctx, int64_t value)
+{
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t length = decimal_digits(magnitude) + (value < 0 ? 1 : 0);
+    if (ctx->output_sink == BEJ_SINK_MEASURE) 
+    {
+        ctx->output_length += length;
+        return;
+    }
+
+    char text[24];
+    char* digit = text + length;
+    do 
+    {
+        *--digit = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) 
+    {
+        text[0] = '-';
+    }
+    out_write(ctx, text, length);
+}
+
+/// Line break for pretty-printed JSON; compact output stays on one line
+static void emit_newline(DecoderContext_t* ctx)
+{
+    if (!ctx->compact) 
+    {
+        out_putc(ctx, '\n');
+    }
+}
+
+static void emit_indent(DecoderContext_t* ctx, int level)
+{
+    static const char TABS[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+    if (ctx->compact) 
+    {
+        return;
+    }
+
+    while (level > 0) 
+    {
+        int count = level < (int)sizeof(TABS) - 1 ? level : (int)sizeof(TABS) - 1;
+        out_write(ctx, TABS, (size_t)count);
+        level -= count;
+    }
+}
+
+static void emit_json_string(DecoderContext_t* ctx, const char* str, size_t length)
+{
+    out_putc(ctx, '"');
+
+    // Copy runs of characters that need no escaping in one write
+    size_t run_start = 0;
+    for (size_t i = 0; i < length; i++) 
+    {
+        unsigned char c = str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') 
+        {
+            continue;
+        }
+
+        out_write(ctx, str + run_start, i - run_start);
+        run_start = i + 1;
+
+        switch (c) 
+        {
+            case '"':  out_puts(ctx, "\\\""); break;
+            case '\\': out_puts(ctx, "\\\\"); break;
+            case '\b': out_puts(ctx, "\\b"); break;
+            case '\f': out_puts(ctx, "\\f"); break;
+            case '\n': out_puts(ctx, "\\n"); break;
+            case '\r': out_puts(ctx, "\\r"); break;
+            case '\t': out_puts(ctx, "\\t"); break;
+            default:
+            {
+                static const char HEX[] = "0123456789abcdef";
+                const char escape[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0x0F]};
+                out_write(ctx, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    out_write(ctx, str + run_start, length - run_start);
+
+    out_putc(ctx, '"');
+}
+
+void write_indent(FILE* fp, int level)
+{
+    if (!fp) return;
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, NULL, NULL, NULL, fp);
+    emit_indent(&ctx, level);
+}
+
+void write_json_string(FILE* fp, const char* str, size_t length)
+{
+    if (!fp || !str) return;
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, NULL, NULL, NULL, fp);
+    emit_json_string(&ctx, str, length);
+}
+
+static const char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t base64_encode_scalar(const uint8_t* src, size_t length, char* dst)
+{
+    char* out = dst;
+    size_t i = 0;
+
+    for (; i + 3 <= length; i += 3) 
+    {
+        uint32_t triple = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        out[2] = BASE64_ALPHABET[(triple >> 6) & 0x3F];
+        out[3] = BASE64_ALPHABET[triple & 0x3F];
+        out += 4;
+    }
+
+    // Pad the trailing 1 or 2 bytes (RFC 4648, section 4)
+    if (i < length) 
+    {
+        uint32_t triple = (uint32_t)src[i] << 16;
+        if (i + 1 < length) 
+        {
+            triple |= (uint32_t)src[i + 1] << 8;
+        }
+        out[0] = BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        out[1] = BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        out[2] = (i + 1 < length) ? BASE64_ALPHABET[(triple >> 6) & 0x3F] : '=';
+        out[3] = '=';
+        out += 4;
+    }
+
+    return (size_t)(out - dst);
+}
+
+#ifdef BEJ_HAVE_SSSE3_BASE64
+/*
+ * Encodes 12 input bytes into 16 output characters per iteration: a byte shuffle
+ * spreads each 3-byte group over a 32-bit lane, two multiplies move the 6-bit fields
+ * into separate bytes and a pshufb lookup translates them to the alphabet.
+ * Loads are 16 bytes wide, so the loop stops while 16 input bytes remain and
+ * returns the number of input bytes consumed; the scalar encoder finishes the tail.
+ */
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(const uint8_t* src, size_t length, char* dst)
+{
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t consumed = 0;
+
+    while (length - consumed >= 16) 
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + consumed));
+        in = _mm_shuffle_epi8(in, shuffle);
+
+        const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        offsets = _mm_or_si128(offsets, _mm_and_si128(less, _mm_set1_epi8(13)));
+        offsets = _mm_shuffle_epi8(shift_lut, offsets);
+
+        _mm_storeu_si128((__m128i*)dst, _mm_add_epi8(offsets, indices));
+        dst += 16;
+        consumed += 12;
+    }
+
+    return consumed;
+}
+#endif
+
+size_t base64_encode(const uint8_t* src, size_t length, char* dst)
+{
+    if (!src || !dst) return 0;
+
+    size_t consumed = 0;
+    size_t written = 0;
+
+#ifdef BEJ_HAVE_SSSE3_BASE64
+    if (length >= 16 && __builtin_cpu_supports("ssse3")) 
+    {
+        consumed = base64_encode_ssse3(src, length, dst);
+        written = (consumed / 3) * 4;
+    }
+#endif
+
+    return written + base64_encode_scalar(src + consumed, length - consumed, dst + written);
+}
+
+static void emit_base64_string(DecoderContext_t* ctx, const uint8_t* data, size_t length)
+{
+    // Encode in 3 KiB slices so large blobs never need a full-size temporary
+    enum { BASE64_CHUNK_INPUT = 3072 };
+    char chunk[BASE64_CHUNK_INPUT / 3 * 4];
+
+    out_putc(ctx, '"');
+    for (size_t offset = 0; data && offset < length; offset += BASE64_CHUNK_INPUT) 
+    {
+        size_t count = length - offset;
+        if (count > BASE64_CHUNK_INPUT) 
+        {
+            count = BASE64_CHUNK_INPUT;
+        }
+        if (ctx->output_sink == BEJ_SINK_MEASURE) 
+        {
+            // Size is known without encoding anything
+            ctx->output_length += (count + 2) / 3 * 4;
+            continue;
+        }
+        out_write(ctx, chunk, base64_encode(data + offset, count, chunk));
+    }
+    out_putc(ctx, '"');
+}
+
+void write_base64_string(FILE* fp, const uint8_t* data, size_t length)
+{
+    if (!fp) return;
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, NULL, NULL, NULL, fp);
+    emit_base64_string(&ctx, data, length);
+}
+
+void init_decoder_context(DecoderContext_t* ctx, Dictionary_t* schema_dict,
+                         Dictionary_t* anno_dict, FILE* input, FILE* output)
+{
+    if (!ctx) return;
+    
+    ctx->schema_dict = schema_dict;
+    ctx->anno_dict = anno_dict;
+    ctx->input_stream = input;
+    ctx->output_stream = output;
+    ctx->output_format = BEJ_OUTPUT_JSON;
+    ctx->output_sink = BEJ_SINK_STREAM;
+    ctx->output_buffer = NULL;
+    ctx->output_capacity = 0;
+    ctx->output_length = 0;
+    ctx->output_failed = false;
+    ctx->compact = false;
+    ctx->parallel_threads = 0;
+    ctx->parallel_min_members = BEJ_PARALLEL_MIN_MEMBERS;
+    init_diagnostics(&ctx->diagnostics);
+    ctx->arena = NULL;
+    ctx->allocator = NULL;
+    ctx->max_value_length = 0;
+    ctx->projection = NULL;
+    ctx->projection_node = NULL;
+    reset_stats(ctx);
+    ctx->indent_level = 0;
+}
+
+void set_output_buffer(DecoderContext_t* ctx, uint8_t* buffer, size_t capacity)
+{
+    if (!ctx) return;
+
+    ctx->output_sink = BEJ_SINK_BUFFER;
+    ctx->output_buffer = buffer;
+    ctx->output_capacity = buffer ? capacity : 0;
+    ctx->output_length = 0;
+    ctx->output_failed = false;
+}
+
+/// Transient allocation: bumped from the context's arena when it has one, else from its allocator
+static void* ctx_alloc(DecoderContext_t* ctx, size_t size)
+{
+    stats_acquire(&ctx->stats, size);
+    return ctx->arena ? arena_alloc(ctx->arena, size) : bej_alloc(ctx->allocator, size);
+}
+
+/// Grow a ctx_alloc() block; the old arena copy is reclaimed by the next reset
+static void* ctx_grow(DecoderContext_t* ctx, void* memory, size_t old_size, size_t new_size)
+{
+    stats_acquire(&ctx->stats, new_size);
+    stats_release(&ctx->stats, old_size);
+    if (!ctx->arena) 
+    {
+        return bej_realloc(ctx->allocator, memory, new_size);
+    }
+
+    void* grown = arena_alloc(ctx->arena, new_size);
+    if (grown && old_size > 0) 
+    {
+        memcpy(grown, memory, old_size);
+    }
+    return grown;
+}
+
+/// Release a ctx_alloc() block of `size` bytes; a no-op for arena memory
+static void ctx_free(DecoderContext_t* ctx, void* memory, size_t size)
+{
+    if (memory) 
+    {
+        stats_release(&ctx->stats, size);
+    }
+    if (!ctx->arena) 
+    {
+        bej_free(ctx->allocator, memory);
+    }
+}
+
+/// Resolve a SET member against the dictionary its selector bit points at
+static DictionaryEntry_t* find_child_entry(DecoderContext_t* ctx, DictionaryEntry_t* parent, SFLV_t* child)
+{
+    return find_member_entry(ctx->schema_dict, ctx->anno_dict, parent, child);
+}
+
+/// Sign-extend a little-endian BEJ INTEGER value (5.3.10)
+static int64_t integer_from_sflv(const SFLV_t* sflv)
+{
+    int64_t int_value = 0;
+    
+    if (sflv->length > 0 && sflv->length <= 8) 
+    {
+        // Check if negative (MSB of last byte set)
+        bool is_negative = (sflv->value[sflv->length - 1] & 0x80) != 0;
+        
+        // Reconstruct integer (little-endian)
+        for (uint32_t i = 0; i < sflv->length; i++) 
+        {
+            int_value |= ((int64_t)sflv->value[i]) << (i * 8);
+        }
+        
+        // Sign extend if negative
+        if (is_negative && sflv->length < 8) 
+        {
+            // Create sign extension mask
+            uint64_t sign_mask = ~((1ULL << (sflv->length * 8)) - 1);
+            int_value |= (int64_t)sign_mask;
+        }
+    }
+    return int_value;
+}
+
+/// Length of a BEJ STRING without the NUL terminator it carries (5.3.13)
+static uint64_t string_length_from_sflv(const SFLV_t* sflv)
+{
+    if (!sflv->value || sflv->length == 0) 
+    {
+        return 0;
+    }
+    return sflv->value[sflv->length - 1] == '\0' ? sflv->length - 1 : sflv->length;
+}
+
+/// Numeric value of a BEJ REAL as decode_real() reads it; false for an unsupported length
+static bool real_from_sflv(const SFLV_t* sflv, double* real)
+{
+    if (!sflv->value) 
+    {
+        return false;
+    }
+    switch (sflv->length) 
+    {
+        case 4:
+        {
+            float f_value;
+            memcpy(&f_value, sflv->value, 4);
+            *real = f_value;
+            return true;
+        }
+        case 8:
+            memcpy(real, sflv->value, 8);
+            return true;
+        case 1:
+            *real = sflv->value[0];
+            return true;
+        case 2:
+            *real = (uint16_t)(sflv->value[0] | (sflv->value[1] << 8));
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Option sequence number of a BEJ ENUM (5.3.12); an empty value is option 0
+static bool enum_sequence_from_sflv(const SFLV_t* sflv, uint32_t* sequence)
+{
+    *sequence = 0;
+    if (sflv->length == 0 || !sflv->value) 
+    {
+        return true;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv->value, sflv->length);
+
+    // Dictionary sequence numbers are at most 32 bits wide
+    uint64_t encoded;
+    if (!read_nnint_from_buffer(&reader, &encoded) || encoded > UINT32_MAX) 
+    {
+        return false;
+    }
+    *sequence = (uint32_t)encoded;
+    return true;
+}
+
+// ============================================================================
+// Decode Functions - Specific Types
+// ============================================================================
+
+bool decode_integer(DecoderContext_t* ctx, SFLV_t* sflv)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    int64_t int_value = integer_from_sflv(sflv);
+    
+    out_integer(ctx, int_value);
+    return true;
+}
+
+bool decode_string(DecoderContext_t* ctx, SFLV_t* sflv)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    uint64_t length = string_length_from_sflv(sflv);
+    if (length > 0) 
+    {
+        emit_json_string(ctx, (const char*)sflv->value, length);
+    } 
+    else 
+    {
+        out_puts(ctx, "\"\"");
+    }
+    
+    return true;
+}
+
+bool decode_byte_string(DecoderContext_t* ctx, SFLV_t* sflv)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+
+    // JSON has no binary type; byte strings are rendered as base64 text
+    emit_base64_string(ctx, sflv->value, sflv->length);
+    return true;
+}
+
+bool decode_real(DecoderContext_t* ctx, SFLV_t* sflv)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    if (sflv->length == 4 && sflv->value) 
+    {
+        // 32-bit float
+        float f_value;
+        memcpy(&f_value, sflv->value, 4);
+        out_printf(ctx, "%.7g", f_value);
+    } 
+    else if (sflv->length == 8 && sflv->value) 
+    {
+        // 64-bit double
+        double d_value;
+        memcpy(&d_value, sflv->value, 8);
+        out_printf(ctx, "%.15g", d_value);
+    } 
+    else if (sflv->length == 1 && sflv->value) 
+    {
+        // Some encodings use 1-byte REAL
+        out_integer(ctx, sflv->value[0]);
+    } 
+    else if (sflv->length == 2 && sflv->value) 
+    {
+        // 2-byte value - could be half-precision float
+        uint16_t val = sflv->value[0] | (sflv->value[1] << 8);
+        out_integer(ctx, val);
+    } 
+    else 
+    {
+        // Unknown length - output null
+        out_puts(ctx, "null");
+    }
+    
+    return true;
+}
+
+bool decode_boolean(DecoderContext_t* ctx, SFLV_t* sflv)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    bool value = false;
+    if (sflv->length > 0 && sflv->value) 
+    {
+        value = (sflv->value[0] != 0);
+    }
+    
+    out_puts(ctx, value ? "true" : "false");
+    return true;
+}
+
+bool decode_enum(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    // Enum value is encoded as nnint - the sequence number for the enumeration option (5.3.12)
+    uint32_t enum_sequence;
+    if (!enum_sequence_from_sflv(sflv, &enum_sequence)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read enum sequence");
+        out_puts(ctx, "null");
+        return false;
+    }
+    
+    // Look up the enum option name from the dictionary
+    // Use the appropriate dictionary based on dict_selector
+    DictionaryEntry_t* enum_entry = NULL;
+    if (sflv->dict_selector == 0) 
+    {
+        enum_entry = find_dictionary_entry(ctx->schema_dict, entry, enum_sequence, -1);
+    } 
+    else if (sflv->dict_selector == 1) 
+    {
+        enum_entry = find_dictionary_entry(ctx->anno_dict, entry, enum_sequence, -1);
+    }
+
+    if (enum_entry && enum_entry->name) 
+    {
+        emit_json_string(ctx, enum_entry->name, strlen(enum_entry->name));
+    } 
+    else 
+    {
+        out_putc(ctx, '"');
+        out_integer(ctx, enum_sequence);
+        out_putc(ctx, '"');
+    }
+    
+    return true;
+}
+
+bool decode_null(DecoderContext_t* ctx)
+{
+    if (!ctx || !has_output(ctx)) 
+    {
+        return false;
+    }
+    
+    out_puts(ctx, "null");
+    return true;
+}
+
+// ============================================================================
+// Container Member Functions
+// ============================================================================
+
+static void emit_text(DecoderContext_t* ctx, const char* str, size_t length);
+static bool decode_members_parallel(DecoderContext_t* ctx, BufferReader_t* reader, DictionaryEntry_t* entry,
+                                    uint8_t container_format, uint64_t* member_count);
+
+/// Separator written between two members of a SET or ARRAY
+static void emit_member_separator(DecoderContext_t* ctx, uint8_t container_format)
+{
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        return;
+    }
+
+    if (container_format == BEJ_FORMAT_SET) 
+    {
+        out_putc(ctx, ',');
+        emit_newline(ctx);
+    }
+    else 
+    {
+        out_puts(ctx, ctx->compact ? "," : ", ");
+    }
+}
+
+/// Write one member: SET members get their property name, ARRAY elements share the array's entry
+static bool emit_member(DecoderContext_t* ctx, SFLV_t* member, DictionaryEntry_t* entry, uint8_t container_format)
+{
+    if (container_format != BEJ_FORMAT_SET) 
+    {
+        return decode_value(ctx, member, entry);
+    }
+
+    DictionaryEntry_t* child_entry = find_child_entry(ctx, entry, member);
+
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        if (child_entry && child_entry->name) 
+        {
+            emit_text(ctx, child_entry->name, strlen(child_entry->name));
+        }
+        else 
+        {
+            char key[24];
+            int key_length = snprintf(key, sizeof(key), "seq_%u", member->sequence);
+            emit_text(ctx, key, (size_t)key_length);
+        }
+        return decode_value(ctx, member, child_entry);
+    }
+
+    emit_indent(ctx, ctx->indent_level);
+    
+    // Write property name
+    if (child_entry && child_entry->name) 
+    {
+        emit_json_string(ctx, child_entry->name, strlen(child_entry->name));
+        out_putc(ctx, ':');
+    }
+    else 
+    {
+        out_puts(ctx, "\"seq_");
+        out_integer(ctx, member->sequence);
+        out_puts(ctx, "\":");
+    }
+    
+    if (!ctx->compact) 
+    {
+        out_putc(ctx, ' ');
+    }
+    
+    return decode_value(ctx, member, child_entry);
+}
+
+/// Write every member left in reader; large containers are split across worker threads
+static bool decode_members(DecoderContext_t* ctx, BufferReader_t* reader, DictionaryEntry_t* entry,
+                           uint8_t container_format, uint64_t declared_count, uint64_t* member_count)
+{
+    // Members below a projection carry their own filters, so they stay serial
+    const BejProjectionNode_t* node = ctx->projection_node;
+    bool projected = node && container_format == BEJ_FORMAT_SET;
+    // Counting bytes is cheaper than spawning workers, so the sizing pass stays serial too
+    if (ctx->parallel_threads > 1 && declared_count >= ctx->parallel_min_members && !node
+        && ctx->output_sink != BEJ_SINK_MEASURE) 
+    {
+        return decode_members_parallel(ctx, reader, entry, container_format, member_count);
+    }
+
+    uint64_t count = 0;
+    while (!buffer_eof(reader)) 
+    {
+        // Members are decoded in place: the value stays in the parent's buffer
+        SFLV_t child_sflv;
+        if (!read_sflv_header_from_buffer(reader, &child_sflv)) 
+        {
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read member %llu tuple", (unsigned long long)count);
+            return false;
+        }
+
+        // Unselected members are already skipped: the header read moved past their value
+        const BejProjectionNode_t* selected = node;
+        if (projected && !projection_select(ctx->projection, node, &child_sflv, &selected)) 
+        {
+            continue;
+        }
+
+        if (count > 0) 
+        {
+            emit_member_separator(ctx, container_format);
+        }
+
+        ctx->projection_node = selected;
+        bool ok = emit_member(ctx, &child_sflv, entry, container_format);
+        ctx->projection_node = node;
+        if (!ok) 
+        {
+            return false;
+        }
+        count++;
+    }
+    *member_count = count;
+    return true;
+}
+
+/// Number of members a projected SET keeps, counted from the tuple headers alone
+static bool count_selected_members(DecoderContext_t* ctx, const BufferReader_t* members, uint64_t* count)
+{
+    BufferReader_t reader = *members;
+    const BejProjectionNode_t* selected;
+    *count = 0;
+    while (!buffer_eof(&reader)) 
+    {
+        SFLV_t member;
+        if (!read_sflv_header_from_buffer(&reader, &member)) 
+        {
+            return false;
+        }
+        *count += projection_select(ctx->projection, ctx->projection_node, &member, &selected);
+    }
+    return true;
+}
+
+bool decode_set(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    out_putc(ctx, '{');
+    
+    if (sflv->length > 0 && sflv->value) 
+    {
+        BufferReader_t reader;
+        init_buffer_reader(&reader, sflv->value, sflv->length);
+        
+        emit_newline(ctx);
+        ctx->indent_level++;
+
+        uint64_t set_length;
+        if (!read_nnint_from_buffer(&reader, &set_length)) 
+        {
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read SET length");
+            return false;
+        }
+
+        uint64_t member_count;
+        if (!decode_members(ctx, &reader, entry, BEJ_FORMAT_SET, set_length, &member_count)) 
+        {
+            return false;
+        }
+        ctx->indent_level--;
+        emit_newline(ctx);
+        emit_indent(ctx, ctx->indent_level);
+    }
+    out_putc(ctx, '}');
+    return true;
+}
+
+bool decode_array(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+    
+    out_putc(ctx, '[');
+    
+    if (sflv->length > 0 && sflv->value) 
+    {
+        BufferReader_t reader;
+        init_buffer_reader(&reader, sflv->value, sflv->length);
+                
+        uint64_t array_length;
+        if (!read_nnint_from_buffer(&reader, &array_length)) 
+        {
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read ARRAY length");
+            return false;
+        }
+
+        uint64_t member_count;
+        if (!decode_members(ctx, &reader, entry, BEJ_FORMAT_ARRAY, array_length, &member_count)) 
+        {
+            return false;
+        }
+    }
+
+    out_putc(ctx, ']');
+    return true;
+}
+
+// ============================================================================
+// Main Decode Value Function
+// ============================================================================
+
+/// Write one value in the context's output format
+static bool dispatch_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        return transcode_value(ctx, sflv, entry);
+    }
+    
+    switch (sflv->format) 
+    {
+        case BEJ_FORMAT_SET:
+            return decode_set(ctx, sflv, entry);
+            
+        case BEJ_FORMAT_ARRAY:
+            return decode_array(ctx, sflv, entry);
+            
+        case BEJ_FORMAT_NULL:
+            return decode_null(ctx);
+
+        case BEJ_FORMAT_INTEGER: // check it
+            return decode_integer(ctx, sflv);
+            
+        case BEJ_FORMAT_ENUM:
+            return decode_enum(ctx, sflv, entry);
+            
+        case BEJ_FORMAT_STRING:
+            return decode_string(ctx, sflv);
+            
+        case BEJ_FORMAT_REAL: // check it
+            return decode_real(ctx, sflv);
+            
+        case BEJ_FORMAT_BOOLEAN:
+            return decode_boolean(ctx, sflv);
+                     
+        case BEJ_FORMAT_BYTE_STRING:
+            return decode_byte_string(ctx, sflv);
+            
+        case BEJ_FORMAT_CHOICE:
+        case BEJ_FORMAT_PROPERTY_ANNOTATION:
+        case BEJ_FORMAT_REGISTRY_ITEM:
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_WARNING, "Format type 0x%02X not fully implemented",
+                         sflv->format);
+            out_puts(ctx, "null");
+            return true;
+            
+        default:
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Unknown format type 0x%02X", sflv->format);
+            out_puts(ctx, "null");
+            return false;
+    }
+}
+
+bool decode_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (!ctx || !sflv) 
+    {
+        return false;
+    }
+
+    // The sizing pass walks the same tuples; trace them only once
+    if (ctx->output_sink != BEJ_SINK_MEASURE) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_TRACE, "SFLV: seq=%u, format=0x%02X, length=%llu, dict_selector=%u",
+                     sflv->sequence, sflv->format, (unsigned long long)sflv->length, sflv->dict_selector);
+    }
+
+    bool is_container = sflv->format == BEJ_FORMAT_SET || sflv->format == BEJ_FORMAT_ARRAY;
+    if (!is_container) 
+    {
+        if (sflv->length > ctx->stats.largest_value) 
+        {
+            ctx->stats.largest_value = sflv->length;
+        }
+        return dispatch_value(ctx, sflv, entry);
+    }
+
+    if (++ctx->depth > ctx->stats.max_depth) 
+    {
+        ctx->stats.max_depth = ctx->depth;
+    }
+    bool ok = dispatch_value(ctx, sflv, entry);
+    ctx->depth--;
+    return ok;
+}
+
+// ============================================================================
+// Binary Transcoders (CBOR / MessagePack)
+// ============================================================================
+
+/// Write the low `count` bytes of value in network (big-endian) order
+static void write_be(DecoderContext_t* ctx, uint64_t value, int count)
+{
+    uint8_t bytes[8];
+    for (int i = 0; i < count; i++) 
+    {
+        bytes[i] = (uint8_t)(value >> (8 * (count - 1 - i)));
+    }
+    out_write(ctx, bytes, (size_t)count);
+}
+
+/// CBOR initial byte plus argument in the shortest form (RFC 8949, 3.1)
+static void write_cbor_head(DecoderContext_t* ctx, uint8_t major, uint64_t value)
+{
+    major <<= 5;
+    if (value < 24) 
+    {
+        out_putc(ctx, (char)(major | (uint8_t)value));
+    }
+    else if (value <= 0xFF) 
+    {
+        out_putc(ctx, (char)(major | 24));
+        write_be(ctx, value, 1);
+    }
+    else if (value <= 0xFFFF) 
+    {
+        out_putc(ctx, (char)(major | 25));
+        write_be(ctx, value, 2);
+    }
+    else if (value <= 0xFFFFFFFFULL) 
+    {
+        out_putc(ctx, (char)(major | 26));
+        write_be(ctx, value, 4);
+    }
+    else 
+    {
+        out_putc(ctx, (char)(major | 27));
+        write_be(ctx, value, 8);
+    }
+}
+
+/// MessagePack header for str/bin/array/map; fix_base is 0 when there is no fix form
+static void write_msgpack_head(DecoderContext_t* ctx, uint64_t count, uint8_t fix_base, uint32_t fix_limit,
+                               uint8_t tag8, uint8_t tag16, uint8_t tag32)
+{
+    // MessagePack has no 64-bit lengths (unlike CBOR)
+    if (count > UINT32_MAX) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Length %llu does not fit MessagePack",
+                     (unsigned long long)count);
+        ctx->output_failed = true;
+        return;
+    }
+
+    if (fix_base && count < fix_limit) 
+    {
+        out_putc(ctx, (char)(fix_base | (uint8_t)count));
+    }
+    else if (tag8 && count <= 0xFF) 
+    {
+        out_putc(ctx, (char)(tag8));
+        write_be(ctx, count, 1);
+    }
+    else if (count <= 0xFFFF) 
+    {
+        out_putc(ctx, (char)(tag16));
+        write_be(ctx, count, 2);
+    }
+    else 
+    {
+        out_putc(ctx, (char)(tag32));
+        write_be(ctx, count, 4);
+    }
+}
+
+static void emit_map_header(DecoderContext_t* ctx, uint64_t count)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        write_cbor_head(ctx, 5, count);
+    }
+    else 
+    {
+        write_msgpack_head(ctx, count, 0x80, 16, 0, 0xDE, 0xDF);
+    }
+}
+
+static void emit_array_header(DecoderContext_t* ctx, uint64_t count)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        write_cbor_head(ctx, 4, count);
+    }
+    else 
+    {
+        write_msgpack_head(ctx, count, 0x90, 16, 0, 0xDC, 0xDD);
+    }
+}
+
+static void emit_text(DecoderContext_t* ctx, const char* str, size_t length)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        write_cbor_head(ctx, 3, length);
+    }
+    else 
+    {
+        write_msgpack_head(ctx, length, 0xA0, 32, 0xD9, 0xDA, 0xDB);
+    }
+    if (length > 0) 
+    {
+        out_write(ctx, str, length);
+    }
+}
+
+static void emit_bytes(DecoderContext_t* ctx, const uint8_t* data, size_t length)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        write_cbor_head(ctx, 2, length);
+    }
+    else 
+    {
+        write_msgpack_head(ctx, length, 0, 0, 0xC4, 0xC5, 0xC6);
+    }
+    if (length > 0) 
+    {
+        out_write(ctx, data, length);
+    }
+}
+
+static void emit_integer(DecoderContext_t* ctx, int64_t value)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        if (value >= 0) 
+        {
+            write_cbor_head(ctx, 0, (uint64_t)value);
+        }
+        else 
+        {
+            // Major type 1 carries -1 - n
+            write_cbor_head(ctx, 1, (uint64_t)(-1 - value));
+        }
+        return;
+    }
+
+    if (value >= 0 && value < 128) 
+    {
+        out_putc(ctx, (char)((uint8_t)value));
+    }
+    else if (value < 0 && value >= -32) 
+    {
+        out_putc(ctx, (char)((uint8_t)(int8_t)value));
+    }
+    else if (value >= INT8_MIN && value <= INT8_MAX) 
+    {
+        out_putc(ctx, (char)(0xD0));
+        write_be(ctx, (uint64_t)value, 1);
+    }
+    else if (value >= INT16_MIN && value <= INT16_MAX) 
+    {
+        out_putc(ctx, (char)(0xD1));
+        write_be(ctx, (uint64_t)value, 2);
+    }
+    else if (value >= INT32_MIN && value <= INT32_MAX) 
+    {
+        out_putc(ctx, (char)(0xD2));
+        write_be(ctx, (uint64_t)value, 4);
+    }
+    else 
+    {
+        out_putc(ctx, (char)(0xD3));
+        write_be(ctx, (uint64_t)value, 8);
+    }
+}
+
+static void emit_float(DecoderContext_t* ctx, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    out_putc(ctx, (char)(ctx->output_format == BEJ_OUTPUT_CBOR ? 0xFA : 0xCA));
+    write_be(ctx, bits, 4);
+}
+
+static void emit_double(DecoderContext_t* ctx, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    out_putc(ctx, (char)(ctx->output_format == BEJ_OUTPUT_CBOR ? 0xFB : 0xCB));
+    write_be(ctx, bits, 8);
+}
+
+static void emit_boolean(DecoderContext_t* ctx, bool value)
+{
+    if (ctx->output_format == BEJ_OUTPUT_CBOR) 
+    {
+        out_putc(ctx, (char)(value ? 0xF5 : 0xF4));
+    }
+    else 
+    {
+        out_putc(ctx, (char)(value ? 0xC3 : 0xC2));
+    }
+}
+
+static void emit_null(DecoderContext_t* ctx)
+{
+    out_putc(ctx, (char)(ctx->output_format == BEJ_OUTPUT_CBOR ? 0xF6 : 0xC0));
+}
+
+/// Transcode the children of a SET or ARRAY; SET members are written as key/value pairs
+static bool transcode_container(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry, bool is_set)
+{
+    if (sflv->length == 0 || !sflv->value) 
+    {
+        if (is_set) 
+        {
+            emit_map_header(ctx, 0);
+        }
+        else 
+        {
+            emit_array_header(ctx, 0);
+        }
+        return true;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv->value, sflv->length);
+
+    // Both target formats are length-prefixed, so the BEJ member count goes first
+    uint64_t count;
+    if (!read_nnint_from_buffer(&reader, &count)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read %s length", is_set ? "SET" : "ARRAY");
+        return false;
+    }
+    if (is_set && ctx->projection_node && !count_selected_members(ctx, &reader, &count)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read SET members");
+        return false;
+    }
+
+    if (is_set) 
+    {
+        emit_map_header(ctx, count);
+    }
+    else 
+    {
+        emit_array_header(ctx, count);
+    }
+
+    uint64_t written;
+    if (!decode_members(ctx, &reader, entry, is_set ? BEJ_FORMAT_SET : BEJ_FORMAT_ARRAY, count, &written)) 
+    {
+        return false;
+    }
+
+    if (written != count) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "%s declares %llu members but holds %llu",
+                     is_set ? "SET" : "ARRAY", (unsigned long long)count, (unsigned long long)written);
+        return false;
+    }
+    return true;
+}
+
+bool transcode_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+{
+    if (!ctx || !has_output(ctx) || !sflv) 
+    {
+        return false;
+    }
+
+    switch (sflv->format) 
+    {
+        case BEJ_FORMAT_SET:
+            return transcode_container(ctx, sflv, entry, true);
+
+        case BEJ_FORMAT_ARRAY:
+            return transcode_container(ctx, sflv, entry, false);
+
+        case BEJ_FORMAT_NULL:
+            emit_null(ctx);
+            return true;
+
+        case BEJ_FORMAT_INTEGER:
+            emit_integer(ctx, integer_from_sflv(sflv));
+            return true;
+
+        case BEJ_FORMAT_ENUM:
+        {
+            uint32_t enum_sequence = 0;
+            if (sflv->length > 0 && sflv->value) 
+            {
+                BufferReader_t reader;
+                init_buffer_reader(&reader, sflv->value, sflv->length);
+                uint64_t encoded;
+                if (!read_nnint_from_buffer(&reader, &encoded) || encoded > UINT32_MAX) 
+                {
+                    bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read enum sequence");
+                    emit_null(ctx);
+                    return false;
+                }
+                enum_sequence = (uint32_t)encoded;
+            }
+
+            Dictionary_t* dict = sflv->dict_selector ? ctx->anno_dict : ctx->schema_dict;
+            DictionaryEntry_t* enum_entry = find_dictionary_entry(dict, entry, enum_sequence, -1);
+            if (enum_entry && enum_entry->name) 
+            {
+                emit_text(ctx, enum_entry->name, strlen(enum_entry->name));
+            }
+            else 
+            {
+                char text[16];
+                int text_length = snprintf(text, sizeof(text), "%u", enum_sequence);
+                emit_text(ctx, text, (size_t)text_length);
+            }
+            return true;
+        }
+
+        case BEJ_FORMAT_STRING:
+            emit_text(ctx, (const char*)sflv->value, string_length_from_sflv(sflv));
+            return true;
+
+        case BEJ_FORMAT_REAL:
+            // Same length interpretation as decode_real()
+            if (sflv->length == 4 && sflv->value) 
+            {
+                float f_value;
+                memcpy(&f_value, sflv->value, 4);
+                emit_float(ctx, f_value);
+            }
+            else if (sflv->length == 8 && sflv->value) 
+            {
+                double d_value;
+                memcpy(&d_value, sflv->value, 8);
+                emit_double(ctx, d_value);
+            }
+            else if (sflv->length == 1 && sflv->value) 
+            {
+                emit_integer(ctx, sflv->value[0]);
+            }
+            else if (sflv->length == 2 && sflv->value) 
+            {
+                emit_integer(ctx, sflv->value[0] | (sflv->value[1] << 8));
+            }
+            else 
+            {
+                emit_null(ctx);
+            }
+            return true;
+
+        case BEJ_FORMAT_BOOLEAN:
+            emit_boolean(ctx, sflv->length > 0 && sflv->value && sflv->value[0] != 0);
+            return true;
+
+        case BEJ_FORMAT_BYTE_STRING:
+            emit_bytes(ctx, sflv->value, sflv->value ? sflv->length : 0);
+            return true;
+
+        case BEJ_FORMAT_CHOICE:
+        case BEJ_FORMAT_PROPERTY_ANNOTATION:
+        case BEJ_FORMAT_REGISTRY_ITEM:
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_WARNING, "Format type 0x%02X not fully implemented",
+                         sflv->format);
+            emit_null(ctx);
+            return true;
+
+        default:
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Unknown format type 0x%02X", sflv->format);
+            emit_null(ctx);
+            return false;
+    }
+}
+
+// ============================================================================
+// Parallel Container Decode
+// ============================================================================
+
+/// A run of consecutive members decoded by one worker into its own buffer
+typedef struct
+{
+    size_t first;
+    size_t count;
+    uint8_t* output;
+    size_t length;
+    BejDecodeStats_t stats;     // of this chunk alone; output is still held
+    bool ok;
+} MemberChunk_t;
+
+/// Shared state of one parallel container decode
+typedef struct
+{
+    const DecoderContext_t* parent;
+    SFLV_t* members;
+    DictionaryEntry_t* entry;
+    uint8_t container_format;
+    MemberChunk_t* chunks;
+    size_t chunk_count;
+    atomic_size_t next_chunk;   // chunks are claimed dynamically, so fast workers take more
+} MemberJob_t;
+
+static int member_worker(void* arg)
+{
+    MemberJob_t* job = (MemberJob_t*)arg;
+
+    for (;;)
     {
-        // 2-byte value - could be half-precision float
-        uint16_t val = sflv->value[0] | (sflv->value[1] << 8);
-        fprintf(ctx->output_stream, "%u", val);
+        size_t index = atomic_fetch_add(&job->next_chunk, 1);
+        if (index >= job->chunk_count) 
+        {
+            break;
+        }
+        MemberChunk_t* chunk = &job->chunks[index];
+
+        // Same dictionaries, format and indentation as the parent; nested
+        // containers are decoded serially inside the chunk
+        DecoderContext_t ctx = *job->parent;
+        ctx.parallel_threads = 0;
+        ctx.arena = NULL;       // the parent's arena is not thread-safe; serial decoding needs none
+        ctx.allocator = NULL;   // nor need the caller's allocator be, so workers use the C heap
+        memset(&ctx.stats, 0, sizeof(ctx.stats));
+        set_output_buffer(&ctx, NULL, 0);
+
+        chunk->ok = true;
+        for (size_t i = 0; i < chunk->count && chunk->ok; i++) 
+        {
+            if (i > 0) 
+            {
+                emit_member_separator(&ctx, job->container_format);
+            }
+            chunk->ok = emit_member(&ctx, &job->members[chunk->first + i], job->entry, job->container_format);
+        }
+        chunk->ok = chunk->ok && !ctx.output_failed;
+        chunk->output = ctx.output_sink == BEJ_SINK_BUFFER ? ctx.output_buffer : NULL;
+        chunk->length = ctx.output_length;
+        chunk->stats = ctx.stats;
+    }
+    return 0;
+}
+
+/// Fold the statistics of joined workers into the parent; every chunk output is held at this point
+static void merge_chunk_stats(BejDecodeStats_t* stats, const MemberChunk_t* chunks, size_t chunk_count)
+{
+    for (size_t i = 0; i < chunk_count; i++) 
+    {
+        const BejDecodeStats_t* chunk = &chunks[i].stats;
+        stats->allocations += chunk->allocations;
+        stats->bytes_allocated += chunk->bytes_allocated;
+        stats->live_bytes += chunk->live_bytes;
+        if (chunk->max_depth > stats->max_depth) 
+        {
+            stats->max_depth = chunk->max_depth;
+        }
+        if (chunk->largest_value > stats->largest_value) 
+        {
+            stats->largest_value = chunk->largest_value;
+        }
+    }
+    if (stats->live_bytes > stats->peak_live_bytes) 
+    {
+        stats->peak_live_bytes = stats->live_bytes;
+    }
+}
+
+static bool decode_members_parallel(DecoderContext_t* ctx, BufferReader_t* reader, DictionaryEntry_t* entry,
+                                    uint8_t container_format, uint64_t* member_count)
+{
+    // Stage 1: every member is length-prefixed, so boundaries are found
+    // from the tuple headers alone, without decoding or copying values
+    size_t capacity = 1024;
+    size_t count = 0;
+    SFLV_t* members = (SFLV_t*)ctx_alloc(ctx, capacity * sizeof(SFLV_t));
+    if (!members) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate member index");
+        return false;
+    }
+
+    while (!buffer_eof(reader)) 
+    {
+        if (count == capacity) 
+        {
+            SFLV_t* grown = (SFLV_t*)ctx_grow(ctx, members, capacity * sizeof(SFLV_t),
+                                              capacity * 2 * sizeof(SFLV_t));
+            if (!grown) 
+            {
+                bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to grow member index");
+                ctx_free(ctx, members, capacity * sizeof(SFLV_t));
+                return false;
+            }
+            members = grown;
+            capacity *= 2;
+        }
+        if (!read_sflv_header_from_buffer(reader, &members[count])) 
+        {
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read member %zu tuple", count);
+            ctx_free(ctx, members, capacity * sizeof(SFLV_t));
+            return false;
+        }
+        count++;
+    }
+
+    // Stage 2: several chunks per thread keep the load balanced when member sizes vary
+    size_t thread_count = (size_t)ctx->parallel_threads;
+    size_t chunk_size = count / (thread_count * 8);
+    if (chunk_size < 16) 
+    {
+        chunk_size = 16;
+    }
+    size_t chunk_count = count ? (count + chunk_size - 1) / chunk_size : 0;
+    if (thread_count > chunk_count) 
+    {
+        thread_count = chunk_count;
+    }
+
+    size_t chunks_size = (chunk_count ? chunk_count : 1) * sizeof(MemberChunk_t);
+    size_t threads_size = (thread_count ? thread_count : 1) * sizeof(thrd_t);
+    MemberChunk_t* chunks = (MemberChunk_t*)ctx_alloc(ctx, chunks_size);
+    thrd_t* threads = (thrd_t*)ctx_alloc(ctx, threads_size);
+    if (!chunks || !threads) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate parallel decode state");
+        ctx_free(ctx, chunks, chunks_size);
+        ctx_free(ctx, threads, threads_size);
+        ctx_free(ctx, members, capacity * sizeof(SFLV_t));
+        return false;
+    }
+    memset(chunks, 0, chunks_size);
+
+    MemberJob_t job;
+    job.parent = ctx;
+    job.members = members;
+    job.entry = entry;
+    job.container_format = container_format;
+    job.chunks = chunks;
+    job.chunk_count = chunk_count;
+    atomic_init(&job.next_chunk, 0);
+
+    for (size_t i = 0; i < chunk_count; i++) 
+    {
+        chunks[i].first = i * chunk_size;
+        chunks[i].count = (i + 1 == chunk_count) ? count - chunks[i].first : chunk_size;
+    }
+
+    size_t started = 0;
+    while (started < thread_count && thrd_create(&threads[started], member_worker, &job) == thrd_success) 
+    {
+        started++;
+    }
+    // Whatever no thread picked up (e.g. thread creation failed) runs here
+    member_worker(&job);
+    for (size_t i = 0; i < started; i++) 
+    {
+        thrd_join(threads[i], NULL);
+    }
+    merge_chunk_stats(&ctx->stats, chunks, chunk_count);
+
+    // Stitch the chunk outputs together in document order
+    bool ok = true;
+    for (size_t i = 0; i < chunk_count; i++) 
+    {
+        ok = ok && chunks[i].ok;
+        if (ok) 
+        {
+            if (i > 0) 
+            {
+                emit_member_separator(ctx, container_format);
+            }
+            if (chunks[i].length > 0) 
+            {
+                out_write(ctx, chunks[i].output, chunks[i].length);
+            }
+        }
+        bej_free(NULL, chunks[i].output);
+        stats_release(&ctx->stats, chunks[i].stats.live_bytes);
+    }
+
+    ctx_free(ctx, chunks, chunks_size);
+    ctx_free(ctx, threads, threads_size);
+    ctx_free(ctx, members, capacity * sizeof(SFLV_t));
+    *member_count = count;
+    return ok;
+}
+
+// ============================================================================
+// Main Decode Function
+// ============================================================================
+
+bool read_bej_header_from_buffer(BufferReader_t* reader, const BejDiagnostics_t* diagnostics)
+{
+    // Version is 32-bit: 0xF1F0F000 (v1.0.0) or 0xF1F1F000 (v1.1.0)
+    uint8_t version_bytes[4];
+    if (buffer_read(reader, version_bytes, 4) != 4) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read BEJ version");
+        return false;
+    }
+    uint32_t version = version_bytes[0] | (version_bytes[1] << 8) 
+                      | (version_bytes[2] << 16) | ((uint32_t)version_bytes[3] << 24);
+    bej_diagnose(diagnostics, BEJ_DIAG_TRACE, "BEJ Version: 0x%08X", version);
+
+    uint8_t BEG_flags_bytes[2];
+    if (buffer_read(reader, BEG_flags_bytes, 2) != 2) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read BEJ flags");
+        return false;
+    }
+    uint16_t BEG_flags = BEG_flags_bytes[0] | (BEG_flags_bytes[1] << 8);
+    bej_diagnose(diagnostics, BEJ_DIAG_TRACE, "BEJ Flags: 0x%04X", BEG_flags);
+
+    uint8_t schemaClass;
+    if (buffer_read(reader, &schemaClass, 1) != 1) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read Schema Class");
+        return false;
+    }
+    bej_diagnose(diagnostics, BEJ_DIAG_TRACE, "Schema class: 0x%02X", schemaClass);
+    return true;
+}
+
+bool decode_bej_to_json(DecoderContext_t* ctx)
+{
+    if (!ctx) return false;
+
+    if (!ctx->input_stream || !has_output(ctx)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Invalid decoder context");
+        return false;
+    }
+
+    // The document is pushed through in fixed-size pieces: containers are
+    // descended into as their headers arrive, only leaf values are buffered
+    BejPushParser_t* parser = bej_push_create(ctx);
+    uint8_t* chunk = parser ? (uint8_t*)bej_alloc(ctx->allocator, BEJ_STREAM_CHUNK_SIZE) : NULL;
+    if (!chunk) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate stream decoder");
+        bej_push_free(parser);
+        return false;
+    }
+    stats_acquire(&ctx->stats, BEJ_STREAM_CHUNK_SIZE);
+
+    bool result = true;
+    size_t length;
+    while (result && (length = fread(chunk, 1, BEJ_STREAM_CHUNK_SIZE, ctx->input_stream)) > 0) 
+    {
+        result = bej_feed(parser, chunk, length);
+    }
+    if (result && ferror(ctx->input_stream)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read input stream");
+        result = false;
+    }
+
+    // Also flushes a stream sink
+    result = bej_finish(parser) && result;
+    bej_push_free(parser);
+    bej_free(ctx->allocator, chunk);
+    stats_release(&ctx->stats, BEJ_STREAM_CHUNK_SIZE);
+    
+    if (result) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_INFO, "Decoding completed successfully");
     } 
     else 
     {
-        // Unknown length - output null
-        fprintf(ctx->output_stream, "null");
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Decoding failed");
+    }
+    
+    return result;
+}
+
+bool decode_bej_buffer(DecoderContext_t* ctx, uint8_t* data, uint64_t size)
+{
+    if (!ctx) return false;
+
+    if (!data || !has_output(ctx)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Invalid decoder context");
+        return false;
+    }
+
+    // Whatever the previous document left in the arena is released in O(1)
+    arena_reset(ctx->arena);
+    reset_stats(ctx);
+    ctx->projection_node = ctx->projection ? ctx->projection->nodes : NULL;
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, data, size);
+    if (!read_bej_header_from_buffer(&reader, &ctx->diagnostics)) 
+    {
+        return false;
+    }
+
+    SFLV_t sflv;
+    if (!read_sflv_header_from_buffer(&reader, &sflv)) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to read SFLV tuple");
+        return false;
+    }
+
+    return decode_value(ctx, &sflv, NULL) && !ctx->output_failed;
+}
+
+bool measure_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry, size_t* size)
+{
+    if (!ctx || !sflv || !size) 
+    {
+        return false;
+    }
+
+    // Run the normal writers against a counting sink, so the size can never
+    // drift from what decode_value() actually produces
+    DecoderContext_t measure = *ctx;
+    measure.output_sink = BEJ_SINK_MEASURE;
+    measure.output_length = 0;
+    measure.output_failed = false;
+
+    if (!decode_value(&measure, sflv, entry)) 
+    {
+        return false;
+    }
+    *size = measure.output_length;
+    return true;
+}
+
+// ============================================================================
+// Random Access (JSON Pointer)
+// ============================================================================
+
+/// Next reference token of pointer (RFC 6901), unescaped into name; returns the position after it
+static const char* pointer_segment(const char* pointer, char* name, size_t capacity, size_t* length)
+{
+    *length = 0;
+    for (pointer++; *pointer && *pointer != '/'; pointer++) 
+    {
+        char c = *pointer;
+        if (c == '~') 
+        {
+            if (pointer[1] != '0' && pointer[1] != '1') 
+            {
+                return NULL;
+            }
+            c = (*++pointer == '0') ? '~' : '/';
+        }
+        if (*length + 1 >= capacity) 
+        {
+            return NULL;
+        }
+        name[(*length)++] = c;
+    }
+    name[*length] = '\0';
+    return pointer;
+}
+
+/// Array index token: decimal digits without a leading zero
+static bool parse_array_index(const char* token, size_t length, uint64_t* index)
+{
+    if (length == 0 || length > 19 || (token[0] == '0' && length > 1)) 
+    {
+        return false;
+    }
+    *index = 0;
+    for (size_t i = 0; i < length; i++) 
+    {
+        if (token[i] < '0' || token[i] > '9') 
+        {
+            return false;
+        }
+        *index = *index * 10 + (uint64_t)(token[i] - '0');
+    }
+    return true;
+}
+
+/// Move sflv to its member named token, skipping the other members by their length
+static bool step_into_set(const char* token, size_t length, SFLV_t* sflv, Dictionary_t** dict,
+                          DictionaryEntry_t** entry, Dictionary_t* anno_dict, const BejDiagnostics_t* diagnostics)
+{
+    // "@..." names an annotation; its subtree is described by the annotation dictionary
+    Dictionary_t* member_dict = *dict;
+    DictionaryEntry_t* parent = *entry;
+    uint8_t selector = sflv->dict_selector;
+    if (token[0] == '@' && anno_dict && anno_dict->entry_count > 0) 
+    {
+        member_dict = anno_dict;
+        parent = &anno_dict->entries[0];
+        selector = 1;
+    }
+
+    DictionaryEntry_t* member_entry = parent ? find_dictionary_entry_by_name(member_dict, parent, token, length) : NULL;
+    if (!member_entry) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Unknown property '%s'", token);
+        return false;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv->value, sflv->length);
+    uint64_t count;
+    if (sflv->length > 0 && !read_nnint_from_buffer(&reader, &count)) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read member count");
+        return false;
+    }
+
+    while (!buffer_eof(&reader)) 
+    {
+        SFLV_t member;
+        if (!read_sflv_header_from_buffer(&reader, &member)) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read member tuple");
+            return false;
+        }
+        if (member.sequence == member_entry->sequence_number && member.dict_selector == selector) 
+        {
+            *sflv = member;
+            *dict = member_dict;
+            *entry = member_entry;
+            return true;
+        }
+    }
+    bej_diagnose(diagnostics, BEJ_DIAG_WARNING, "Property '%s' is not present", token);
+    return false;
+}
+
+/// Move sflv to element index of the ARRAY it holds, skipping the ones before it by their length
+static bool step_into_array(uint64_t index, SFLV_t* sflv, Dictionary_t* dict, DictionaryEntry_t** entry,
+                            const BejDiagnostics_t* diagnostics)
+{
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv->value, sflv->length);
+    uint64_t count = 0;
+    if (sflv->length > 0 && !read_nnint_from_buffer(&reader, &count)) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read element count");
+        return false;
+    }
+    if (index >= count) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_WARNING, "Index %llu is past the %llu array elements",
+                     (unsigned long long)index, (unsigned long long)count);
+        return false;
     }
-    
+
+    SFLV_t element;
+    for (uint64_t i = 0; i <= index; i++) 
+    {
+        if (!read_sflv_header_from_buffer(&reader, &element)) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read element %llu tuple", (unsigned long long)i);
+            return false;
+        }
+    }
+
+    // Every element is described by the array's single child entry
+    uint32_t start;
+    uint32_t children;
+    *entry = (*entry && dictionary_children(dict, *entry, &start, &children)) ? &dict->entries[start] : NULL;
+    *sflv = element;
     return true;
 }
 
-bool decode_boolean(DecoderContext_t* ctx, SFLV_t* sflv)
+bool bej_value_from_sflv(const SFLV_t* sflv, Dictionary_t* dict, DictionaryEntry_t* entry,
+                         BejValue_t* value, const BejDiagnostics_t* diagnostics)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!sflv || !value) 
     {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
         return false;
     }
-    
-    bool value = false;
-    if (sflv->length > 0 && sflv->value) 
+
+    memset(value, 0, sizeof(*value));
+    value->format = sflv->format;
+    value->dict_selector = sflv->dict_selector;
+    value->data = sflv->value;
+    value->length = sflv->length;
+    value->entry = entry;
+
+    switch (sflv->format) 
     {
-        value = (sflv->value[0] != 0);
+        case BEJ_FORMAT_INTEGER:
+            value->integer = integer_from_sflv(sflv);
+            break;
+
+        case BEJ_FORMAT_REAL:
+            if (!real_from_sflv(sflv, &value->real)) 
+            {
+                bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Unsupported REAL length %llu",
+                             (unsigned long long)sflv->length);
+                return false;
+            }
+            break;
+
+        case BEJ_FORMAT_BOOLEAN:
+            value->boolean = sflv->length > 0 && sflv->value && sflv->value[0] != 0;
+            break;
+
+        case BEJ_FORMAT_STRING:
+            value->string = (const char*)sflv->value;
+            value->string_length = string_length_from_sflv(sflv);
+            break;
+
+        case BEJ_FORMAT_ENUM:
+        {
+            if (!enum_sequence_from_sflv(sflv, &value->enum_sequence)) 
+            {
+                bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read enum sequence");
+                return false;
+            }
+            DictionaryEntry_t* option = entry ? find_dictionary_entry(dict, entry, value->enum_sequence, -1) : NULL;
+            if (option && option->name) 
+            {
+                value->string = option->name;
+                value->string_length = strlen(option->name);
+            }
+            break;
+        }
+
+        default:
+            break;
     }
-    
-    fprintf(ctx->output_stream, "%s", value ? "true" : "false");
     return true;
 }
 
-bool decode_enum(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+bool bej_get(const uint8_t* data, uint64_t size, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+             const char* pointer, BejValue_t* value, const BejDiagnostics_t* diagnostics)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!data || !schema_dict || !schema_dict->entries || schema_dict->entry_count == 0 || !pointer || !value) 
     {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
         return false;
     }
-    
-    // Enum value is encoded as nnint - the sequence number for the enumeration option (5.3.12)
-    uint32_t enum_sequence = 0;
-    
-    if (sflv->length > 0 && sflv->value) 
+    if (*pointer != '\0' && *pointer != '/') 
     {
-        BufferReader_t reader;
-        init_buffer_reader(&reader, sflv->value, sflv->length);
-        
-        if (!read_nnint_from_buffer(&reader, &enum_sequence)) 
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "JSON Pointer '%s' does not start with '/'", pointer);
+        return false;
+    }
+
+    // The reader never writes; it only shares the non-const buffer type
+    BufferReader_t reader;
+    init_buffer_reader(&reader, (uint8_t*)data, size);
+    SFLV_t sflv;
+    if (!read_bej_header_from_buffer(&reader, diagnostics) || !read_sflv_header_from_buffer(&reader, &sflv)) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read the root tuple");
+        return false;
+    }
+
+    Dictionary_t* dict = schema_dict;
+    DictionaryEntry_t* entry = &schema_dict->entries[0];
+
+    // Dictionary names are at most 255 bytes (name_length is one byte)
+    char token[256];
+    size_t length;
+    while (*pointer) 
+    {
+        pointer = pointer_segment(pointer, token, sizeof(token), &length);
+        if (!pointer) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid JSON Pointer token");
+            return false;
+        }
+
+        bool found;
+        uint64_t index;
+        if (sflv.format == BEJ_FORMAT_SET) 
+        {
+            found = step_into_set(token, length, &sflv, &dict, &entry, anno_dict, diagnostics);
+        }
+        else if (sflv.format == BEJ_FORMAT_ARRAY && parse_array_index(token, length, &index)) 
+        {
+            found = step_into_array(index, &sflv, dict, &entry, diagnostics);
+        }
+        else 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "'%s' does not name a member of a format 0x%X value",
+                         token, sflv.format);
+            found = false;
+        }
+        if (!found) 
         {
-            fprintf(stderr, "Error: Failed to read enum sequence\n");
-            fprintf(ctx->output_stream, "null");
             return false;
         }
     }
-    
-    // Look up the enum option name from the dictionary
-    // Use the appropriate dictionary based on dict_selector
-    DictionaryEntry_t* enum_entry = NULL;
-    if (sflv->dict_selector == 0) 
+
+    return bej_value_from_sflv(&sflv, dict, entry, value, diagnostics);
+}
+
+// ============================================================================
+// Push Parser
+// ============================================================================
+
+typedef enum
+{
+    PUSH_HEADER,        // collecting the 7-byte encoding header
+    PUSH_TUPLE,         // collecting an S, F and L tuple header
+    PUSH_COUNT,         // collecting a SET/ARRAY member count
+    PUSH_VALUE,         // collecting a leaf value
+    PUSH_DONE,
+    PUSH_FAILED
+} PushState_t;
+
+/// An open SET or ARRAY
+typedef struct
+{
+    DictionaryEntry_t* entry;   // entry of the container itself
+    uint64_t end;               // document offset one past its value
+    uint64_t declared;          // member count from the encoding
+    uint64_t count;             // members started so far
+    uint8_t format;
+} PushFrame_t;
+
+struct BejPushParser
+{
+    DecoderContext_t* ctx;
+    PushState_t state;
+    uint8_t scratch[24];        // partial header, tuple header or count
+    uint32_t scratch_length;
+    SFLV_t tuple;               // tuple whose value is being collected
+    DictionaryEntry_t* entry;   // its dictionary entry
+    uint8_t* value;
+    size_t value_capacity;
+    size_t value_length;
+    PushFrame_t* frames;
+    size_t depth;
+    size_t frame_capacity;
+    uint64_t offset;            // document bytes consumed
+};
+
+BejPushParser_t* bej_push_create(DecoderContext_t* ctx)
+{
+    if (!ctx || !has_output(ctx)) 
     {
-        enum_entry = find_dictionary_entry(ctx->schema_dict, entry, enum_sequence, -1);
-    } 
-    else if (sflv->dict_selector == 1) 
+        return NULL;
+    }
+
+    if (ctx->projection) 
     {
-        enum_entry = find_dictionary_entry(ctx->anno_dict, entry, enum_sequence, -1);
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Projections need the whole document in memory");
+        return NULL;
+    }
+
+    BejPushParser_t* parser = (BejPushParser_t*)bej_alloc(ctx->allocator, sizeof(BejPushParser_t));
+    if (!parser) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate push parser");
+        return NULL;
+    }
+    memset(parser, 0, sizeof(BejPushParser_t));
+    reset_stats(ctx);
+    stats_acquire(&ctx->stats, sizeof(BejPushParser_t));
+    parser->ctx = ctx;
+    parser->state = PUSH_HEADER;
+    return parser;
+}
+
+void bej_push_free(BejPushParser_t* parser)
+{
+    if (!parser) return;
+
+    const BejAllocator_t* allocator = parser->ctx->allocator;
+    stats_release(&parser->ctx->stats, sizeof(BejPushParser_t) + parser->value_capacity
+                                       + parser->frame_capacity * sizeof(PushFrame_t));
+    bej_free(allocator, parser->value);
+    bej_free(allocator, parser->frames);
+    bej_free(allocator, parser);
+}
+
+static bool push_fail(BejPushParser_t* parser, const char* message)
+{
+    bej_diagnose(&parser->ctx->diagnostics, BEJ_DIAG_ERROR, "%s at offset %llu", message,
+                 (unsigned long long)parser->offset);
+    parser->state = PUSH_FAILED;
+    return false;
+}
+
+/// Total bytes of the tuple header in scratch, or 0 while more bytes are needed; -1 if malformed
+static int push_tuple_header_size(const BejPushParser_t* parser)
+{
+    const uint8_t* bytes = parser->scratch;
+    uint32_t have = parser->scratch_length;
+
+    if (have < 1) return 0;
+    if (bytes[0] == 0 || bytes[0] > BEJ_NNINT_MAX_BYTES) return -1;
+
+    uint32_t length_at = 1u + bytes[0] + 1u;    // sequence, then format
+    if (have <= length_at) return 0;
+    if (bytes[length_at] == 0 || bytes[length_at] > BEJ_NNINT_MAX_BYTES) return -1;
+    return (int)(length_at + 1u + bytes[length_at]);
+}
+
+/// Write what precedes a value: separator and, inside a SET, the property name
+static void push_begin_member(BejPushParser_t* parser, SFLV_t* member, DictionaryEntry_t** entry)
+{
+    DecoderContext_t* ctx = parser->ctx;
+    *entry = NULL;
+    if (parser->depth == 0) 
+    {
+        return;
+    }
+
+    PushFrame_t* frame = &parser->frames[parser->depth - 1];
+    if (frame->count++ > 0) 
+    {
+        emit_member_separator(ctx, frame->format);
+    }
+    if (frame->format != BEJ_FORMAT_SET) 
+    {
+        *entry = frame->entry;
+        return;
+    }
+
+    DictionaryEntry_t* child_entry = find_child_entry(ctx, frame->entry, member);
+    *entry = child_entry;
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        if (child_entry && child_entry->name) 
+        {
+            emit_text(ctx, child_entry->name, strlen(child_entry->name));
+        }
+        else 
+        {
+            char key[24];
+            int key_length = snprintf(key, sizeof(key), "seq_%u", member->sequence);
+            emit_text(ctx, key, (size_t)key_length);
+        }
+        return;
+    }
+
+    emit_indent(ctx, ctx->indent_level);
+    if (child_entry && child_entry->name) 
+    {
+        emit_json_string(ctx, child_entry->name, strlen(child_entry->name));
+        out_putc(ctx, ':');
+    }
+    else 
+    {
+        out_puts(ctx, "\"seq_");
+        out_integer(ctx, member->sequence);
+        out_puts(ctx, "\":");
+    }
+    if (!ctx->compact) 
+    {
+        out_putc(ctx, ' ');
+    }
+}
+
+/// Same output as decode_set()/decode_array() write before the first member
+static void push_open_container(BejPushParser_t* parser, PushFrame_t* frame)
+{
+    DecoderContext_t* ctx = parser->ctx;
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        if (frame->format == BEJ_FORMAT_SET) 
+        {
+            emit_map_header(ctx, frame->declared);
+        }
+        else 
+        {
+            emit_array_header(ctx, frame->declared);
+        }
+        return;
+    }
+
+    if (frame->format == BEJ_FORMAT_SET) 
+    {
+        out_putc(ctx, '{');
+        emit_newline(ctx);
+        ctx->indent_level++;
+    }
+    else 
+    {
+        out_putc(ctx, '[');
+    }
+}
+
+static bool push_close_container(BejPushParser_t* parser, PushFrame_t* frame)
+{
+    DecoderContext_t* ctx = parser->ctx;
+    if (ctx->output_format != BEJ_OUTPUT_JSON) 
+    {
+        if (frame->count != frame->declared) 
+        {
+            bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "%s declares %llu members but holds %llu",
+                         frame->format == BEJ_FORMAT_SET ? "SET" : "ARRAY",
+                         (unsigned long long)frame->declared, (unsigned long long)frame->count);
+            parser->state = PUSH_FAILED;
+            return false;
+        }
+        return true;
+    }
+
+    if (frame->format == BEJ_FORMAT_SET) 
+    {
+        ctx->indent_level--;
+        emit_newline(ctx);
+        emit_indent(ctx, ctx->indent_level);
+        out_putc(ctx, '}');
+    }
+    else 
+    {
+        out_putc(ctx, ']');
+    }
+    return true;
+}
+
+/// A value just ended: close every container it completed, then expect the next tuple
+static bool push_end_value(BejPushParser_t* parser)
+{
+    while (parser->depth > 0) 
+    {
+        PushFrame_t* frame = &parser->frames[parser->depth - 1];
+        if (parser->offset < frame->end) 
+        {
+            parser->state = PUSH_TUPLE;
+            return true;
+        }
+        if (!push_close_container(parser, frame)) 
+        {
+            return false;
+        }
+        parser->depth--;
+    }
+    parser->state = PUSH_DONE;
+    return true;
+}
+
+/// A complete tuple header is in scratch: emit what can be emitted and pick the next state
+static bool push_begin_tuple(BejPushParser_t* parser)
+{
+    DecoderContext_t* ctx = parser->ctx;
+    BufferReader_t reader;
+    init_buffer_reader(&reader, parser->scratch, parser->scratch_length);
+
+    // Same fields as read_sflv_header_from_buffer(), but the value has not arrived yet
+    SFLV_t* tuple = &parser->tuple;
+    uint64_t sequence;
+    read_nnint_from_buffer(&reader, &sequence);
+    if (!split_sequence(tuple, sequence)) 
+    {
+        return push_fail(parser, "Malformed SFLV tuple");
+    }
+    buffer_read(&reader, &tuple->format, 1);
+    tuple->format = (tuple->format >> 4) & 0x0F;
+    read_nnint_from_buffer(&reader, &tuple->length);
+    tuple->value = NULL;
+
+    if (parser->depth > 0 && parser->offset + tuple->length > parser->frames[parser->depth - 1].end) 
+    {
+        return push_fail(parser, "SFLV tuple overruns its container");
+    }
+
+    push_begin_member(parser, tuple, &parser->entry);
+
+    bool is_container = tuple->format == BEJ_FORMAT_SET || tuple->format == BEJ_FORMAT_ARRAY;
+    if (is_container && tuple->length > 0) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_TRACE, "SFLV: seq=%u, format=0x%02X, length=%llu, dict_selector=%u",
+                     tuple->sequence, tuple->format, (unsigned long long)tuple->length, tuple->dict_selector);
+        parser->state = PUSH_COUNT;
+        return true;
+    }
+    if (tuple->length == 0) 
+    {
+        // Empty values need no further input
+        if (!decode_value(ctx, tuple, parser->entry)) 
+        {
+            return push_fail(parser, "Failed to decode value");
+        }
+        return push_end_value(parser);
+    }
+
+    if (ctx->max_value_length && tuple->length > ctx->max_value_length) 
+    {
+        bej_diagnose(&ctx->diagnostics, BEJ_DIAG_ERROR, "Value of %llu bytes exceeds the %llu byte limit",
+                     (unsigned long long)tuple->length, (unsigned long long)ctx->max_value_length);
+        return push_fail(parser, "Value too large to buffer");
+    }
+    if (!fits_in_memory(tuple->length)) 
+    {
+        return push_fail(parser, "Value too large to buffer");
+    }
+    if (tuple->length > parser->value_capacity) 
+    {
+        uint8_t* grown = (uint8_t*)bej_realloc(parser->ctx->allocator, parser->value, (size_t)tuple->length);
+        if (!grown) 
+        {
+            return push_fail(parser, "Failed to allocate value buffer");
+        }
+        stats_acquire(&parser->ctx->stats, tuple->length);
+        stats_release(&parser->ctx->stats, parser->value_capacity);
+        parser->value = grown;
+        parser->value_capacity = (size_t)tuple->length;
+    }
+    parser->value_length = 0;
+    parser->state = PUSH_VALUE;
+    return true;
+}
+
+/// A container's member count is in scratch: open it
+static bool push_begin_container(BejPushParser_t* parser)
+{
+    BufferReader_t reader;
+    init_buffer_reader(&reader, parser->scratch, parser->scratch_length);
+    uint64_t declared;
+    read_nnint_from_buffer(&reader, &declared);
+
+    // The tuple length was checked to cover the count when the count was collected
+    uint64_t end = parser->offset - parser->scratch_length + parser->tuple.length;
+
+    if (parser->depth == parser->frame_capacity) 
+    {
+        size_t capacity = parser->frame_capacity ? parser->frame_capacity * 2 : 16;
+        PushFrame_t* grown = (PushFrame_t*)bej_realloc(parser->ctx->allocator, parser->frames,
+                                                       capacity * sizeof(PushFrame_t));
+        if (!grown) 
+        {
+            return push_fail(parser, "Failed to allocate container stack");
+        }
+        stats_acquire(&parser->ctx->stats, capacity * sizeof(PushFrame_t));
+        stats_release(&parser->ctx->stats, parser->frame_capacity * sizeof(PushFrame_t));
+        parser->frames = grown;
+        parser->frame_capacity = capacity;
+    }
+
+    PushFrame_t* frame = &parser->frames[parser->depth++];
+    if (parser->depth > parser->ctx->stats.max_depth) 
+    {
+        parser->ctx->stats.max_depth = (uint32_t)parser->depth;
+    }
+    frame->entry = parser->entry;
+    frame->end = end;
+    frame->declared = declared;
+    frame->count = 0;
+    frame->format = parser->tuple.format;
+    push_open_container(parser, frame);
+    return push_end_value(parser);
+}
+
+bool bej_feed(BejPushParser_t* parser, const uint8_t* chunk, size_t length)
+{
+    if (!parser || (!chunk && length > 0)) 
+    {
+        return false;
+    }
+
+    DecoderContext_t* ctx = parser->ctx;
+    size_t position = 0;
+    while (position < length && parser->state != PUSH_FAILED) 
+    {
+        switch (parser->state) 
+        {
+            case PUSH_HEADER:
+            {
+                parser->scratch[parser->scratch_length++] = chunk[position++];
+                parser->offset++;
+                if (parser->scratch_length == BEJ_HEADER_SIZE) 
+                {
+                    BufferReader_t reader;
+                    init_buffer_reader(&reader, parser->scratch, BEJ_HEADER_SIZE);
+                    read_bej_header_from_buffer(&reader, &ctx->diagnostics);
+                    parser->scratch_length = 0;
+                    parser->state = PUSH_TUPLE;
+                }
+                break;
+            }
+
+            case PUSH_TUPLE:
+            {
+                // Header bytes are taken one at a time: the tuple header is at most 19 bytes
+                parser->scratch[parser->scratch_length++] = chunk[position++];
+                parser->offset++;
+                if (parser->depth > 0 && parser->offset > parser->frames[parser->depth - 1].end) 
+                {
+                    push_fail(parser, "SFLV tuple overruns its container");
+                    break;
+                }
+
+                int size = push_tuple_header_size(parser);
+                if (size < 0) 
+                {
+                    push_fail(parser, "Malformed SFLV tuple");
+                }
+                else if (size > 0 && parser->scratch_length == (uint32_t)size) 
+                {
+                    push_begin_tuple(parser);
+                    parser->scratch_length = 0;
+                }
+                break;
+            }
+
+            case PUSH_COUNT:
+            {
+                parser->scratch[parser->scratch_length++] = chunk[position++];
+                parser->offset++;
+                if (parser->scratch[0] == 0 || parser->scratch[0] > BEJ_NNINT_MAX_BYTES 
+                    || parser->scratch_length > parser->tuple.length) 
+                {
+                    push_fail(parser, "Failed to read container length");
+                }
+                else if (parser->scratch_length == 1u + parser->scratch[0]) 
+                {
+                    push_begin_container(parser);
+                    parser->scratch_length = 0;
+                }
+                break;
+            }
+
+            case PUSH_VALUE:
+            {
+                size_t wanted = (size_t)parser->tuple.length - parser->value_length;
+                size_t count = (length - position) < wanted ? length - position : wanted;
+                memcpy(parser->value + parser->value_length, chunk + position, count);
+                parser->value_length += count;
+                parser->offset += count;
+                position += count;
+
+                if (parser->value_length == parser->tuple.length) 
+                {
+                    parser->tuple.value = parser->value;
+                    bool ok = decode_value(ctx, &parser->tuple, parser->entry);
+                    parser->tuple.value = NULL;
+                    if (!ok) 
+                    {
+                        push_fail(parser, "Failed to decode value");
+                        break;
+                    }
+                    push_end_value(parser);
+                }
+                break;
+            }
+
+            case PUSH_DONE:
+                // Like decode_bej_buffer(), ignore anything after the root value
+                position = length;
+                break;
+
+            case PUSH_FAILED:
+                break;
+        }
     }
 
-    if (enum_entry && enum_entry->name) 
-    {
-        fprintf(ctx->output_stream, "\"%s\"", enum_entry->name);
-    } 
-    else 
+    if (ctx->output_failed && parser->state != PUSH_FAILED) 
     {
-        fprintf(ctx->output_stream, "\"%u\"", enum_sequence);
+        push_fail(parser, "Output write failed");
     }
-    
-    return true;
+    return parser->state != PUSH_FAILED;
 }
 
-bool decode_null(DecoderContext_t* ctx)
+bool bej_finish(BejPushParser_t* parser)
 {
-    if (!ctx || !ctx->output_stream) 
+    if (!parser) 
     {
         return false;
     }
-    
-    fprintf(ctx->output_stream, "null");
-    return true;
+
+    DecoderContext_t* ctx = parser->ctx;
+    if (ctx->output_sink == BEJ_SINK_STREAM) 
+    {
+        fflush(ctx->output_stream);
+    }
+    if (parser->state == PUSH_DONE) 
+    {
+        return !ctx->output_failed;
+    }
+    if (parser->state != PUSH_FAILED) 
+    {
+        push_fail(parser, "Document truncated");
+    }
+    return false;
 }
 
-bool decode_set(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+// ============================================================================
+// High-Level API
+// ============================================================================
+
+bool read_file_into_buffer(const char* path, uint8_t** data, size_t* capacity, uint64_t* size,
+                           const BejDiagnostics_t* diagnostics)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    FILE* input = fopen(path, "rb");
+    if (!input) 
     {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open input file %s", path);
         return false;
     }
-    
-    fprintf(ctx->output_stream, "{");
-    
-    if (sflv->length > 0 && sflv->value) 
+
+    fseek(input, 0, SEEK_END);
+    long input_size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+
+    if (input_size <= 0) 
     {
-        BufferReader_t reader;
-        init_buffer_reader(&reader, sflv->value, sflv->length);
-        
-        fprintf(ctx->output_stream, "\n");
-        ctx->indent_level++;
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Input file %s is empty or unreadable", path);
+        fclose(input);
+        return false;
+    }
 
-        uint32_t set_length;
-        if (!read_nnint_from_buffer(&reader, &set_length)) 
+    if ((size_t)input_size > *capacity) 
+    {
+        uint8_t* grown = (uint8_t*)realloc(*data, (size_t)input_size);
+        if (!grown) 
         {
-            fprintf(stderr, "Error: Failed to read SET length\n");
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate input buffer");
+            fclose(input);
             return false;
         }
+        *data = grown;
+        *capacity = (size_t)input_size;
+    }
 
-        bool first = true;
-        while (!buffer_eof(&reader)) 
-        {
-            if (!first) 
-            {
-                fprintf(ctx->output_stream, ",\n");
-            }
-            first = false;
-            
-            SFLV_t child_sflv;
-            if (!read_sflv_from_buffer(&reader, &child_sflv)) 
-            {
-                return false;
-            }
-
-            DictionaryEntry_t* child_entry = NULL;
-            if (child_sflv.dict_selector == 0) 
-            {
-                child_entry = find_dictionary_entry(ctx->schema_dict, entry, child_sflv.sequence, child_sflv.format);
-            } 
-            else if (child_sflv.dict_selector == 1) 
-            {
-                child_entry = find_dictionary_entry(ctx->anno_dict, entry, child_sflv.sequence, child_sflv.format);
-            }
-
-            write_indent(ctx->output_stream, ctx->indent_level);
-            
-            // Write property name
-            if (child_entry && child_entry->name) 
-            {
-                fprintf(ctx->output_stream, "\"%s\":", child_entry->name);
-            }
-            else 
-            {
-                fprintf(ctx->output_stream, "\"seq_%u\":", child_sflv.sequence);
-            }
-            
-            fprintf(ctx->output_stream, " ");
-            
-            // Decode child value
-            if (!decode_value(ctx, &child_sflv, child_entry)) 
-            {
-                free_sflv(&child_sflv);
-                return false;
-            }
-            free_sflv(&child_sflv);
-        }
-        ctx->indent_level--;
-        fprintf(ctx->output_stream, "\n");
-        write_indent(ctx->output_stream, ctx->indent_level);
+    bool ok = fread(*data, 1, (size_t)input_size, input) == (size_t)input_size;
+    fclose(input);
+    if (!ok) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read input file %s", path);
+        return false;
     }
-    fprintf(ctx->output_stream, "}");
+    *size = (uint64_t)input_size;
     return true;
 }
 
-bool decode_array(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+bool bej_decode_files_ndjson(const char* const* input_files, size_t count, FILE* output,
+                             Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                             size_t* decoded_count, const BejDiagnostics_t* diagnostics)
 {
-    if (!ctx || !ctx->output_stream || !sflv) 
+    if (!input_files || !output) 
     {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
         return false;
     }
-    
-    fprintf(ctx->output_stream, "[");
-    
-    if (sflv->length > 0 && sflv->value) 
+
+    // Input and output buffers and the arena are reused for every record, so a steady-state
+    // batch does no per-file allocation and no per-file output open/close
+    uint8_t* input_data = NULL;
+    size_t input_capacity = 0;
+
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, schema_dict, anno_dict, NULL, NULL);
+    ctx.arena = &arena;
+    ctx.compact = true;
+    if (diagnostics) 
     {
-        BufferReader_t reader;
-        init_buffer_reader(&reader, sflv->value, sflv->length);
-                
-        uint32_t array_length;
-        if (!read_nnint_from_buffer(&reader, &array_length)) 
+        ctx.diagnostics = *diagnostics;
+    }
+    set_output_buffer(&ctx, NULL, 0);
+
+    size_t decoded = 0;
+    bool write_ok = true;
+    for (size_t i = 0; i < count && write_ok; i++) 
+    {
+        uint64_t input_size;
+        if (!read_file_into_buffer(input_files[i], &input_data, &input_capacity, &input_size, diagnostics)) 
         {
-            fprintf(stderr, "Error: Failed to read ARRAY length\n");
-            return false;
+            continue;
         }
 
-        bool first = true;
-        
-        while (!buffer_eof(&reader)) 
+        ctx.output_length = 0;
+        ctx.output_failed = false;
+        ctx.indent_level = 0;
+        if (!decode_bej_buffer(&ctx, input_data, input_size)) 
         {
-            if (!first)
-            {
-                fprintf(ctx->output_stream, ", ");
-            }
-            first = false;
-            
-            SFLV_t element_sflv;
-            if (!read_sflv_from_buffer(&reader, &element_sflv)) 
-            {
-                return false;
-            }
-            
-            // Decode array element
-            if (!decode_value(ctx, &element_sflv, entry)) 
-            {
-                free_sflv(&element_sflv);
-                return false;
-            }
-            free_sflv(&element_sflv);
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to decode %s, record skipped", input_files[i]);
+            continue;
+        }
+
+        // One document per line
+        out_putc(&ctx, '\n');
+        if (ctx.output_failed 
+            || fwrite(ctx.output_buffer, 1, ctx.output_length, output) != ctx.output_length) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to write NDJSON output");
+            write_ok = false;
+            break;
         }
+        decoded++;
     }
 
-    fprintf(ctx->output_stream, "]");
-    return true;
+    free(input_data);
+    bej_free(ctx.allocator, ctx.output_buffer);
+    free_arena(&arena);
+
+    if (decoded_count) 
+    {
+        *decoded_count = decoded;
+    }
+    return write_ok && decoded == count;
 }
 
-// ============================================================================
-// Main Decode Value Function
-// ============================================================================
+void init_decode_options(BejDecodeOptions_t* options)
+{
+    if (!options) return;
+
+    options->format = BEJ_OUTPUT_JSON;
+    options->compact = false;
+    options->threads = 0;
+    init_diagnostics(&options->diagnostics);
+    options->allocator = NULL;
+    options->streaming = false;
+    options->max_value_length = 0;
+    options->stats = NULL;
+    options->projection = NULL;
+    options->select = NULL;
+}
 
-bool decode_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry)
+bool bej_decode_to_memory(uint8_t* data, uint64_t size,
+                          Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                          const BejDecodeOptions_t* options, uint8_t** output, size_t* output_size)
 {
-    if (!ctx || !sflv) 
+    const BejDiagnostics_t* diagnostics = options ? &options->diagnostics : NULL;
+    if (!data || !output || !output_size) 
     {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
         return false;
     }
-    
-    switch (sflv->format) 
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, data, size);
+    if (!read_bej_header_from_buffer(&reader, diagnostics)) 
     {
-        case BEJ_FORMAT_SET:
-            return decode_set(ctx, sflv, entry);
-            
-        case BEJ_FORMAT_ARRAY:
-            return decode_array(ctx, sflv, entry);
-            
-        case BEJ_FORMAT_NULL:
-            return decode_null(ctx);
+        return false;
+    }
 
-        case BEJ_FORMAT_INTEGER: // check it
-            return decode_integer(ctx, sflv);
-            
-        case BEJ_FORMAT_ENUM:
-            return decode_enum(ctx, sflv, entry);
-            
-        case BEJ_FORMAT_STRING:
-            return decode_string(ctx, sflv);
-            
-        case BEJ_FORMAT_REAL: // check it
-            return decode_real(ctx, sflv);
-            
-        case BEJ_FORMAT_BOOLEAN:
-            return decode_boolean(ctx, sflv);
-                     
-        case BEJ_FORMAT_BYTE_STRING:
-            // Byte string could be base64 encoded
-            fprintf(ctx->output_stream, "\"<byte_string>\"");
-            return true;
-            
-        case BEJ_FORMAT_CHOICE:
-        case BEJ_FORMAT_PROPERTY_ANNOTATION:
-        case BEJ_FORMAT_REGISTRY_ITEM:
-            fprintf(stderr, "Warning: Format type 0x%02X not fully implemented\n", 
-                    sflv->format);
-            fprintf(ctx->output_stream, "null");
-            return true;
-            
-        default:
-            fprintf(stderr, "Error: Unknown format type 0x%02X\n", sflv->format);
-            fprintf(ctx->output_stream, "null");
-            return false;
+    SFLV_t sflv;
+    if (!read_sflv_header_from_buffer(&reader, &sflv)) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read SFLV tuple");
+        return false;
     }
-}
 
-// ============================================================================
-// Main Decode Function
-// ============================================================================
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, schema_dict, anno_dict, NULL, NULL);
+    if (options) 
+    {
+        ctx.output_format = options->format;
+        ctx.compact = options->compact;
+        ctx.parallel_threads = options->threads;
+        ctx.diagnostics = options->diagnostics;
+        ctx.allocator = options->allocator;
+        ctx.projection = options->projection;
+        ctx.projection_node = options->projection ? options->projection->nodes : NULL;
+    }
 
-bool decode_bej_to_json(DecoderContext_t* ctx)
-{
-    if (!ctx || !ctx->input_stream || !ctx->output_stream) 
+    // One pass straight into a growable buffer; sizing it from the input
+    // first means a typical document grows it once or not at all
+    set_output_buffer(&ctx, NULL, 0);
+    size_t estimate = size <= SIZE_MAX / OUTPUT_BYTES_PER_INPUT_BYTE ? (size_t)size * OUTPUT_BYTES_PER_INPUT_BYTE : 0;
+    if (!reserve_output(&ctx, estimate)) 
     {
-        fprintf(stderr, "Error: Invalid decoder context\n");
         return false;
     }
-    
-    // Read BEJ version header (4 bytes) (5.3.4)
-    // Version is 32-bit: 0xF1F0F000 (v1.0.0) or 0xF1F1F000 (v1.1.0)
-    uint8_t version_bytes[4];
-    if (fread(version_bytes, 1, 4, ctx->input_stream) != 4) 
+    bool result = decode_value(&ctx, &sflv, NULL) && !ctx.output_failed;
+
+    // One spare byte keeps JSON output NUL-terminated for C callers
+    result = result && reserve_output(&ctx, 1);
+    if (options && options->stats) 
     {
-        fprintf(stderr, "Error: Failed to read BEJ version\n");
-        return false;
+        *options->stats = ctx.stats;
     }
-    uint32_t version = version_bytes[0] | (version_bytes[1] << 8) 
-                      | (version_bytes[2] << 16) | (version_bytes[3] << 24);
-    fprintf(stderr, "BEJ Version: 0x%08X\n", version);
 
-    // Read BEJ flags (2 bytes) (5.3.4)
-    uint8_t BEG_flags_bytes[2];
-    if (fread(BEG_flags_bytes, 1, 2, ctx->input_stream) != 2) 
+    if (!result) 
     {
-        fprintf(stderr, "Error: Failed to read BEJ flags\n");
+        bej_free(ctx.allocator, ctx.output_buffer);
         return false;
     }
-    uint16_t BEG_flags = BEG_flags_bytes[0] | (BEG_flags_bytes[1] << 8);
-    fprintf(stderr, "BEJ Flags: 0x%04X\n", BEG_flags);
 
-    // Read schemaClass (1 byte) (5.3.2)
-    uint8_t schemaClass_bytes[1];
-    if (fread(schemaClass_bytes, 1, 1, ctx->input_stream) != 1) 
+    ctx.output_buffer[ctx.output_length] = '\0';
+    *output = ctx.output_buffer;
+    *output_size = ctx.output_length;
+    return true;
+}
+
+bool bej_decode_file(const char* input_file, const char* output_file,
+                     const char* schema_dict_file, const char* anno_dict_file)
+{
+    return bej_decode_file_as(input_file, output_file, schema_dict_file, anno_dict_file,
+                              BEJ_OUTPUT_JSON);
+}
+
+bool bej_decode_file_as(const char* input_file, const char* output_file,
+                        const char* schema_dict_file, const char* anno_dict_file,
+                        BejOutputFormat_t format)
+{
+    BejDecodeOptions_t options;
+    init_decode_options(&options);
+    options.format = format;
+    return bej_decode_file_with_options(input_file, output_file, schema_dict_file, anno_dict_file,
+                                        &options);
+}
+
+/// File-to-file decode for options->streaming: nothing is held beyond the parser state
+static bool decode_file_streaming(const char* input_file, const char* output_file,
+                                  Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                  const BejDecodeOptions_t* options)
+{
+    const BejDiagnostics_t* diagnostics = &options->diagnostics;
+
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Streaming %s to %s", input_file, output_file);
+    FILE* input = fopen(input_file, "rb");
+    if (!input) 
     {
-        fprintf(stderr, "Error: Failed to read Schema Class\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open input file %s", input_file);
         return false;
     }
-    uint8_t schemaClass = schemaClass_bytes[0];
-    fprintf(stderr, "Schema class: 0x%02X\n", schemaClass);
-    
-    SFLV_t sflv;
-
-    if (!read_sflv(ctx->input_stream, &sflv))
+    FILE* output = fopen(output_file, options->format == BEJ_OUTPUT_JSON ? "w" : "wb");
+    if (!output) 
     {
-        fprintf(stderr, "Error: Failed to read SFLV tuple\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot create output file %s", output_file);
+        fclose(input);
         return false;
     }
 
-    bool result = decode_value(ctx, &sflv, NULL);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, schema_dict, anno_dict, input, output);
+    ctx.output_format = options->format;
+    ctx.compact = options->compact;
+    ctx.diagnostics = options->diagnostics;
+    ctx.allocator = options->allocator;
+    ctx.max_value_length = options->max_value_length;
 
-    // Flush output to ensure it's written
-    fflush(ctx->output_stream);
-    
-    free_sflv(&sflv);
-    
-    if (result) 
+    bool result = decode_bej_to_json(&ctx);
+    if (options->stats) 
     {
-        fprintf(stderr, "Decoding completed successfully\n");
-    } 
-    else 
+        *options->stats = ctx.stats;
+    }
+    fclose(input);
+    if (fclose(output) != 0 && result) 
     {
-        fprintf(stderr, "Decoding failed\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to write output file %s", output_file);
+        result = false;
     }
-    
     return result;
 }
 
-// ============================================================================
-// High-Level API
-// ============================================================================
-
-bool bej_decode_file(const char* input_file, const char* output_file,
-                     const char* schema_dict_file, const char* anno_dict_file)
+bool bej_decode_file_with_options(const char* input_file, const char* output_file,
+                                  const char* schema_dict_file, const char* anno_dict_file,
+                                  const BejDecodeOptions_t* options)
 {
+    BejDecodeOptions_t defaults;
+    if (!options) 
+    {
+        init_decode_options(&defaults);
+        options = &defaults;
+    }
+    BejOutputFormat_t format = options->format;
+    const BejDiagnostics_t* diagnostics = &options->diagnostics;
+    const BejAllocator_t* allocator = options->allocator;
+
     if (!input_file || !output_file || !schema_dict_file || !anno_dict_file) 
     {
-        fprintf(stderr, "Error: Invalid parameters\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
         return false;
     }
     
-    fprintf(stderr, "Loading schema dictionary: %s\n", schema_dict_file);
-    Dictionary_t* schema_dict = load_dictionary(schema_dict_file);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Loading schema dictionary: %s", schema_dict_file);
+    Dictionary_t* schema_dict = load_dictionary_with_allocator(schema_dict_file, diagnostics, allocator);
     if (!schema_dict) 
     {
-        fprintf(stderr, "Error: Failed to load schema dictionary\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to load schema dictionary");
         return false;
     }
-    fprintf(stderr, "Schema dictionary loaded: %u entries\n", schema_dict->entry_count);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Schema dictionary loaded: %u entries", schema_dict->entry_count);
     //print_dictionary(schema_dict);
 
-    fprintf(stderr, "Loading annotation dictionary: %s\n", anno_dict_file);
-    Dictionary_t* anno_dict = load_dictionary(anno_dict_file);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Loading annotation dictionary: %s", anno_dict_file);
+    Dictionary_t* anno_dict = load_dictionary_with_allocator(anno_dict_file, diagnostics, allocator);
     if (!anno_dict) 
     {
-        fprintf(stderr, "Error: Failed to load annotation dictionary\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to load annotation dictionary");
         free_dictionary(schema_dict);
         return false;
     }
-    fprintf(stderr, "Annotation dictionary loaded: %u entries\n", anno_dict->entry_count);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Annotation dictionary loaded: %u entries", anno_dict->entry_count);
+
+    // A $select list can only be compiled once the schema dictionary is loaded
+    BejDecodeOptions_t projected;
+    BejProjection_t* projection = NULL;
+    if (options->select && !options->projection) 
+    {
+        projection = bej_compile_projection(schema_dict, options->select, allocator, diagnostics);
+        if (!projection) 
+        {
+            free_dictionary(schema_dict);
+            free_dictionary(anno_dict);
+            return false;
+        }
+        projected = *options;
+        projected.projection = projection;
+        options = &projected;
+    }
+
+    if (options->streaming) 
+    {
+        bool streamed = false;
+        if (options->projection) 
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "A projection cannot be combined with streaming");
+        }
+        else 
+        {
+            streamed = decode_file_streaming(input_file, output_file, schema_dict, anno_dict, options);
+        }
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        bej_free_projection(projection);
+        return streamed;
+    }
 
-    fprintf(stderr, "Opening input file: %s\n", input_file);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Opening input file: %s", input_file);
     FILE* input = fopen(input_file, "rb");
     if (!input) 
     {
-        fprintf(stderr, "Error: Cannot open input file %s\n", input_file);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open input file %s", input_file);
         free_dictionary(schema_dict);
         free_dictionary(anno_dict);
+        bej_free_projection(projection);
         return false;
     }
     
@@ -1035,45 +3816,82 @@ bool bej_decode_file(const char* input_file, const char* output_file,
     fseek(input, 0, SEEK_END);
     long input_size = ftell(input);
     fseek(input, 0, SEEK_SET);
-    fprintf(stderr, "Input file size: %ld bytes\n", input_size);
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Input file size: %ld bytes", input_size);
     
     if (input_size == 0) 
     {
-        fprintf(stderr, "Error: Input file is empty\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Input file is empty");
         fclose(input);
         free_dictionary(schema_dict);
         free_dictionary(anno_dict);
+        bej_free_projection(projection);
         return false;
     }
     
-    fprintf(stderr, "Creating output file: %s\n", output_file);
-    FILE* output = fopen(output_file, "w");
-    if (!output) 
+    // The document is read whole, since projection and parallel members work
+    // on the buffer; the output goes straight to the file as it is produced
+    uint8_t* input_data = (uint8_t*)bej_alloc(allocator, (size_t)input_size);
+    if (!input_data || fread(input_data, 1, (size_t)input_size, input) != (size_t)input_size) 
     {
-        fprintf(stderr, "Error: Cannot create output file %s\n", output_file);
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read input file %s", input_file);
+        bej_free(allocator, input_data);
         fclose(input);
         free_dictionary(schema_dict);
         free_dictionary(anno_dict);
+        bej_free_projection(projection);
         return false;
     }
-    
+    fclose(input);
+
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Creating output file: %s", output_file);
+    // Binary encodings must not go through text-mode newline translation
+    FILE* output = fopen(output_file, format == BEJ_OUTPUT_JSON ? "w" : "wb");
+    if (!output) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot create output file %s", output_file);
+        bej_free(allocator, input_data);
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        bej_free_projection(projection);
+        return false;
+    }
+
     DecoderContext_t ctx;
-    init_decoder_context(&ctx, schema_dict, anno_dict, input, output);
-    
-    fprintf(stderr, "Starting BEJ decode...\n");
-    bool result = decode_bej_to_json(&ctx);
+    init_decoder_context(&ctx, schema_dict, anno_dict, NULL, output);
+    ctx.output_format = format;
+    ctx.compact = options->compact;
+    ctx.parallel_threads = options->threads;
+    ctx.diagnostics = options->diagnostics;
+    ctx.allocator = allocator;
+    ctx.projection = options->projection;
+
+    bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Starting BEJ decode...");
+    bool decoded = decode_bej_buffer(&ctx, input_data, (uint64_t)input_size);
+    if (options->stats) 
+    {
+        *options->stats = ctx.stats;
+    }
+    bej_free(allocator, input_data);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    bej_free_projection(projection);
+
+    bool result = (fclose(output) == 0) && decoded;
+    if (!decoded) 
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to decode BEJ file");
+        return false;
+    }
+
     if (result)
     {
-        printf("Successfully decoded BEJ to JSON: %s\n", output_file);
+        bej_diagnose(diagnostics, BEJ_DIAG_INFO, "Successfully decoded BEJ to %s: %s",
+                     format == BEJ_OUTPUT_CBOR ? "CBOR" : format == BEJ_OUTPUT_MSGPACK ? "MessagePack" : "JSON",
+                     output_file);
     } 
     else 
     {
-        fprintf(stderr, "Error: Failed to decode BEJ file\n");
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to write output file %s", output_file);
     }
-    
-    fclose(input);
-    fclose(output);
-    free_dictionary(schema_dict);
-    free_dictionary(anno_dict);
     return result;
-}
\ No newline at end of file
+}
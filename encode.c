@@ -0,0 +1,1098 @@
+/**
+ * @file encode.c
+ * @author Vladyslav Kolodii
+ * @brief JSON-to-BEJ encoding with reverse name indexes over the dictionaries
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "encode.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Deepest JSON nesting accepted
+#define ENCODE_MAX_DEPTH 256
+
+/// Longest property or option name looked up; dictionary names are shorter than 255 bytes
+#define ENCODE_MAX_NAME 256
+
+// ============================================================================
+// Reverse Name Index
+// ============================================================================
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t first_child;       // entry index where the child range the name belongs to starts
+    uint32_t entry;             // entry index + 1; 0 marks an empty slot
+    uint32_t name_length;
+} NameSlot_t;
+
+struct BejNameIndex
+{
+    const Dictionary_t* dict;
+    NameSlot_t* slots;
+    uint32_t slot_mask;         // slot count - 1; the count is a power of two
+};
+
+/// Index of parent's first child, or false if it has none inside the dictionary
+static bool first_child_of(const Dictionary_t* dict, const DictionaryEntry_t* parent, uint32_t* first_child)
+{
+    const uint32_t DICTIONARY_HEADER_SIZE = 12;
+    const uint32_t DICTIONARY_ENTRY_SIZE = 10;
+    if (parent->child_count == 0 || parent->child_pointer_offset < DICTIONARY_HEADER_SIZE)
+    {
+        return false;
+    }
+    *first_child = (parent->child_pointer_offset - DICTIONARY_HEADER_SIZE) / DICTIONARY_ENTRY_SIZE;
+    return *first_child + parent->child_count <= dict->entry_count;
+}
+
+/// FNV-1a over the name, seeded with the child range
+static uint32_t hash_name(uint32_t first_child, const char* name, size_t length)
+{
+    uint32_t hash = (2166136261u ^ first_child) * 16777619u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/// Slot holding the name in the child range, or the empty slot where it belongs
+static NameSlot_t* find_name_slot(const BejNameIndex_t* index, uint32_t first_child, const char* name,
+                                  size_t length, uint32_t hash)
+{
+    for (uint32_t i = hash & index->slot_mask;; i = (i + 1) & index->slot_mask)
+    {
+        NameSlot_t* slot = &index->slots[i];
+        if (slot->entry == 0)
+        {
+            return slot;
+        }
+        if (slot->hash == hash && slot->first_child == first_child && slot->name_length == length
+            && memcmp(index->dict->entries[slot->entry - 1].name, name, length) == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+BejNameIndex_t* bej_name_index_create(const Dictionary_t* dict)
+{
+    if (!dict || !dict->entries)
+    {
+        return NULL;
+    }
+
+    // At most one slot per child reference, kept at most half full
+    uint64_t names = 0;
+    for (uint32_t i = 0; i < dict->entry_count; i++)
+    {
+        names += dict->entries[i].child_count;
+    }
+    uint32_t slot_count = 16;
+    while (slot_count < names * 2)
+    {
+        slot_count *= 2;
+    }
+
+    BejNameIndex_t* index = (BejNameIndex_t*)calloc(1, sizeof(BejNameIndex_t));
+    if (index)
+    {
+        index->slots = (NameSlot_t*)calloc(slot_count, sizeof(NameSlot_t));
+    }
+    if (!index || !index->slots)
+    {
+        bej_name_index_free(index);
+        return NULL;
+    }
+    index->dict = dict;
+    index->slot_mask = slot_count - 1;
+
+    // Parents sharing a child range find the same slots already filled
+    for (uint32_t i = 0; i < dict->entry_count; i++)
+    {
+        uint32_t first_child;
+        if (!first_child_of(dict, &dict->entries[i], &first_child))
+        {
+            continue;
+        }
+        for (uint32_t child = first_child; child < first_child + dict->entries[i].child_count; child++)
+        {
+            const char* name = dict->entries[child].name;
+            if (!name)
+            {
+                continue;
+            }
+            size_t length = strlen(name);
+            uint32_t hash = hash_name(first_child, name, length);
+            NameSlot_t* slot = find_name_slot(index, first_child, name, length, hash);
+            if (slot->entry == 0)
+            {
+                slot->hash = hash;
+                slot->first_child = first_child;
+                slot->entry = child + 1;
+                slot->name_length = (uint32_t)length;
+            }
+        }
+    }
+    return index;
+}
+
+const DictionaryEntry_t* bej_name_index_find(const BejNameIndex_t* index, const DictionaryEntry_t* parent,
+                                             const char* name, size_t length)
+{
+    uint32_t first_child;
+    if (!index || !parent || !name || !first_child_of(index->dict, parent, &first_child))
+    {
+        return NULL;
+    }
+    const NameSlot_t* slot = find_name_slot(index, first_child, name, length, hash_name(first_child, name, length));
+    if (slot->entry == 0 || slot->entry - 1 < first_child || slot->entry - 1 >= first_child + parent->child_count)
+    {
+        return NULL;
+    }
+    return &index->dict->entries[slot->entry - 1];
+}
+
+void bej_name_index_free(BejNameIndex_t* index)
+{
+    if (!index) return;
+
+    free(index->slots);
+    free(index);
+}
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+typedef enum
+{
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL
+} JsonKind_t;
+
+/// One JSON value; objects are followed by key/value token pairs, arrays by their elements
+typedef struct
+{
+    uint32_t start;             // text offset; a string starts after its opening quote
+    uint32_t end;               // text end; a string ends at its closing quote
+    uint32_t next;              // token after this value and everything inside it
+    uint32_t count;             // object members or array elements
+    uint64_t length;            // strings: text length with escapes resolved; after sizing: BEJ value length
+    uint64_t sequence;          // after sizing: sequence number << 1 | dictionary selector
+    union
+    {
+        int64_t integer;        // INTEGER value, or ENUM option sequence number
+        double real;
+    } number;
+    uint8_t kind;               // JsonKind_t
+    uint8_t format;             // after sizing: BEJ_FORMAT_*
+    bool escaped;               // string contains escapes
+} JsonToken_t;
+
+struct BejEncoder
+{
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+    BejNameIndex_t* schema_index;
+    BejNameIndex_t* anno_index;
+    BejDiagnostics_t diagnostics;
+    const char* json;           // document being encoded
+    size_t json_length;
+    JsonToken_t* tokens;        // reused by every document
+    uint32_t token_count;
+    uint32_t token_capacity;
+};
+
+static bool json_error(BejEncoder_t* encoder, size_t position, const char* message)
+{
+    bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "JSON error at offset %zu: %s", position, message);
+    return false;
+}
+
+static size_t skip_whitespace(const BejEncoder_t* encoder, size_t position)
+{
+    while (position < encoder->json_length)
+    {
+        char c = encoder->json[position];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+        {
+            break;
+        }
+        position++;
+    }
+    return position;
+}
+
+static bool add_token(BejEncoder_t* encoder, JsonKind_t kind, size_t start, uint32_t* token)
+{
+    if (encoder->token_count == encoder->token_capacity)
+    {
+        uint32_t capacity = encoder->token_capacity ? encoder->token_capacity * 2 : 256;
+        JsonToken_t* grown = (JsonToken_t*)realloc(encoder->tokens, capacity * sizeof(JsonToken_t));
+        if (!grown)
+        {
+            bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate JSON tokens");
+            return false;
+        }
+        encoder->tokens = grown;
+        encoder->token_capacity = capacity;
+    }
+    *token = encoder->token_count++;
+    JsonToken_t* added = &encoder->tokens[*token];
+    memset(added, 0, sizeof(*added));
+    added->kind = (uint8_t)kind;
+    added->start = (uint32_t)start;
+    return true;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/// Code unit of the \uXXXX escape at text, or -1 if it is malformed
+static long read_hex4(const char* text, size_t available)
+{
+    if (available < 6 || text[0] != '\\' || text[1] != 'u')
+    {
+        return -1;
+    }
+    long value = 0;
+    for (int i = 2; i < 6; i++)
+    {
+        int digit = hex_value(text[i]);
+        if (digit < 0)
+        {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+/// Decode the escape at text[0] == '\\'; *consumed receives its length in the text.
+/// Writes the UTF-8 bytes to out when it is not NULL and returns how many there are (0 on error).
+static size_t unescape_one(const char* text, size_t available, size_t* consumed, char* out)
+{
+    char single = 0;
+    switch (available > 1 ? text[1] : '\0')
+    {
+        case '"':  single = '"'; break;
+        case '\\': single = '\\'; break;
+        case '/':  single = '/'; break;
+        case 'b':  single = '\b'; break;
+        case 'f':  single = '\f'; break;
+        case 'n':  single = '\n'; break;
+        case 'r':  single = '\r'; break;
+        case 't':  single = '\t'; break;
+        case 'u':  break;
+        default:   return 0;
+    }
+    if (single)
+    {
+        *consumed = 2;
+        if (out) *out = single;
+        return 1;
+    }
+
+    // A high surrogate needs its low half to make one code point
+    long code = read_hex4(text, available);
+    *consumed = 6;
+    if (code >= 0xD800 && code <= 0xDBFF)
+    {
+        long low = read_hex4(text + 6, available - 6);
+        if (low < 0xDC00 || low > 0xDFFF)
+        {
+            return 0;
+        }
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        *consumed = 12;
+    }
+    else if (code < 0 || (code >= 0xDC00 && code <= 0xDFFF))
+    {
+        return 0;
+    }
+
+    uint8_t bytes[4];
+    size_t count;
+    if (code < 0x80)
+    {
+        bytes[0] = (uint8_t)code;
+        count = 1;
+    }
+    else if (code < 0x800)
+    {
+        bytes[0] = (uint8_t)(0xC0 | (code >> 6));
+        bytes[1] = (uint8_t)(0x80 | (code & 0x3F));
+        count = 2;
+    }
+    else if (code < 0x10000)
+    {
+        bytes[0] = (uint8_t)(0xE0 | (code >> 12));
+        bytes[1] = (uint8_t)(0x80 | ((code >> 6) & 0x3F));
+        bytes[2] = (uint8_t)(0x80 | (code & 0x3F));
+        count = 3;
+    }
+    else
+    {
+        bytes[0] = (uint8_t)(0xF0 | (code >> 18));
+        bytes[1] = (uint8_t)(0x80 | ((code >> 12) & 0x3F));
+        bytes[2] = (uint8_t)(0x80 | ((code >> 6) & 0x3F));
+        bytes[3] = (uint8_t)(0x80 | (code & 0x3F));
+        count = 4;
+    }
+    if (out)
+    {
+        memcpy(out, bytes, count);
+    }
+    return count;
+}
+
+/// Copy a validated string token's text to out with its escapes resolved
+static void unescape_string(const BejEncoder_t* encoder, const JsonToken_t* token, char* out)
+{
+    const char* text = encoder->json + token->start;
+    size_t length = token->end - token->start;
+    if (!token->escaped)
+    {
+        memcpy(out, text, length);
+        return;
+    }
+    for (size_t i = 0; i < length;)
+    {
+        if (text[i] != '\\')
+        {
+            *out++ = text[i++];
+            continue;
+        }
+        size_t consumed;
+        out += unescape_one(text + i, length - i, &consumed, out);
+        i += consumed;
+    }
+}
+
+static bool parse_string(BejEncoder_t* encoder, size_t* position, uint32_t* token)
+{
+    size_t start = *position + 1;
+    if (!add_token(encoder, JSON_STRING, start, token))
+    {
+        return false;
+    }
+
+    // Measured here so sizing never walks the text again
+    const char* json = encoder->json;
+    uint64_t length = 0;
+    bool escaped = false;
+    size_t i = start;
+    for (; i < encoder->json_length && json[i] != '"'; )
+    {
+        unsigned char c = (unsigned char)json[i];
+        if (c < 0x20)
+        {
+            return json_error(encoder, i, "control character in string");
+        }
+        if (c != '\\')
+        {
+            length++;
+            i++;
+            continue;
+        }
+        size_t consumed;
+        size_t bytes = unescape_one(json + i, encoder->json_length - i, &consumed, NULL);
+        if (bytes == 0)
+        {
+            return json_error(encoder, i, "invalid escape");
+        }
+        length += bytes;
+        escaped = true;
+        i += consumed;
+    }
+    if (i >= encoder->json_length)
+    {
+        return json_error(encoder, start - 1, "unterminated string");
+    }
+
+    JsonToken_t* added = &encoder->tokens[*token];
+    added->end = (uint32_t)i;
+    added->length = length;
+    added->escaped = escaped;
+    added->next = encoder->token_count;
+    *position = i + 1;
+    return true;
+}
+
+/// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool parse_number(BejEncoder_t* encoder, size_t* position, uint32_t* token)
+{
+    const char* json = encoder->json;
+    size_t end = encoder->json_length;
+    size_t i = *position;
+    if (i < end && json[i] == '-') i++;
+    if (i < end && json[i] == '0')
+    {
+        i++;
+    }
+    else
+    {
+        if (i >= end || json[i] < '1' || json[i] > '9')
+        {
+            return json_error(encoder, *position, "invalid number");
+        }
+        while (i < end && json[i] >= '0' && json[i] <= '9') i++;
+    }
+    if (i < end && json[i] == '.')
+    {
+        size_t digits = ++i;
+        while (i < end && json[i] >= '0' && json[i] <= '9') i++;
+        if (i == digits)
+        {
+            return json_error(encoder, *position, "invalid number");
+        }
+    }
+    if (i < end && (json[i] == 'e' || json[i] == 'E'))
+    {
+        i++;
+        if (i < end && (json[i] == '+' || json[i] == '-')) i++;
+        size_t digits = i;
+        while (i < end && json[i] >= '0' && json[i] <= '9') i++;
+        if (i == digits)
+        {
+            return json_error(encoder, *position, "invalid number");
+        }
+    }
+
+    if (!add_token(encoder, JSON_NUMBER, *position, token))
+    {
+        return false;
+    }
+    encoder->tokens[*token].end = (uint32_t)i;
+    encoder->tokens[*token].next = encoder->token_count;
+    *position = i;
+    return true;
+}
+
+static bool parse_value(BejEncoder_t* encoder, size_t* position, uint32_t depth, uint32_t* token);
+
+/// Object or array members, up to the closing bracket
+static bool parse_container(BejEncoder_t* encoder, size_t* position, uint32_t depth, uint32_t* token)
+{
+    bool object = encoder->json[*position] == '{';
+    char close = object ? '}' : ']';
+    if (depth >= ENCODE_MAX_DEPTH)
+    {
+        return json_error(encoder, *position, "nesting too deep");
+    }
+    if (!add_token(encoder, object ? JSON_OBJECT : JSON_ARRAY, *position, token))
+    {
+        return false;
+    }
+
+    uint32_t count = 0;
+    size_t i = skip_whitespace(encoder, *position + 1);
+    if (i < encoder->json_length && encoder->json[i] == close)
+    {
+        i++;
+    }
+    else
+    {
+        for (;;)
+        {
+            uint32_t member;
+            if (object)
+            {
+                if (i >= encoder->json_length || encoder->json[i] != '"')
+                {
+                    return json_error(encoder, i, "expected a property name");
+                }
+                if (!parse_string(encoder, &i, &member))
+                {
+                    return false;
+                }
+                i = skip_whitespace(encoder, i);
+                if (i >= encoder->json_length || encoder->json[i] != ':')
+                {
+                    return json_error(encoder, i, "expected ':'");
+                }
+                i++;
+            }
+            if (!parse_value(encoder, &i, depth + 1, &member))
+            {
+                return false;
+            }
+            count++;
+
+            i = skip_whitespace(encoder, i);
+            if (i < encoder->json_length && encoder->json[i] == ',')
+            {
+                i = skip_whitespace(encoder, i + 1);
+                continue;
+            }
+            if (i < encoder->json_length && encoder->json[i] == close)
+            {
+                i++;
+                break;
+            }
+            return json_error(encoder, i, object ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+    }
+
+    JsonToken_t* added = &encoder->tokens[*token];
+    added->count = count;
+    added->end = (uint32_t)i;
+    added->next = encoder->token_count;
+    *position = i;
+    return true;
+}
+
+static bool parse_literal(BejEncoder_t* encoder, size_t* position, const char* word, JsonKind_t kind,
+                          uint32_t* token)
+{
+    size_t length = strlen(word);
+    if (encoder->json_length - *position < length || memcmp(encoder->json + *position, word, length) != 0)
+    {
+        return json_error(encoder, *position, "unexpected character");
+    }
+    if (!add_token(encoder, kind, *position, token))
+    {
+        return false;
+    }
+    *position += length;
+    encoder->tokens[*token].end = (uint32_t)*position;
+    encoder->tokens[*token].next = encoder->token_count;
+    return true;
+}
+
+static bool parse_value(BejEncoder_t* encoder, size_t* position, uint32_t depth, uint32_t* token)
+{
+    *position = skip_whitespace(encoder, *position);
+    if (*position >= encoder->json_length)
+    {
+        return json_error(encoder, *position, "unexpected end of input");
+    }
+
+    switch (encoder->json[*position])
+    {
+        case '{':
+        case '[':
+            return parse_container(encoder, position, depth, token);
+        case '"':
+            return parse_string(encoder, position, token);
+        case 't':
+            return parse_literal(encoder, position, "true", JSON_TRUE, token);
+        case 'f':
+            return parse_literal(encoder, position, "false", JSON_FALSE, token);
+        case 'n':
+            return parse_literal(encoder, position, "null", JSON_NULL, token);
+        default:
+            return parse_number(encoder, position, token);
+    }
+}
+
+// ============================================================================
+// Sizing Pass
+// ============================================================================
+
+/// Bytes of a BEJ NNINT: a length byte, then at least one value byte
+static uint64_t nnint_size(uint64_t value)
+{
+    uint64_t bytes = 1;
+    while (bytes < 8 && (value >> (8 * bytes)) != 0)
+    {
+        bytes++;
+    }
+    return 1 + bytes;
+}
+
+/// Bytes of the shortest two's complement form of value
+static uint64_t integer_size(int64_t value)
+{
+    uint64_t bytes = 1;
+    while (bytes < 8)
+    {
+        int64_t limit = (int64_t)1 << (8 * bytes - 1);
+        if (value >= -limit && value < limit)
+        {
+            break;
+        }
+        bytes++;
+    }
+    return bytes;
+}
+
+static int base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/// Decoded size of padded base64 text, or false if it is not base64
+static bool base64_size(const char* text, size_t length, uint64_t* size)
+{
+    if (length % 4 != 0)
+    {
+        return false;
+    }
+    size_t padding = 0;
+    while (padding < 2 && padding < length && text[length - 1 - padding] == '=')
+    {
+        padding++;
+    }
+    for (size_t i = 0; i < length - padding; i++)
+    {
+        if (base64_value(text[i]) < 0)
+        {
+            return false;
+        }
+    }
+    *size = length / 4 * 3 - padding;
+    return true;
+}
+
+static uint8_t* base64_decode_into(const char* text, size_t length, uint8_t* out)
+{
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (size_t i = 0; i < length && text[i] != '='; i++)
+    {
+        bits = (bits << 6) | (uint32_t)base64_value(text[i]);
+        bit_count += 6;
+        if (bit_count >= 8)
+        {
+            bit_count -= 8;
+            *out++ = (uint8_t)(bits >> bit_count);
+        }
+    }
+    return out;
+}
+
+/// Text of a string token with escapes resolved, for name lookups; false if it is too long
+static bool token_name(const BejEncoder_t* encoder, const JsonToken_t* token, char* buffer,
+                       const char** name, size_t* length)
+{
+    *length = (size_t)token->length;
+    if (!token->escaped)
+    {
+        *name = encoder->json + token->start;
+        return true;
+    }
+    if (token->length >= ENCODE_MAX_NAME)
+    {
+        return false;
+    }
+    unescape_string(encoder, token, buffer);
+    *name = buffer;
+    return true;
+}
+
+static bool encode_error(BejEncoder_t* encoder, const JsonToken_t* token, const DictionaryEntry_t* entry,
+                         const char* message)
+{
+    bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "Encode error at offset %u (%s): %s",
+                 token->start, entry && entry->name ? entry->name : "?", message);
+    return false;
+}
+
+static bool size_value(BejEncoder_t* encoder, uint32_t index, const DictionaryEntry_t* entry, uint8_t selector,
+                       uint64_t* tuple_size);
+
+/// Resolve each member name and size its tuple
+static bool size_set(BejEncoder_t* encoder, uint32_t index, const DictionaryEntry_t* entry, uint8_t selector,
+                     uint64_t* length)
+{
+    JsonToken_t* tokens = encoder->tokens;
+    *length = nnint_size(tokens[index].count);
+    uint32_t key = index + 1;
+    for (uint32_t member = 0; member < tokens[index].count; member++)
+    {
+        char buffer[ENCODE_MAX_NAME];
+        const char* name;
+        size_t name_length;
+        if (!token_name(encoder, &tokens[key], buffer, &name, &name_length))
+        {
+            return encode_error(encoder, &tokens[key], entry, "property name too long");
+        }
+
+        // '@' names come from the annotation dictionary, whose root entry holds them
+        const DictionaryEntry_t* parent = entry;
+        const BejNameIndex_t* names = selector ? encoder->anno_index : encoder->schema_index;
+        uint8_t member_selector = selector;
+        if (name_length > 0 && name[0] == '@' && selector == 0 && encoder->anno_index)
+        {
+            parent = &encoder->anno_dict->entries[0];
+            names = encoder->anno_index;
+            member_selector = 1;
+        }
+        const DictionaryEntry_t* child = bej_name_index_find(names, parent, name, name_length);
+        if (!child)
+        {
+            bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "Encode error at offset %u: unknown property '%.*s'",
+                         tokens[key].start, (int)name_length, name);
+            return false;
+        }
+
+        uint32_t value = key + 1;
+        uint64_t member_size;
+        tokens[value].sequence = ((uint64_t)child->sequence_number << 1) | member_selector;
+        if (!size_value(encoder, value, child, member_selector, &member_size))
+        {
+            return false;
+        }
+        *length += member_size;
+        key = tokens[value].next;
+    }
+    return true;
+}
+
+/// Size every element against the array's element entry; elements are numbered from 0
+static bool size_array(BejEncoder_t* encoder, uint32_t index, const DictionaryEntry_t* entry, uint8_t selector,
+                       uint64_t* length)
+{
+    JsonToken_t* tokens = encoder->tokens;
+    Dictionary_t* dict = selector ? encoder->anno_dict : encoder->schema_dict;
+    const DictionaryEntry_t* element = find_dictionary_entry(dict, (DictionaryEntry_t*)entry, 0, -1);
+    if (!element && tokens[index].count > 0)
+    {
+        return encode_error(encoder, &tokens[index], entry, "array has no element type");
+    }
+
+    *length = nnint_size(tokens[index].count);
+    uint32_t value = index + 1;
+    for (uint32_t position = 0; position < tokens[index].count; position++)
+    {
+        uint64_t element_size;
+        tokens[value].sequence = ((uint64_t)position << 1) | selector;
+        if (!size_value(encoder, value, element, selector, &element_size))
+        {
+            return false;
+        }
+        *length += element_size;
+        value = tokens[value].next;
+    }
+    return true;
+}
+
+static bool size_number(BejEncoder_t* encoder, JsonToken_t* token, const DictionaryEntry_t* entry)
+{
+    char text[64];
+    size_t length = token->end - token->start;
+    if (length >= sizeof(text))
+    {
+        return encode_error(encoder, token, entry, "number too long");
+    }
+    memcpy(text, encoder->json + token->start, length);
+    text[length] = '\0';
+
+    errno = 0;
+    if (token->format == BEJ_FORMAT_INTEGER)
+    {
+        if (strcspn(text, ".eE") != length)
+        {
+            return encode_error(encoder, token, entry, "expected an integer");
+        }
+        token->number.integer = strtoll(text, NULL, 10);
+        token->length = integer_size(token->number.integer);
+    }
+    else
+    {
+        token->number.real = strtod(text, NULL);
+        token->length = sizeof(double);
+    }
+    return errno == 0 || encode_error(encoder, token, entry, "number out of range");
+}
+
+/// Pick the BEJ format of a value and compute its length and its whole tuple's size
+static bool size_value(BejEncoder_t* encoder, uint32_t index, const DictionaryEntry_t* entry, uint8_t selector,
+                       uint64_t* tuple_size)
+{
+    JsonToken_t* token = &encoder->tokens[index];
+    uint8_t format = get_msb4(entry->format);
+    bool ok = true;
+
+    // A string token arrives holding its unescaped text length
+    if (token->kind == JSON_NULL)
+    {
+        token->format = BEJ_FORMAT_NULL;
+        token->length = 0;
+    }
+    else
+    {
+        token->format = format;
+        switch (format)
+        {
+            case BEJ_FORMAT_SET:
+                ok = token->kind == JSON_OBJECT
+                    ? size_set(encoder, index, entry, selector, &token->length)
+                    : encode_error(encoder, token, entry, "expected an object");
+                break;
+
+            case BEJ_FORMAT_ARRAY:
+                ok = token->kind == JSON_ARRAY
+                    ? size_array(encoder, index, entry, selector, &token->length)
+                    : encode_error(encoder, token, entry, "expected an array");
+                break;
+
+            case BEJ_FORMAT_INTEGER:
+            case BEJ_FORMAT_REAL:
+                ok = token->kind == JSON_NUMBER
+                    ? size_number(encoder, token, entry)
+                    : encode_error(encoder, token, entry, "expected a number");
+                break;
+
+            case BEJ_FORMAT_BOOLEAN:
+                ok = token->kind == JSON_TRUE || token->kind == JSON_FALSE
+                    || encode_error(encoder, token, entry, "expected true or false");
+                token->length = 1;
+                break;
+
+            case BEJ_FORMAT_STRING:
+                ok = token->kind == JSON_STRING || encode_error(encoder, token, entry, "expected a string");
+                token->length += 1;     // NUL terminator (5.3.13)
+                break;
+
+            case BEJ_FORMAT_ENUM:
+            {
+                char buffer[ENCODE_MAX_NAME];
+                const char* name;
+                size_t name_length;
+                const BejNameIndex_t* names = selector ? encoder->anno_index : encoder->schema_index;
+                const DictionaryEntry_t* option = token->kind == JSON_STRING
+                    && token_name(encoder, token, buffer, &name, &name_length)
+                    ? bej_name_index_find(names, entry, name, name_length) : NULL;
+                if (!option)
+                {
+                    return encode_error(encoder, token, entry, "not an option of the enum");
+                }
+                token->number.integer = option->sequence_number;
+                token->length = nnint_size(option->sequence_number);
+                break;
+            }
+
+            case BEJ_FORMAT_BYTE_STRING:
+                ok = (token->kind == JSON_STRING && !token->escaped
+                      && base64_size(encoder->json + token->start, token->end - token->start, &token->length))
+                    || encode_error(encoder, token, entry, "expected base64 text");
+                break;
+
+            default:
+                return encode_error(encoder, token, entry, "format not supported by the encoder");
+        }
+    }
+
+    *tuple_size = nnint_size(token->sequence) + 1 + nnint_size(token->length) + token->length;
+    return ok;
+}
+
+// ============================================================================
+// Emission Pass
+// ============================================================================
+
+static uint8_t* write_nnint(uint8_t* out, uint64_t value)
+{
+    uint8_t bytes = (uint8_t)(nnint_size(value) - 1);
+    *out++ = bytes;
+    for (uint8_t i = 0; i < bytes; i++)
+    {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
+
+/// Write the tuple of a sized token; every length is already final
+static uint8_t* emit_tuple(const BejEncoder_t* encoder, uint32_t index, uint8_t* out)
+{
+    const JsonToken_t* tokens = encoder->tokens;
+    const JsonToken_t* token = &tokens[index];
+    out = write_nnint(out, token->sequence);
+    *out++ = (uint8_t)(token->format << 4);
+    out = write_nnint(out, token->length);
+
+    switch (token->format)
+    {
+        case BEJ_FORMAT_SET:
+        case BEJ_FORMAT_ARRAY:
+        {
+            // SET members are key/value pairs; only the value carries a tuple
+            bool set = token->format == BEJ_FORMAT_SET;
+            out = write_nnint(out, token->count);
+            uint32_t member = index + 1;
+            for (uint32_t i = 0; i < token->count; i++)
+            {
+                uint32_t value = set ? member + 1 : member;
+                out = emit_tuple(encoder, value, out);
+                member = tokens[value].next;
+            }
+            break;
+        }
+
+        case BEJ_FORMAT_INTEGER:
+            for (uint64_t i = 0; i < token->length; i++)
+            {
+                *out++ = (uint8_t)((uint64_t)token->number.integer >> (8 * i));
+            }
+            break;
+
+        case BEJ_FORMAT_REAL:
+            memcpy(out, &token->number.real, sizeof(double));
+            out += sizeof(double);
+            break;
+
+        case BEJ_FORMAT_BOOLEAN:
+            *out++ = token->kind == JSON_TRUE;
+            break;
+
+        case BEJ_FORMAT_STRING:
+            unescape_string(encoder, token, (char*)out);
+            out += token->length - 1;
+            *out++ = '\0';
+            break;
+
+        case BEJ_FORMAT_ENUM:
+            out = write_nnint(out, (uint64_t)token->number.integer);
+            break;
+
+        case BEJ_FORMAT_BYTE_STRING:
+            out = base64_decode_into(encoder->json + token->start, token->end - token->start, out);
+            break;
+
+        default:
+            break;
+    }
+    return out;
+}
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+BejEncoder_t* bej_encoder_create(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                 const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    BejEncoder_t* encoder = (BejEncoder_t*)calloc(1, sizeof(BejEncoder_t));
+    if (!encoder)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate encoder");
+        return NULL;
+    }
+    encoder->schema_dict = schema_dict;
+    encoder->anno_dict = anno_dict && anno_dict->entries && anno_dict->entry_count > 0 ? anno_dict : NULL;
+    if (diagnostics)
+    {
+        encoder->diagnostics = *diagnostics;
+    }
+    else
+    {
+        init_diagnostics(&encoder->diagnostics);
+    }
+
+    encoder->schema_index = bej_name_index_create(schema_dict);
+    encoder->anno_index = encoder->anno_dict ? bej_name_index_create(encoder->anno_dict) : NULL;
+    if (!encoder->schema_index || (encoder->anno_dict && !encoder->anno_index))
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to build dictionary name index");
+        bej_encoder_free(encoder);
+        return NULL;
+    }
+    return encoder;
+}
+
+bool bej_encode_json(BejEncoder_t* encoder, const char* json, size_t length,
+                     uint8_t** output, size_t* capacity, size_t* size)
+{
+    if (!encoder || !json || !output || !capacity || !size)
+    {
+        return false;
+    }
+    if (length >= UINT32_MAX)
+    {
+        bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "JSON document is too large");
+        return false;
+    }
+
+    encoder->json = json;
+    encoder->json_length = length;
+    encoder->token_count = 0;
+
+    uint32_t root;
+    size_t position = 0;
+    if (!parse_value(encoder, &position, 0, &root))
+    {
+        return false;
+    }
+    position = skip_whitespace(encoder, position);
+    if (position != length)
+    {
+        return json_error(encoder, position, "unexpected text after the document");
+    }
+    if (encoder->tokens[root].kind != JSON_OBJECT)
+    {
+        return json_error(encoder, 0, "the document must be an object");
+    }
+
+    // The root SET is sequence 0 of the schema dictionary
+    uint64_t root_size;
+    encoder->tokens[root].sequence = 0;
+    if (!size_value(encoder, root, &encoder->schema_dict->entries[0], 0, &root_size))
+    {
+        return false;
+    }
+
+    uint64_t total = BEJ_HEADER_SIZE + root_size;
+    if (total > SIZE_MAX)
+    {
+        bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "Encoded document is too large");
+        return false;
+    }
+    if (*capacity < total)
+    {
+        uint8_t* grown = (uint8_t*)realloc(*output, (size_t)total);
+        if (!grown)
+        {
+            bej_diagnose(&encoder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate output buffer");
+            return false;
+        }
+        *output = grown;
+        *capacity = (size_t)total;
+    }
+
+    // Version 1.0.0 (0xF1F0F000), no flags, major schema class
+    static const uint8_t HEADER[BEJ_HEADER_SIZE] = { 0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00 };
+    memcpy(*output, HEADER, BEJ_HEADER_SIZE);
+    emit_tuple(encoder, root, *output + BEJ_HEADER_SIZE);
+    *size = (size_t)total;
+    return true;
+}
+
+void bej_encoder_free(BejEncoder_t* encoder)
+{
+    if (!encoder) return;
+
+    bej_name_index_free(encoder->schema_index);
+    bej_name_index_free(encoder->anno_index);
+    free(encoder->tokens);
+    free(encoder);
+}
@@ -0,0 +1,800 @@
+/**
+ * @file filter.c
+ * @author Vladyslav Kolodii
+ * @brief Predicate filters evaluated directly on BEJ payloads, without decoding them
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "filter.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Deepest nesting of parentheses accepted
+#define FILTER_MAX_DEPTH 64
+
+typedef enum
+{
+    FILTER_EQ,
+    FILTER_NE,
+    FILTER_LT,
+    FILTER_LE,
+    FILTER_GT,
+    FILTER_GE
+} FilterOp_t;
+
+typedef enum
+{
+    LITERAL_INTEGER,
+    LITERAL_REAL,
+    LITERAL_STRING,
+    LITERAL_BOOLEAN,
+    LITERAL_NULL
+} LiteralKind_t;
+
+/// path operator literal, with everything resolved against the dictionaries
+typedef struct
+{
+    uint32_t first_step;        // steps[first_step .. first_step + step_count) lead to the value
+    uint32_t step_count;
+    FilterOp_t op;
+    uint8_t format;             // BEJ_FORMAT_* the dictionary gives the property
+    LiteralKind_t kind;
+    int64_t integer;            // LITERAL_INTEGER
+    double real;                // LITERAL_INTEGER and LITERAL_REAL
+    bool boolean;               // LITERAL_BOOLEAN
+    uint32_t enum_sequence;     // LITERAL_STRING compared with an ENUM
+    uint32_t string;            // LITERAL_STRING: offset into strings
+    uint32_t string_length;
+} FilterComparison_t;
+
+typedef enum
+{
+    NODE_COMPARE,
+    NODE_AND,
+    NODE_OR
+} FilterNodeKind_t;
+
+typedef struct
+{
+    FilterNodeKind_t kind;
+    uint32_t left;              // NODE_COMPARE: index of the comparison
+    uint32_t right;
+} FilterNode_t;
+
+struct BejFilter
+{
+    FilterNode_t* nodes;
+    uint32_t node_count;
+    uint32_t root;
+    FilterComparison_t* comparisons;
+    uint32_t comparison_count;
+    BejPathStep_t* steps;
+    uint32_t step_count;
+    char* strings;              // string literals, unescaped
+    uint32_t strings_size;
+};
+
+typedef struct
+{
+    BejFilter_t* filter;
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+    const char* expression;
+    const char* position;
+    uint32_t depth;
+    const BejDiagnostics_t* diagnostics;
+} FilterParser_t;
+
+// ============================================================================
+// Compilation
+// ============================================================================
+
+static void skip_space(FilterParser_t* parser)
+{
+    while (isspace((unsigned char)*parser->position))
+    {
+        parser->position++;
+    }
+}
+
+/// Whether c may continue a path or keyword
+static bool is_word_char(char c)
+{
+    return c != '\0' && !isspace((unsigned char)c) && strchr("=!<>()&|\"", c) == NULL;
+}
+
+/// Consume word if it is the next token
+static bool accept_word(FilterParser_t* parser, const char* word)
+{
+    size_t length = strlen(word);
+    if (strncmp(parser->position, word, length) != 0)
+    {
+        return false;
+    }
+    if (isalpha((unsigned char)word[0]) && is_word_char(parser->position[length]))
+    {
+        return false;       // "order" does not start with "or"
+    }
+    parser->position += length;
+    skip_space(parser);
+    return true;
+}
+
+static bool parse_error(FilterParser_t* parser, const char* message)
+{
+    bej_diagnose(parser->diagnostics, BEJ_DIAG_ERROR, "Filter error at offset %u: %s",
+                 (unsigned)(parser->position - parser->expression), message);
+    return false;
+}
+
+static uint32_t add_node(BejFilter_t* filter, FilterNodeKind_t kind, uint32_t left, uint32_t right)
+{
+    FilterNode_t* node = &filter->nodes[filter->node_count];
+    node->kind = kind;
+    node->left = left;
+    node->right = right;
+    return filter->node_count++;
+}
+
+/// Resolve a path such as Status/Health to member and element steps; *entry receives its dictionary
+/// entry, which belongs to the annotation dictionary if the last step's dict_selector is 1
+static bool resolve_path(Dictionary_t* schema_dict, Dictionary_t* anno_dict, const char* path, size_t length,
+                         BejPathStep_t* steps, uint32_t* step_count, DictionaryEntry_t** entry,
+                         const BejDiagnostics_t* diagnostics)
+{
+    Dictionary_t* dict = schema_dict;
+    DictionaryEntry_t* current = &dict->entries[0];
+    uint8_t selector = 0;
+    const char* end = path + length;
+    const char* segment = (*path == '/') ? path + 1 : path;
+
+    *step_count = 0;
+    while (segment < end)
+    {
+        size_t segment_length = 0;
+        while (segment + segment_length < end && segment[segment_length] != '/')
+        {
+            segment_length++;
+        }
+
+        BejPathStep_t* step = &steps[*step_count];
+        if (get_msb4(current->format) == BEJ_FORMAT_ARRAY)
+        {
+            // Elements are addressed by index and all described by the array's child entry
+            char* digits_end;
+            errno = 0;
+            unsigned long long index = strtoull(segment, &digits_end, 10);
+            if (segment_length == 0 || !isdigit((unsigned char)*segment) || digits_end != segment + segment_length
+                || errno != 0)
+            {
+                bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Path '%.*s': '%.*s' is not an array index",
+                             (int)length, path, (int)segment_length, segment);
+                return false;
+            }
+            step->value = index;
+            step->index = true;
+            step->dict_selector = selector;
+            current = find_dictionary_entry(dict, current, 0, -1);
+        }
+        else
+        {
+            // "@..." names an annotation; its subtree is described by the annotation dictionary
+            DictionaryEntry_t* parent = current;
+            if (*segment == '@' && anno_dict && anno_dict->entry_count > 0)
+            {
+                dict = anno_dict;
+                parent = &dict->entries[0];
+                selector = 1;
+            }
+            bool has_properties = get_msb4(parent->format) == BEJ_FORMAT_SET;
+            current = (segment_length && has_properties)
+                ? find_dictionary_entry_by_name(dict, parent, segment, segment_length) : NULL;
+            step->value = current ? current->sequence_number : 0;
+            step->index = false;
+            step->dict_selector = selector;
+        }
+
+        if (!current)
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Path '%.*s': unknown property '%.*s'",
+                         (int)length, path, (int)segment_length, segment);
+            return false;
+        }
+        (*step_count)++;
+        segment += segment_length + 1;
+    }
+
+    *entry = current;
+    return true;
+}
+
+static bool parse_operator(FilterParser_t* parser, FilterOp_t* op)
+{
+    static const struct { const char* text; FilterOp_t op; } OPERATORS[] = {
+        {"==", FILTER_EQ}, {"!=", FILTER_NE}, {"<=", FILTER_LE},
+        {">=", FILTER_GE}, {"<", FILTER_LT}, {">", FILTER_GT}
+    };
+    for (size_t i = 0; i < sizeof(OPERATORS) / sizeof(OPERATORS[0]); i++)
+    {
+        if (accept_word(parser, OPERATORS[i].text))
+        {
+            *op = OPERATORS[i].op;
+            return true;
+        }
+    }
+    return parse_error(parser, "expected ==, !=, <, <=, > or >=");
+}
+
+/// Double-quoted string with \" and \\ escapes, unescaped into the filter's string pool
+static bool parse_string(FilterParser_t* parser, FilterComparison_t* comparison)
+{
+    BejFilter_t* filter = parser->filter;
+    comparison->string = filter->strings_size;
+    for (parser->position++; *parser->position != '"'; parser->position++)
+    {
+        char c = *parser->position;
+        if (c == '\\' && (parser->position[1] == '"' || parser->position[1] == '\\'))
+        {
+            c = *++parser->position;
+        }
+        else if (c == '\0')
+        {
+            return parse_error(parser, "unterminated string");
+        }
+        filter->strings[filter->strings_size++] = c;
+    }
+    parser->position++;
+    comparison->string_length = filter->strings_size - comparison->string;
+    filter->strings[filter->strings_size++] = '\0';
+    comparison->kind = LITERAL_STRING;
+    return true;
+}
+
+static bool parse_literal(FilterParser_t* parser, FilterComparison_t* comparison)
+{
+    if (*parser->position == '"')
+    {
+        if (!parse_string(parser, comparison))
+        {
+            return false;
+        }
+    }
+    else if (accept_word(parser, "true"))
+    {
+        comparison->kind = LITERAL_BOOLEAN;
+        comparison->boolean = true;
+        return true;
+    }
+    else if (accept_word(parser, "false"))
+    {
+        comparison->kind = LITERAL_BOOLEAN;
+        comparison->boolean = false;
+        return true;
+    }
+    else if (accept_word(parser, "null"))
+    {
+        comparison->kind = LITERAL_NULL;
+        return true;
+    }
+    else
+    {
+        const char* start = parser->position;
+        size_t length = 0;
+        while (is_word_char(start[length]))
+        {
+            length++;
+        }
+        bool real = length > 0 && strcspn(start, ".eE") < length;
+        char* end;
+        errno = 0;
+        if (real)
+        {
+            comparison->kind = LITERAL_REAL;
+            comparison->real = strtod(start, &end);
+        }
+        else
+        {
+            comparison->kind = LITERAL_INTEGER;
+            comparison->integer = strtoll(start, &end, 10);
+            comparison->real = (double)comparison->integer;
+        }
+        if (length == 0 || end != start + length || errno != 0)
+        {
+            return parse_error(parser, "expected a number, \"string\", true, false or null");
+        }
+        parser->position += length;
+    }
+    skip_space(parser);
+    return true;
+}
+
+/// Check that the literal and operator suit the property's format, resolving enum names
+static bool check_comparison(FilterParser_t* parser, FilterComparison_t* comparison, Dictionary_t* dict,
+                             DictionaryEntry_t* entry)
+{
+    bool equality = comparison->op == FILTER_EQ || comparison->op == FILTER_NE;
+    comparison->format = get_msb4(entry->format);
+    if (comparison->kind == LITERAL_NULL)
+    {
+        return equality || parse_error(parser, "null only allows == and !=");
+    }
+
+    switch (comparison->format)
+    {
+        case BEJ_FORMAT_INTEGER:
+        case BEJ_FORMAT_REAL:
+            if (comparison->kind == LITERAL_INTEGER || comparison->kind == LITERAL_REAL)
+            {
+                return true;
+            }
+            break;
+
+        case BEJ_FORMAT_STRING:
+            if (comparison->kind == LITERAL_STRING)
+            {
+                return true;
+            }
+            break;
+
+        case BEJ_FORMAT_BOOLEAN:
+            if (comparison->kind == LITERAL_BOOLEAN)
+            {
+                return equality || parse_error(parser, "booleans only allow == and !=");
+            }
+            break;
+
+        case BEJ_FORMAT_ENUM:
+            if (comparison->kind == LITERAL_STRING)
+            {
+                if (!equality)
+                {
+                    return parse_error(parser, "enums only allow == and !=");
+                }
+                const char* name = parser->filter->strings + comparison->string;
+                DictionaryEntry_t* option = find_dictionary_entry_by_name(dict, entry, name, comparison->string_length);
+                if (!option)
+                {
+                    bej_diagnose(parser->diagnostics, BEJ_DIAG_ERROR, "Filter: '%s' is not an option of %s",
+                                 name, entry->name ? entry->name : "the enum");
+                    return false;
+                }
+                comparison->enum_sequence = option->sequence_number;
+                return true;
+            }
+            break;
+
+        default:
+            return parse_error(parser, "only integers, reals, strings, enums and booleans can be compared");
+    }
+    return parse_error(parser, "literal does not match the property's type");
+}
+
+static bool parse_comparison(FilterParser_t* parser, uint32_t* node)
+{
+    BejFilter_t* filter = parser->filter;
+    const char* path = parser->position;
+    size_t length = 0;
+    while (is_word_char(path[length]))
+    {
+        length++;
+    }
+    if (length == 0)
+    {
+        return parse_error(parser, "expected a property path");
+    }
+
+    FilterComparison_t* comparison = &filter->comparisons[filter->comparison_count];
+    memset(comparison, 0, sizeof(*comparison));
+    DictionaryEntry_t* entry;
+    comparison->first_step = filter->step_count;
+    if (!resolve_path(parser->schema_dict, parser->anno_dict, path, length, filter->steps + filter->step_count,
+                      &comparison->step_count, &entry, parser->diagnostics))
+    {
+        return false;
+    }
+    filter->step_count += comparison->step_count;
+    parser->position += length;
+    skip_space(parser);
+
+    // The dictionary the value's entry belongs to resolves enum option names
+    Dictionary_t* dict = (comparison->step_count > 0
+                          && filter->steps[filter->step_count - 1].dict_selector) ? parser->anno_dict : parser->schema_dict;
+    if (!parse_operator(parser, &comparison->op) || !parse_literal(parser, comparison)
+        || !check_comparison(parser, comparison, dict, entry))
+    {
+        return false;
+    }
+    *node = add_node(filter, NODE_COMPARE, filter->comparison_count++, 0);
+    return true;
+}
+
+static bool parse_expression(FilterParser_t* parser, uint32_t* node);
+
+static bool parse_factor(FilterParser_t* parser, uint32_t* node)
+{
+    if (!accept_word(parser, "("))
+    {
+        return parse_comparison(parser, node);
+    }
+    if (++parser->depth > FILTER_MAX_DEPTH)
+    {
+        return parse_error(parser, "parentheses nested too deeply");
+    }
+    if (!parse_expression(parser, node))
+    {
+        return false;
+    }
+    parser->depth--;
+    return accept_word(parser, ")") || parse_error(parser, "expected )");
+}
+
+static bool parse_term(FilterParser_t* parser, uint32_t* node)
+{
+    if (!parse_factor(parser, node))
+    {
+        return false;
+    }
+    while (accept_word(parser, "and") || accept_word(parser, "&&"))
+    {
+        uint32_t right;
+        if (!parse_factor(parser, &right))
+        {
+            return false;
+        }
+        *node = add_node(parser->filter, NODE_AND, *node, right);
+    }
+    return true;
+}
+
+static bool parse_expression(FilterParser_t* parser, uint32_t* node)
+{
+    if (!parse_term(parser, node))
+    {
+        return false;
+    }
+    while (accept_word(parser, "or") || accept_word(parser, "||"))
+    {
+        uint32_t right;
+        if (!parse_term(parser, &right))
+        {
+            return false;
+        }
+        *node = add_node(parser->filter, NODE_OR, *node, right);
+    }
+    return true;
+}
+
+BejFilter_t* bej_filter_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                const char* expression, const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0 || !expression)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    // Every node, comparison, step and literal byte takes at least one character of the text
+    size_t capacity = strlen(expression) + 1;
+    if (capacity > UINT32_MAX)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Filter expression is too long");
+        return NULL;
+    }
+    BejFilter_t* filter = (BejFilter_t*)calloc(1, sizeof(BejFilter_t));
+    if (filter)
+    {
+        filter->nodes = (FilterNode_t*)malloc(capacity * sizeof(FilterNode_t));
+        filter->comparisons = (FilterComparison_t*)malloc(capacity * sizeof(FilterComparison_t));
+        filter->steps = (BejPathStep_t*)malloc(capacity * sizeof(BejPathStep_t));
+        filter->strings = (char*)malloc(capacity);
+    }
+    if (!filter || !filter->nodes || !filter->comparisons || !filter->steps || !filter->strings)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate filter");
+        bej_filter_free(filter);
+        return NULL;
+    }
+
+    FilterParser_t parser;
+    parser.filter = filter;
+    parser.schema_dict = schema_dict;
+    parser.anno_dict = anno_dict;
+    parser.expression = expression;
+    parser.position = expression;
+    parser.depth = 0;
+    parser.diagnostics = diagnostics;
+
+    skip_space(&parser);
+    if (!parse_expression(&parser, &filter->root)
+        || (*parser.position != '\0' && !parse_error(&parser, "unexpected text after the expression")))
+    {
+        bej_filter_free(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+void bej_filter_free(BejFilter_t* filter)
+{
+    if (!filter) return;
+
+    free(filter->nodes);
+    free(filter->comparisons);
+    free(filter->steps);
+    free(filter->strings);
+    free(filter);
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+/// Follow steps from root; *found is false if the payload lacks the property
+static bool follow_steps(const BejPathStep_t* steps, uint32_t step_count, const SFLV_t* root,
+                         SFLV_t* value, bool* found)
+{
+    *value = *root;
+    *found = false;
+    for (uint32_t i = 0; i < step_count; i++)
+    {
+        const BejPathStep_t* step = &steps[i];
+        uint8_t container = step->index ? BEJ_FORMAT_ARRAY : BEJ_FORMAT_SET;
+        if (value->format != container)
+        {
+            return true;
+        }
+
+        BufferReader_t reader;
+        init_buffer_reader(&reader, value->value, value->length);
+        uint64_t count = 0;
+        if (value->length > 0 && !read_nnint_from_buffer(&reader, &count))
+        {
+            return false;
+        }
+
+        // Members before the one wanted are skipped by their length
+        bool stepped = false;
+        for (uint64_t position = 0; !stepped && !buffer_eof(&reader); position++)
+        {
+            SFLV_t member;
+            if (!read_sflv_header_from_buffer(&reader, &member))
+            {
+                return false;
+            }
+            stepped = step->index
+                ? position == step->value
+                : (member.sequence == step->value && member.dict_selector == step->dict_selector);
+            if (stepped)
+            {
+                *value = member;
+            }
+        }
+        if (!stepped)
+        {
+            return true;
+        }
+    }
+    *found = true;
+    return true;
+}
+
+/// -1, 0 or 1 as a is below, equal to or above b
+static int order_of(double a, double b)
+{
+    return (a > b) - (a < b);
+}
+
+static bool evaluate_comparison(const BejFilter_t* filter, const FilterComparison_t* comparison,
+                                const SFLV_t* root, bool* result)
+{
+    SFLV_t sflv;
+    bool found;
+    if (!follow_steps(filter->steps + comparison->first_step, comparison->step_count, root, &sflv, &found))
+    {
+        return false;
+    }
+    *result = false;
+    if (!found)
+    {
+        return true;
+    }
+    if (comparison->kind == LITERAL_NULL)
+    {
+        *result = (sflv.format == BEJ_FORMAT_NULL) == (comparison->op == FILTER_EQ);
+        return true;
+    }
+    if (sflv.format != comparison->format)
+    {
+        *result = comparison->op == FILTER_NE;
+        return true;
+    }
+
+    BejValue_t value;
+    if (!bej_value_from_sflv(&sflv, NULL, NULL, &value, NULL))
+    {
+        return false;
+    }
+
+    int order;
+    switch (sflv.format)
+    {
+        case BEJ_FORMAT_INTEGER:
+            order = comparison->kind == LITERAL_INTEGER
+                ? (value.integer > comparison->integer) - (value.integer < comparison->integer)
+                : order_of((double)value.integer, comparison->real);
+            break;
+
+        case BEJ_FORMAT_REAL:
+            order = order_of(value.real, comparison->real);
+            break;
+
+        case BEJ_FORMAT_STRING:
+        {
+            const char* literal = filter->strings + comparison->string;
+            size_t shorter = value.string_length < comparison->string_length
+                ? (size_t)value.string_length : comparison->string_length;
+            order = shorter ? memcmp(value.string, literal, shorter) : 0;
+            if (order == 0)
+            {
+                order = (value.string_length > comparison->string_length) - (value.string_length < comparison->string_length);
+            }
+            break;
+        }
+
+        case BEJ_FORMAT_BOOLEAN:
+            order = value.boolean != comparison->boolean;
+            break;
+
+        case BEJ_FORMAT_ENUM:
+            order = value.enum_sequence != comparison->enum_sequence;
+            break;
+
+        default:
+            return true;
+    }
+
+    switch (comparison->op)
+    {
+        case FILTER_EQ: *result = order == 0; break;
+        case FILTER_NE: *result = order != 0; break;
+        case FILTER_LT: *result = order < 0; break;
+        case FILTER_LE: *result = order <= 0; break;
+        case FILTER_GT: *result = order > 0; break;
+        case FILTER_GE: *result = order >= 0; break;
+    }
+    return true;
+}
+
+/// Evaluate a node, skipping the right side of and/or when the left side decides
+static bool evaluate_node(const BejFilter_t* filter, uint32_t index, const SFLV_t* root, bool* result)
+{
+    const FilterNode_t* node = &filter->nodes[index];
+    if (node->kind == NODE_COMPARE)
+    {
+        return evaluate_comparison(filter, &filter->comparisons[node->left], root, result);
+    }
+    if (!evaluate_node(filter, node->left, root, result))
+    {
+        return false;
+    }
+    if (*result == (node->kind == NODE_OR))
+    {
+        return true;
+    }
+    return evaluate_node(filter, node->right, root, result);
+}
+
+bool bej_filter_match(const BejFilter_t* filter, const uint8_t* data, uint64_t size, bool* matched)
+{
+    if (!filter || !data || !matched)
+    {
+        return false;
+    }
+
+    // The reader never writes; it only shares the non-const buffer type
+    BufferReader_t reader;
+    init_buffer_reader(&reader, (uint8_t*)data, size);
+    SFLV_t root;
+    if (!read_bej_header_from_buffer(&reader, NULL) || !read_sflv_header_from_buffer(&reader, &root))
+    {
+        return false;
+    }
+    return evaluate_node(filter, filter->root, &root, matched);
+}
+
+// ============================================================================
+// Compiled Paths
+// ============================================================================
+
+struct BejPath
+{
+    BejPathStep_t* steps;
+    uint32_t step_count;
+    uint16_t entry;             // index of the describing entry, so the path suits any copy of the dictionaries
+    uint8_t entry_selector;     // dictionary that entry is in: 0 schema, 1 annotation
+};
+
+BejPath_t* bej_path_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict, const char* path,
+                            const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0 || !path)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    // A step takes at least one character of the path
+    size_t length = strlen(path);
+    if (length >= UINT32_MAX)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Path is too long");
+        return NULL;
+    }
+    BejPath_t* compiled = (BejPath_t*)calloc(1, sizeof(BejPath_t));
+    if (compiled)
+    {
+        compiled->steps = (BejPathStep_t*)malloc((length + 1) * sizeof(BejPathStep_t));
+    }
+    if (!compiled || !compiled->steps)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate path");
+        bej_path_free(compiled);
+        return NULL;
+    }
+
+    DictionaryEntry_t* entry;
+    if (!resolve_path(schema_dict, anno_dict, path, length, compiled->steps, &compiled->step_count,
+                      &entry, diagnostics))
+    {
+        bej_path_free(compiled);
+        return NULL;
+    }
+    compiled->entry_selector = compiled->step_count > 0 ? compiled->steps[compiled->step_count - 1].dict_selector : 0;
+    Dictionary_t* dict = compiled->entry_selector ? anno_dict : schema_dict;
+    compiled->entry = (uint16_t)(entry - dict->entries);
+    return compiled;
+}
+
+const DictionaryEntry_t* bej_path_entry(const BejPath_t* path, const Dictionary_t* schema_dict,
+                                        const Dictionary_t* anno_dict)
+{
+    const Dictionary_t* dict = (path && path->entry_selector) ? anno_dict : schema_dict;
+    if (!path || !dict || path->entry >= dict->entry_count)
+    {
+        return NULL;
+    }
+    return &dict->entries[path->entry];
+}
+
+uint8_t bej_path_entry_selector(const BejPath_t* path)
+{
+    return path ? path->entry_selector : 0;
+}
+
+const BejPathStep_t* bej_path_steps(const BejPath_t* path, size_t* step_count)
+{
+    *step_count = path ? path->step_count : 0;
+    return path ? path->steps : NULL;
+}
+
+bool bej_path_find(const BejPath_t* path, const SFLV_t* root, SFLV_t* value, bool* found)
+{
+    if (!path || !root || !value || !found)
+    {
+        return false;
+    }
+    return follow_steps(path->steps, path->step_count, root, value, found);
+}
+
+void bej_path_free(BejPath_t* path)
+{
+    if (!path) return;
+
+    free(path->steps);
+    free(path);
+}
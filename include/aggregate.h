@@ -0,0 +1,119 @@
+/**
+ * @file aggregate.h
+ * @author Vladyslav Kolodii
+ * @brief Min/max/sum/percentile aggregation of numeric properties across many BEJ payloads
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+#include "batch.h"
+
+/// Summary of one aggregated path
+typedef struct
+{
+    uint64_t count;             // numeric values folded in
+    uint64_t missing;           // payloads without the property, plus values that are not numbers (e.g. null)
+    double min;                 // min to p99 are 0 when count is 0
+    double max;
+    double sum;
+    double mean;
+    double p50;                 // nearest-rank percentiles, within 0.8% (magnitudes below 2^-20 read as 0)
+    double p90;
+    double p99;
+} BejAggregateResult_t;
+
+/// Numeric paths compiled against the dictionaries; shared read-only by all threads
+typedef struct BejAggregate BejAggregate_t;
+
+/// Running totals and a fixed-size percentile histogram per path; merged into one at the end
+typedef struct BejAccumulator BejAccumulator_t;
+
+/**
+ * Compile the paths to aggregate
+ *
+ * Each path must lead to an INTEGER or REAL property, or to an ARRAY of them, in
+ * which case every element is folded in.
+ * @param schema_dict Schema dictionary the payloads are encoded with
+ * @param anno_dict Annotation dictionary, for names starting with '@' (may be NULL)
+ * @param paths Paths in filter syntax, e.g. PowerConsumedWatts or MemoryLocation/Slot
+ * @param path_count Number of paths
+ * @param diagnostics Where unknown or non-numeric paths are reported (NULL for silent)
+ * @return Compiled paths, or NULL on failure. Free with bej_aggregate_free()
+ */
+BejAggregate_t* bej_aggregate_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                      const char* const* paths, size_t path_count,
+                                      const BejDiagnostics_t* diagnostics);
+
+/**
+ * Free compiled paths
+ * @param aggregate Compiled paths to free (NULL is ignored)
+ */
+void bej_aggregate_free(BejAggregate_t* aggregate);
+
+/**
+ * Create an empty accumulator
+ * @param aggregate Compiled paths; must outlive the accumulator
+ * @return Accumulator, or NULL on allocation failure. Free with bej_accumulator_free()
+ */
+BejAccumulator_t* bej_accumulator_create(const BejAggregate_t* aggregate);
+
+/**
+ * Fold the values of one BEJ document into an accumulator
+ *
+ * Only tuple headers on the way to each value are read, and nothing is decoded to text.
+ * @param accumulator Accumulator
+ * @param data Complete BEJ document, including its header
+ * @param size Size of data in bytes
+ * @return true on success; false if the document is malformed, in which case nothing is folded in
+ */
+bool bej_accumulator_add(BejAccumulator_t* accumulator, const uint8_t* data, uint64_t size);
+
+/**
+ * Add the totals of one accumulator to another built from the same compiled paths
+ * @param into Accumulator that receives the totals
+ * @param from Accumulator to add; left unchanged
+ * @return true on success, false if the accumulators were built from different compiled paths
+ */
+bool bej_accumulator_merge(BejAccumulator_t* into, const BejAccumulator_t* from);
+
+/**
+ * Summarize one path
+ * @param accumulator Accumulator
+ * @param path Index into the paths given to bej_aggregate_compile()
+ * @param result Receives the summary
+ * @return true on success, false if path is out of range
+ */
+bool bej_accumulator_result(BejAccumulator_t* accumulator, size_t path, BejAggregateResult_t* result);
+
+/**
+ * Free an accumulator
+ * @param accumulator Accumulator to free (NULL is ignored)
+ */
+void bej_accumulator_free(BejAccumulator_t* accumulator);
+
+/**
+ * Aggregate a list of BEJ files on a pool of worker threads
+ *
+ * Each worker folds the files it claims into its own accumulator and read buffer;
+ * the accumulators are merged into total once all workers are done.
+ * @param aggregate Compiled paths
+ * @param files Input files
+ * @param thread_count Worker threads; <= 1 aggregates on the calling thread
+ * @param diagnostics Called from every worker; must be thread-safe (NULL for silent)
+ * @param total Accumulator that receives every file's values
+ * @param stats Receives file counts and throughput; bytes_out stays 0 (may be NULL)
+ * @return true if every file was read and aggregated, false otherwise
+ */
+bool bej_aggregate_files(const BejAggregate_t* aggregate, const BatchFileList_t* files, int thread_count,
+                         const BejDiagnostics_t* diagnostics, BejAccumulator_t* total, BatchStats_t* stats);
+
+#endif // AGGREGATE_H
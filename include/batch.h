@@ -0,0 +1,130 @@
+/**
+ * @file batch.h
+ * @author Vladyslav Kolodii
+ * @brief Multi-threaded batch decoding of many BEJ files with shared dictionaries
+ * @version 0.1
+ * @date 2025-11-11
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+/// Growable list of input file paths
+typedef struct
+{
+    char** paths;
+    size_t count;
+    size_t capacity;
+} BatchFileList_t;
+
+/// File I/O layer used by a batch run
+typedef enum
+{
+    BATCH_IO_AUTO,      // io_uring when the kernel provides it, otherwise BATCH_IO_PREAD
+    BATCH_IO_PREAD,     // each worker opens, preads and pwrites its own files
+    BATCH_IO_URING      // Linux io_uring: opens, reads, writes and closes queued in batches
+} BatchIoBackend_t;
+
+/// Default number of files kept in flight by the io_uring backend
+#define BATCH_IO_QUEUE_DEPTH 64
+
+/// Batch decode options
+typedef struct
+{
+    Dictionary_t* schema_dict;      // shared read-only by all workers
+    Dictionary_t* anno_dict;
+    BejOutputFormat_t output_format;
+    const char* output_dir;         // per-file outputs go here; NULL writes next to each input
+    FILE* ndjson_output;            // when set, every record is appended here as one line instead
+    int thread_count;               // worker threads; <= 1 decodes on the calling thread
+    BejDiagnostics_t diagnostics;   // called from every worker; must be thread-safe
+    BatchIoBackend_t io_backend;
+    size_t queue_depth;             // io_uring only; 0 selects BATCH_IO_QUEUE_DEPTH
+} BatchOptions_t;
+
+/// Aggregate results of a batch run
+typedef struct
+{
+    size_t files_total;
+    size_t files_ok;
+    size_t files_failed;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    double seconds;
+} BatchStats_t;
+
+/**
+ * Initialize an empty file list
+ * @param list File list
+ */
+void init_file_list(BatchFileList_t* list);
+
+/**
+ * Free all paths held by a file list
+ * @param list File list
+ */
+void free_file_list(BatchFileList_t* list);
+
+/**
+ * Append a copy of a path to a file list
+ * @param list File list
+ * @param path Path to add
+ * @return true on success, false on allocation failure
+ */
+bool file_list_add(BatchFileList_t* list, const char* path);
+
+/**
+ * Add the regular files of a directory, or the matches of a glob pattern, to a file list
+ * @param list File list
+ * @param source Directory path or glob pattern (e.g. a path ending in *.bin)
+ * @return true on success, false if the source could not be read or matched nothing
+ */
+bool collect_batch_inputs(BatchFileList_t* list, const char* source);
+
+/**
+ * Add the paths listed in a text file, one per line, to a file list
+ * @param list File list
+ * @param list_file Path of the list file; blank lines and lines starting with '#' are ignored
+ * @return true on success, false on failure
+ */
+bool read_batch_list_file(BatchFileList_t* list, const char* list_file);
+
+/**
+ * Number of online processors, used as the default worker count
+ * @return Processor count (at least 1)
+ */
+int default_thread_count(void);
+
+/**
+ * Derive an output path from an input path by replacing its extension
+ * @param input Input file path
+ * @param output_dir Directory for the output, or NULL to keep the input's directory
+ * @param format Output encoding (selects .json, .cbor or .msgpack)
+ * @param output Destination buffer
+ * @param size Size of destination buffer
+ * @return true on success, false if the path does not fit
+ */
+bool make_output_path(const char* input, const char* output_dir, BejOutputFormat_t format,
+                      char* output, size_t size);
+
+/**
+ * Decode a list of BEJ files on a pool of worker threads
+ *
+ * Each worker owns its decoder context and buffers; only the dictionaries are shared.
+ * In NDJSON mode records are written whole, but in completion order (input order
+ * with the io_uring backend). File I/O goes through options->io_backend.
+ * @param files Input files
+ * @param options Batch options
+ * @param stats Receives aggregate counts and throughput (may be NULL)
+ * @return true if every file was decoded, false otherwise
+ */
+bool bej_decode_batch(const BatchFileList_t* files, const BatchOptions_t* options, BatchStats_t* stats);
+
+#endif // BATCH_H
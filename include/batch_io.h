@@ -0,0 +1,66 @@
+/**
+ * @file batch_io.h
+ * @author Vladyslav Kolodii
+ * @brief File I/O backends for batch decoding: io_uring and pread/pwrite
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BATCH_IO_H
+#define BATCH_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "batch.h"
+
+/**
+ * Check whether the io_uring backend can run here
+ *
+ * False when built for another platform or without <linux/io_uring.h>, and
+ * when the kernel lacks io_uring or has it disabled.
+ * @return true if an io_uring instance with file open/close support can be created
+ */
+bool batch_io_uring_supported(void);
+
+/**
+ * Read a whole file with open/fstat/pread, reusing (and growing) a caller-owned buffer
+ * @param path File to read
+ * @param data In/out heap buffer (may start as NULL); free with free()
+ * @param capacity In/out size of *data in bytes
+ * @param size Receives the file size in bytes
+ * @param diagnostics Where failures are reported (NULL for silent)
+ * @return true on success, false if the file is missing, empty, too large or unreadable
+ */
+bool batch_read_file(const char* path, uint8_t** data, size_t* capacity, uint64_t* size,
+                     const BejDiagnostics_t* diagnostics);
+
+/**
+ * Create (or truncate) a file and write a buffer to it with pwrite
+ * @param path File to write
+ * @param data Bytes to write
+ * @param size Number of bytes
+ * @param diagnostics Where failures are reported (NULL for silent)
+ * @return true on success, false on failure
+ */
+bool batch_write_file(const char* path, const uint8_t* data, size_t size,
+                      const BejDiagnostics_t* diagnostics);
+
+/**
+ * Decode a list of BEJ files using io_uring for all file I/O
+ *
+ * Files are processed in windows of options->queue_depth. Each window's
+ * opens, reads, writes and closes are queued and submitted together, and the
+ * buffers read go straight to the in-memory decoder. The decode threads are
+ * started once per batch, and the next window is read while they decode the
+ * current one. NDJSON records are written in input order.
+ * @param files Input files
+ * @param options Batch options
+ * @param stats Receives aggregate counts and throughput (may be NULL)
+ * @return true if every file was decoded, false otherwise (including when io_uring is unavailable)
+ */
+bool bej_decode_batch_uring(const BatchFileList_t* files, const BatchOptions_t* options, BatchStats_t* stats);
+
+#endif // BATCH_IO_H
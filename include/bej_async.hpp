@@ -0,0 +1,227 @@
+/**
+ * @file bej_async.hpp
+ * @author Vladyslav Kolodii
+ * @brief C++20 coroutine API: co_await bej::decode_async(source, sink)
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BEJ_ASYNC_HPP
+#define BEJ_ASYNC_HPP
+
+// Header-only; needs C++20. The decoder core stays plain C and never blocks
+// here: all I/O goes through the caller's awaitable source and sink, so a
+// decode suspends (instead of blocking a thread) whenever the source has no
+// data yet or the sink cannot take more output.
+//
+// A source provides   read_some(std::span<uint8_t>)        -> awaitable of size_t (0 = end of input)
+// A sink provides     write(std::span<const uint8_t>)      -> awaitable of bool   (false = failed)
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "decode.h"
+}
+
+namespace bej
+{
+
+/// Lazily started coroutine result; co_await it, or start() it from non-coroutine code
+template <typename T>
+class [[nodiscard]] Task
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // Resume whoever awaited the task, without growing the stack
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+            {
+                return handle.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume()
+            {
+                if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+                return std::move(*handle.promise().value);
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+    /// Run until the first suspension (for top-level tasks driven by an event loop)
+    void start()
+    {
+        if (!handle_.done()) handle_.resume();
+    }
+
+    /// @return true once the coroutine has finished
+    bool done() const { return handle_.done(); }
+
+    /// Result of a finished task; rethrows an exception escaped from the coroutine
+    T result()
+    {
+        if (handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+        return std::move(*handle_.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/// Options for decode_async
+struct AsyncDecodeOptions
+{
+    Dictionary_t* schema_dict = nullptr;
+    Dictionary_t* anno_dict = nullptr;
+    const BejDecodeOptions_t* decode = nullptr;   // format, diagnostics, allocator, stats; NULL for pretty JSON
+    size_t chunk_size = 64 * 1024;                // bytes per read_some and per write
+};
+
+namespace detail
+{
+
+/// Write the buffered output in chunk-sized pieces; a partial piece stays buffered unless final
+template <typename Sink>
+Task<bool> flush_output(Sink& sink, DecoderContext_t& ctx, size_t chunk, bool final)
+{
+    size_t offset = 0;
+    while (ctx.output_length - offset >= chunk || (final && offset < ctx.output_length))
+    {
+        size_t count = std::min(chunk, ctx.output_length - offset);
+        if (!co_await sink.write(std::span<const uint8_t>(ctx.output_buffer + offset, count))) co_return false;
+        offset += count;
+    }
+    if (offset > 0)
+    {
+        std::memmove(ctx.output_buffer, ctx.output_buffer + offset, ctx.output_length - offset);
+        ctx.output_length -= offset;
+    }
+    co_return true;
+}
+
+} // namespace detail
+
+/**
+ * Decode one BEJ document from an awaitable source into an awaitable sink
+ *
+ * Each chunk read from the source is fed to a push parser (bej_feed()), and
+ * the output it produces is written to the sink as soon as a full chunk has
+ * built up. Memory stays bounded by the chunk size and the largest leaf value,
+ * whatever the document size. The coroutine suspends only at the source and
+ * sink. Projections and parallel member decoding are not available here.
+ * @param source Awaitable byte source; must outlive the task
+ * @param sink Awaitable byte sink; must outlive the task
+ * @param options Dictionaries, decode options and chunk size
+ * @return true on success, false if the document is invalid or a write failed;
+ *         output already written for an invalid document is not taken back
+ */
+template <typename Source, typename Sink>
+Task<bool> decode_async(Source& source, Sink& sink, AsyncDecodeOptions options = {})
+{
+    const size_t chunk = options.chunk_size > 0 ? options.chunk_size : 64 * 1024;
+    BejDecodeOptions_t defaults;
+    init_decode_options(&defaults);
+    const BejDecodeOptions_t& decode = options.decode ? *options.decode : defaults;
+
+    // The context lives in the coroutine frame, so the parser's pointer to it stays valid
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, options.schema_dict, options.anno_dict, nullptr, nullptr);
+    ctx.output_format = decode.format;
+    ctx.compact = decode.compact;
+    ctx.diagnostics = decode.diagnostics;
+    ctx.allocator = decode.allocator;
+    ctx.max_value_length = decode.max_value_length;
+    ctx.projection = decode.projection;
+    set_output_buffer(&ctx, nullptr, 0);
+
+    // Released however the coroutine ends, including destruction while suspended
+    struct Resources
+    {
+        DecoderContext_t& ctx;
+        BejPushParser_t* parser;
+        ~Resources()
+        {
+            bej_push_free(parser);
+            bej_free(ctx.allocator, ctx.output_buffer);
+        }
+    } resources{ctx, bej_push_create(&ctx)};
+
+    std::vector<uint8_t> input(chunk);
+    bool ok = resources.parser != nullptr;
+    while (ok)
+    {
+        size_t count = co_await source.read_some(std::span<uint8_t>(input.data(), chunk));
+        if (count == 0) break;
+        ok = bej_feed(resources.parser, input.data(), std::min(count, chunk)) && !ctx.output_failed;
+        ok = ok && co_await detail::flush_output(sink, ctx, chunk, false);
+    }
+    ok = ok && bej_finish(resources.parser) && !ctx.output_failed;
+    ok = ok && co_await detail::flush_output(sink, ctx, chunk, true);
+    if (decode.stats) *decode.stats = ctx.stats;
+    co_return ok;
+}
+
+} // namespace bej
+
+#endif // BEJ_ASYNC_HPP
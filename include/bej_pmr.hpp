@@ -0,0 +1,412 @@
+/**
+ * @file bej_pmr.hpp
+ * @author Vladyslav Kolodii
+ * @brief C++17 API whose every allocation comes from a std::pmr::memory_resource
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BEJ_PMR_HPP
+#define BEJ_PMR_HPP
+
+// Header-only; needs C++17. Two entry points share one memory resource:
+//
+//   bej::pmr::decode()  renders JSON/CBOR/MessagePack into a std::pmr::string
+//   bej::pmr::parse()   builds a DOM of bej::pmr::Value nodes
+//
+// Output strings, DOM nodes, the parse stack and whatever the C core allocates
+// during the decode (through ResourceAllocator) all come from the resource, so
+// a std::pmr::monotonic_buffer_resource over a stack buffer decodes a small
+// payload without touching the heap. The one exception is the workers of a
+// parallel decode (threads > 1): a resource need not be thread-safe, so their
+// chunk buffers come from the C heap.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+extern "C" {
+#include "decode.h"
+}
+
+namespace bej::pmr
+{
+
+/// BejAllocator_t that forwards to a memory resource
+//
+// memory_resource needs the size back on deallocate(), so every block carries
+// a small header. The C core keeps a pointer to this object: it must outlive
+// any context or dictionary it is installed in, and it cannot be moved.
+class ResourceAllocator
+{
+public:
+    explicit ResourceAllocator(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource)
+    {
+        allocator_.alloc = &ResourceAllocator::alloc;
+        allocator_.realloc = &ResourceAllocator::realloc;
+        allocator_.free = &ResourceAllocator::free;
+        allocator_.user = this;
+    }
+    ResourceAllocator(const ResourceAllocator&) = delete;
+    ResourceAllocator& operator=(const ResourceAllocator&) = delete;
+
+    /// @return the allocator to pass to the C API
+    const BejAllocator_t* get() const { return &allocator_; }
+
+    std::pmr::memory_resource* resource() const { return resource_; }
+
+private:
+    struct alignas(std::max_align_t) Header
+    {
+        size_t size;
+    };
+
+    static void* alloc(void* user, size_t size)
+    {
+        auto* self = static_cast<ResourceAllocator*>(user);
+        try
+        {
+            auto* header = static_cast<Header*>(
+                self->resource_->allocate(sizeof(Header) + size, alignof(std::max_align_t)));
+            header->size = size;
+            return header + 1;
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+    static void free(void* user, void* memory)
+    {
+        if (!memory) return;
+        auto* self = static_cast<ResourceAllocator*>(user);
+        Header* header = static_cast<Header*>(memory) - 1;
+        self->resource_->deallocate(header, sizeof(Header) + header->size, alignof(std::max_align_t));
+    }
+
+    static void* realloc(void* user, void* memory, size_t size)
+    {
+        if (!memory) return alloc(user, size);
+        size_t old_size = (static_cast<Header*>(memory) - 1)->size;
+        if (size <= old_size) return memory;
+
+        void* grown = alloc(user, size);
+        if (!grown) return nullptr;
+        std::memcpy(grown, memory, old_size);
+        free(user, memory);
+        return grown;
+    }
+
+    std::pmr::memory_resource* resource_;
+    BejAllocator_t allocator_;
+};
+
+/// Settings shared by decode() and parse()
+struct Options
+{
+    Dictionary_t* schema_dict = nullptr;
+    Dictionary_t* anno_dict = nullptr;
+    BejOutputFormat_t format = BEJ_OUTPUT_JSON;    // decode() only
+    bool compact = false;                           // decode() only, JSON only
+    int threads = 0;                                // decode() only: > 1 for parallel members
+    BejDiagnostics_t diagnostics = {nullptr, nullptr, BEJ_DIAG_ERROR};
+};
+
+/**
+ * Decode a BEJ document into a string allocated from the string's own resource
+ *
+ * A sizing pass runs first, so the string is allocated exactly once.
+ * @param data BEJ document (header included)
+ * @param size Size of data in bytes
+ * @param options Dictionaries, output format and diagnostics
+ * @param output Receives the output; its allocator's resource serves every allocation
+ * @return true on success; output is left empty on failure
+ */
+inline bool decode(const uint8_t* data, size_t size, const Options& options, std::pmr::string& output)
+{
+    output.clear();
+    if (!data) return false;
+
+    ResourceAllocator allocator(output.get_allocator().resource());
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, options.schema_dict, options.anno_dict, nullptr, nullptr);
+    ctx.output_format = options.format;
+    ctx.compact = options.compact;
+    ctx.parallel_threads = options.threads;
+    ctx.diagnostics = options.diagnostics;
+    ctx.allocator = allocator.get();
+
+    // The decoder only reads the input; its API is not const-qualified
+    uint8_t* input = const_cast<uint8_t*>(data);
+    ctx.output_sink = BEJ_SINK_MEASURE;
+    if (!decode_bej_buffer(&ctx, input, size)) return false;
+
+    // The sizing pass runs the same writers, so the buffer is never grown
+    size_t exact_size = ctx.output_length;
+    output.resize(exact_size);
+    set_output_buffer(&ctx, reinterpret_cast<uint8_t*>(output.data()), exact_size + 1);
+    if (!decode_bej_buffer(&ctx, input, size) || ctx.output_length != exact_size)
+    {
+        output.clear();
+        return false;
+    }
+    return true;
+}
+
+/// Kind of a DOM node, one per BEJ format that carries data (5.3.7)
+enum class Kind : uint8_t
+{
+    Null,
+    Boolean,
+    Integer,
+    Real,
+    Enum,
+    String,
+    Bytes,
+    Object,     // BEJ SET
+    Array
+};
+
+struct Member;
+
+/// One decoded value; containers own their members
+struct Value
+{
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    int64_t integer = 0;        // Integer; Enum option sequence number
+    double real = 0.0;
+    std::string_view name;      // Enum option name; points into the dictionary, empty if unknown
+    std::pmr::string text;      // String and Bytes (raw, not base64)
+    std::pmr::vector<Member> members;  // Object and Array; Array members have no name
+
+    explicit Value(const allocator_type& allocator = {}) : text(allocator), members(allocator) {}
+    Value(const Value& other, const allocator_type& allocator);
+    Value(Value&& other, const allocator_type& allocator);
+    Value(const Value&) = default;
+    Value(Value&&) noexcept = default;
+    Value& operator=(const Value&) = default;
+    Value& operator=(Value&&) = default;
+
+    /// @return the Object member called name, or nullptr
+    const Value* find(std::string_view key) const;
+};
+
+/// A member of an Object or Array
+struct Member
+{
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    std::string_view name;      // points into the dictionary; empty if unknown or in an Array
+    uint32_t sequence = 0;      // dictionary sequence number of the property
+    Value value;
+
+    explicit Member(const allocator_type& allocator = {}) : value(allocator) {}
+    Member(const Member& other, const allocator_type& allocator)
+        : name(other.name), sequence(other.sequence), value(other.value, allocator) {}
+    Member(Member&& other, const allocator_type& allocator)
+        : name(other.name), sequence(other.sequence), value(std::move(other.value), allocator) {}
+    Member(const Member&) = default;
+    Member(Member&&) noexcept = default;
+    Member& operator=(const Member&) = default;
+    Member& operator=(Member&&) = default;
+};
+
+inline Value::Value(const Value& other, const allocator_type& allocator)
+    : kind(other.kind), boolean(other.boolean), integer(other.integer), real(other.real), name(other.name),
+      text(other.text, allocator), members(other.members, allocator) {}
+
+inline Value::Value(Value&& other, const allocator_type& allocator)
+    : kind(other.kind), boolean(other.boolean), integer(other.integer), real(other.real), name(other.name),
+      text(std::move(other.text), allocator), members(std::move(other.members), allocator) {}
+
+inline const Value* Value::find(std::string_view key) const
+{
+    if (kind != Kind::Object) return nullptr;
+    for (const Member& member : members)
+    {
+        if (member.name == key) return &member.value;
+    }
+    return nullptr;
+}
+
+namespace detail
+{
+
+/// Sign-extended little-endian BEJ INTEGER (5.3.10)
+inline int64_t integer_value(const SFLV_t& sflv)
+{
+    if (sflv.length == 0 || sflv.length > 8) return 0;
+    uint64_t bits = 0;
+    for (uint64_t i = 0; i < sflv.length; i++)
+    {
+        bits |= uint64_t(sflv.value[i]) << (i * 8);
+    }
+    if (sflv.length < 8 && (sflv.value[sflv.length - 1] & 0x80))
+    {
+        bits |= ~((uint64_t(1) << (sflv.length * 8)) - 1);
+    }
+    return int64_t(bits);
+}
+
+/// Fill one node from its tuple; mirrors decode_value()
+inline bool fill_value(const Options& options, const SFLV_t& sflv, DictionaryEntry_t* entry, Value& out)
+{
+    Dictionary_t* dict = sflv.dict_selector ? options.anno_dict : options.schema_dict;
+    switch (sflv.format)
+    {
+        case BEJ_FORMAT_SET:
+        case BEJ_FORMAT_ARRAY:
+        {
+            bool is_set = sflv.format == BEJ_FORMAT_SET;
+            out.kind = is_set ? Kind::Object : Kind::Array;
+            if (sflv.length == 0) return true;
+
+            BufferReader_t reader;
+            init_buffer_reader(&reader, sflv.value, sflv.length);
+            uint64_t count;
+            if (!read_nnint_from_buffer(&reader, &count)) return false;
+
+            // Every member needs at least 3 bytes, which bounds a hostile count
+            out.members.reserve(size_t(count < sflv.length / 3 ? count : sflv.length / 3));
+            while (!buffer_eof(&reader))
+            {
+                SFLV_t child;
+                if (!read_sflv_header_from_buffer(&reader, &child)) return false;
+
+                Member& member = out.members.emplace_back();
+                member.sequence = child.sequence;
+                DictionaryEntry_t* child_entry = entry;
+                if (is_set)
+                {
+                    child_entry = find_member_entry(options.schema_dict, options.anno_dict, entry, &child);
+                    if (child_entry && child_entry->name) member.name = child_entry->name;
+                }
+                if (!fill_value(options, child, child_entry, member.value)) return false;
+            }
+            return true;
+        }
+
+        case BEJ_FORMAT_NULL:
+            out.kind = Kind::Null;
+            return true;
+
+        case BEJ_FORMAT_INTEGER:
+            out.kind = Kind::Integer;
+            out.integer = integer_value(sflv);
+            return true;
+
+        case BEJ_FORMAT_ENUM:
+        {
+            out.kind = Kind::Enum;
+            uint64_t sequence = 0;
+            if (sflv.length > 0)
+            {
+                BufferReader_t reader;
+                init_buffer_reader(&reader, sflv.value, sflv.length);
+                if (!read_nnint_from_buffer(&reader, &sequence) || sequence > UINT32_MAX) return false;
+            }
+            out.integer = int64_t(sequence);
+            DictionaryEntry_t* option = find_dictionary_entry(dict, entry, uint32_t(sequence), -1);
+            if (option && option->name) out.name = option->name;
+            return true;
+        }
+
+        case BEJ_FORMAT_STRING:
+        case BEJ_FORMAT_BYTE_STRING:
+        {
+            // A STRING's NUL terminator is not part of its text
+            size_t length = size_t(sflv.length);
+            bool terminated = sflv.format == BEJ_FORMAT_STRING && length > 0 && sflv.value[length - 1] == 0;
+            out.kind = sflv.format == BEJ_FORMAT_STRING ? Kind::String : Kind::Bytes;
+            out.text.assign(reinterpret_cast<const char*>(sflv.value), terminated ? length - 1 : length);
+            return true;
+        }
+
+        case BEJ_FORMAT_REAL:
+            out.kind = Kind::Real;
+            if (sflv.length == 4)
+            {
+                float value;
+                std::memcpy(&value, sflv.value, 4);
+                out.real = value;
+            }
+            else if (sflv.length == 8)
+            {
+                std::memcpy(&out.real, sflv.value, 8);
+            }
+            else if (sflv.length == 1 || sflv.length == 2)
+            {
+                // Same short forms decode_real() accepts
+                out.real = sflv.length == 1 ? sflv.value[0] : (sflv.value[0] | (sflv.value[1] << 8));
+            }
+            else
+            {
+                out.kind = Kind::Null;
+            }
+            return true;
+
+        case BEJ_FORMAT_BOOLEAN:
+            out.kind = Kind::Boolean;
+            out.boolean = sflv.length > 0 && sflv.value[0] != 0;
+            return true;
+
+        case BEJ_FORMAT_CHOICE:
+        case BEJ_FORMAT_PROPERTY_ANNOTATION:
+        case BEJ_FORMAT_REGISTRY_ITEM:
+            out.kind = Kind::Null;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+} // namespace detail
+
+/**
+ * Build a DOM for a BEJ document; every node comes from the root's resource
+ *
+ * Property and enum names are views into the dictionaries, which must outlive root.
+ * @param data BEJ document (header included)
+ * @param size Size of data in bytes
+ * @param options Dictionaries and diagnostics
+ * @param root Receives the root value
+ * @return true on success
+ */
+inline bool parse(const uint8_t* data, size_t size, const Options& options, Value& root)
+{
+    root = Value(root.members.get_allocator());
+    if (!data || size < BEJ_HEADER_SIZE)
+    {
+        bej_diagnose(&options.diagnostics, BEJ_DIAG_ERROR, "Invalid BEJ document");
+        return false;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, const_cast<uint8_t*>(data), size);
+    reader.position = BEJ_HEADER_SIZE;
+
+    SFLV_t sflv;
+    if (!read_sflv_header_from_buffer(&reader, &sflv) || !detail::fill_value(options, sflv, nullptr, root))
+    {
+        bej_diagnose(&options.diagnostics, BEJ_DIAG_ERROR, "Malformed BEJ document");
+        root = Value(root.members.get_allocator());
+        return false;
+    }
+    return true;
+}
+
+} // namespace bej::pmr
+
+#endif // BEJ_PMR_HPP
@@ -16,6 +16,7 @@
 // For more information checkout DSP0218_1.2.0
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -33,12 +34,142 @@
 #define BEJ_FORMAT_PROPERTY_ANNOTATION  0x0A
 #define BEJ_FORMAT_REGISTRY_ITEM        0x0B
 
-/// Buffer reader structure for memory reading
+/// Output encoding produced by the decoder
+typedef enum
+{
+    BEJ_OUTPUT_JSON,
+    BEJ_OUTPUT_CBOR,     // RFC 8949
+    BEJ_OUTPUT_MSGPACK
+} BejOutputFormat_t;
+
+/// Destination of decoder output
+typedef enum
+{
+    BEJ_SINK_STREAM,    // output_stream
+    BEJ_SINK_BUFFER,    // output_buffer, grown with realloc when full
+    BEJ_SINK_MEASURE    // nothing is stored, only output_length is counted
+} BejSinkType_t;
+
+/// Default member count from which a SET/ARRAY is decoded in parallel (see parallel_threads)
+#define BEJ_PARALLEL_MIN_MEMBERS 1024
+
+/// Bytes read from the input stream at a time by streaming decodes
+#define BEJ_STREAM_CHUNK_SIZE (64 * 1024)
+
+/// Severity of a diagnostic message, most severe first
+typedef enum
+{
+    BEJ_DIAG_ERROR,
+    BEJ_DIAG_WARNING,
+    BEJ_DIAG_INFO,      // progress of the high-level functions
+    BEJ_DIAG_TRACE      // one message per decoded tuple
+} BejDiagLevel_t;
+
+/// Receives one formatted diagnostic message (no trailing newline)
+typedef void (*BejDiagnosticFn_t)(void* user, BejDiagLevel_t level, const char* message);
+
+/// Where a decode reports problems; the decoder itself never prints
+//
+// With parallel or batch decoding the callback is invoked from several threads
+// at once, so it must be thread-safe (or user must be per-thread state).
+typedef struct
+{
+    BejDiagnosticFn_t callback;     // NULL discards all messages
+    void* user;                     // passed through to callback
+    BejDiagLevel_t level;           // most verbose level delivered
+} BejDiagnostics_t;
+
+/// Memory functions the decoder allocates through, with the same contract as malloc/realloc/free
+//
+// A NULL allocator pointer anywhere in the API means the C heap. With batch
+// decoding the functions are called from several threads at once. Parallel
+// member decoding (threads > 1) does not call them from its workers: their
+// scratch and output buffers come from the C heap, so a single-threaded pool
+// or arena stays safe there.
+typedef struct
+{
+    void* (*alloc)(void* user, size_t size);
+    void* (*realloc)(void* user, void* memory, size_t size);
+    void (*free)(void* user, void* memory);
+    void* user;                     // passed through to every function
+} BejAllocator_t;
+
+/// What one decode cost; kept on the decoder context and reset when a document starts
+//
+// Allocations are the decoder's own requests (arena or allocator), including
+// output buffer growth; the input document and dictionaries are not counted.
+typedef struct
+{
+    uint64_t allocations;       // allocation and growth requests
+    uint64_t bytes_allocated;   // total bytes requested by them
+    uint64_t live_bytes;        // bytes held right now
+    uint64_t peak_live_bytes;   // most bytes held at once
+    uint32_t max_depth;         // deepest SET/ARRAY nesting; a root SET is depth 1
+    uint64_t largest_value;     // longest leaf value in bytes
+} BejDecodeStats_t;
+
+/// One selected property of a compiled projection
+typedef struct
+{
+    uint32_t sequence;          // schema sequence number of the property
+    uint32_t first_child;       // index of its first selected sub-property in the node table
+    uint32_t child_count;       // 0: the property is selected with everything below it
+} BejProjectionNode_t;
+
+/// Redfish $select list compiled to schema sequence numbers (see bej_compile_projection())
+typedef struct
+{
+    BejProjectionNode_t* nodes; // nodes[0] is the resource itself; siblings are contiguous
+    uint32_t node_count;
+    const BejAllocator_t* allocator; // where nodes came from
+} BejProjection_t;
+
+/// Options for the high-level decode functions
+typedef struct
+{
+    BejOutputFormat_t format;
+    bool compact;               // JSON only: no whitespace between tokens
+    int threads;                // > 1 decodes large SETs/ARRAYs on this many threads (workers use the C heap)
+    BejDiagnostics_t diagnostics;
+    const BejAllocator_t* allocator; // NULL for the C heap
+    bool streaming;             // file decode in chunks: memory grows with depth, not size
+    uint64_t max_value_length;  // streaming only: largest leaf value buffered, 0 for no limit
+    BejDecodeStats_t* stats;    // receives the statistics of the decode, NULL to skip
+    const BejProjection_t* projection; // in-memory decodes: properties to keep, NULL for all
+    const char* select;         // file decodes without projection: $select list compiled after loading
+} BejDecodeOptions_t;
+
+/// Size of the BEJ encoding header: version (4), flags (2), schemaClass (1) (5.3.2, 5.3.4)
+#define BEJ_HEADER_SIZE 7
+
+/// Default minimum size of one arena block
+#define BEJ_ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct BejArenaBlock BejArenaBlock_t;
+
+/// Bump-pointer allocator for the transient memory of a decode
+//
+// Blocks are kept by arena_reset(), so once they cover the largest document
+// seen, later decodes take nothing from the heap. Not thread-safe.
+typedef struct
+{
+    BejArenaBlock_t* first;
+    BejArenaBlock_t* last;
+    BejArenaBlock_t* current;   // block allocations are bumped from
+    size_t used;                // bytes taken from current
+    size_t block_size;          // minimum size of a new block
+    const BejAllocator_t* allocator; // where blocks come from; NULL for the C heap
+} BejArena_t;
+
+/// Largest NNINT encoding accepted: a length byte followed by up to 8 value bytes (5.3.6)
+#define BEJ_NNINT_MAX_BYTES 8
+
+/// Buffer reader structure for memory reading; 64-bit so documents may exceed 4 GiB
 typedef struct 
 {
     uint8_t* data;
-    uint32_t size;
-    uint32_t position;
+    uint64_t size;
+    uint64_t position;
 } BufferReader_t;
 
 /// SFLV (Sequence, Format, Length, Value) structure (5.3.6 - 5.3.9)
@@ -47,7 +178,7 @@ typedef struct
     uint32_t sequence;
     uint8_t dict_selector;
     uint8_t format; //only 4 MSB bits used
-    uint32_t length;
+    uint64_t length;
     uint8_t* value;
 } SFLV_t;
 
@@ -72,8 +203,27 @@ typedef struct
     uint16_t entry_count;
     uint32_t schema_version;
     uint32_t dictionary_size;
+    uint64_t content_hash;      // FNV-1a of the whole file; tells revisions with one schema_version apart
+    char* names;                // one block holding every entry name
+    const BejAllocator_t* allocator; // the dictionary's memory came from here
 } Dictionary_t;
 
+/// One value read straight from a BEJ buffer by bej_get(); pointers refer to the buffer or dictionary
+typedef struct
+{
+    uint8_t format;             // BEJ_FORMAT_* of the value
+    uint8_t dict_selector;      // 0: described by the schema dictionary, 1: by the annotation one
+    const uint8_t* data;        // raw value bytes (a SET/ARRAY: its encoded members)
+    uint64_t length;
+    int64_t integer;            // INTEGER
+    double real;                // REAL
+    bool boolean;               // BOOLEAN
+    const char* string;         // STRING text or ENUM option name (NULL if unknown); may lack a NUL
+    uint64_t string_length;
+    uint32_t enum_sequence;     // ENUM option sequence number
+    const DictionaryEntry_t* entry; // dictionary entry describing the value, NULL if none
+} BejValue_t;
+
 /// Decoder context
 typedef struct 
 {
@@ -81,12 +231,31 @@ typedef struct
     Dictionary_t* anno_dict;
     FILE* input_stream;
     FILE* output_stream;
+    BejOutputFormat_t output_format;
+    BejSinkType_t output_sink;
+    uint8_t* output_buffer;     // BEJ_SINK_BUFFER only; owned by the caller, from allocator
+    size_t output_capacity;
+    size_t output_length;       // bytes produced so far, for every sink type
+    bool output_failed;         // a write or buffer growth failed
+    bool compact;               // JSON only: no whitespace between tokens
+    int parallel_threads;       // > 1 splits large SETs/ARRAYs across this many threads
+    uint32_t parallel_min_members; // member count from which parallel decode kicks in
+    BejDiagnostics_t diagnostics;  // silent unless the caller installs a callback
+    BejArena_t* arena;          // transient allocations; NULL uses allocator
+    const BejAllocator_t* allocator; // every other allocation; NULL for the C heap
+    uint64_t max_value_length;  // push/stream decode: largest leaf value buffered, 0 for no limit
+    BejDecodeStats_t stats;     // of the current or last document
+    uint32_t depth;             // SET/ARRAY nesting of the value being decoded
+    const BejProjection_t* projection;          // decode_bej_buffer(): properties to keep, NULL for all
+    const BejProjectionNode_t* projection_node; // filter of the SET being decoded, NULL for none
     int indent_level;
 } DecoderContext_t;
 
 // Main decode function
 /**
  * Decode a BEJ encoded file to JSON
+ *
+ * Nothing is printed; use bej_decode_file_with_options() to receive diagnostics.
  * @param input_file Path to BEJ encoded file
  * @param output_file Path to output JSON file
  * @param schema_dict_file Path to schema dictionary file
@@ -96,20 +265,203 @@ typedef struct
 bool bej_decode_file(const char* input_file, const char* output_file,
                      const char* schema_dict_file, const char* anno_dict_file);
 
+/**
+ * Decode a BEJ encoded file to the selected output encoding
+ * @param input_file Path to BEJ encoded file
+ * @param output_file Path to output file
+ * @param schema_dict_file Path to schema dictionary file
+ * @param anno_dict_file Path to annotation dictionary file
+ * @param format Output encoding (JSON, CBOR or MessagePack)
+ * @return true on success, false on failure
+ */
+bool bej_decode_file_as(const char* input_file, const char* output_file,
+                        const char* schema_dict_file, const char* anno_dict_file,
+                        BejOutputFormat_t format);
+
+/**
+ * Decode a BEJ encoded file with explicit decode options
+ * @param input_file Path to BEJ encoded file
+ * @param output_file Path to output file
+ * @param schema_dict_file Path to schema dictionary file
+ * @param anno_dict_file Path to annotation dictionary file
+ * @param options Decode options (NULL for defaults)
+ * @return true on success, false on failure
+ */
+bool bej_decode_file_with_options(const char* input_file, const char* output_file,
+                                  const char* schema_dict_file, const char* anno_dict_file,
+                                  const BejDecodeOptions_t* options);
+
+/**
+ * Initialize decode options to defaults: pretty JSON, single-threaded, C heap
+ * @param options Options to initialize
+ */
+void init_decode_options(BejDecodeOptions_t* options);
+
+/**
+ * Decode a complete BEJ document held in memory
+ *
+ * The output buffer is sized from the input up front and only grows, by
+ * doubling, for documents that expand more than that.
+ * @param data BEJ encoded document (header and root tuple)
+ * @param size Size of the document in bytes
+ * @param schema_dict Schema dictionary
+ * @param anno_dict Annotation dictionary
+ * @param options Output format, threading and allocator (NULL for pretty JSON, single-threaded)
+ * @param output Receives the output; JSON output is NUL-terminated.
+ *               Free with bej_free(options->allocator, ...), or free() without options
+
+ * @param output_size Receives the output length in bytes (excluding the terminator)
+ * @return true on success, false on failure
+ */
+bool bej_decode_to_memory(uint8_t* data, uint64_t size,
+                          Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                          const BejDecodeOptions_t* options, uint8_t** output, size_t* output_size);
+
+/**
+ * Decode many BEJ files into one NDJSON stream: one compact JSON document per line
+ *
+ * Files that fail to decode are reported and skipped; the others are still written.
+ * @param input_files Paths of BEJ encoded files
+ * @param count Number of paths
+ * @param output Output stream
+ * @param schema_dict Schema dictionary, shared by all records
+ * @param anno_dict Annotation dictionary, shared by all records
+ * @param decoded_count Receives the number of records written (may be NULL)
+ * @param diagnostics Where skipped files are reported (NULL for silent)
+ * @return true if every file was decoded and written, false otherwise
+ */
+bool bej_decode_files_ndjson(const char* const* input_files, size_t count, FILE* output,
+                             Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                             size_t* decoded_count, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Read a whole file into memory, reusing (and growing) a caller-owned buffer
+ * @param path File to read
+ * @param data In/out heap buffer (may start as NULL); free with free()
+ * @param capacity In/out size of *data in bytes
+ * @param size Receives the file size in bytes
+ * @param diagnostics Where failures are reported (NULL for silent)
+ * @return true on success, false if the file is missing, empty, larger than memory or unreadable
+ */
+bool read_file_into_buffer(const char* path, uint8_t** data, size_t* capacity, uint64_t* size,
+                           const BejDiagnostics_t* diagnostics);
+
+// Diagnostics functions
+/**
+ * Initialize diagnostics to silent: no callback, errors only
+ * @param diagnostics Diagnostics to initialize
+ */
+void init_diagnostics(BejDiagnostics_t* diagnostics);
+
+/**
+ * Format a message and hand it to the diagnostics callback
+ *
+ * Nothing is formatted when there is no callback or level is more verbose
+ * than diagnostics->level.
+ * @param diagnostics Diagnostics (may be NULL)
+ * @param level Severity of the message
+ * @param format printf-style format string
+ */
+void bej_diagnose(const BejDiagnostics_t* diagnostics, BejDiagLevel_t level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+/**
+ * Diagnostics callback that prints to stderr, prefixing errors and warnings
+ * @param user Unused
+ * @param level Severity of the message
+ * @param message Formatted message
+ */
+void bej_diagnostics_stderr(void* user, BejDiagLevel_t level, const char* message);
+
 // Dictionary functions
 /**
- * Load a BEJ dictionary from file
+ * Load a BEJ dictionary from file, silently
  * @param filename Path to dictionary file
  * @return Pointer to Dictionary_t or NULL on failure
  */
 Dictionary_t* load_dictionary(const char* filename);
 
 /**
- * Free dictionary memory
+ * Load a BEJ dictionary from file, reporting failures and the header (at INFO level)
+ * @param filename Path to dictionary file
+ * @param diagnostics Where messages are reported (NULL for silent)
+ * @return Pointer to Dictionary_t or NULL on failure
+ */
+Dictionary_t* load_dictionary_with_diagnostics(const char* filename, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Load a BEJ dictionary from file with a custom allocator
+ * @param filename Path to dictionary file
+ * @param diagnostics Where messages are reported (NULL for silent)
+ * @param allocator Where the dictionary's memory comes from (NULL for the C heap);
+ *                  it must outlive the dictionary
+ * @return Pointer to Dictionary_t or NULL on failure
+ */
+Dictionary_t* load_dictionary_with_allocator(const char* filename, const BejDiagnostics_t* diagnostics,
+                                             const BejAllocator_t* allocator);
+
+/**
+ * Free dictionary memory through the allocator it was loaded with
  * @param dict Dictionary to free
  */
 void free_dictionary(Dictionary_t* dict);
 
+/**
+ * Compile a Redfish $select list against a schema dictionary
+ *
+ * Paths are comma-separated, segments separated by '/' (e.g. "Id,Status/Health");
+ * a path through an ARRAY applies to each element. Annotation properties of a
+ * selected object are always kept. Decoding with the result skips every other
+ * property by its length, without copying it or looking up its name.
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param select The $select list
+ * @param allocator Where the projection is allocated (NULL for the C heap)
+ * @param diagnostics Where unknown properties are reported (NULL for silent)
+ * @return Compiled projection, or NULL on failure. Free with bej_free_projection()
+ */
+BejProjection_t* bej_compile_projection(Dictionary_t* schema_dict, const char* select,
+                                        const BejAllocator_t* allocator, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Free a projection from bej_compile_projection()
+ * @param projection Projection to free (NULL is ignored)
+ */
+void bej_free_projection(BejProjection_t* projection);
+
+/**
+ * Read one value from a BEJ document without decoding the rest of it
+ *
+ * Each token of the JSON Pointer (RFC 6901) is mapped to a dictionary sequence
+ * number; sibling tuples are skipped by their length and nothing is allocated.
+ * Tokens starting with '@' name annotations. Array elements are addressed by index,
+ * e.g. "/Status/Health" or "/AllowedSpeedsMHz/1"; "" is the whole resource.
+ * @param data Complete BEJ document, including its header
+ * @param size Size of data in bytes
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param anno_dict Annotation dictionary (NULL if annotations are not looked up)
+ * @param pointer JSON Pointer of the value
+ * @param value Receives the value; its pointers stay valid while data and the dictionaries do
+ * @param diagnostics Where failures are reported (NULL for silent); an absent property is a warning
+ * @return true if the value was found
+ */
+bool bej_get(const uint8_t* data, uint64_t size, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+             const char* pointer, BejValue_t* value, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Read the typed value of one tuple, as bej_get() returns it
+ * @param sflv Tuple whose value is in memory
+ * @param dict Dictionary describing the tuple (schema or annotation, by its dict_selector)
+ * @param entry Dictionary entry of the tuple, used for ENUM option names (may be NULL)
+ * @param value Receives the value; its pointers refer to sflv->value and dict
+ * @param diagnostics Where failures are reported (NULL for silent)
+ * @return true on success, false for a malformed value
+ */
+bool bej_value_from_sflv(const SFLV_t* sflv, Dictionary_t* dict, DictionaryEntry_t* entry,
+                         BejValue_t* value, const BejDiagnostics_t* diagnostics);
+
 /**
  * Find dictionary entry by sequence number
  * @param dict Dictionary to search
@@ -120,22 +472,49 @@ void free_dictionary(Dictionary_t* dict);
  */
 DictionaryEntry_t* find_dictionary_entry(Dictionary_t* dict, DictionaryEntry_t* parent, uint32_t sequence, int8_t format);
 
+/**
+ * Find the dictionary entry of a SET member
+ *
+ * The member's selector bit picks the dictionary. A parent outside that dictionary (an annotation
+ * inside a schema SET) is replaced by the dictionary's root entry, and a NULL member matches its
+ * sequence number whatever format the entry declares.
+ * @param schema_dict Schema dictionary
+ * @param anno_dict Annotation dictionary (may be NULL)
+ * @param parent Entry of the enclosing SET, or NULL if it is unknown
+ * @param member Member tuple header
+ * @return Pointer to DictionaryEntry_t or NULL if not found
+ */
+DictionaryEntry_t* find_member_entry(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                     DictionaryEntry_t* parent, const SFLV_t* member);
+
+/**
+ * Find the child of a dictionary entry by property name
+ * @param dict Dictionary to search
+ * @param parent SET (properties) or ENUM (options) entry whose children are searched;
+ *               an ARRAY is stepped through to its element entry
+ * @param name Property name (need not be NUL-terminated)
+ * @param length Length of name
+ * @return Pointer to DictionaryEntry_t or NULL if not found
+ */
+DictionaryEntry_t* find_dictionary_entry_by_name(Dictionary_t* dict, DictionaryEntry_t* parent,
+                                                 const char* name, size_t length);
+
 // NNINT (Non-Negative Integer) functions
 /**
- * Read NNINT from file stream
+ * Read NNINT (1 to 8 value bytes) from file stream
  * @param fp File pointer
  * @param value Pointer to store the read value
  * @return true on success, false on failure
  */
-bool read_nnint(FILE* fp, uint32_t* value);
+bool read_nnint(FILE* fp, uint64_t* value);
 
 /**
- * Read NNINT from buffer
+ * Read NNINT (1 to 8 value bytes) from buffer
  * @param reader Buffer reader
  * @param value Pointer to store the read value
  * @return true on success, false on failure
  */
-bool read_nnint_from_buffer(BufferReader_t* reader, uint32_t* value);
+bool read_nnint_from_buffer(BufferReader_t* reader, uint64_t* value);
 
 // SFLV functions
 /**
@@ -154,6 +533,23 @@ bool read_sflv(FILE* fp, SFLV_t* sflv);
  */
 bool read_sflv_from_buffer(BufferReader_t* reader, SFLV_t* sflv);
 
+/**
+ * Read only the SFLV tuple header from buffer; the value is not copied
+ * @param reader Buffer reader, advanced past the whole tuple
+ * @param sflv Receives the tuple; sflv->value points into the reader's buffer
+ *             and must not be passed to free_sflv()
+ * @return true on success, false on failure or if the value is truncated
+ */
+bool read_sflv_header_from_buffer(BufferReader_t* reader, SFLV_t* sflv);
+
+/**
+ * Read the BEJ encoding header: version, flags and schema class (5.3.2, 5.3.4)
+ * @param reader Buffer reader positioned at the start of a document, advanced past the header
+ * @param diagnostics Where a truncated header is reported (NULL for silent)
+ * @return true on success, false if the header is truncated
+ */
+bool read_bej_header_from_buffer(BufferReader_t* reader, const BejDiagnostics_t* diagnostics);
+
 /**
  * Free SFLV value memory
  * @param sflv SFLV_t structure with allocated value
@@ -162,12 +558,85 @@ void free_sflv(SFLV_t* sflv);
 
 // Decoding functions
 /**
- * Decode BEJ stream to JSON
+ * Decode a BEJ document from ctx->input_stream into the context's output sink
+ *
+ * The stream is read in BEJ_STREAM_CHUNK_SIZE pieces through a push parser, so
+ * SETs and ARRAYs are never materialized: memory is bounded by the nesting depth
+ * and the largest leaf value (capped by ctx->max_value_length). ctx->stats
+ * describes the decode afterwards.
  * @param ctx Decoder context
  * @return true on success, false on failure
  */
 bool decode_bej_to_json(DecoderContext_t* ctx);
 
+/**
+ * Decode a complete BEJ document (header and root tuple) held in memory
+ * into the context's output sink
+ *
+ * The context's arena, if any, and ctx->stats are reset first. With
+ * ctx->projection set, unselected properties are skipped by their length.
+ * @param ctx Decoder context
+ * @param data BEJ encoded document
+ * @param size Size of the document in bytes
+ * @return true on success, false on failure
+ */
+bool decode_bej_buffer(DecoderContext_t* ctx, uint8_t* data, uint64_t size);
+
+// Push parser functions
+/// Resumable decoder fed a document in arbitrary chunks (see bej_push_create())
+typedef struct BejPushParser BejPushParser_t;
+
+/**
+ * Create a push parser writing into the context's output sink
+ *
+ * Output is emitted as soon as each value is complete, so a document arriving
+ * in transfer chunks never has to be reassembled. Only the leaf value being
+ * collected is buffered. The context must outlive the parser; its stats are reset.
+ * Projections are not supported: creation fails when ctx->projection is set.
+ * @param ctx Decoder context (dictionaries, output format and sink)
+ * @return New parser, or NULL on failure. Free with bej_push_free()
+ */
+BejPushParser_t* bej_push_create(DecoderContext_t* ctx);
+
+/**
+ * Feed the next chunk of a BEJ document (header and root tuple)
+ *
+ * Chunks may split the document anywhere, including inside a tuple header.
+ * Bytes after the root value are ignored. A leaf value longer than
+ * ctx->max_value_length (when non-zero) fails the decode.
+ * @param parser Push parser
+ * @param chunk Next bytes of the document (may be NULL when length is 0)
+ * @param length Number of bytes in chunk
+ * @return true while the document is well-formed so far, false once decoding failed
+ */
+bool bej_feed(BejPushParser_t* parser, const uint8_t* chunk, size_t length);
+
+/**
+ * Signal the end of input and flush the output
+ * @param parser Push parser
+ * @return true if a complete document was decoded and written, false otherwise
+ */
+bool bej_finish(BejPushParser_t* parser);
+
+/**
+ * Free a push parser (the decoder context is not touched)
+ * @param parser Push parser (may be NULL)
+ */
+void bej_push_free(BejPushParser_t* parser);
+
+/**
+ * Compute the exact number of bytes decode_value() would produce, without writing anything
+ *
+ * Integers are sized by their digit count and strings by their escapes; no members are
+ * decoded in parallel. Only REAL values are formatted.
+ * @param ctx Decoder context (its output sink is not touched)
+ * @param sflv SFLV tuple to measure
+ * @param entry Dictionary entry (can be NULL)
+ * @param size Receives the output size in bytes
+ * @return true on success, false on failure
+ */
+bool measure_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry, size_t* size);
+
 /**
  * Decode a single BEJ value
  * @param ctx Decoder context
@@ -177,6 +646,16 @@ bool decode_bej_to_json(DecoderContext_t* ctx);
  */
 bool decode_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry);
 
+/**
+ * Transcode a single BEJ value straight to CBOR or MessagePack
+ * (selected by ctx->output_format), without going through JSON text
+ * @param ctx Decoder context
+ * @param sflv SFLV tuple to transcode
+ * @param entry Dictionary entry (can be NULL)
+ * @return true on success, false on failure
+ */
+bool transcode_value(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry);
+
 /**
  * Decode BEJ SET format (JSON object)
  * @param ctx Decoder context
@@ -227,6 +706,14 @@ bool decode_enum(DecoderContext_t* ctx, SFLV_t* sflv, DictionaryEntry_t* entry);
  */
 bool decode_string(DecoderContext_t* ctx, SFLV_t* sflv);
 
+/**
+ * Decode BEJ BYTE STRING format as a base64 JSON string
+ * @param ctx Decoder context
+ * @param sflv SFLV tuple with BYTE STRING data
+ * @return true on success, false on failure
+ */
+bool decode_byte_string(DecoderContext_t* ctx, SFLV_t* sflv);
+
 /**
  * Decode BEJ REAL format (floating point)
  * @param ctx Decoder context
@@ -257,7 +744,7 @@ uint8_t get_msb4(uint8_t value);
  * @param data Pointer to buffer data
  * @param size Size of buffer
  */
-void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint32_t size);
+void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint64_t size);
 
 /**
  * Read bytes from buffer
@@ -266,7 +753,7 @@ void init_buffer_reader(BufferReader_t* reader, uint8_t* data, uint32_t size);
  * @param count Number of bytes to read
  * @return Number of bytes actually read
  */
-uint32_t buffer_read(BufferReader_t* reader, void* dest, uint32_t count);
+uint64_t buffer_read(BufferReader_t* reader, void* dest, uint64_t count);
 
 /**
  * Check if at end of buffer
@@ -288,7 +775,77 @@ void write_indent(FILE* fp, int level);
  * @param str String to write
  * @param length Length of string
  */
-void write_json_string(FILE* fp, const char* str, uint32_t length);
+void write_json_string(FILE* fp, const char* str, size_t length);
+
+/**
+ * Base64 encode a byte buffer (RFC 4648, with padding)
+ * @param src Source bytes
+ * @param length Number of source bytes
+ * @param dst Destination, must hold at least 4 * ((length + 2) / 3) characters
+ * @return Number of characters written (no terminating NUL)
+ */
+size_t base64_encode(const uint8_t* src, size_t length, char* dst);
+
+/**
+ * Write byte data to JSON output as a quoted base64 string
+ * @param fp File pointer
+ * @param data Bytes to encode (may be NULL when length is 0)
+ * @param length Number of bytes
+ */
+void write_base64_string(FILE* fp, const uint8_t* data, size_t length);
+
+// Allocator functions
+/**
+ * Allocate through an allocator
+ * @param allocator Allocator (NULL for the C heap)
+ * @param size Number of bytes
+ * @return Memory, or NULL on failure
+ */
+void* bej_alloc(const BejAllocator_t* allocator, size_t size);
+
+/**
+ * Resize memory obtained from the same allocator
+ * @param allocator Allocator (NULL for the C heap)
+ * @param memory Memory to resize (may be NULL)
+ * @param size New size in bytes
+ * @return Resized memory, or NULL on failure (memory is then left untouched)
+ */
+void* bej_realloc(const BejAllocator_t* allocator, void* memory, size_t size);
+
+/**
+ * Free memory obtained from the same allocator
+ * @param allocator Allocator (NULL for the C heap)
+ * @param memory Memory to free (may be NULL)
+ */
+void bej_free(const BejAllocator_t* allocator, void* memory);
+
+// Arena functions
+/**
+ * Initialize an empty arena on the C heap; no memory is allocated until the first arena_alloc()
+ * @param arena Arena to initialize
+ * @param block_size Minimum size of each block (0 for BEJ_ARENA_BLOCK_SIZE)
+ */
+void init_arena(BejArena_t* arena, size_t block_size);
+
+/**
+ * Allocate from the arena, aligned for any type
+ * @param arena Arena
+ * @param size Number of bytes
+ * @return Memory valid until the next arena_reset() or free_arena(), or NULL on failure
+ */
+void* arena_alloc(BejArena_t* arena, size_t size);
+
+/**
+ * Release every allocation at once, keeping the blocks for reuse
+ * @param arena Arena (may be NULL)
+ */
+void arena_reset(BejArena_t* arena);
+
+/**
+ * Free every block of the arena
+ * @param arena Arena (may be NULL)
+ */
+void free_arena(BejArena_t* arena);
 
 /**
  * Initialize decoder context
@@ -301,4 +858,13 @@ void write_json_string(FILE* fp, const char* str, uint32_t length);
 void init_decoder_context(DecoderContext_t* ctx, Dictionary_t* schema_dict,
                          Dictionary_t* anno_dict, FILE* input, FILE* output);
 
+/**
+ * Redirect decoder output into a memory buffer
+ * @param ctx Decoder context
+ * @param buffer Buffer from ctx->allocator (or NULL); it is grown through the allocator
+ *               when full, so read ctx->output_buffer back after decoding
+ * @param capacity Size of buffer in bytes
+ */
+void set_output_buffer(DecoderContext_t* ctx, uint8_t* buffer, size_t capacity);
+
 #endif // DECODE_H
\ No newline at end of file
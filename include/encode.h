@@ -0,0 +1,92 @@
+/**
+ * @file encode.h
+ * @author Vladyslav Kolodii
+ * @brief JSON-to-BEJ encoding with reverse name indexes over the dictionaries
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+// Encoding takes three passes over one JSON document, and the text is copied once:
+//
+//   1. Tokenize: a flat token array. String lengths are measured with escapes resolved.
+//   2. Size: every name is resolved to a dictionary entry through a hash index. Each
+//      tuple's value length is computed bottom-up, so every NNINT gets its final width.
+//   3. Emit: the tuples are written straight into an output buffer of the exact size.
+//
+// Values are written as this decoder reads them. INTEGER is the shortest two's
+// complement, REAL is an IEEE 754 double, STRING is NUL-terminated, ENUM is the
+// option's sequence number, and BYTE_STRING comes from base64 text.
+
+/// Reverse index of one dictionary: (parent entry, name) to child entry
+typedef struct BejNameIndex BejNameIndex_t;
+
+/// Reusable encoder; keeps its scratch buffers between documents
+typedef struct BejEncoder BejEncoder_t;
+
+/**
+ * Build the reverse name index of a dictionary
+ *
+ * Parents that share a child range (as DSP0218 dictionaries do for common types)
+ * share its index entries.
+ * @param dict Dictionary; must outlive the index
+ * @return Index, or NULL on allocation failure. Free with bej_name_index_free()
+ */
+BejNameIndex_t* bej_name_index_create(const Dictionary_t* dict);
+
+/**
+ * Find a property (or enum option) of parent by name in constant time
+ * @param index Index of the dictionary parent belongs to
+ * @param parent SET or ENUM entry whose children are searched
+ * @param name Name, not necessarily NUL-terminated
+ * @param length Length of name
+ * @return The child entry, or NULL if parent has no child of that name
+ */
+const DictionaryEntry_t* bej_name_index_find(const BejNameIndex_t* index, const DictionaryEntry_t* parent,
+                                             const char* name, size_t length);
+
+/**
+ * Free a name index
+ * @param index Index to free (NULL is ignored)
+ */
+void bej_name_index_free(BejNameIndex_t* index);
+
+/**
+ * Create an encoder and index its dictionaries
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param anno_dict Annotation dictionary, for names starting with '@' (may be NULL)
+ * @param diagnostics Where unknown names and type mismatches are reported (NULL for silent)
+ * @return Encoder, or NULL on failure. Free with bej_encoder_free()
+ */
+BejEncoder_t* bej_encoder_create(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                 const BejDiagnostics_t* diagnostics);
+
+/**
+ * Encode one JSON object as a complete BEJ document, header included
+ * @param encoder Encoder
+ * @param json JSON text, not necessarily NUL-terminated
+ * @param length Length of json in bytes
+ * @param output In/out heap buffer (may start as NULL), grown with realloc as needed; free with free()
+ * @param capacity In/out size of *output in bytes
+ * @param size Receives the encoded size in bytes
+ * @return true on success, false on malformed JSON or JSON the dictionaries do not describe
+ */
+bool bej_encode_json(BejEncoder_t* encoder, const char* json, size_t length,
+                     uint8_t** output, size_t* capacity, size_t* size);
+
+/**
+ * Free an encoder
+ * @param encoder Encoder to free (NULL is ignored)
+ */
+void bej_encoder_free(BejEncoder_t* encoder);
+
+#endif // ENCODE_H
@@ -0,0 +1,135 @@
+/**
+ * @file filter.h
+ * @author Vladyslav Kolodii
+ * @brief Predicate filters evaluated directly on BEJ payloads, without decoding them
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+// Expression syntax:
+//
+//   expression := term { ("or" | "||") term }
+//   term       := factor { ("and" | "&&") factor }
+//   factor     := "(" expression ")" | path operator literal
+//   path       := property names separated by '/', array elements by index,
+//                 e.g. Status/Health or /AllowedSpeedsMHz/0 (leading '/' optional)
+//   operator   := == | != | < | <= | > | >=
+//   literal    := integer | real | "string" | true | false | null
+//
+// The literal must suit the property's dictionary format: ENUM takes the option
+// name as a string, BOOLEAN takes true or false, and ENUM, BOOLEAN and null only
+// allow == and !=. A comparison with a property the payload lacks is false. A
+// value of another format than the dictionary's (e.g. null) only matches !=.
+
+typedef struct BejFilter BejFilter_t;
+
+/**
+ * Compile a filter expression against the dictionaries
+ *
+ * Property names become sequence numbers and enum literals become option
+ * sequence numbers here, so matching never compares names.
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param anno_dict Annotation dictionary, for names starting with '@' (may be NULL)
+ * @param expression Filter expression, e.g. Status/Health != "OK" and CapacityMiB >= 65536
+ * @param diagnostics Where syntax errors and unknown names are reported (NULL for silent)
+ * @return Compiled filter, or NULL on failure. Free with bej_filter_free()
+ */
+BejFilter_t* bej_filter_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                const char* expression, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Evaluate a compiled filter on one BEJ document
+ *
+ * Only the tuple headers on the way to each compared value are read; nothing is
+ * allocated or written. A filter is read-only and may be used by many threads at once.
+ * @param filter Compiled filter
+ * @param data Complete BEJ document, including its header
+ * @param size Size of data in bytes
+ * @param matched Receives whether the document satisfies the filter
+ * @return true on success, false if the document is malformed
+ */
+bool bej_filter_match(const BejFilter_t* filter, const uint8_t* data, uint64_t size, bool* matched);
+
+/**
+ * Free a compiled filter
+ * @param filter Filter to free (NULL is ignored)
+ */
+void bej_filter_free(BejFilter_t* filter);
+
+/// A property path resolved to member sequence numbers and element indices
+typedef struct BejPath BejPath_t;
+
+/// One step of a compiled path: from a SET to a member, or from an ARRAY to an element
+typedef struct
+{
+    uint64_t value;             // member sequence number or element index
+    uint8_t dict_selector;      // 0 schema, 1 annotation; members match on both value and selector
+    bool index;                 // value is an element index
+} BejPathStep_t;
+
+/**
+ * Compile a property path against the dictionaries, for lookups in many documents
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param anno_dict Annotation dictionary, for names starting with '@' (may be NULL)
+ * @param path Path in filter syntax, e.g. Status/Health or /AllowedSpeedsMHz/0
+ * @param diagnostics Where unknown names are reported (NULL for silent)
+ * @return Compiled path, or NULL on failure. Free with bej_path_free()
+ */
+BejPath_t* bej_path_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict, const char* path,
+                            const BejDiagnostics_t* diagnostics);
+
+/**
+ * Dictionary entry describing the value a path leads to
+ *
+ * Paths keep entry indices rather than pointers, so a path compiled once serves
+ * every copy of the same dictionaries.
+ * @param path Compiled path
+ * @param schema_dict Schema dictionary, as given to bej_path_compile() or a copy of it
+ * @param anno_dict Annotation dictionary, likewise (may be NULL if the path has no annotation)
+ * @return The entry (the root entry for an empty path), or NULL if the dictionaries do not fit
+ */
+const DictionaryEntry_t* bej_path_entry(const BejPath_t* path, const Dictionary_t* schema_dict,
+                                        const Dictionary_t* anno_dict);
+
+/**
+ * Dictionary the entry of bej_path_entry() belongs to
+ * @param path Compiled path
+ * @return 0 for the schema dictionary, 1 for the annotation dictionary
+ */
+uint8_t bej_path_entry_selector(const BejPath_t* path);
+
+/**
+ * Steps of a compiled path, from the root to the value
+ * @param path Compiled path
+ * @param step_count Receives the number of steps (0 for the root itself)
+ * @return The steps; valid until the path is freed
+ */
+const BejPathStep_t* bej_path_steps(const BejPath_t* path, size_t* step_count);
+
+/**
+ * Find the value a compiled path leads to, reading only the tuple headers on the way
+ * @param path Compiled path
+ * @param root Document's root tuple, as read_sflv_header_from_buffer() returns it after the BEJ header
+ * @param value Receives the value's tuple
+ * @param found Receives false if the document lacks the property
+ * @return true on success, false if the document is malformed
+ */
+bool bej_path_find(const BejPath_t* path, const SFLV_t* root, SFLV_t* value, bool* found);
+
+/**
+ * Free a compiled path
+ * @param path Path to free (NULL is ignored)
+ */
+void bej_path_free(BejPath_t* path);
+
+#endif // FILTER_H
@@ -0,0 +1,107 @@
+/**
+ * @file pipeline.h
+ * @author Vladyslav Kolodii
+ * @brief Pipelined streaming decoder for length-framed BEJ records
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// Stream framing: every record is a 4-byte little-endian length followed by
+// that many bytes of BEJ document (header and root tuple). The stream ends
+// cleanly at a record boundary.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+/// Default number of slots per ring (and buffers in flight per stage)
+#define PIPELINE_RING_CAPACITY 64
+
+/// Default upper bound for a single framed record
+#define PIPELINE_MAX_RECORD_SIZE (64u * 1024u * 1024u)
+
+/// Single-producer/single-consumer ring of pointers (defined in pipeline.c)
+//
+// spsc_try_push() and spsc_try_pop() are lock-free. The pipeline's blocking
+// push and pop yield for a bounded number of attempts, then sleep on a condition
+// variable until the other side's next push or pop, so an idle stream costs no CPU.
+typedef struct SpscRing SpscRing_t;
+
+/// Pipeline options
+typedef struct
+{
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+    FILE* input;                // framed BEJ records
+    FILE* output;               // NDJSON: one compact JSON document per record
+    size_t ring_capacity;       // rounded up to a power of two; 0 selects PIPELINE_RING_CAPACITY
+    uint32_t max_record_size;   // frames above this are rejected; 0 selects PIPELINE_MAX_RECORD_SIZE
+    BejDiagnostics_t diagnostics;   // called from all three stages; must be thread-safe
+} PipelineOptions_t;
+
+/// Pipeline results
+typedef struct
+{
+    uint64_t records_in;
+    uint64_t records_out;
+    uint64_t records_failed;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    double seconds;
+} PipelineStats_t;
+
+/**
+ * Create a ring
+ * @param capacity Number of slots, rounded up to a power of two
+ * @return Ring, or NULL on allocation failure
+ */
+SpscRing_t* spsc_create(size_t capacity);
+
+/**
+ * Free a ring
+ * @param ring Ring (may be NULL)
+ */
+void spsc_free(SpscRing_t* ring);
+
+/**
+ * Get the number of slots in a ring
+ * @param ring Ring
+ * @return Capacity, always a power of two
+ */
+size_t spsc_capacity(const SpscRing_t* ring);
+
+/**
+ * Push an item without blocking (producer thread only)
+ * @param ring Ring
+ * @param item Item to push
+ * @return true if pushed, false if the ring is full
+ */
+bool spsc_try_push(SpscRing_t* ring, void* item);
+
+/**
+ * Pop an item without blocking (consumer thread only)
+ * @param ring Ring
+ * @param item Receives the item
+ * @return true if popped, false if the ring is empty
+ */
+bool spsc_try_pop(SpscRing_t* ring, void** item);
+
+/**
+ * Decode a stream of length-framed BEJ records to NDJSON
+ *
+ * Reading, decoding and writing run on three threads connected by SPSC rings;
+ * record buffers circulate between the stages and are reused, so steady state
+ * does no allocation. Records that fail to decode are reported and skipped.
+ * @param options Pipeline options
+ * @param stats Receives record/byte counts and wall time (may be NULL)
+ * @return true if the stream was read to a clean end and every record was written
+ */
+bool bej_decode_stream_pipeline(const PipelineOptions_t* options, PipelineStats_t* stats);
+
+#endif // PIPELINE_H
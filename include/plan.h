@@ -0,0 +1,111 @@
+/**
+ * @file plan.h
+ * @author Vladyslav Kolodii
+ * @brief Compiled query plans (value paths plus an optional filter) and their in-process cache
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PLAN_H
+#define PLAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+// A plan holds no names and no pointers into a dictionary: the paths become a tree
+// of sequence numbers and element indices, the filter becomes comparisons against
+// sequence numbers. It therefore serves every document encoded with the same
+// dictionary revision, which the cache identifies by schema_version and content_hash.
+
+typedef struct BejPlan BejPlan_t;
+typedef struct BejPlanCache BejPlanCache_t;
+
+/**
+ * Compile the values to read and an optional filter into a plan
+ * @param schema_dict Schema dictionary whose first entry is the resource
+ * @param anno_dict Annotation dictionary, for names starting with '@' (may be NULL)
+ * @param paths Paths in filter syntax, e.g. Status/Health or /AllowedSpeedsMHz/0
+ * @param path_count Number of paths (may be 0 for a plan that only filters)
+ * @param where Filter expression as for bej_filter_compile(), or NULL to select every document
+ * @param diagnostics Where syntax errors and unknown names are reported (NULL for silent)
+ * @return Plan, or NULL on failure. Free with bej_plan_free()
+ */
+BejPlan_t* bej_plan_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                            const char* const* paths, size_t path_count, const char* where,
+                            const BejDiagnostics_t* diagnostics);
+
+/**
+ * Number of paths a plan reads
+ * @param plan Plan
+ * @return Path count
+ */
+size_t bej_plan_path_count(const BejPlan_t* plan);
+
+/**
+ * Run a plan on one BEJ document
+ *
+ * The filter is evaluated first. If the document matches, every path is read in a
+ * single walk over the tuple headers: members no path needs are skipped by their
+ * length and a container is left as soon as its last wanted member is found.
+ * @param plan Plan
+ * @param schema_dict The schema dictionary the plan was compiled with, or another copy of it
+ * @param anno_dict The annotation dictionary, likewise (may be NULL)
+ * @param data Complete BEJ document, including its header
+ * @param size Size of data in bytes
+ * @param matched Receives whether the document satisfies the filter
+ * @param values Receives one value per path, as bej_get() returns it; untouched if not matched
+ * @param found Receives, per path, whether the document has the property
+ * @return true on success; false if the document is malformed or the dictionaries differ
+ */
+bool bej_plan_execute(const BejPlan_t* plan, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                      const uint8_t* data, uint64_t size, bool* matched, BejValue_t* values, bool* found);
+
+/**
+ * Free a plan
+ * @param plan Plan to free (NULL is ignored)
+ */
+void bej_plan_free(BejPlan_t* plan);
+
+/**
+ * Create an empty plan cache
+ * @return Cache, or NULL on allocation failure. Free with bej_plan_cache_free()
+ */
+BejPlanCache_t* bej_plan_cache_create(void);
+
+/**
+ * Return the plan for a query, compiling it on first use
+ *
+ * Plans are keyed by the dictionaries' schema_version and content_hash and by the
+ * query text, so reloading the same dictionary files reuses them. The cache is
+ * thread-safe, and the plans it returns stay valid until it is freed.
+ * @param cache Cache
+ * @param schema_dict Schema dictionary
+ * @param anno_dict Annotation dictionary (may be NULL)
+ * @param paths Paths, as for bej_plan_compile()
+ * @param path_count Number of paths
+ * @param where Filter expression, or NULL
+ * @param diagnostics Where compile errors are reported (NULL for silent)
+ * @return Plan owned by the cache, or NULL if the query does not compile
+ */
+const BejPlan_t* bej_plan_cache_get(BejPlanCache_t* cache, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                    const char* const* paths, size_t path_count, const char* where,
+                                    const BejDiagnostics_t* diagnostics);
+
+/**
+ * Number of plans a cache holds
+ * @param cache Cache
+ * @return Plan count
+ */
+size_t bej_plan_cache_size(BejPlanCache_t* cache);
+
+/**
+ * Free a cache and every plan in it
+ * @param cache Cache to free (NULL is ignored)
+ */
+void bej_plan_cache_free(BejPlanCache_t* cache);
+
+#endif // PLAN_H
@@ -0,0 +1,86 @@
+/**
+ * @file server.h
+ * @author Vladyslav Kolodii
+ * @brief Long-running decode daemon over a Unix domain socket
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+// Wire protocol (all integers little-endian). A connection may send any
+// number of requests; responses come back in request order.
+//
+//   request:  u32 body_length | u8 key_length | key | BEJ document
+//   response: u32 body_length | u8 status     | payload
+//
+// body_length counts every byte after the length field itself. On
+// SERVER_STATUS_OK the payload is compact JSON; otherwise it is an error
+// message.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+#define SERVER_STATUS_OK            0
+#define SERVER_STATUS_DECODE_ERROR  1   // the document could not be decoded
+#define SERVER_STATUS_UNKNOWN_KEY   2   // no dictionary pair registered under the key
+#define SERVER_STATUS_BAD_REQUEST   3   // malformed or oversized request; the connection is closed
+
+/// Default upper bound for a request body
+#define SERVER_MAX_REQUEST_SIZE (16u * 1024u * 1024u)
+
+/// A dictionary pair that requests select by key
+typedef struct
+{
+    const char* key;
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+} ServerDictionary_t;
+
+/// Server options
+typedef struct
+{
+    const char* socket_path;                // created mode 0600 on start; an existing socket there is
+                                            // replaced, any other file makes server_create() fail
+    const ServerDictionary_t* dictionaries; // shared read-only by all workers; must outlive the server
+    size_t dictionary_count;
+    int thread_count;                       // decode workers; <= 0 selects one per CPU
+    uint32_t max_request_size;              // 0 selects SERVER_MAX_REQUEST_SIZE
+    BejDiagnostics_t diagnostics;           // called from the event loop and the workers
+} ServerOptions_t;
+
+/// Opaque server handle
+typedef struct BejServer BejServer_t;
+
+/**
+ * Create a server: bind and listen on the socket and start the worker pool
+ * @param options Server options (copied; the dictionaries are referenced)
+ * @return Server, or NULL on failure (or when not built for Linux)
+ */
+BejServer_t* server_create(const ServerOptions_t* options);
+
+/**
+ * Run the event loop until server_stop() is called
+ * @param server Server
+ * @return true on a clean stop, false if the event loop failed
+ */
+bool server_run(BejServer_t* server);
+
+/**
+ * Ask a running server to stop; safe to call from another thread or a signal handler
+ * @param server Server
+ */
+void server_stop(BejServer_t* server);
+
+/**
+ * Stop the workers, close every connection, remove the socket file and free the server
+ * @param server Server (may be NULL); server_run() must have returned
+ */
+void server_destroy(BejServer_t* server);
+
+#endif // SERVER_H
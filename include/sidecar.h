@@ -0,0 +1,185 @@
+/**
+ * @file sidecar.h
+ * @author Vladyslav Kolodii
+ * @brief Sidecar offset index: where every property of many BEJ payloads is stored
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef SIDECAR_H
+#define SIDECAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "decode.h"
+
+// A sidecar file is written in host byte order and memory-mapped as is:
+//
+//   BejIndexHeader_t
+//   BejIndexPath_t[path_count]         sorted by pointer text
+//   BejIndexPayload_t[payload_count]   in the order the payloads were added
+//   BejIndexEntry_t[entry_count]       per payload, sorted by path
+//   string pool                        payload file names and JSON Pointers, NUL-terminated
+//
+// Every section starts on an 8-byte boundary.
+
+/// "BEJX" in the first four bytes of a sidecar file
+#define BEJ_INDEX_MAGIC "BEJX"
+
+/// Layout version; also tells a sidecar written with another byte order apart
+#define BEJ_INDEX_VERSION 1u
+
+/// dict_entry of a value the dictionaries do not describe
+#define BEJ_INDEX_NO_ENTRY 0xFFFFu
+
+/// Sidecar file header
+typedef struct
+{
+    char magic[4];              // BEJ_INDEX_MAGIC
+    uint32_t version;           // BEJ_INDEX_VERSION
+    uint32_t schema_version;    // of the schema dictionary the payloads were indexed with
+    uint32_t schema_size;       // dictionary_size of that schema dictionary
+    uint32_t anno_size;         // dictionary_size of the annotation dictionary (0 if none)
+    uint32_t path_count;
+    uint64_t payload_count;
+    uint64_t entry_count;
+    uint64_t paths_offset;      // byte offsets of the sections from the start of the file
+    uint64_t payloads_offset;
+    uint64_t entries_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+} BejIndexHeader_t;
+
+/// One distinct property path, e.g. "/Status/Health"
+typedef struct
+{
+    uint32_t name;              // JSON Pointer, as an offset into the string pool
+    uint32_t length;            // its length without the NUL
+} BejIndexPath_t;
+
+/// One indexed payload file
+typedef struct
+{
+    uint64_t first_entry;       // its entries are entries[first_entry .. first_entry + entry_count)
+    uint64_t size;              // file size when indexed; a different size means the index is stale
+    uint32_t entry_count;
+    uint32_t name;              // file path, as an offset into the string pool
+} BejIndexPayload_t;
+
+/// Where one property of one payload is stored
+typedef struct
+{
+    uint64_t offset;            // of the value bytes in the payload file
+    uint64_t length;            // of the value bytes
+    uint32_t path;              // index into the path table
+    uint16_t dict_entry;        // index of the describing dictionary entry, or BEJ_INDEX_NO_ENTRY
+    uint8_t format;             // BEJ_FORMAT_*
+    uint8_t dict_selector;      // 0: schema dictionary, 1: annotation dictionary
+} BejIndexEntry_t;
+
+typedef struct BejIndexBuilder BejIndexBuilder_t;
+typedef struct BejIndex BejIndex_t;
+
+/**
+ * Create a builder that collects the property offsets of many payloads
+ * @param schema_dict Schema dictionary the payloads are encoded with
+ * @param anno_dict Annotation dictionary (NULL to leave annotations out)
+ * @param diagnostics Where failures are reported (NULL for silent)
+ * @return Builder, or NULL on allocation failure. Free with bej_index_builder_free()
+ */
+BejIndexBuilder_t* bej_index_builder_create(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                            const BejDiagnostics_t* diagnostics);
+
+/**
+ * Record every property path of one payload, with array elements addressed by index
+ *
+ * Only tuple headers are read; properties the dictionaries do not name are left out.
+ * @param builder Builder
+ * @param name File the payload is read from at query time
+ * @param data Complete BEJ document, as stored in that file
+ * @param size Size of data in bytes
+ * @return true on success; on failure the payload is not added
+ */
+bool bej_index_add(BejIndexBuilder_t* builder, const char* name, const uint8_t* data, uint64_t size);
+
+/**
+ * Write the collected payloads to a sidecar file
+ * @param builder Builder
+ * @param path Sidecar file to create
+ * @return true on success, false on failure
+ */
+bool bej_index_write(BejIndexBuilder_t* builder, const char* path);
+
+/**
+ * Free a builder
+ * @param builder Builder to free (NULL is ignored)
+ */
+void bej_index_builder_free(BejIndexBuilder_t* builder);
+
+/**
+ * Map a sidecar file and check its layout
+ * @param path Sidecar file
+ * @param diagnostics Where failures are reported, now and by later queries (NULL for silent)
+ * @return Index, or NULL on failure. Close with bej_index_close()
+ */
+BejIndex_t* bej_index_open(const char* path, const BejDiagnostics_t* diagnostics);
+
+/**
+ * Unmap a sidecar file
+ * @param index Index to close (NULL is ignored)
+ */
+void bej_index_close(BejIndex_t* index);
+
+/**
+ * Number of payloads in an index
+ * @param index Index
+ * @return Payload count
+ */
+uint64_t bej_index_payload_count(const BejIndex_t* index);
+
+/**
+ * File name of a payload
+ * @param index Index
+ * @param payload Payload number, below bej_index_payload_count()
+ * @return File name, or NULL if payload is out of range
+ */
+const char* bej_index_payload_name(const BejIndex_t* index, uint64_t payload);
+
+/**
+ * Look up a property path; resolve it once and reuse the result for every payload
+ * @param index Index
+ * @param pointer JSON Pointer, e.g. "/Status/Health"
+ * @param path Receives the path number
+ * @return true if some payload has the property
+ */
+bool bej_index_find_path(const BejIndex_t* index, const char* pointer, uint32_t* path);
+
+/**
+ * Find where a payload stores a property
+ * @param index Index
+ * @param payload Payload number
+ * @param path Path number from bej_index_find_path()
+ * @return The entry, or NULL if the payload does not have the property
+ */
+const BejIndexEntry_t* bej_index_lookup(const BejIndex_t* index, uint64_t payload, uint32_t path);
+
+/**
+ * Read a property of a payload with a single positioned read of its file
+ * @param index Index
+ * @param payload Payload number
+ * @param path Path number from bej_index_find_path()
+ * @param schema_dict The schema dictionary the index was built with
+ * @param anno_dict The annotation dictionary it was built with (may be NULL)
+ * @param buffer Read buffer, grown with realloc as needed; the value points into it
+ * @param capacity Size of *buffer
+ * @param value Receives the value, as bej_get() returns it
+ * @return true on success; false if the property is absent, the file changed or cannot be read
+ */
+bool bej_index_read(const BejIndex_t* index, uint64_t payload, uint32_t path,
+                    Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                    uint8_t** buffer, size_t* capacity, BejValue_t* value);
+
+#endif // SIDECAR_H
@@ -12,26 +12,169 @@
 #include <stdlib.h>
 #include <string.h>
 #include "decode.h"
+#include "batch.h"
+#include "pipeline.h"
+#include "server.h"
+#include "sidecar.h"
+#include "filter.h"
+#include "aggregate.h"
+#include "encode.h"
+#include <signal.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 typedef struct
 {
     char* schemaDictionary;
     char* annotationDictionary;
-    char* bejEncodedFile;
+    char** bejEncodedFiles;
+    int bejEncodedCount;
+    char* ndjsonOutput;
+    BejOutputFormat_t outputFormat;
+    int threadCount;
+    int streaming;
+    uint64_t maxValueLength;
+    int stats;
+    char* select;
     int verbose;
 } DecodeArgs_t;
 
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    BatchFileList_t inputs;
+    char* outputDirectory;
+    char* ndjsonOutput;
+    BejOutputFormat_t outputFormat;
+    BatchIoBackend_t ioBackend;
+    int threadCount;
+    int verbose;
+} BatchArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    char* inputFile;
+    char* outputFile;
+    int verbose;
+} StreamArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    char* bejEncodedFile;
+    char** pointers;            // JSON Pointers, printed in this order
+    int pointerCount;
+    int verbose;
+} GetArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    BatchFileList_t inputs;
+    char* indexFile;
+    int verbose;
+} IndexArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    char* indexFile;
+    char** pointers;            // JSON Pointers, printed in this order
+    int pointerCount;
+    int verbose;
+} QueryArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    BatchFileList_t inputs;
+    char* expression;
+    int verbose;
+} FilterArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    BatchFileList_t inputs;
+    char** paths;               // numeric property paths, reported in this order
+    int pathCount;
+    int threadCount;
+    int verbose;
+} AggregateArgs_t;
+
+typedef struct
+{
+    char* schemaDictionary;
+    char* annotationDictionary;
+    char* inputFile;
+    char* outputFile;
+    int verbose;
+} EncodeArgs_t;
+
+typedef struct
+{
+    char* socketPath;
+    char** dictionarySpecs;     // "<key>=<schema.bin>,<anno.bin>"
+    int dictionaryCount;
+    int threadCount;
+    int verbose;
+} ServeArgs_t;
+
 typedef enum
 {
     CMD_DECODE,
+    CMD_DECODE_BATCH,
+    CMD_STREAM,
+    CMD_SERVE,
+    CMD_GET,
+    CMD_INDEX,
+    CMD_QUERY,
+    CMD_FILTER,
+    CMD_AGGREGATE,
+    CMD_ENCODE,
     CMD_UNKNOWN
 } CommandType_t;
 
 void print_help(const char* program_name);
 CommandType_t get_command_type(const char* command);
 int validate_parse_filePath(int argc, char* argv[], int current_index, const char* option_name);
+int parse_output_format(const char* name, BejOutputFormat_t* format);
+void init_cli_diagnostics(BejDiagnostics_t* diagnostics, BejDiagLevel_t level);
+int parse_thread_count(int argc, char* argv[], int current_index, int* count);
 int parse_decode_args(int argc, char* argv[], DecodeArgs_t* args);
 void BEJ_decode(DecodeArgs_t* args);
+void BEJ_decode_single(DecodeArgs_t* args, const char* input_filename);
+void BEJ_decode_ndjson(DecodeArgs_t* args);
+int parse_batch_args(int argc, char* argv[], BatchArgs_t* args);
+int BEJ_decode_batch(BatchArgs_t* args);
+int parse_stream_args(int argc, char* argv[], StreamArgs_t* args);
+int BEJ_decode_stream(StreamArgs_t* args);
+int parse_serve_args(int argc, char* argv[], ServeArgs_t* args);
+int BEJ_serve(ServeArgs_t* args);
+int parse_get_args(int argc, char* argv[], GetArgs_t* args);
+int BEJ_get(GetArgs_t* args);
+int print_value(DecoderContext_t* ctx, const BejValue_t* value);
+int parse_index_args(int argc, char* argv[], IndexArgs_t* args);
+int BEJ_index(IndexArgs_t* args);
+int parse_query_args(int argc, char* argv[], QueryArgs_t* args);
+int BEJ_query(QueryArgs_t* args);
+int parse_filter_args(int argc, char* argv[], FilterArgs_t* args);
+int BEJ_filter(FilterArgs_t* args);
+int parse_aggregate_args(int argc, char* argv[], AggregateArgs_t* args);
+int BEJ_aggregate(AggregateArgs_t* args);
+int parse_encode_args(int argc, char* argv[], EncodeArgs_t* args);
+int BEJ_encode(EncodeArgs_t* args);
 
 int main(int argc, char* argv[])
 {
@@ -58,12 +201,136 @@ int main(int argc, char* argv[])
             DecodeArgs_t args;
             if (!parse_decode_args(argc, argv, &args))
             {
+                free(args.bejEncodedFiles);
                 printf("\n");
                 return 1;
             }
             BEJ_decode(&args);
+            free(args.bejEncodedFiles);
             break;
         }
+
+        case CMD_DECODE_BATCH:
+        {
+            BatchArgs_t args;
+            if (!parse_batch_args(argc, argv, &args))
+            {
+                free_file_list(&args.inputs);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_decode_batch(&args);
+            free_file_list(&args.inputs);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_STREAM:
+        {
+            StreamArgs_t args;
+            if (!parse_stream_args(argc, argv, &args))
+            {
+                printf("\n");
+                return 1;
+            }
+            return BEJ_decode_stream(&args) ? 0 : 1;
+        }
+
+        case CMD_SERVE:
+        {
+            ServeArgs_t args;
+            if (!parse_serve_args(argc, argv, &args))
+            {
+                free(args.dictionarySpecs);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_serve(&args);
+            free(args.dictionarySpecs);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_GET:
+        {
+            GetArgs_t args;
+            if (!parse_get_args(argc, argv, &args))
+            {
+                free(args.pointers);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_get(&args);
+            free(args.pointers);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_INDEX:
+        {
+            IndexArgs_t args;
+            if (!parse_index_args(argc, argv, &args))
+            {
+                free_file_list(&args.inputs);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_index(&args);
+            free_file_list(&args.inputs);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_QUERY:
+        {
+            QueryArgs_t args;
+            if (!parse_query_args(argc, argv, &args))
+            {
+                free(args.pointers);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_query(&args);
+            free(args.pointers);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_FILTER:
+        {
+            FilterArgs_t args;
+            if (!parse_filter_args(argc, argv, &args))
+            {
+                free_file_list(&args.inputs);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_filter(&args);
+            free_file_list(&args.inputs);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_AGGREGATE:
+        {
+            AggregateArgs_t args;
+            if (!parse_aggregate_args(argc, argv, &args))
+            {
+                free_file_list(&args.inputs);
+                free(args.paths);
+                printf("\n");
+                return 1;
+            }
+            int ok = BEJ_aggregate(&args);
+            free_file_list(&args.inputs);
+            free(args.paths);
+            return ok ? 0 : 1;
+        }
+
+        case CMD_ENCODE:
+        {
+            EncodeArgs_t args;
+            if (!parse_encode_args(argc, argv, &args))
+            {
+                printf("\n");
+                return 1;
+            }
+            return BEJ_encode(&args) ? 0 : 1;
+        }
         
         default:
             fprintf(stderr, "Error: Unknown command\n");
@@ -77,15 +344,118 @@ void print_help(const char* program_name)
 {
     printf("USAGE:\n"
            "%s <command> [options] <filename> [options] <filename> [options] <filename>\n\n"
-           "COMMANDS:\n"
-           "  <decode>\n"
-           "    OPTIONS:\n"
-           "      -s <file>     Schema dictionary file\n"
-           "      -a <file>     Annotation dictionary file\n"
-           "      -b <file>     BEJ encoded file for decoding\n"
-           "    OPTIONAL ARGUMENTS:\n"
-           "      -v            Verbose\n", 
+           "COMMANDS:\n",
            program_name);
+    fputs("  <decode>\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -b <file>     BEJ encoded file for decoding (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -f <format>   Output format: json (default), cbor, msgpack\n"
+          "      --ndjson <file>  Write all inputs to <file>, one compact JSON document per line\n"
+          "      -j <count>    Decode large SETs/ARRAYs within a document on <count> threads\n"
+          "      --streaming   Decode in chunks; memory grows with nesting depth, not file size\n"
+          "      --max-value <bytes>  With --streaming, fail on leaf values larger than <bytes>\n"
+          "      --stats       Print allocations, peak memory, depth and largest value per file\n"
+          "      --select <list>  Keep only these properties, e.g. Id,Status/Health (Redfish $select)\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <decode-batch>\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -i <path>     Input directory or glob pattern, e.g. \"archive/*.bin\" (repeatable)\n"
+          "      -l <file>     List file with one input path per line (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -j <count>    Worker threads (default: number of CPUs)\n"
+          "      -o <dir>      Output directory (default: next to each input)\n"
+          "      -f <format>   Output format: json (default), cbor, msgpack\n"
+          "      --ndjson <file>  Write all records to <file>, one compact JSON document per line\n"
+          "      --io <backend>   File I/O: auto (default), uring (Linux io_uring) or pread\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <stream>\n"
+          "    Decodes length-framed records (4-byte little-endian length, then the BEJ\n"
+          "    document) to NDJSON, with reading, decoding and writing on separate threads\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -i <file>     Framed input (default: stdin)\n"
+          "      -o <file>     NDJSON output (default: stdout)\n"
+          "      -v            Print a throughput summary to stderr\n", stdout);
+    fputs("  <serve>\n"
+          "    Runs a decode daemon on a Unix domain socket (Linux). Requests name a\n"
+          "    dictionary pair by key; see server.h for the wire protocol\n"
+          "    OPTIONS:\n"
+          "      --socket <path>  Socket to listen on\n"
+          "      -d <key>=<schema.bin>,<anno.bin>  Dictionary pair served under <key> (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -j <count>    Decode worker threads (default: number of CPUs)\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <get>\n"
+          "    Prints the values at JSON Pointers as compact JSON, one per line, reading\n"
+          "    only the tuples on the way to each value\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -b <file>     BEJ encoded file\n"
+          "      -p <pointer>  JSON Pointer, e.g. /Status/Health (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <index>\n"
+          "    Writes a sidecar file with the offset, format and length of every property\n"
+          "    of every input, for use by <query>\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -o <file>     Sidecar file to write\n"
+          "      -b <file>     BEJ encoded file (repeatable)\n"
+          "      -i <path>     Input directory or glob pattern (repeatable)\n"
+          "      -l <file>     List file with one input path per line (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <query>\n"
+          "    Prints one line per indexed file: its name, then each value as compact JSON,\n"
+          "    tab-separated (empty where the file lacks the property)\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file the index was built with\n"
+          "      -a <file>     Annotation dictionary file the index was built with\n"
+          "      -x <file>     Sidecar file from <index>\n"
+          "      -p <pointer>  JSON Pointer, e.g. /Status/Health (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -v            Verbose\n", stdout);
+    fputs("  <filter>\n"
+          "    Prints the inputs that satisfy a predicate, evaluated without decoding them\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -w <expr>     Predicate, e.g. 'Status/Health != \"OK\" or CapacityMiB < 8192'\n"
+          "      -b <file>     BEJ encoded file (repeatable)\n"
+          "      -i <path>     Input directory or glob pattern (repeatable)\n"
+          "      -l <file>     List file with one input path per line (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -v            Print a match count to stderr\n", stdout);
+    fputs("  <aggregate>\n"
+          "    Prints count, missing, min, max, mean, sum, p50, p90 and p99 of numeric properties\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -p <path>     Integer or real property (or array of them), e.g. PowerConsumedWatts (repeatable)\n"
+          "      -b <file>     BEJ encoded file (repeatable)\n"
+          "      -i <path>     Input directory or glob pattern (repeatable)\n"
+          "      -l <file>     List file with one input path per line (repeatable)\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -j <count>    Worker threads (default: number of CPUs)\n"
+          "      -v            Print file counts and throughput to stderr\n", stdout);
+    fputs("  <encode>\n"
+          "    Encodes a JSON document as BEJ, the reverse of <decode>\n"
+          "    OPTIONS:\n"
+          "      -s <file>     Schema dictionary file\n"
+          "      -a <file>     Annotation dictionary file\n"
+          "      -i <file>     JSON input\n"
+          "    OPTIONAL ARGUMENTS:\n"
+          "      -o <file>     BEJ output (default: stdout)\n"
+          "      -v            Print the encoded size to stderr\n", stdout);
 }
 
 CommandType_t get_command_type(const char* command) 
@@ -94,6 +464,42 @@ CommandType_t get_command_type(const char* command)
     {
         return CMD_DECODE;
     }
+    if (strcmp(command, "decode-batch") == 0) 
+    {
+        return CMD_DECODE_BATCH;
+    }
+    if (strcmp(command, "stream") == 0) 
+    {
+        return CMD_STREAM;
+    }
+    if (strcmp(command, "serve") == 0) 
+    {
+        return CMD_SERVE;
+    }
+    if (strcmp(command, "get") == 0) 
+    {
+        return CMD_GET;
+    }
+    if (strcmp(command, "index") == 0) 
+    {
+        return CMD_INDEX;
+    }
+    if (strcmp(command, "query") == 0) 
+    {
+        return CMD_QUERY;
+    }
+    if (strcmp(command, "filter") == 0) 
+    {
+        return CMD_FILTER;
+    }
+    if (strcmp(command, "aggregate") == 0) 
+    {
+        return CMD_AGGREGATE;
+    }
+    if (strcmp(command, "encode") == 0) 
+    {
+        return CMD_ENCODE;
+    }
     return CMD_UNKNOWN;
 }
 
@@ -114,12 +520,70 @@ int validate_parse_filePath(int argc, char* argv[], int current_index, const cha
     return 1;
 }
 
+int parse_output_format(const char* name, BejOutputFormat_t* format)
+{
+    if (strcmp(name, "json") == 0) 
+    {
+        *format = BEJ_OUTPUT_JSON;
+    }
+    else if (strcmp(name, "cbor") == 0) 
+    {
+        *format = BEJ_OUTPUT_CBOR;
+    }
+    else if (strcmp(name, "msgpack") == 0) 
+    {
+        *format = BEJ_OUTPUT_MSGPACK;
+    }
+    else 
+    {
+        fprintf(stderr, "Error: Unknown output format '%s' (expected json, cbor or msgpack)\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+void init_cli_diagnostics(BejDiagnostics_t* diagnostics, BejDiagLevel_t level)
+{
+    // The library stays silent unless asked; the CLI reports on stderr
+    init_diagnostics(diagnostics);
+    diagnostics->callback = bej_diagnostics_stderr;
+    diagnostics->level = level;
+}
+
+int parse_thread_count(int argc, char* argv[], int current_index, int* count)
+{
+    char* end = NULL;
+    long value = (current_index + 1 < argc) ? strtol(argv[current_index + 1], &end, 10) : 0;
+    if (value < 1 || value > 1024 || !end || *end != '\0') 
+    {
+        fprintf(stderr, "Error: %s requires a thread count between 1 and 1024\n", argv[current_index]);
+        return 0;
+    }
+    *count = (int)value;
+    return 1;
+}
+
 int parse_decode_args(int argc, char* argv[], DecodeArgs_t* args) 
 {
+    // Every -b argument can be kept, since there are never more than argc of them
     args->schemaDictionary = NULL;
     args->annotationDictionary = NULL;
-    args->bejEncodedFile = NULL;
+    args->bejEncodedFiles = (char**)calloc((size_t)argc, sizeof(char*));
+    args->bejEncodedCount = 0;
+    args->ndjsonOutput = NULL;
+    args->outputFormat = BEJ_OUTPUT_JSON;
+    args->threadCount = 0;
+    args->streaming = 0;
+    args->maxValueLength = 0;
+    args->stats = 0;
+    args->select = NULL;
     args->verbose = 0;
+
+    if (args->bejEncodedFiles == NULL) 
+    {
+        fprintf(stderr, "Error: Failed to allocate argument list\n");
+        return 0;
+    }
     
     for (int i = 2; i < argc; i++) 
     {
@@ -141,9 +605,62 @@ int parse_decode_args(int argc, char* argv[], DecodeArgs_t* args)
         {
             if(!validate_parse_filePath(argc, argv, i, "-b"))
                 return 0;
-            args->bejEncodedFile = argv[i + 1];
+            args->bejEncodedFiles[args->bejEncodedCount++] = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--format") == 0)
+        {
+            if (i + 1 >= argc) 
+            {
+                fprintf(stderr, "Error: %s requires a format name\n", argv[i]);
+                return 0;
+            }
+            if (!parse_output_format(argv[i + 1], &args->outputFormat))
+                return 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "--ndjson") == 0)
+        {
+            if(!validate_parse_filePath(argc, argv, i, "--ndjson"))
+                return 0;
+            args->ndjsonOutput = argv[i + 1];
             i++;
         }
+        else if (strcmp(argv[i], "-j") == 0) 
+        {
+            if (!parse_thread_count(argc, argv, i, &args->threadCount))
+                return 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "--streaming") == 0)
+        {
+            args->streaming = 1;
+        }
+        else if (strcmp(argv[i], "--max-value") == 0)
+        {
+            char* end = NULL;
+            unsigned long long value = (i + 1 < argc) ? strtoull(argv[i + 1], &end, 10) : 0;
+            if (value < 1 || !end || *end != '\0') 
+            {
+                fprintf(stderr, "Error: --max-value requires a positive byte count\n");
+                return 0;
+            }
+            args->maxValueLength = (uint64_t)value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            args->stats = 1;
+        }
+        else if (strcmp(argv[i], "--select") == 0)
+        {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0') 
+            {
+                fprintf(stderr, "Error: --select requires a property list\n");
+                return 0;
+            }
+            args->select = argv[++i];
+        }
         else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
         {
             args->verbose = 1;
@@ -165,11 +682,32 @@ int parse_decode_args(int argc, char* argv[], DecodeArgs_t* args)
         fprintf(stderr, "Error: decode requires -a (annotation dictionary)\n");
         return 0;
     }
-    if (args->bejEncodedFile == NULL) 
+    if (args->bejEncodedCount == 0) 
     {
         fprintf(stderr, "Error: decode requires -b (BEJ encoded file)\n");
         return 0;
     }
+    if (args->streaming && (args->threadCount > 0 || args->ndjsonOutput != NULL)) 
+    {
+        fprintf(stderr, "Error: --streaming cannot be combined with -j or --ndjson\n");
+        return 0;
+    }
+    if ((args->stats || args->select) && args->ndjsonOutput != NULL) 
+    {
+        fprintf(stderr, "Error: --stats and --select cannot be combined with --ndjson\n");
+        return 0;
+    }
+    if (args->select && args->streaming) 
+    {
+        fprintf(stderr, "Error: --select cannot be combined with --streaming\n");
+        return 0;
+    }
+    if (args->ndjsonOutput != NULL && args->outputFormat != BEJ_OUTPUT_JSON) 
+    {
+        fprintf(stderr, "Error: --ndjson cannot be combined with -f %s\n",
+                args->outputFormat == BEJ_OUTPUT_CBOR ? "cbor" : "msgpack");
+        return 0;
+    }
 
     return 1;
 }
@@ -181,32 +719,78 @@ void BEJ_decode(DecodeArgs_t* args)
         printf("=== BEJ Decoder Starting ===\n");
         printf("Schema Dictionary: %s\n", args->schemaDictionary);
         printf("Annotation Dictionary: %s\n", args->annotationDictionary);
-        printf("BEJ Encoded File: %s\n", args->bejEncodedFile);
+        for (int i = 0; i < args->bejEncodedCount; i++) 
+        {
+            printf("BEJ Encoded File: %s\n", args->bejEncodedFiles[i]);
+        }
     }
-    
-    // Create output filename by replacing extension with .json
+
+    if (args->ndjsonOutput) 
+    {
+        BEJ_decode_ndjson(args);
+        return;
+    }
+
+    for (int i = 0; i < args->bejEncodedCount; i++) 
+    {
+        BEJ_decode_single(args, args->bejEncodedFiles[i]);
+    }
+}
+
+void BEJ_decode_ndjson(DecodeArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    // Dictionaries are loaded once for the whole batch
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    if (!schema_dict || !anno_dict) 
+    {
+        fprintf(stderr, "Error: Failed to load dictionaries\n");
+        free_dictionary(schema_dict);
+        return;
+    }
+
+    FILE* output = fopen(args->ndjsonOutput, "w");
+    if (!output) 
+    {
+        fprintf(stderr, "Error: Cannot create output file %s\n", args->ndjsonOutput);
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return;
+    }
+
+    size_t decoded = 0;
+    bool all_ok = bej_decode_files_ndjson((const char* const*)args->bejEncodedFiles,
+                                          (size_t)args->bejEncodedCount, output,
+                                          schema_dict, anno_dict, &decoded, &diagnostics);
+    fclose(output);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+
+    if (!all_ok) 
+    {
+        fprintf(stderr, "Decoding failed for %zu of %d files\n",
+                (size_t)args->bejEncodedCount - decoded, args->bejEncodedCount);
+    }
+    if (args->verbose) 
+    {
+        printf("Wrote %zu records to %s\n", decoded, args->ndjsonOutput);
+        printf("=== Decoding Complete ===\n");
+    }
+}
+
+void BEJ_decode_single(DecodeArgs_t* args, const char* input_filename)
+{
+    // Create output filename by replacing extension with one matching the output format
     char output_filename[512];
-    const char* input_filename = args->bejEncodedFile;
-    
-    // Find the last dot in the filename
-    const char* last_dot = strrchr(input_filename, '.');
-    const char* last_slash = strrchr(input_filename, '/');
-    const char* last_backslash = strrchr(input_filename, '\\');
-    
-    // Determine which path separator came last
-    const char* last_separator = last_slash > last_backslash ? last_slash : last_backslash;
-    
-    // Only use the dot if it comes after the last path separator (i.e., it's part of the filename, not directory)
-    if (last_dot && (!last_separator || last_dot > last_separator)) {
-        size_t base_len = last_dot - input_filename;
-        if (base_len >= sizeof(output_filename) - 6) {
-            base_len = sizeof(output_filename) - 6;
-        }
-        memcpy(output_filename, input_filename, base_len);
-        strcpy(output_filename + base_len, ".json");
-    } else {
-        // No extension found, just append .json
-        snprintf(output_filename, sizeof(output_filename), "%s.json", input_filename);
+    if (!make_output_path(input_filename, NULL, args->outputFormat,
+                          output_filename, sizeof(output_filename)))
+    {
+        fprintf(stderr, "Error: Output path for %s is too long\n", input_filename);
+        return;
     }
     
     if (args->verbose) 
@@ -216,8 +800,30 @@ void BEJ_decode(DecodeArgs_t* args)
     }
     
     // Call the decode function from decode module
-    if (!bej_decode_file(args->bejEncodedFile, output_filename,
-                         args->schemaDictionary, args->annotationDictionary))
+    BejDecodeOptions_t options;
+    init_decode_options(&options);
+    options.format = args->outputFormat;
+    options.threads = args->threadCount;
+    options.streaming = args->streaming != 0;
+    options.max_value_length = args->maxValueLength;
+    init_cli_diagnostics(&options.diagnostics, args->verbose ? BEJ_DIAG_TRACE : BEJ_DIAG_WARNING);
+    BejDecodeStats_t stats = {0};
+    options.stats = args->stats ? &stats : NULL;
+    options.select = args->select;
+
+    bool ok = bej_decode_file_with_options(input_filename, output_filename,
+                                           args->schemaDictionary, args->annotationDictionary,
+                                           &options);
+    if (args->stats) 
+    {
+        fprintf(stderr, "%s: %llu allocations, %llu bytes allocated, %llu bytes peak, depth %u, "
+                "largest value %llu bytes\n", input_filename,
+                (unsigned long long)stats.allocations, (unsigned long long)stats.bytes_allocated,
+                (unsigned long long)stats.peak_live_bytes, stats.max_depth,
+                (unsigned long long)stats.largest_value);
+    }
+
+    if (!ok)
     {
         fprintf(stderr, "Decoding failed\n");
     } 
@@ -228,4 +834,1213 @@ void BEJ_decode(DecodeArgs_t* args)
             printf("=== Decoding Complete ===\n");
         }
     }
-}
\ No newline at end of file
+}
+
+int parse_batch_args(int argc, char* argv[], BatchArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    init_file_list(&args->inputs);
+    args->outputDirectory = NULL;
+    args->ndjsonOutput = NULL;
+    args->outputFormat = BEJ_OUTPUT_JSON;
+    args->ioBackend = BATCH_IO_AUTO;
+    args->threadCount = default_thread_count();
+    args->verbose = 0;
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            if (!collect_batch_inputs(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-l") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-l"))
+                return 0;
+            if (!read_batch_list_file(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-o") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-o"))
+                return 0;
+            args->outputDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], "--ndjson") == 0)
+        {
+            if(!validate_parse_filePath(argc, argv, i, "--ndjson"))
+                return 0;
+            args->ndjsonOutput = argv[++i];
+        }
+        else if (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--format") == 0)
+        {
+            if (i + 1 >= argc) 
+            {
+                fprintf(stderr, "Error: %s requires a format name\n", argv[i]);
+                return 0;
+            }
+            if (!parse_output_format(argv[++i], &args->outputFormat))
+                return 0;
+        }
+        else if (strcmp(argv[i], "--io") == 0)
+        {
+            const char* backend = (i + 1 < argc) ? argv[++i] : "";
+            if (strcmp(backend, "auto") == 0) 
+            {
+                args->ioBackend = BATCH_IO_AUTO;
+            }
+            else if (strcmp(backend, "uring") == 0) 
+            {
+                args->ioBackend = BATCH_IO_URING;
+            }
+            else if (strcmp(backend, "pread") == 0) 
+            {
+                args->ioBackend = BATCH_IO_PREAD;
+            }
+            else 
+            {
+                fprintf(stderr, "Error: --io requires auto, uring or pread\n");
+                return 0;
+            }
+        }
+        else if (strcmp(argv[i], "-j") == 0) 
+        {
+            if (!parse_thread_count(argc, argv, i, &args->threadCount))
+                return 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <decode-batch> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL) 
+    {
+        fprintf(stderr, "Error: decode-batch requires -s (schema dictionary)\n");
+        return 0;
+    }
+    if (args->annotationDictionary == NULL) 
+    {
+        fprintf(stderr, "Error: decode-batch requires -a (annotation dictionary)\n");
+        return 0;
+    }
+    if (args->inputs.count == 0) 
+    {
+        fprintf(stderr, "Error: decode-batch requires -i or -l with at least one input file\n");
+        return 0;
+    }
+    if (args->ndjsonOutput != NULL && args->outputFormat != BEJ_OUTPUT_JSON) 
+    {
+        fprintf(stderr, "Error: --ndjson cannot be combined with -f %s\n",
+                args->outputFormat == BEJ_OUTPUT_CBOR ? "cbor" : "msgpack");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_decode_batch(BatchArgs_t* args)
+{
+    if (args->verbose) 
+    {
+        printf("=== BEJ Batch Decoder Starting ===\n");
+        printf("Schema Dictionary: %s\n", args->schemaDictionary);
+        printf("Annotation Dictionary: %s\n", args->annotationDictionary);
+        printf("Input files: %zu, worker threads: %d\n", args->inputs.count, args->threadCount);
+    }
+
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    // Dictionaries are loaded once and shared read-only by every worker
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    if (!schema_dict || !anno_dict) 
+    {
+        fprintf(stderr, "Error: Failed to load dictionaries\n");
+        free_dictionary(schema_dict);
+        return 0;
+    }
+
+    FILE* ndjson = NULL;
+    if (args->ndjsonOutput) 
+    {
+        ndjson = fopen(args->ndjsonOutput, "w");
+        if (!ndjson) 
+        {
+            fprintf(stderr, "Error: Cannot create output file %s\n", args->ndjsonOutput);
+            free_dictionary(schema_dict);
+            free_dictionary(anno_dict);
+            return 0;
+        }
+    }
+
+    BatchOptions_t options;
+    options.schema_dict = schema_dict;
+    options.anno_dict = anno_dict;
+    options.output_format = args->outputFormat;
+    options.output_dir = args->outputDirectory;
+    options.ndjson_output = ndjson;
+    options.thread_count = args->threadCount;
+    options.diagnostics = diagnostics;
+    options.io_backend = args->ioBackend;
+    options.queue_depth = 0;
+
+    BatchStats_t stats;
+    bool all_ok = bej_decode_batch(&args->inputs, &options, &stats);
+
+    if (ndjson && fclose(ndjson) != 0) 
+    {
+        fprintf(stderr, "Error: Failed to write %s\n", args->ndjsonOutput);
+        all_ok = false;
+    }
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+
+    double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    printf("Decoded %zu of %zu files (%zu failed) in %.3f s: %.1f files/s, %.2f MB/s in, %.2f MB/s out\n",
+           stats.files_ok, stats.files_total, stats.files_failed, stats.seconds,
+           (double)stats.files_ok / seconds,
+           (double)stats.bytes_in / 1e6 / seconds,
+           (double)stats.bytes_out / 1e6 / seconds);
+    return all_ok;
+}
+
+int parse_stream_args(int argc, char* argv[], StreamArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    args->inputFile = NULL;
+    args->outputFile = NULL;
+    args->verbose = 0;
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            args->inputFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-o"))
+                return 0;
+            args->outputFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <stream> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL) 
+    {
+        fprintf(stderr, "Error: stream requires -s (schema dictionary)\n");
+        return 0;
+    }
+    if (args->annotationDictionary == NULL) 
+    {
+        fprintf(stderr, "Error: stream requires -a (annotation dictionary)\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_decode_stream(StreamArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    if (!schema_dict || !anno_dict) 
+    {
+        fprintf(stderr, "Error: Failed to load dictionaries\n");
+        free_dictionary(schema_dict);
+        return 0;
+    }
+
+#ifdef _WIN32
+    // Framed records are binary; keep the C runtime from translating bytes
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+    FILE* input = args->inputFile ? fopen(args->inputFile, "rb") : stdin;
+    FILE* output = args->outputFile ? fopen(args->outputFile, "w") : stdout;
+    if (!input || !output) 
+    {
+        fprintf(stderr, "Error: Cannot open %s\n", !input ? args->inputFile : args->outputFile);
+        if (input && input != stdin) fclose(input);
+        if (output && output != stdout) fclose(output);
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return 0;
+    }
+
+    PipelineOptions_t options;
+    memset(&options, 0, sizeof(options));
+    options.schema_dict = schema_dict;
+    options.anno_dict = anno_dict;
+    options.input = input;
+    options.output = output;
+    options.diagnostics = diagnostics;
+
+    PipelineStats_t stats;
+    bool all_ok = bej_decode_stream_pipeline(&options, &stats);
+
+    if (input != stdin) 
+    {
+        fclose(input);
+    }
+    if (output != stdout && fclose(output) != 0) 
+    {
+        fprintf(stderr, "Error: Failed to write %s\n", args->outputFile);
+        all_ok = false;
+    }
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+
+    // stdout may be carrying the records, so the summary goes to stderr
+    if (args->verbose || !all_ok) 
+    {
+        double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+        fprintf(stderr, "Decoded %llu of %llu records (%llu failed) in %.3f s: %.1f records/s, %.2f MB/s in, %.2f MB/s out\n",
+                (unsigned long long)stats.records_out, (unsigned long long)stats.records_in,
+                (unsigned long long)stats.records_failed, stats.seconds,
+                (double)stats.records_out / seconds,
+                (double)stats.bytes_in / 1e6 / seconds,
+                (double)stats.bytes_out / 1e6 / seconds);
+    }
+    return all_ok;
+}
+
+int parse_serve_args(int argc, char* argv[], ServeArgs_t* args)
+{
+    args->socketPath = NULL;
+    args->dictionarySpecs = (char**)malloc((size_t)argc * sizeof(char*));
+    args->dictionaryCount = 0;
+    args->threadCount = 0;
+    args->verbose = 0;
+    if (!args->dictionarySpecs) 
+    {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 0;
+    }
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "--socket") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "--socket"))
+                return 0;
+            args->socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-d") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-d"))
+                return 0;
+            char* spec = argv[++i];
+            char* equals = strchr(spec, '=');
+            char* comma = equals ? strchr(equals, ',') : NULL;
+            if (!equals || !comma || equals == spec || equals - spec > 255 || comma == equals + 1 || comma[1] == '\0') 
+            {
+                fprintf(stderr, "Error: -d expects <key>=<schema.bin>,<anno.bin>, got '%s'\n", spec);
+                return 0;
+            }
+            args->dictionarySpecs[args->dictionaryCount++] = spec;
+        }
+        else if (strcmp(argv[i], "-j") == 0) 
+        {
+            if (!parse_thread_count(argc, argv, i, &args->threadCount))
+                return 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <serve> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->socketPath == NULL) 
+    {
+        fprintf(stderr, "Error: serve requires --socket <path>\n");
+        return 0;
+    }
+    if (args->dictionaryCount == 0) 
+    {
+        fprintf(stderr, "Error: serve requires at least one -d <key>=<schema.bin>,<anno.bin>\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+static BejServer_t* g_running_server = NULL;
+
+static void stop_server_on_signal(int signal_number)
+{
+    (void)signal_number;
+    server_stop(g_running_server);
+}
+
+int BEJ_serve(ServeArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    ServerDictionary_t* dictionaries = (ServerDictionary_t*)calloc((size_t)args->dictionaryCount, sizeof(ServerDictionary_t));
+    if (!dictionaries) 
+    {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 0;
+    }
+
+    // Split each "<key>=<schema>,<anno>" spec in place
+    bool loaded = true;
+    int count = 0;
+    for (; count < args->dictionaryCount && loaded; count++) 
+    {
+        char* spec = args->dictionarySpecs[count];
+        char* schema_path = strchr(spec, '=');
+        *schema_path++ = '\0';
+        char* anno_path = strchr(schema_path, ',');
+        *anno_path++ = '\0';
+
+        dictionaries[count].key = spec;
+        dictionaries[count].schema_dict = load_dictionary_with_diagnostics(schema_path, &diagnostics);
+        dictionaries[count].anno_dict = dictionaries[count].schema_dict 
+            ? load_dictionary_with_diagnostics(anno_path, &diagnostics) : NULL;
+        if (!dictionaries[count].schema_dict || !dictionaries[count].anno_dict) 
+        {
+            fprintf(stderr, "Error: Failed to load dictionaries for key '%s'\n", spec);
+            loaded = false;
+        }
+    }
+
+    BejServer_t* server = NULL;
+    if (loaded) 
+    {
+        ServerOptions_t options;
+        memset(&options, 0, sizeof(options));
+        options.socket_path = args->socketPath;
+        options.dictionaries = dictionaries;
+        options.dictionary_count = (size_t)args->dictionaryCount;
+        options.thread_count = args->threadCount;
+        options.diagnostics = diagnostics;
+        server = server_create(&options);
+    }
+
+    bool ok = server != NULL;
+    if (ok) 
+    {
+        g_running_server = server;
+        signal(SIGINT, stop_server_on_signal);
+        signal(SIGTERM, stop_server_on_signal);
+        bej_diagnose(&diagnostics, BEJ_DIAG_INFO, "Serving %d dictionary pair(s) on %s",
+                     args->dictionaryCount, args->socketPath);
+
+        ok = server_run(server);
+
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        g_running_server = NULL;
+        server_destroy(server);
+    }
+
+    for (int i = 0; i < count; i++) 
+    {
+        free_dictionary(dictionaries[i].schema_dict);
+        free_dictionary(dictionaries[i].anno_dict);
+    }
+    free(dictionaries);
+    return ok;
+}
+
+int parse_get_args(int argc, char* argv[], GetArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    args->bejEncodedFile = NULL;
+    args->pointers = (char**)malloc(sizeof(char*) * (size_t)argc);
+    args->pointerCount = 0;
+    args->verbose = 0;
+    if (!args->pointers) 
+    {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 0;
+    }
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-b"))
+                return 0;
+            args->bejEncodedFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0) 
+        {
+            // "" is a valid pointer (the whole resource), so only presence is checked
+            if (i + 1 >= argc) 
+            {
+                fprintf(stderr, "Error: -p requires a JSON Pointer\n");
+                return 0;
+            }
+            args->pointers[args->pointerCount++] = argv[++i];
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <get> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->bejEncodedFile == NULL) 
+    {
+        fprintf(stderr, "Error: get requires -s, -a and -b\n");
+        return 0;
+    }
+    if (args->pointerCount == 0) 
+    {
+        fprintf(stderr, "Error: get requires at least one -p <pointer>\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_get(GetArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    uint8_t* data = NULL;
+    size_t capacity = 0;
+    uint64_t size = 0;
+    bool ok = schema_dict && anno_dict 
+              && read_file_into_buffer(args->bejEncodedFile, &data, &capacity, &size, &diagnostics);
+
+    // Values are rendered by the regular writers, straight from the input buffer
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, schema_dict, anno_dict, NULL, stdout);
+    ctx.compact = true;
+    ctx.diagnostics = diagnostics;
+
+    for (int i = 0; ok && i < args->pointerCount; i++) 
+    {
+        BejValue_t value;
+        ok = bej_get(data, size, schema_dict, anno_dict, args->pointers[i], &value, &diagnostics)
+             && print_value(&ctx, &value);
+        putchar('\n');
+    }
+
+    free(data);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return ok;
+}
+
+int print_value(DecoderContext_t* ctx, const BejValue_t* value)
+{
+    // Values are rendered by the regular writers, straight from the buffer they point into
+    SFLV_t sflv = {0, value->dict_selector, value->format, value->length, (uint8_t*)value->data};
+    return decode_value(ctx, &sflv, (DictionaryEntry_t*)value->entry) && !ctx->output_failed;
+}
+
+int parse_index_args(int argc, char* argv[], IndexArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    init_file_list(&args->inputs);
+    args->indexFile = NULL;
+    args->verbose = 0;
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-o"))
+                return 0;
+            args->indexFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-b"))
+                return 0;
+            if (!file_list_add(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            if (!collect_batch_inputs(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-l") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-l"))
+                return 0;
+            if (!read_batch_list_file(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <index> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->indexFile == NULL) 
+    {
+        fprintf(stderr, "Error: index requires -s, -a and -o\n");
+        return 0;
+    }
+    if (args->inputs.count == 0) 
+    {
+        fprintf(stderr, "Error: index requires at least one input (-b, -i or -l)\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_index(IndexArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    BejIndexBuilder_t* builder = anno_dict ? bej_index_builder_create(schema_dict, anno_dict, &diagnostics) : NULL;
+    if (!builder) 
+    {
+        fprintf(stderr, "Error: Failed to load dictionaries\n");
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return 0;
+    }
+
+    // Inputs that cannot be read or indexed are reported and left out
+    uint8_t* data = NULL;
+    size_t capacity = 0;
+    size_t indexed = 0;
+    for (size_t i = 0; i < args->inputs.count; i++) 
+    {
+        uint64_t size = 0;
+        const char* path = args->inputs.paths[i];
+        if (read_file_into_buffer(path, &data, &capacity, &size, &diagnostics) 
+            && bej_index_add(builder, path, data, size)) 
+        {
+            indexed++;
+        }
+    }
+
+    bool ok = bej_index_write(builder, args->indexFile);
+    if (args->verbose || indexed < args->inputs.count) 
+    {
+        fprintf(stderr, "Indexed %zu of %zu files into %s\n", indexed, args->inputs.count, args->indexFile);
+    }
+
+    free(data);
+    bej_index_builder_free(builder);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return ok && indexed == args->inputs.count;
+}
+
+int parse_query_args(int argc, char* argv[], QueryArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    args->indexFile = NULL;
+    args->pointers = (char**)malloc(sizeof(char*) * (size_t)argc);
+    args->pointerCount = 0;
+    args->verbose = 0;
+    if (!args->pointers) 
+    {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 0;
+    }
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-x") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-x"))
+                return 0;
+            args->indexFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0) 
+        {
+            if (i + 1 >= argc) 
+            {
+                fprintf(stderr, "Error: -p requires a JSON Pointer\n");
+                return 0;
+            }
+            args->pointers[args->pointerCount++] = argv[++i];
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <query> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->indexFile == NULL) 
+    {
+        fprintf(stderr, "Error: query requires -s, -a and -x\n");
+        return 0;
+    }
+    if (args->pointerCount == 0) 
+    {
+        fprintf(stderr, "Error: query requires at least one -p <pointer>\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_query(QueryArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    BejIndex_t* index = anno_dict ? bej_index_open(args->indexFile, &diagnostics) : NULL;
+    uint32_t* paths = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)args->pointerCount);
+    bool* known = (bool*)malloc(sizeof(bool) * (size_t)args->pointerCount);
+    bool ok = index && paths && known;
+
+    // Pointers are resolved once; a pointer no file has prints as empty fields
+    for (int p = 0; ok && p < args->pointerCount; p++) 
+    {
+        known[p] = bej_index_find_path(index, args->pointers[p], &paths[p]);
+    }
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, schema_dict, anno_dict, NULL, stdout);
+    ctx.compact = true;
+    ctx.diagnostics = diagnostics;
+
+    uint8_t* buffer = NULL;
+    size_t capacity = 0;
+    uint64_t payload_count = ok ? bej_index_payload_count(index) : 0;
+    for (uint64_t i = 0; i < payload_count; i++) 
+    {
+        fputs(bej_index_payload_name(index, i), stdout);
+        for (int p = 0; p < args->pointerCount; p++) 
+        {
+            putchar('\t');
+            BejValue_t value;
+            if (known[p] && bej_index_lookup(index, i, paths[p]) 
+                && !(bej_index_read(index, i, paths[p], schema_dict, anno_dict, &buffer, &capacity, &value) 
+                     && print_value(&ctx, &value))) 
+            {
+                ok = false;
+            }
+        }
+        putchar('\n');
+    }
+
+    free(buffer);
+    free(paths);
+    free(known);
+    bej_index_close(index);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return ok;
+}
+
+int parse_filter_args(int argc, char* argv[], FilterArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    init_file_list(&args->inputs);
+    args->expression = NULL;
+    args->verbose = 0;
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-w") == 0) 
+        {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0') 
+            {
+                fprintf(stderr, "Error: -w requires an expression\n");
+                return 0;
+            }
+            args->expression = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-b"))
+                return 0;
+            if (!file_list_add(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            if (!collect_batch_inputs(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-l") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-l"))
+                return 0;
+            if (!read_batch_list_file(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <filter> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->expression == NULL) 
+    {
+        fprintf(stderr, "Error: filter requires -s, -a and -w\n");
+        return 0;
+    }
+    if (args->inputs.count == 0) 
+    {
+        fprintf(stderr, "Error: filter requires at least one input (-b, -i or -l)\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_filter(FilterArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    BejFilter_t* filter = anno_dict ? bej_filter_compile(schema_dict, anno_dict, args->expression, &diagnostics) : NULL;
+    if (!filter) 
+    {
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return 0;
+    }
+
+    // Files that cannot be read or are malformed are reported and do not match
+    uint8_t* data = NULL;
+    size_t capacity = 0;
+    size_t matches = 0;
+    size_t failures = 0;
+    for (size_t i = 0; i < args->inputs.count; i++) 
+    {
+        uint64_t size = 0;
+        bool matched = false;
+        const char* path = args->inputs.paths[i];
+        if (!read_file_into_buffer(path, &data, &capacity, &size, &diagnostics)) 
+        {
+            failures++;
+        }
+        else if (!bej_filter_match(filter, data, size, &matched)) 
+        {
+            fprintf(stderr, "Error: %s is not a valid BEJ document\n", path);
+            failures++;
+        }
+        else if (matched) 
+        {
+            puts(path);
+            matches++;
+        }
+    }
+
+    if (args->verbose) 
+    {
+        fprintf(stderr, "%zu of %zu files matched (%zu failed)\n", matches, args->inputs.count, failures);
+    }
+
+    free(data);
+    bej_filter_free(filter);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return failures == 0;
+}
+
+int parse_aggregate_args(int argc, char* argv[], AggregateArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    init_file_list(&args->inputs);
+    args->paths = (char**)malloc(sizeof(char*) * (size_t)argc);
+    args->pathCount = 0;
+    args->threadCount = default_thread_count();
+    args->verbose = 0;
+    if (!args->paths) 
+    {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 0;
+    }
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0) 
+        {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0') 
+            {
+                fprintf(stderr, "Error: -p requires a property path\n");
+                return 0;
+            }
+            args->paths[args->pathCount++] = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-b"))
+                return 0;
+            if (!file_list_add(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            if (!collect_batch_inputs(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-l") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-l"))
+                return 0;
+            if (!read_batch_list_file(&args->inputs, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(argv[i], "-j") == 0) 
+        {
+            if (!parse_thread_count(argc, argv, i, &args->threadCount))
+                return 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <aggregate> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->pathCount == 0) 
+    {
+        fprintf(stderr, "Error: aggregate requires -s, -a and at least one -p\n");
+        return 0;
+    }
+    if (args->inputs.count == 0) 
+    {
+        fprintf(stderr, "Error: aggregate requires at least one input (-b, -i or -l)\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_aggregate(AggregateArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    BejAggregate_t* aggregate = anno_dict 
+        ? bej_aggregate_compile(schema_dict, anno_dict, (const char* const*)args->paths, (size_t)args->pathCount,
+                                &diagnostics)
+        : NULL;
+    BejAccumulator_t* total = aggregate ? bej_accumulator_create(aggregate) : NULL;
+    if (!total) 
+    {
+        bej_aggregate_free(aggregate);
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return 0;
+    }
+
+    // Nothing is written per file; only the summary table below
+    BatchStats_t stats;
+    bool ok = bej_aggregate_files(aggregate, &args->inputs, args->threadCount, &diagnostics, total, &stats);
+
+    printf("path\tcount\tmissing\tmin\tmax\tmean\tsum\tp50\tp90\tp99\n");
+    for (int i = 0; i < args->pathCount; i++) 
+    {
+        BejAggregateResult_t result;
+        bej_accumulator_result(total, (size_t)i, &result);
+        printf("%s\t%llu\t%llu\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\n", args->paths[i],
+               (unsigned long long)result.count, (unsigned long long)result.missing,
+               result.min, result.max, result.mean, result.sum, result.p50, result.p90, result.p99);
+    }
+
+    if (args->verbose) 
+    {
+        double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+        fprintf(stderr, "Aggregated %zu of %zu files (%zu failed) in %.3f s: %.1f files/s, %.2f MB/s in\n",
+                stats.files_ok, stats.files_total, stats.files_failed, stats.seconds,
+                (double)stats.files_ok / seconds,
+                (double)stats.bytes_in / 1e6 / seconds);
+    }
+
+    bej_accumulator_free(total);
+    bej_aggregate_free(aggregate);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return ok;
+}
+
+int parse_encode_args(int argc, char* argv[], EncodeArgs_t* args)
+{
+    args->schemaDictionary = NULL;
+    args->annotationDictionary = NULL;
+    args->inputFile = NULL;
+    args->outputFile = NULL;
+    args->verbose = 0;
+
+    for (int i = 2; i < argc; i++) 
+    {
+        if (strcmp(argv[i], "-s") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-s"))
+                return 0;
+            args->schemaDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-a") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-a"))
+                return 0;
+            args->annotationDictionary = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-i"))
+                return 0;
+            args->inputFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0) 
+        {
+            if(!validate_parse_filePath(argc, argv, i, "-o"))
+                return 0;
+            args->outputFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+        {
+            args->verbose = 1;
+        }
+        else 
+        {
+            fprintf(stderr, "Error: Unknown option '%s' for <encode> command\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (args->schemaDictionary == NULL || args->annotationDictionary == NULL || args->inputFile == NULL) 
+    {
+        fprintf(stderr, "Error: encode requires -s, -a and -i\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int BEJ_encode(EncodeArgs_t* args)
+{
+    BejDiagnostics_t diagnostics;
+    init_cli_diagnostics(&diagnostics, args->verbose ? BEJ_DIAG_INFO : BEJ_DIAG_WARNING);
+
+    Dictionary_t* schema_dict = load_dictionary_with_diagnostics(args->schemaDictionary, &diagnostics);
+    Dictionary_t* anno_dict = schema_dict 
+        ? load_dictionary_with_diagnostics(args->annotationDictionary, &diagnostics) : NULL;
+    BejEncoder_t* encoder = anno_dict ? bej_encoder_create(schema_dict, anno_dict, &diagnostics) : NULL;
+    if (!encoder) 
+    {
+        free_dictionary(schema_dict);
+        free_dictionary(anno_dict);
+        return 0;
+    }
+
+    uint8_t* json = NULL;
+    size_t json_capacity = 0;
+    uint64_t json_size = 0;
+    uint8_t* bej = NULL;
+    size_t bej_capacity = 0;
+    size_t bej_size = 0;
+    bool ok = read_file_into_buffer(args->inputFile, &json, &json_capacity, &json_size, &diagnostics)
+              && bej_encode_json(encoder, (const char*)json, (size_t)json_size, &bej, &bej_capacity, &bej_size);
+
+    if (ok) 
+    {
+#ifdef _WIN32
+        // BEJ is binary; keep the C runtime from translating bytes
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        FILE* output = args->outputFile ? fopen(args->outputFile, "wb") : stdout;
+        if (!output) 
+        {
+            fprintf(stderr, "Error: Cannot open %s\n", args->outputFile);
+            ok = false;
+        }
+        else 
+        {
+            ok = fwrite(bej, 1, bej_size, output) == bej_size;
+            if (output != stdout && fclose(output) != 0) 
+            {
+                ok = false;
+            }
+            if (!ok) 
+            {
+                fprintf(stderr, "Error: Failed to write %s\n", args->outputFile ? args->outputFile : "stdout");
+            }
+        }
+    }
+
+    if (ok && args->verbose) 
+    {
+        fprintf(stderr, "Encoded %s: %llu bytes of JSON to %zu bytes of BEJ\n", args->inputFile,
+                (unsigned long long)json_size, bej_size);
+    }
+
+    free(json);
+    free(bej);
+    bej_encoder_free(encoder);
+    free_dictionary(schema_dict);
+    free_dictionary(anno_dict);
+    return ok;
+}
@@ -0,0 +1,547 @@
+/**
+ * @file pipeline.c
+ * @author Vladyslav Kolodii
+ * @brief Pipelined streaming decoder for length-framed BEJ records
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+// ============================================================================
+// SPSC Ring Functions
+// ============================================================================
+
+/// Failed attempts a blocking push or pop yields through before it parks
+#define SPSC_SPIN_LIMIT 128
+
+struct SpscRing
+{
+    void** slots;
+    size_t mask;                        // capacity - 1; capacity is a power of two
+    _Alignas(64) atomic_size_t head;    // next slot to write, owned by the producer
+    _Alignas(64) atomic_size_t tail;    // next slot to read, owned by the consumer
+    _Alignas(64) atomic_int waiters;    // threads parked on changed
+    mtx_t lock;                         // guards the parking, never the slots
+    cnd_t changed;                      // signalled by a push or pop while someone is parked
+};
+
+SpscRing_t* spsc_create(size_t capacity)
+{
+    size_t slots = 2;
+    while (slots < capacity)
+    {
+        slots *= 2;
+    }
+
+    // The indices sit on their own cache lines, so the ring needs aligned storage
+    size_t size = (sizeof(SpscRing_t) + 63) & ~(size_t)63;
+    SpscRing_t* ring = (SpscRing_t*)aligned_alloc(64, size);
+    void** storage = (void**)calloc(slots, sizeof(void*));
+    if (!ring || !storage)
+    {
+        free(ring);
+        free(storage);
+        return NULL;
+    }
+    if (mtx_init(&ring->lock, mtx_plain) != thrd_success)
+    {
+        free(ring);
+        free(storage);
+        return NULL;
+    }
+    if (cnd_init(&ring->changed) != thrd_success)
+    {
+        mtx_destroy(&ring->lock);
+        free(ring);
+        free(storage);
+        return NULL;
+    }
+    ring->slots = storage;
+    ring->mask = slots - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->waiters, 0);
+    return ring;
+}
+
+void spsc_free(SpscRing_t* ring)
+{
+    if (!ring) return;
+
+    cnd_destroy(&ring->changed);
+    mtx_destroy(&ring->lock);
+    free(ring->slots);
+    free(ring);
+}
+
+size_t spsc_capacity(const SpscRing_t* ring)
+{
+    return ring ? ring->mask + 1 : 0;
+}
+
+/// Wake the other side if it is parked; called after every index update
+static void spsc_wake(SpscRing_t* ring)
+{
+    // Pairs with the fence in spsc_park: either the parked thread sees the new
+    // index when it re-checks, or this sees it waiting and signals
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiters, memory_order_relaxed) > 0)
+    {
+        mtx_lock(&ring->lock);
+        cnd_broadcast(&ring->changed);
+        mtx_unlock(&ring->lock);
+    }
+}
+
+static bool spsc_full(SpscRing_t* ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_relaxed)
+         - atomic_load_explicit(&ring->tail, memory_order_acquire) > ring->mask;
+}
+
+static bool spsc_empty(SpscRing_t* ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_relaxed)
+        == atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/// Sleep until blocked(ring) turns false; the other side's push or pop wakes us
+static void spsc_park(SpscRing_t* ring, bool (*blocked)(SpscRing_t*))
+{
+    mtx_lock(&ring->lock);
+    atomic_fetch_add_explicit(&ring->waiters, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (blocked(ring))
+    {
+        cnd_wait(&ring->changed, &ring->lock);
+    }
+    atomic_fetch_sub_explicit(&ring->waiters, 1, memory_order_relaxed);
+    mtx_unlock(&ring->lock);
+}
+
+bool spsc_try_push(SpscRing_t* ring, void* item)
+{
+    // Only the producer writes head, so a relaxed load of our own index is enough;
+    // acquiring tail makes sure the consumer is done with the slot we reuse
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask)
+    {
+        return false;
+    }
+
+    ring->slots[head & ring->mask] = item;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    spsc_wake(ring);
+    return true;
+}
+
+bool spsc_try_pop(SpscRing_t* ring, void** item)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head)
+    {
+        return false;
+    }
+
+    *item = ring->slots[tail & ring->mask];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    spsc_wake(ring);
+    return true;
+}
+
+/// Blocking push: rings are sized to hold every buffer, so waiting is brief
+static void spsc_push(SpscRing_t* ring, void* item)
+{
+    for (int attempt = 1; !spsc_try_push(ring, item); attempt++)
+    {
+        if (attempt < SPSC_SPIN_LIMIT)
+        {
+            thrd_yield();
+        }
+        else
+        {
+            spsc_park(ring, spsc_full);
+        }
+    }
+}
+
+/// Blocking pop: yields briefly, then sleeps while the upstream stage is idle
+static void* spsc_pop(SpscRing_t* ring)
+{
+    void* item;
+    for (int attempt = 1; !spsc_try_pop(ring, &item); attempt++)
+    {
+        if (attempt < SPSC_SPIN_LIMIT)
+        {
+            thrd_yield();
+        }
+        else
+        {
+            spsc_park(ring, spsc_empty);
+        }
+    }
+    return item;
+}
+
+// ============================================================================
+// Pipeline Stages
+// ============================================================================
+
+/// A record travelling through the pipeline; its storage is reused
+typedef struct
+{
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+    bool end;           // last buffer of the stream, carries no record
+} PipelineBuffer_t;
+
+/// State shared by the three stages
+//
+// Filled buffers flow reader -> decoder -> writer through decode_ring and
+// write_ring; emptied ones flow back through input_free and output_free.
+// Each ring has exactly one producer and one consumer thread.
+typedef struct
+{
+    const PipelineOptions_t* options;
+    SpscRing_t* input_free;     // decoder -> reader
+    SpscRing_t* decode_ring;    // reader -> decoder
+    SpscRing_t* write_ring;     // decoder -> writer
+    SpscRing_t* output_free;    // writer -> decoder
+    bool read_ok;               // written by the reader only
+    bool write_ok;              // written by the writer only
+    uint64_t records_in;
+    uint64_t records_out;
+    uint64_t records_failed;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} Pipeline_t;
+
+/// Read exactly size bytes; returns the number actually read
+static size_t read_exact(FILE* input, uint8_t* data, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        size_t count = fread(data + total, 1, size - total, input);
+        if (count == 0)
+        {
+            break;
+        }
+        total += count;
+    }
+    return total;
+}
+
+static int reader_stage(void* arg)
+{
+    Pipeline_t* pipeline = (Pipeline_t*)arg;
+    const PipelineOptions_t* options = pipeline->options;
+    pipeline->read_ok = true;
+
+    for (;;)
+    {
+        PipelineBuffer_t* buffer = (PipelineBuffer_t*)spsc_pop(pipeline->input_free);
+        buffer->length = 0;
+        buffer->end = false;
+
+        uint8_t frame[4];
+        size_t count = read_exact(options->input, frame, sizeof(frame));
+        if (count == 0)
+        {
+            // Clean end of stream at a record boundary
+            buffer->end = true;
+            spsc_push(pipeline->decode_ring, buffer);
+            break;
+        }
+
+        uint32_t size = (uint32_t)frame[0] | ((uint32_t)frame[1] << 8) |
+                        ((uint32_t)frame[2] << 16) | ((uint32_t)frame[3] << 24);
+        if (count < sizeof(frame) || size > options->max_record_size)
+        {
+            if (count < sizeof(frame))
+            {
+                bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR,
+                             "Truncated frame length after %llu records",
+                             (unsigned long long)pipeline->records_in);
+            }
+            else
+            {
+                bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR,
+                             "Record %llu is %u bytes, above the %u byte limit",
+                             (unsigned long long)pipeline->records_in, size, options->max_record_size);
+            }
+            pipeline->read_ok = false;
+            buffer->end = true;
+            spsc_push(pipeline->decode_ring, buffer);
+            break;
+        }
+
+        if (size > buffer->capacity)
+        {
+            uint8_t* grown = (uint8_t*)realloc(buffer->data, size);
+            if (!grown)
+            {
+                bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR,
+                             "Failed to allocate %u byte record buffer", size);
+                pipeline->read_ok = false;
+                buffer->end = true;
+                spsc_push(pipeline->decode_ring, buffer);
+                break;
+            }
+            buffer->data = grown;
+            buffer->capacity = size;
+        }
+
+        buffer->length = read_exact(options->input, buffer->data, size);
+        if (buffer->length < size)
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR,
+                         "Truncated record %llu: expected %u bytes, got %zu",
+                         (unsigned long long)pipeline->records_in, size, buffer->length);
+            pipeline->read_ok = false;
+            buffer->end = true;
+            spsc_push(pipeline->decode_ring, buffer);
+            break;
+        }
+
+        pipeline->records_in++;
+        pipeline->bytes_in += sizeof(frame) + size;
+        spsc_push(pipeline->decode_ring, buffer);
+    }
+    return 0;
+}
+
+static int decoder_stage(void* arg)
+{
+    Pipeline_t* pipeline = (Pipeline_t*)arg;
+    const PipelineOptions_t* options = pipeline->options;
+
+    // The arena is reset by every decode, so its blocks are reused record after record
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, options->schema_dict, options->anno_dict, NULL, NULL);
+    ctx.arena = &arena;
+    ctx.compact = true;
+    ctx.diagnostics = options->diagnostics;
+
+    for (;;)
+    {
+        PipelineBuffer_t* input = (PipelineBuffer_t*)spsc_pop(pipeline->decode_ring);
+        PipelineBuffer_t* output = (PipelineBuffer_t*)spsc_pop(pipeline->output_free);
+        output->length = 0;
+        output->end = input->end;
+
+        if (input->end)
+        {
+            spsc_push(pipeline->write_ring, output);
+            spsc_push(pipeline->input_free, input);
+            break;
+        }
+
+        // Decode straight into the output buffer; it grows in place if needed
+        set_output_buffer(&ctx, output->data, output->capacity);
+        ctx.indent_level = 0;
+        bool ok = decode_bej_buffer(&ctx, input->data, input->length);
+        output->data = ctx.output_buffer;
+        output->capacity = ctx.output_capacity;
+
+        if (ok && ctx.output_length + 1 > output->capacity)
+        {
+            uint8_t* grown = (uint8_t*)realloc(output->data, ctx.output_length + 1);
+            ok = grown != NULL;
+            if (grown)
+            {
+                output->data = grown;
+                output->capacity = ctx.output_length + 1;
+            }
+        }
+
+        if (ok)
+        {
+            output->data[ctx.output_length] = '\n';
+            output->length = ctx.output_length + 1;
+        }
+        else
+        {
+            // Skip the record; an empty buffer is simply recycled by the writer
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to decode record %llu",
+                         (unsigned long long)(pipeline->records_out + pipeline->records_failed));
+            pipeline->records_failed++;
+        }
+        pipeline->records_out += ok ? 1 : 0;
+
+        spsc_push(pipeline->input_free, input);
+        spsc_push(pipeline->write_ring, output);
+    }
+    free_arena(&arena);
+    return 0;
+}
+
+static int writer_stage(void* arg)
+{
+    Pipeline_t* pipeline = (Pipeline_t*)arg;
+    const PipelineOptions_t* options = pipeline->options;
+    FILE* output_stream = options->output;
+    pipeline->write_ok = true;
+
+    for (;;)
+    {
+        PipelineBuffer_t* buffer = (PipelineBuffer_t*)spsc_pop(pipeline->write_ring);
+        if (buffer->end)
+        {
+            spsc_push(pipeline->output_free, buffer);
+            break;
+        }
+
+        // After a write error keep draining so upstream stages are never stuck
+        if (pipeline->write_ok && buffer->length > 0)
+        {
+            if (fwrite(buffer->data, 1, buffer->length, output_stream) == buffer->length)
+            {
+                pipeline->bytes_out += buffer->length;
+            }
+            else
+            {
+                bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to write pipeline output");
+                pipeline->write_ok = false;
+            }
+        }
+        spsc_push(pipeline->output_free, buffer);
+    }
+
+    if (fflush(output_stream) != 0)
+    {
+        pipeline->write_ok = false;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Pipeline Driver
+// ============================================================================
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool bej_decode_stream_pipeline(const PipelineOptions_t* options, PipelineStats_t* stats)
+{
+    if (!options) return false;
+
+    if (!options->input || !options->output)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return false;
+    }
+
+    PipelineOptions_t resolved = *options;
+    if (resolved.ring_capacity == 0)
+    {
+        resolved.ring_capacity = PIPELINE_RING_CAPACITY;
+    }
+    if (resolved.max_record_size == 0)
+    {
+        resolved.max_record_size = PIPELINE_MAX_RECORD_SIZE;
+    }
+
+    Pipeline_t pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.options = &resolved;
+
+    pipeline.input_free = spsc_create(resolved.ring_capacity);
+    pipeline.decode_ring = spsc_create(resolved.ring_capacity);
+    pipeline.write_ring = spsc_create(resolved.ring_capacity);
+    pipeline.output_free = spsc_create(resolved.ring_capacity);
+    bool ok = pipeline.input_free && pipeline.decode_ring && pipeline.write_ring && pipeline.output_free;
+    if (!ok)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate pipeline rings");
+    }
+
+    // One buffer per slot, so a push can never find its ring full for long
+    size_t buffer_count = ok ? spsc_capacity(pipeline.input_free) : 0;
+    PipelineBuffer_t* buffers = ok ? (PipelineBuffer_t*)calloc(buffer_count * 2, sizeof(PipelineBuffer_t)) : NULL;
+    if (ok && !buffers)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate pipeline buffers");
+        ok = false;
+    }
+    for (size_t i = 0; ok && i < buffer_count; i++)
+    {
+        spsc_try_push(pipeline.input_free, &buffers[i]);
+        spsc_try_push(pipeline.output_free, &buffers[buffer_count + i]);
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    if (ok)
+    {
+        thrd_t reader;
+        thrd_t writer;
+        if (thrd_create(&writer, writer_stage, &pipeline) != thrd_success)
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to start writer thread");
+            ok = false;
+        }
+        else if (thrd_create(&reader, reader_stage, &pipeline) != thrd_success)
+        {
+            // Nothing was read; hand the writer its end marker so it exits
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to start reader thread");
+            PipelineBuffer_t* end = (PipelineBuffer_t*)spsc_pop(pipeline.output_free);
+            end->end = true;
+            spsc_push(pipeline.write_ring, end);
+            thrd_join(writer, NULL);
+            ok = false;
+        }
+        else
+        {
+            // The calling thread is the decoder stage
+            decoder_stage(&pipeline);
+            thrd_join(reader, NULL);
+            thrd_join(writer, NULL);
+        }
+    }
+
+    double seconds = elapsed_seconds(&start);
+
+    if (buffers)
+    {
+        for (size_t i = 0; i < buffer_count * 2; i++)
+        {
+            free(buffers[i].data);
+        }
+        free(buffers);
+    }
+    spsc_free(pipeline.input_free);
+    spsc_free(pipeline.decode_ring);
+    spsc_free(pipeline.write_ring);
+    spsc_free(pipeline.output_free);
+
+    if (stats)
+    {
+        stats->records_in = pipeline.records_in;
+        stats->records_out = pipeline.records_out;
+        stats->records_failed = pipeline.records_failed;
+        stats->bytes_in = pipeline.bytes_in;
+        stats->bytes_out = pipeline.bytes_out;
+        stats->seconds = seconds;
+    }
+    return ok && pipeline.read_ok && pipeline.write_ok && pipeline.records_failed == 0;
+}
@@ -0,0 +1,540 @@
+/**
+ * @file plan.c
+ * @author Vladyslav Kolodii
+ * @brief Compiled query plans (value paths plus an optional filter) and their in-process cache
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "plan.h"
+#include "filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+/// No node, or no path
+#define PLAN_NONE UINT32_MAX
+
+/// Initial slot count of a plan cache; always a power of two
+#define PLAN_CACHE_SLOTS 16
+
+/// One step of the path tree; node 0 stands for the document's root tuple
+typedef struct
+{
+    BejPathStep_t step;
+    uint32_t first_child;       // PLAN_NONE for a leaf
+    uint32_t next_sibling;
+    uint32_t child_count;
+    uint32_t output;            // first path whose value this node is, or PLAN_NONE
+} PlanNode_t;
+
+/// Where one path ends and which dictionary entry describes its value
+typedef struct
+{
+    uint32_t node;
+    uint16_t entry;
+    uint8_t dict_selector;
+} PlanOutput_t;
+
+struct BejPlan
+{
+    PlanNode_t* nodes;
+    uint32_t node_count;
+    PlanOutput_t* outputs;
+    size_t path_count;
+    BejFilter_t* filter;        // NULL selects every document
+    uint32_t schema_version;    // of the dictionaries the plan was compiled with
+    uint64_t schema_hash;
+    uint64_t anno_hash;         // 0 without an annotation dictionary
+};
+
+// ============================================================================
+// Compilation
+// ============================================================================
+
+/// Child of parent taking step, added if the tree does not have it yet
+static uint32_t add_step(BejPlan_t* plan, uint32_t parent, const BejPathStep_t* step)
+{
+    uint32_t* link = &plan->nodes[parent].first_child;
+    for (; *link != PLAN_NONE; link = &plan->nodes[*link].next_sibling)
+    {
+        const BejPathStep_t* other = &plan->nodes[*link].step;
+        if (other->value == step->value && other->dict_selector == step->dict_selector && other->index == step->index)
+        {
+            return *link;
+        }
+    }
+
+    uint32_t index = plan->node_count++;
+    PlanNode_t* node = &plan->nodes[index];
+    node->step = *step;
+    node->first_child = PLAN_NONE;
+    node->next_sibling = PLAN_NONE;
+    node->child_count = 0;
+    node->output = PLAN_NONE;
+    *link = index;
+    plan->nodes[parent].child_count++;
+    return index;
+}
+
+BejPlan_t* bej_plan_compile(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                            const char* const* paths, size_t path_count, const char* where,
+                            const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0 || (path_count > 0 && !paths))
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    // Every step of every path takes at most one node
+    size_t node_capacity = 1;
+    for (size_t i = 0; i < path_count; i++)
+    {
+        node_capacity += paths[i] ? strlen(paths[i]) + 1 : 0;
+    }
+    BejPlan_t* plan = (BejPlan_t*)calloc(1, sizeof(BejPlan_t));
+    if (plan)
+    {
+        plan->nodes = (PlanNode_t*)malloc(node_capacity * sizeof(PlanNode_t));
+        plan->outputs = (PlanOutput_t*)calloc(path_count ? path_count : 1, sizeof(PlanOutput_t));
+    }
+    if (!plan || !plan->nodes || !plan->outputs || node_capacity >= PLAN_NONE)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate plan");
+        bej_plan_free(plan);
+        return NULL;
+    }
+    plan->path_count = path_count;
+    plan->schema_version = schema_dict->schema_version;
+    plan->schema_hash = schema_dict->content_hash;
+    plan->anno_hash = anno_dict ? anno_dict->content_hash : 0;
+
+    PlanNode_t* root = &plan->nodes[plan->node_count++];
+    memset(root, 0, sizeof(*root));
+    root->first_child = PLAN_NONE;
+    root->next_sibling = PLAN_NONE;
+    root->output = PLAN_NONE;
+
+    for (size_t i = 0; i < path_count; i++)
+    {
+        BejPath_t* path = bej_path_compile(schema_dict, anno_dict, paths[i], diagnostics);
+        if (!path)
+        {
+            bej_plan_free(plan);
+            return NULL;
+        }
+
+        // Paths with a common prefix share its nodes, so it is walked once
+        size_t step_count;
+        const BejPathStep_t* steps = bej_path_steps(path, &step_count);
+        uint32_t node = 0;
+        for (size_t s = 0; s < step_count; s++)
+        {
+            node = add_step(plan, node, &steps[s]);
+        }
+        if (plan->nodes[node].output == PLAN_NONE)
+        {
+            plan->nodes[node].output = (uint32_t)i;
+        }
+
+        PlanOutput_t* output = &plan->outputs[i];
+        output->node = node;
+        output->dict_selector = bej_path_entry_selector(path);
+        Dictionary_t* dict = output->dict_selector ? anno_dict : schema_dict;
+        output->entry = (uint16_t)(bej_path_entry(path, schema_dict, anno_dict) - dict->entries);
+        bej_path_free(path);
+    }
+
+    if (where)
+    {
+        plan->filter = bej_filter_compile(schema_dict, anno_dict, where, diagnostics);
+        if (!plan->filter)
+        {
+            bej_plan_free(plan);
+            return NULL;
+        }
+    }
+    return plan;
+}
+
+size_t bej_plan_path_count(const BejPlan_t* plan)
+{
+    return plan ? plan->path_count : 0;
+}
+
+void bej_plan_free(BejPlan_t* plan)
+{
+    if (!plan) return;
+
+    free(plan->nodes);
+    free(plan->outputs);
+    bej_filter_free(plan->filter);
+    free(plan);
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+/// State of one bej_plan_execute() call
+typedef struct
+{
+    const BejPlan_t* plan;
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+    BejValue_t* values;
+    bool* found;
+} PlanRun_t;
+
+static bool visit_node(PlanRun_t* run, uint32_t index, const SFLV_t* sflv);
+
+/// Read the members of container that node's children want, skipping the rest by their length
+static bool walk_children(PlanRun_t* run, const PlanNode_t* node, const SFLV_t* container)
+{
+    const PlanNode_t* nodes = run->plan->nodes;
+    bool by_index = nodes[node->first_child].step.index;
+    if (container->format != (by_index ? BEJ_FORMAT_ARRAY : BEJ_FORMAT_SET))
+    {
+        return true;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, container->value, container->length);
+    uint64_t count = 0;
+    if (container->length > 0 && !read_nnint_from_buffer(&reader, &count))
+    {
+        return false;
+    }
+
+    uint32_t remaining = node->child_count;
+    for (uint64_t position = 0; remaining > 0 && !buffer_eof(&reader); position++)
+    {
+        SFLV_t member;
+        if (!read_sflv_header_from_buffer(&reader, &member))
+        {
+            return false;
+        }
+        for (uint32_t child = node->first_child; child != PLAN_NONE; child = nodes[child].next_sibling)
+        {
+            const BejPathStep_t* step = &nodes[child].step;
+            bool wanted = by_index
+                ? position == step->value
+                : (member.sequence == step->value && member.dict_selector == step->dict_selector);
+            if (wanted)
+            {
+                remaining--;
+                if (!visit_node(run, child, &member))
+                {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static bool visit_node(PlanRun_t* run, uint32_t index, const SFLV_t* sflv)
+{
+    const PlanNode_t* node = &run->plan->nodes[index];
+    if (node->output != PLAN_NONE)
+    {
+        const PlanOutput_t* output = &run->plan->outputs[node->output];
+        Dictionary_t* dict = output->dict_selector ? run->anno_dict : run->schema_dict;
+        if (!bej_value_from_sflv(sflv, dict, &dict->entries[output->entry], &run->values[node->output], NULL))
+        {
+            return false;
+        }
+        run->found[node->output] = true;
+    }
+    return node->first_child == PLAN_NONE || walk_children(run, node, sflv);
+}
+
+bool bej_plan_execute(const BejPlan_t* plan, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                      const uint8_t* data, uint64_t size, bool* matched, BejValue_t* values, bool* found)
+{
+    if (!plan || !schema_dict || !data || !matched || (plan->path_count > 0 && (!values || !found)))
+    {
+        return false;
+    }
+
+    // Entry indices only mean something in the dictionary revision the plan was built from
+    if (schema_dict->schema_version != plan->schema_version || schema_dict->content_hash != plan->schema_hash
+        || (anno_dict ? anno_dict->content_hash : 0) != plan->anno_hash)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < plan->path_count; i++)
+    {
+        found[i] = false;
+    }
+    *matched = true;
+    if (plan->filter && !bej_filter_match(plan->filter, data, size, matched))
+    {
+        return false;
+    }
+    if (!*matched || plan->path_count == 0)
+    {
+        return true;
+    }
+
+    // The reader never writes; it only shares the non-const buffer type
+    BufferReader_t reader;
+    init_buffer_reader(&reader, (uint8_t*)data, size);
+    SFLV_t root;
+    if (!read_bej_header_from_buffer(&reader, NULL) || !read_sflv_header_from_buffer(&reader, &root))
+    {
+        return false;
+    }
+
+    PlanRun_t run = { plan, schema_dict, anno_dict, values, found };
+    if (!visit_node(&run, 0, &root))
+    {
+        return false;
+    }
+
+    // A path given twice was read once, into its first position
+    for (size_t i = 0; i < plan->path_count; i++)
+    {
+        uint32_t first = plan->nodes[plan->outputs[i].node].output;
+        if (first != i)
+        {
+            found[i] = found[first];
+            values[i] = values[first];
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Plan Cache
+// ============================================================================
+
+typedef struct
+{
+    uint64_t hash;
+    char* key;                  // NULL for an empty slot
+    size_t key_length;
+    BejPlan_t* plan;
+} PlanCacheSlot_t;
+
+struct BejPlanCache
+{
+    PlanCacheSlot_t* slots;     // open addressing, linear probing
+    size_t slot_count;
+    size_t plan_count;
+    mtx_t lock;
+};
+
+/// FNV-1a
+static uint64_t hash_key(const char* key, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)key[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/// Dictionary revisions, then each path and the filter, NUL-terminated
+static char* make_key(Dictionary_t* schema_dict, Dictionary_t* anno_dict, const char* const* paths,
+                      size_t path_count, const char* where, size_t* length)
+{
+    char prefix[64];
+    int prefix_length = snprintf(prefix, sizeof(prefix), "%08x:%016llx:%016llx:%zu",
+                                 (unsigned)schema_dict->schema_version,
+                                 (unsigned long long)schema_dict->content_hash,
+                                 (unsigned long long)(anno_dict ? anno_dict->content_hash : 0), path_count);
+    size_t size = (size_t)prefix_length + 1 + (where ? strlen(where) + 1 : 1);
+    for (size_t i = 0; i < path_count; i++)
+    {
+        size += strlen(paths[i]) + 1;
+    }
+
+    char* key = (char*)malloc(size);
+    if (!key)
+    {
+        return NULL;
+    }
+    char* next = key;
+    memcpy(next, prefix, (size_t)prefix_length + 1);
+    next += prefix_length + 1;
+    for (size_t i = 0; i < path_count; i++)
+    {
+        size_t path_length = strlen(paths[i]) + 1;
+        memcpy(next, paths[i], path_length);
+        next += path_length;
+    }
+
+    // "W<filter>" and a lone NUL never collide, so an empty filter differs from none
+    if (where)
+    {
+        *next++ = 'W';
+        memcpy(next, where, strlen(where));
+        next += strlen(where);
+    }
+    else
+    {
+        *next++ = '\0';
+    }
+    *length = (size_t)(next - key);
+    return key;
+}
+
+/// Slot holding key, or the empty slot where it belongs
+static PlanCacheSlot_t* find_slot(PlanCacheSlot_t* slots, size_t slot_count, uint64_t hash,
+                                  const char* key, size_t length)
+{
+    size_t index = (size_t)hash & (slot_count - 1);
+    for (;;)
+    {
+        PlanCacheSlot_t* slot = &slots[index];
+        if (!slot->key
+            || (slot->hash == hash && slot->key_length == length && memcmp(slot->key, key, length) == 0))
+        {
+            return slot;
+        }
+        index = (index + 1) & (slot_count - 1);
+    }
+}
+
+/// Double the slot table, keeping it at most half full
+static bool grow_cache(BejPlanCache_t* cache)
+{
+    size_t slot_count = cache->slot_count * 2;
+    PlanCacheSlot_t* slots = (PlanCacheSlot_t*)calloc(slot_count, sizeof(PlanCacheSlot_t));
+    if (!slots)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < cache->slot_count; i++)
+    {
+        PlanCacheSlot_t* slot = &cache->slots[i];
+        if (slot->key)
+        {
+            *find_slot(slots, slot_count, slot->hash, slot->key, slot->key_length) = *slot;
+        }
+    }
+    free(cache->slots);
+    cache->slots = slots;
+    cache->slot_count = slot_count;
+    return true;
+}
+
+BejPlanCache_t* bej_plan_cache_create(void)
+{
+    BejPlanCache_t* cache = (BejPlanCache_t*)calloc(1, sizeof(BejPlanCache_t));
+    if (!cache)
+    {
+        return NULL;
+    }
+    cache->slot_count = PLAN_CACHE_SLOTS;
+    cache->slots = (PlanCacheSlot_t*)calloc(cache->slot_count, sizeof(PlanCacheSlot_t));
+    if (!cache->slots || mtx_init(&cache->lock, mtx_plain) != thrd_success)
+    {
+        free(cache->slots);
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+const BejPlan_t* bej_plan_cache_get(BejPlanCache_t* cache, Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                    const char* const* paths, size_t path_count, const char* where,
+                                    const BejDiagnostics_t* diagnostics)
+{
+    if (!cache || !schema_dict || (path_count > 0 && !paths))
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+    for (size_t i = 0; i < path_count; i++)
+    {
+        if (!paths[i])
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+            return NULL;
+        }
+    }
+
+    size_t length;
+    char* key = make_key(schema_dict, anno_dict, paths, path_count, where, &length);
+    if (!key)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate plan cache key");
+        return NULL;
+    }
+    uint64_t hash = hash_key(key, length);
+
+    // Compiling under the lock keeps two threads from building the same plan
+    mtx_lock(&cache->lock);
+    PlanCacheSlot_t* slot = find_slot(cache->slots, cache->slot_count, hash, key, length);
+    BejPlan_t* plan = slot->plan;
+    if (slot->key)
+    {
+        free(key);
+    }
+    else
+    {
+        plan = bej_plan_compile(schema_dict, anno_dict, paths, path_count, where, diagnostics);
+        if (plan && (cache->plan_count + 1) * 2 > cache->slot_count)
+        {
+            if (grow_cache(cache))
+            {
+                slot = find_slot(cache->slots, cache->slot_count, hash, key, length);
+            }
+            else
+            {
+                bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to grow plan cache");
+                bej_plan_free(plan);
+                plan = NULL;
+            }
+        }
+        if (plan)
+        {
+            slot->hash = hash;
+            slot->key = key;
+            slot->key_length = length;
+            slot->plan = plan;
+            cache->plan_count++;
+        }
+        else
+        {
+            free(key);
+        }
+    }
+    mtx_unlock(&cache->lock);
+    return plan;
+}
+
+size_t bej_plan_cache_size(BejPlanCache_t* cache)
+{
+    if (!cache)
+    {
+        return 0;
+    }
+    mtx_lock(&cache->lock);
+    size_t count = cache->plan_count;
+    mtx_unlock(&cache->lock);
+    return count;
+}
+
+void bej_plan_cache_free(BejPlanCache_t* cache)
+{
+    if (!cache) return;
+
+    for (size_t i = 0; i < cache->slot_count; i++)
+    {
+        free(cache->slots[i].key);
+        bej_plan_free(cache->slots[i].plan);
+    }
+    free(cache->slots);
+    mtx_destroy(&cache->lock);
+    free(cache);
+}
@@ -0,0 +1,822 @@
+/**
+ * @file server.c
+ * @author Vladyslav Kolodii
+ * @brief Long-running decode daemon over a Unix domain socket
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifdef __linux__
+#define _GNU_SOURCE     // accept4
+#endif
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef __linux__
+
+BejServer_t* server_create(const ServerOptions_t* options)
+{
+    if (options)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "serve is only available on Linux");
+    }
+    return NULL;
+}
+
+bool server_run(BejServer_t* server)
+{
+    (void)server;
+    return false;
+}
+
+void server_stop(BejServer_t* server)
+{
+    (void)server;
+}
+
+void server_destroy(BejServer_t* server)
+{
+    (void)server;
+}
+
+#else
+
+#include <errno.h>
+#include <unistd.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/// Size of the length prefix on requests and responses
+#define SERVER_FRAME_HEADER 4
+
+// ============================================================================
+// Server State
+// ============================================================================
+
+/// One client connection; owned by the event loop thread
+typedef struct Connection
+{
+    int fd;
+    uint32_t events;            // current epoll interest
+    uint8_t* input;             // buffered request bytes
+    size_t input_length;
+    size_t input_capacity;
+    uint8_t* output;            // response being sent
+    size_t output_length;
+    size_t output_sent;
+    bool busy;                  // a request is with the workers; input must not move
+    bool closed;                // socket already closed; free once the worker is done
+    bool close_after_send;
+    struct Connection* prev;
+    struct Connection* next;
+} Connection_t;
+
+/// A decode request handed from the event loop to a worker and back
+typedef struct Job
+{
+    Connection_t* connection;
+    const ServerDictionary_t* dictionary;
+    uint8_t* document;          // points into connection->input
+    uint32_t size;
+    uint8_t* response;          // complete response frame, built by the worker
+    size_t response_length;
+    struct Job* next;
+} Job_t;
+
+struct BejServer
+{
+    ServerOptions_t options;
+    int listen_fd;
+    bool socket_created;        // the socket file at options.socket_path is ours to remove
+    int epoll_fd;
+    int event_fd;               // wakes the event loop: jobs done or stop requested
+    thrd_t* workers;
+    size_t worker_count;
+    mtx_t lock;                 // guards the two job queues and shutting_down
+    cnd_t work_ready;
+    Job_t* pending_head;        // waiting for a worker, FIFO
+    Job_t* pending_tail;
+    Job_t* done;                // finished, waiting for the event loop
+    bool shutting_down;
+    atomic_bool stop_requested;
+    Connection_t* connections;
+    Connection_t* retired;      // freed after the current batch of epoll events
+};
+
+// ============================================================================
+// Response Framing
+// ============================================================================
+
+static void put_le32(uint8_t* bytes, uint32_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+/// Build a response frame holding a status and a text payload
+static uint8_t* make_response(uint8_t status, const char* message, size_t* length)
+{
+    size_t message_length = strlen(message);
+    uint8_t* response = (uint8_t*)malloc(SERVER_FRAME_HEADER + 1 + message_length);
+    if (!response)
+    {
+        return NULL;
+    }
+    put_le32(response, (uint32_t)(1 + message_length));
+    response[SERVER_FRAME_HEADER] = status;
+    memcpy(response + SERVER_FRAME_HEADER + 1, message, message_length);
+    *length = SERVER_FRAME_HEADER + 1 + message_length;
+    return response;
+}
+
+// ============================================================================
+// Worker Pool
+// ============================================================================
+
+static void decode_job(Job_t* job, DecoderContext_t* ctx)
+{
+    ctx->schema_dict = job->dictionary->schema_dict;
+    ctx->anno_dict = job->dictionary->anno_dict;
+    ctx->indent_level = 0;
+
+    // Decode straight after a reserved frame header, so the JSON is never copied
+    size_t capacity = 4096;
+    set_output_buffer(ctx, (uint8_t*)malloc(capacity), capacity);
+    bool ok = ctx->output_buffer != NULL;
+    if (ok)
+    {
+        ctx->output_length = SERVER_FRAME_HEADER + 1;
+        ok = decode_bej_buffer(ctx, job->document, job->size)
+             && ctx->output_length - SERVER_FRAME_HEADER <= UINT32_MAX;
+    }
+
+    if (ok)
+    {
+        put_le32(ctx->output_buffer, (uint32_t)(ctx->output_length - SERVER_FRAME_HEADER));
+        ctx->output_buffer[SERVER_FRAME_HEADER] = SERVER_STATUS_OK;
+        job->response = ctx->output_buffer;
+        job->response_length = ctx->output_length;
+    }
+    else
+    {
+        free(ctx->output_buffer);
+        job->response = make_response(SERVER_STATUS_DECODE_ERROR, "Failed to decode BEJ document",
+                                      &job->response_length);
+    }
+    ctx->output_buffer = NULL;
+    ctx->output_capacity = 0;
+}
+
+static int server_worker(void* arg)
+{
+    BejServer_t* server = (BejServer_t*)arg;
+
+    // The arena is reset by every decode, so its blocks are reused job after job
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, NULL, NULL, NULL, NULL);
+    ctx.arena = &arena;
+    ctx.compact = true;
+    ctx.diagnostics = server->options.diagnostics;
+
+    for (;;)
+    {
+        mtx_lock(&server->lock);
+        while (!server->pending_head && !server->shutting_down)
+        {
+            cnd_wait(&server->work_ready, &server->lock);
+        }
+        Job_t* job = server->pending_head;
+        if (!job)
+        {
+            mtx_unlock(&server->lock);
+            break;
+        }
+        server->pending_head = job->next;
+        if (!server->pending_head)
+        {
+            server->pending_tail = NULL;
+        }
+        mtx_unlock(&server->lock);
+
+        decode_job(job, &ctx);
+
+        mtx_lock(&server->lock);
+        job->next = server->done;
+        server->done = job;
+        mtx_unlock(&server->lock);
+
+        uint64_t one = 1;
+        ssize_t written = write(server->event_fd, &one, sizeof(one));
+        (void)written;
+    }
+    free_arena(&arena);
+    return 0;
+}
+
+// ============================================================================
+// Connection Handling
+// ============================================================================
+
+static void set_interest(BejServer_t* server, Connection_t* connection, uint32_t events)
+{
+    if (connection->events == events)
+    {
+        return;
+    }
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->events = events;
+}
+
+static void free_connection(BejServer_t* server, Connection_t* connection)
+{
+    if (connection->prev)
+    {
+        connection->prev->next = connection->next;
+    }
+    else
+    {
+        server->connections = connection->next;
+    }
+    if (connection->next)
+    {
+        connection->next->prev = connection->prev;
+    }
+
+    // Later events in the same epoll batch may still point at the connection
+    connection->next = server->retired;
+    server->retired = connection;
+}
+
+static void free_retired(BejServer_t* server)
+{
+    while (server->retired)
+    {
+        Connection_t* connection = server->retired;
+        server->retired = connection->next;
+        free(connection->input);
+        free(connection->output);
+        free(connection);
+    }
+}
+
+/// Close the socket; the connection itself lives on while a worker still uses its input
+static void close_connection(BejServer_t* server, Connection_t* connection)
+{
+    if (!connection->closed)
+    {
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        close(connection->fd);
+        connection->closed = true;
+    }
+    if (!connection->busy)
+    {
+        free_connection(server, connection);
+    }
+}
+
+/// Drop the request just answered from the front of the input buffer
+static void consume_request(Connection_t* connection, size_t length)
+{
+    memmove(connection->input, connection->input + length, connection->input_length - length);
+    connection->input_length -= length;
+}
+
+static void set_output(Connection_t* connection, uint8_t* response, size_t length)
+{
+    connection->output = response;
+    connection->output_length = length;
+    connection->output_sent = 0;
+}
+
+static const ServerDictionary_t* find_server_dictionary(BejServer_t* server, const uint8_t* key, size_t length)
+{
+    for (size_t i = 0; i < server->options.dictionary_count; i++)
+    {
+        const ServerDictionary_t* dictionary = &server->options.dictionaries[i];
+        if (strlen(dictionary->key) == length && memcmp(dictionary->key, key, length) == 0)
+        {
+            return dictionary;
+        }
+    }
+    return NULL;
+}
+
+enum { REQUEST_NEED_MORE, REQUEST_DISPATCHED, REQUEST_ANSWERED, REQUEST_FAILED };
+
+/// Look at the buffered input: hand a complete request to the workers or answer it directly
+static int parse_request(BejServer_t* server, Connection_t* connection)
+{
+    if (connection->input_length < SERVER_FRAME_HEADER)
+    {
+        return REQUEST_NEED_MORE;
+    }
+
+    const uint8_t* input = connection->input;
+    uint32_t body_length = (uint32_t)input[0] | ((uint32_t)input[1] << 8) |
+                           ((uint32_t)input[2] << 16) | ((uint32_t)input[3] << 24);
+    size_t response_length = 0;
+    uint8_t* response = NULL;
+
+    if (body_length == 0 || body_length > server->options.max_request_size
+        || (connection->input_length > SERVER_FRAME_HEADER && 1u + input[SERVER_FRAME_HEADER] > body_length))
+    {
+        // The stream cannot be resynchronized after a bad frame
+        response = make_response(SERVER_STATUS_BAD_REQUEST, "Malformed or oversized request", &response_length);
+        connection->input_length = 0;
+        connection->close_after_send = true;
+    }
+    else if (connection->input_length < SERVER_FRAME_HEADER + (size_t)body_length)
+    {
+        return REQUEST_NEED_MORE;
+    }
+    else
+    {
+        size_t key_length = input[SERVER_FRAME_HEADER];
+        const ServerDictionary_t* dictionary =
+            find_server_dictionary(server, input + SERVER_FRAME_HEADER + 1, key_length);
+        if (dictionary)
+        {
+            Job_t* job = (Job_t*)calloc(1, sizeof(Job_t));
+            if (!job)
+            {
+                return REQUEST_FAILED;
+            }
+            job->connection = connection;
+            job->dictionary = dictionary;
+            job->document = connection->input + SERVER_FRAME_HEADER + 1 + key_length;
+            job->size = body_length - 1 - (uint32_t)key_length;
+            connection->busy = true;
+
+            mtx_lock(&server->lock);
+            if (server->pending_tail)
+            {
+                server->pending_tail->next = job;
+            }
+            else
+            {
+                server->pending_head = job;
+            }
+            server->pending_tail = job;
+            cnd_signal(&server->work_ready);
+            mtx_unlock(&server->lock);
+            return REQUEST_DISPATCHED;
+        }
+
+        response = make_response(SERVER_STATUS_UNKNOWN_KEY, "Unknown dictionary key", &response_length);
+        consume_request(connection, SERVER_FRAME_HEADER + (size_t)body_length);
+    }
+
+    if (!response)
+    {
+        return REQUEST_FAILED;
+    }
+    set_output(connection, response, response_length);
+    return REQUEST_ANSWERED;
+}
+
+/// Send pending output, then move on to the next buffered request, until blocked
+static void service_connection(BejServer_t* server, Connection_t* connection)
+{
+    for (;;)
+    {
+        while (connection->output && connection->output_sent < connection->output_length)
+        {
+            ssize_t sent = send(connection->fd, connection->output + connection->output_sent,
+                                connection->output_length - connection->output_sent, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                set_interest(server, connection, EPOLLOUT);
+                return;
+            }
+            if (sent <= 0)
+            {
+                close_connection(server, connection);
+                return;
+            }
+            connection->output_sent += (size_t)sent;
+        }
+        free(connection->output);
+        connection->output = NULL;
+
+        if (connection->close_after_send)
+        {
+            close_connection(server, connection);
+            return;
+        }
+
+        // While a worker reads the input buffer it must not grow, so reading pauses
+        int state = parse_request(server, connection);
+        if (state == REQUEST_DISPATCHED)
+        {
+            set_interest(server, connection, 0);
+            return;
+        }
+        if (state == REQUEST_NEED_MORE)
+        {
+            set_interest(server, connection, EPOLLIN);
+            return;
+        }
+        if (state == REQUEST_FAILED)
+        {
+            bej_diagnose(&server->options.diagnostics, BEJ_DIAG_ERROR, "Failed to allocate request state");
+            close_connection(server, connection);
+            return;
+        }
+    }
+}
+
+static void read_connection(BejServer_t* server, Connection_t* connection)
+{
+    for (;;)
+    {
+        if (connection->input_capacity - connection->input_length < 4096)
+        {
+            size_t capacity = connection->input_capacity ? connection->input_capacity * 2 : 16384;
+            uint8_t* grown = (uint8_t*)realloc(connection->input, capacity);
+            if (!grown)
+            {
+                close_connection(server, connection);
+                return;
+            }
+            connection->input = grown;
+            connection->input_capacity = capacity;
+        }
+
+        ssize_t received = recv(connection->fd, connection->input + connection->input_length,
+                                connection->input_capacity - connection->input_length, 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (received <= 0)
+        {
+            close_connection(server, connection);
+            return;
+        }
+        connection->input_length += (size_t)received;
+
+        // Stop buffering once a whole request (or an oversized header) is in
+        if (connection->input_length >= SERVER_FRAME_HEADER)
+        {
+            const uint8_t* input = connection->input;
+            uint32_t body_length = (uint32_t)input[0] | ((uint32_t)input[1] << 8) |
+                                   ((uint32_t)input[2] << 16) | ((uint32_t)input[3] << 24);
+            if (body_length > server->options.max_request_size
+                || connection->input_length >= SERVER_FRAME_HEADER + (size_t)body_length)
+            {
+                break;
+            }
+        }
+    }
+    service_connection(server, connection);
+}
+
+static void accept_connections(BejServer_t* server)
+{
+    for (;;)
+    {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                bej_diagnose(&server->options.diagnostics, BEJ_DIAG_WARNING, "accept failed: %s", strerror(errno));
+            }
+            return;
+        }
+
+        Connection_t* connection = (Connection_t*)calloc(1, sizeof(Connection_t));
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (!connection || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        connection->next = server->connections;
+        if (server->connections)
+        {
+            server->connections->prev = connection;
+        }
+        server->connections = connection;
+    }
+}
+
+/// Hand finished jobs back to their connections
+static void deliver_results(BejServer_t* server)
+{
+    uint64_t count;
+    ssize_t drained = read(server->event_fd, &count, sizeof(count));
+    (void)drained;
+
+    mtx_lock(&server->lock);
+    Job_t* job = server->done;
+    server->done = NULL;
+    mtx_unlock(&server->lock);
+
+    while (job)
+    {
+        Job_t* next = job->next;
+        Connection_t* connection = job->connection;
+        connection->busy = false;
+
+        if (connection->closed)
+        {
+            free(job->response);
+            free_connection(server, connection);
+        }
+        else if (!job->response)
+        {
+            bej_diagnose(&server->options.diagnostics, BEJ_DIAG_ERROR, "Failed to allocate response");
+            close_connection(server, connection);
+        }
+        else
+        {
+            // The request can leave the input buffer now that the worker is done with it
+            uint32_t body_length = (uint32_t)connection->input[0] | ((uint32_t)connection->input[1] << 8) |
+                                   ((uint32_t)connection->input[2] << 16) |
+                                   ((uint32_t)connection->input[3] << 24);
+            consume_request(connection, SERVER_FRAME_HEADER + (size_t)body_length);
+            set_output(connection, job->response, job->response_length);
+            service_connection(server, connection);
+        }
+        free(job);
+        job = next;
+    }
+}
+
+// ============================================================================
+// Server Lifecycle
+// ============================================================================
+
+static void stop_workers(BejServer_t* server)
+{
+    mtx_lock(&server->lock);
+    server->shutting_down = true;
+    cnd_broadcast(&server->work_ready);
+    mtx_unlock(&server->lock);
+
+    for (size_t i = 0; i < server->worker_count; i++)
+    {
+        thrd_join(server->workers[i], NULL);
+    }
+    server->worker_count = 0;
+}
+
+BejServer_t* server_create(const ServerOptions_t* options)
+{
+    if (!options || !options->socket_path || (!options->dictionaries && options->dictionary_count > 0))
+    {
+        return NULL;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(options->socket_path) >= sizeof(address.sun_path))
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Socket path too long: %s", options->socket_path);
+        return NULL;
+    }
+    strcpy(address.sun_path, options->socket_path);
+
+    BejServer_t* server = (BejServer_t*)calloc(1, sizeof(BejServer_t));
+    if (!server)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate server");
+        return NULL;
+    }
+    server->options = *options;
+    if (server->options.max_request_size == 0)
+    {
+        server->options.max_request_size = SERVER_MAX_REQUEST_SIZE;
+    }
+    server->listen_fd = -1;
+    server->epoll_fd = -1;
+    server->event_fd = -1;
+    atomic_init(&server->stop_requested, false);
+    mtx_init(&server->lock, mtx_plain);
+    cnd_init(&server->work_ready);
+
+    // A socket file left behind by an earlier run would make bind fail; anything else stays
+    struct stat existing;
+    if (lstat(options->socket_path, &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Cannot listen on %s: file exists and is not a socket",
+                         options->socket_path);
+            server_destroy(server);
+            return NULL;
+        }
+        unlink(options->socket_path);
+    }
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    bool ok = server->listen_fd >= 0 && server->epoll_fd >= 0 && server->event_fd >= 0;
+    if (ok)
+    {
+        // Created mode 0600, so only the owner can connect and have payloads decoded
+        mode_t mask = umask(0177);
+        ok = bind(server->listen_fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+        umask(mask);
+        server->socket_created = ok;
+    }
+    ok = ok && listen(server->listen_fd, SOMAXCONN) == 0;
+
+    // The listening socket and eventfd are told apart from connections by address
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &server->listen_fd;
+    ok = ok && epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &event) == 0;
+    event.data.ptr = &server->event_fd;
+    ok = ok && epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->event_fd, &event) == 0;
+    if (!ok)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Cannot listen on %s: %s",
+                     options->socket_path, strerror(errno));
+        server_destroy(server);
+        return NULL;
+    }
+
+    size_t thread_count = options->thread_count > 0 ? (size_t)options->thread_count : 0;
+    if (thread_count == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+    server->workers = (thrd_t*)malloc(thread_count * sizeof(thrd_t));
+    while (server->workers && server->worker_count < thread_count
+           && thrd_create(&server->workers[server->worker_count], server_worker, server) == thrd_success)
+    {
+        server->worker_count++;
+    }
+    if (server->worker_count == 0)
+    {
+        bej_diagnose(&options->diagnostics, BEJ_DIAG_ERROR, "Failed to start decode workers");
+        server_destroy(server);
+        return NULL;
+    }
+    return server;
+}
+
+bool server_run(BejServer_t* server)
+{
+    if (!server)
+    {
+        return false;
+    }
+
+    struct epoll_event events[64];
+    while (!atomic_load(&server->stop_requested))
+    {
+        int count = epoll_wait(server->epoll_fd, events, 64, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            bej_diagnose(&server->options.diagnostics, BEJ_DIAG_ERROR, "epoll_wait failed: %s", strerror(errno));
+            return false;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            void* source = events[i].data.ptr;
+            if (source == &server->listen_fd)
+            {
+                accept_connections(server);
+            }
+            else if (source == &server->event_fd)
+            {
+                deliver_results(server);
+            }
+            else
+            {
+                Connection_t* connection = (Connection_t*)source;
+                if (connection->closed)
+                {
+                    continue;
+                }
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    close_connection(server, connection);
+                }
+                else if (events[i].events & EPOLLOUT)
+                {
+                    service_connection(server, connection);
+                }
+                else if (events[i].events & EPOLLIN)
+                {
+                    read_connection(server, connection);
+                }
+            }
+        }
+        free_retired(server);
+    }
+    return true;
+}
+
+void server_stop(BejServer_t* server)
+{
+    if (!server) return;
+
+    // Only a lock-free store and write(): both are async-signal-safe
+    atomic_store(&server->stop_requested, true);
+    uint64_t one = 1;
+    ssize_t written = write(server->event_fd, &one, sizeof(one));
+    (void)written;
+}
+
+void server_destroy(BejServer_t* server)
+{
+    if (!server) return;
+
+    stop_workers(server);
+    free(server->workers);
+
+    // Workers are gone, so every job is either still pending or done
+    Job_t* lists[2] = {server->pending_head, server->done};
+    for (int i = 0; i < 2; i++)
+    {
+        while (lists[i])
+        {
+            Job_t* next = lists[i]->next;
+            lists[i]->connection->busy = false;
+            free(lists[i]->response);
+            free(lists[i]);
+            lists[i] = next;
+        }
+    }
+    while (server->connections)
+    {
+        Connection_t* connection = server->connections;
+        connection->busy = false;
+        if (!connection->closed)
+        {
+            close(connection->fd);
+        }
+        free_connection(server, connection);
+    }
+    free_retired(server);
+
+    if (server->listen_fd >= 0)
+    {
+        close(server->listen_fd);
+    }
+
+    // Only remove our own socket, and not whatever may have replaced it since
+    struct stat current;
+    if (server->socket_created && lstat(server->options.socket_path, &current) == 0 && S_ISSOCK(current.st_mode))
+    {
+        unlink(server->options.socket_path);
+    }
+    if (server->epoll_fd >= 0)
+    {
+        close(server->epoll_fd);
+    }
+    if (server->event_fd >= 0)
+    {
+        close(server->event_fd);
+    }
+    cnd_destroy(&server->work_ready);
+    mtx_destroy(&server->lock);
+    free(server);
+}
+
+#endif
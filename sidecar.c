@@ -0,0 +1,847 @@
+/**
+ * @file sidecar.c
+ * @author Vladyslav Kolodii
+ * @brief Sidecar offset index: where every property of many BEJ payloads is stored
+ * @version 0.1
+ * @date 2025-11-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "sidecar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Longest JSON Pointer recorded; deeper properties fail their payload
+#define BEJ_INDEX_MAX_POINTER 4096
+
+struct BejIndexBuilder
+{
+    Dictionary_t* schema_dict;
+    Dictionary_t* anno_dict;
+    BejDiagnostics_t diagnostics;
+
+    char* strings;                  // payload names and pointers, NUL-terminated
+    size_t strings_size;
+    size_t strings_capacity;
+
+    BejIndexPath_t* paths;          // in the order they were first seen
+    uint32_t path_count;
+    uint32_t path_capacity;
+    uint32_t* path_slots;           // open-addressing table of path number + 1; 0 is empty
+    uint32_t slot_count;            // power of two, at least twice path_count
+
+    BejIndexPayload_t* payloads;
+    uint64_t payload_count;
+    uint64_t payload_capacity;
+
+    BejIndexEntry_t* entries;
+    uint64_t entry_count;
+    uint64_t entry_capacity;
+
+    const uint8_t* document;        // payload being added; value offsets are relative to it
+    char pointer[BEJ_INDEX_MAX_POINTER];
+};
+
+struct BejIndex
+{
+    uint8_t* data;                  // the whole sidecar file
+    uint64_t size;
+    bool mapped;                    // data is an mmap rather than a heap buffer
+    const BejIndexHeader_t* header;
+    const BejIndexPath_t* paths;
+    const BejIndexPayload_t* payloads;
+    const BejIndexEntry_t* entries;
+    const char* strings;
+    BejDiagnostics_t diagnostics;
+};
+
+// ============================================================================
+// Builder
+// ============================================================================
+
+/// Make room for one more item in a growable array
+static bool grow_items(void** items, uint64_t* capacity, uint64_t count, size_t item_size)
+{
+    if (count < *capacity)
+    {
+        return true;
+    }
+    uint64_t grown_capacity = *capacity ? *capacity * 2 : 64;
+    if (grown_capacity > SIZE_MAX / item_size)
+    {
+        return false;
+    }
+    void* grown = realloc(*items, (size_t)grown_capacity * item_size);
+    if (!grown)
+    {
+        return false;
+    }
+    *items = grown;
+    *capacity = grown_capacity;
+    return true;
+}
+
+/// Copy a string into the pool; *offset receives where it starts
+static bool add_string(BejIndexBuilder_t* builder, const char* text, size_t length, uint32_t* offset)
+{
+    size_t needed = builder->strings_size + length + 1;
+    if (needed > UINT32_MAX)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Index string pool is full");
+        return false;
+    }
+    if (needed > builder->strings_capacity)
+    {
+        size_t capacity = builder->strings_capacity ? builder->strings_capacity : 4096;
+        while (capacity < needed)
+        {
+            capacity *= 2;
+        }
+        char* grown = (char*)realloc(builder->strings, capacity);
+        if (!grown)
+        {
+            bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index strings");
+            return false;
+        }
+        builder->strings = grown;
+        builder->strings_capacity = capacity;
+    }
+    memcpy(builder->strings + builder->strings_size, text, length);
+    builder->strings[builder->strings_size + length] = '\0';
+    *offset = (uint32_t)builder->strings_size;
+    builder->strings_size = needed;
+    return true;
+}
+
+/// FNV-1a
+static uint32_t hash_pointer(const char* text, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/// Double the path table, reinserting every path
+static bool grow_path_slots(BejIndexBuilder_t* builder)
+{
+    uint32_t slot_count = builder->slot_count ? builder->slot_count * 2 : 1024;
+    uint32_t* slots = (uint32_t*)calloc(slot_count, sizeof(uint32_t));
+    if (!slots)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < builder->path_count; i++)
+    {
+        const BejIndexPath_t* path = &builder->paths[i];
+        uint32_t slot = hash_pointer(builder->strings + path->name, path->length) & (slot_count - 1);
+        while (slots[slot])
+        {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = i + 1;
+    }
+    free(builder->path_slots);
+    builder->path_slots = slots;
+    builder->slot_count = slot_count;
+    return true;
+}
+
+/// Number of the path in builder->pointer, adding it the first time it is seen
+static bool intern_path(BejIndexBuilder_t* builder, size_t length, uint32_t* number)
+{
+    if ((uint64_t)builder->path_count * 2 >= builder->slot_count && !grow_path_slots(builder))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index paths");
+        return false;
+    }
+
+    uint32_t mask = builder->slot_count - 1;
+    uint32_t slot = hash_pointer(builder->pointer, length) & mask;
+    for (; builder->path_slots[slot]; slot = (slot + 1) & mask)
+    {
+        const BejIndexPath_t* path = &builder->paths[builder->path_slots[slot] - 1];
+        if (path->length == length && memcmp(builder->strings + path->name, builder->pointer, length) == 0)
+        {
+            *number = builder->path_slots[slot] - 1;
+            return true;
+        }
+    }
+
+    uint64_t capacity = builder->path_capacity;
+    if (builder->path_count == UINT32_MAX - 1
+        || !grow_items((void**)&builder->paths, &capacity, builder->path_count, sizeof(BejIndexPath_t)))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index paths");
+        return false;
+    }
+    builder->path_capacity = (uint32_t)capacity;
+
+    BejIndexPath_t* path = &builder->paths[builder->path_count];
+    if (!add_string(builder, builder->pointer, length, &path->name))
+    {
+        return false;
+    }
+    path->length = (uint32_t)length;
+    *number = builder->path_count++;
+    builder->path_slots[slot] = *number + 1;
+    return true;
+}
+
+/// Append one reference token to builder->pointer (RFC 6901 escaping); returns the new length
+static size_t append_token(BejIndexBuilder_t* builder, size_t length, const char* token)
+{
+    char* pointer = builder->pointer;
+    if (length + 1 >= BEJ_INDEX_MAX_POINTER)
+    {
+        return 0;
+    }
+    pointer[length++] = '/';
+    for (const char* c = token; *c; c++)
+    {
+        bool escaped = (*c == '~' || *c == '/');
+        if (length + 1 + escaped >= BEJ_INDEX_MAX_POINTER)
+        {
+            return 0;
+        }
+        if (escaped)
+        {
+            pointer[length++] = '~';
+            pointer[length++] = (*c == '~') ? '0' : '1';
+        }
+        else
+        {
+            pointer[length++] = *c;
+        }
+    }
+    return length;
+}
+
+/// Record sflv under builder->pointer[0..length), then everything below it
+static bool index_tuple(BejIndexBuilder_t* builder, const SFLV_t* sflv, Dictionary_t* dict,
+                        DictionaryEntry_t* entry, size_t length)
+{
+    uint32_t path;
+    if (!intern_path(builder, length, &path)
+        || !grow_items((void**)&builder->entries, &builder->entry_capacity, builder->entry_count, sizeof(BejIndexEntry_t)))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index entries");
+        return false;
+    }
+    BejIndexEntry_t* record = &builder->entries[builder->entry_count++];
+    record->offset = sflv->value ? (uint64_t)(sflv->value - builder->document) : 0;
+    record->length = sflv->length;
+    record->path = path;
+    record->dict_entry = entry ? (uint16_t)(entry - dict->entries) : BEJ_INDEX_NO_ENTRY;
+    record->format = sflv->format;
+    record->dict_selector = sflv->dict_selector;
+
+    if (sflv->format != BEJ_FORMAT_SET && sflv->format != BEJ_FORMAT_ARRAY)
+    {
+        return true;
+    }
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, sflv->value, sflv->length);
+    uint64_t count = 0;
+    if (sflv->length > 0 && !read_nnint_from_buffer(&reader, &count))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to read member count at %s", builder->pointer);
+        return false;
+    }
+
+    // Every array element is described by the array's single child entry (sequence 0)
+    DictionaryEntry_t* element_entry = NULL;
+    if (sflv->format == BEJ_FORMAT_ARRAY && entry && entry->child_count > 0)
+    {
+        element_entry = find_dictionary_entry(dict, entry, 0, -1);
+    }
+
+    for (uint64_t index = 0; !buffer_eof(&reader); index++)
+    {
+        SFLV_t member;
+        if (!read_sflv_header_from_buffer(&reader, &member))
+        {
+            bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to read a member of %s", builder->pointer);
+            return false;
+        }
+
+        size_t member_length;
+        Dictionary_t* member_dict = dict;
+        DictionaryEntry_t* member_entry = element_entry;
+        if (sflv->format == BEJ_FORMAT_ARRAY)
+        {
+            char token[24];
+            snprintf(token, sizeof(token), "%llu", (unsigned long long)index);
+            member_length = append_token(builder, length, token);
+        }
+        else
+        {
+            member_dict = member.dict_selector ? builder->anno_dict : builder->schema_dict;
+            member_entry = entry ? find_member_entry(builder->schema_dict, builder->anno_dict, entry, &member) : NULL;
+            if (!member_entry || !member_entry->name)
+            {
+                continue;       // cannot be asked for by name
+            }
+            member_length = append_token(builder, length, member_entry->name);
+        }
+
+        if (member_length == 0)
+        {
+            bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Property path below %s is too long", builder->pointer);
+            return false;
+        }
+        builder->pointer[member_length] = '\0';
+        bool ok = index_tuple(builder, &member, member_dict, member_entry, member_length);
+        builder->pointer[length] = '\0';
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+BejIndexBuilder_t* bej_index_builder_create(Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                                            const BejDiagnostics_t* diagnostics)
+{
+    if (!schema_dict || !schema_dict->entries || schema_dict->entry_count == 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Invalid parameters");
+        return NULL;
+    }
+
+    BejIndexBuilder_t* builder = (BejIndexBuilder_t*)calloc(1, sizeof(BejIndexBuilder_t));
+    if (!builder)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index builder");
+        return NULL;
+    }
+    builder->schema_dict = schema_dict;
+    builder->anno_dict = anno_dict;
+    if (diagnostics)
+    {
+        builder->diagnostics = *diagnostics;
+    }
+    else
+    {
+        init_diagnostics(&builder->diagnostics);
+    }
+    return builder;
+}
+
+bool bej_index_add(BejIndexBuilder_t* builder, const char* name, const uint8_t* data, uint64_t size)
+{
+    if (!builder || !name || !data)
+    {
+        return false;
+    }
+    // The reader never writes; it only shares the non-const buffer type
+    BufferReader_t reader;
+    init_buffer_reader(&reader, (uint8_t*)data, size);
+    SFLV_t root;
+    if (!read_bej_header_from_buffer(&reader, &builder->diagnostics) || !read_sflv_header_from_buffer(&reader, &root))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "%s: failed to read the root tuple", name);
+        return false;
+    }
+
+    if (!grow_items((void**)&builder->payloads, &builder->payload_capacity, builder->payload_count, sizeof(BejIndexPayload_t)))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index payloads");
+        return false;
+    }
+    BejIndexPayload_t* payload = &builder->payloads[builder->payload_count];
+    payload->first_entry = builder->entry_count;
+    payload->size = size;
+
+    // A failed payload leaves no entries behind; its name and the paths it added stay, unused
+    builder->document = data;
+    builder->pointer[0] = '\0';
+    if (!add_string(builder, name, strlen(name), &payload->name)
+        || !index_tuple(builder, &root, builder->schema_dict, &builder->schema_dict->entries[0], 0))
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "%s: not indexed", name);
+        builder->entry_count = payload->first_entry;
+        return false;
+    }
+
+    if (builder->entry_count - payload->first_entry > UINT32_MAX)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "%s: too many properties", name);
+        builder->entry_count = payload->first_entry;
+        return false;
+    }
+    payload->entry_count = (uint32_t)(builder->entry_count - payload->first_entry);
+    builder->payload_count++;
+    return true;
+}
+
+/// Path pointer text and number, for sorting the path table
+typedef struct
+{
+    const char* name;
+    uint32_t number;
+} PathOrder_t;
+
+static int compare_path_order(const void* a, const void* b)
+{
+    return strcmp(((const PathOrder_t*)a)->name, ((const PathOrder_t*)b)->name);
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+    uint32_t left = ((const BejIndexEntry_t*)a)->path;
+    uint32_t right = ((const BejIndexEntry_t*)b)->path;
+    return (left > right) - (left < right);
+}
+
+/// fwrite that reports whether everything was written
+static bool write_section(FILE* file, const void* data, size_t item_size, uint64_t count)
+{
+    return count == 0 || fwrite(data, item_size, (size_t)count, file) == count;
+}
+
+bool bej_index_write(BejIndexBuilder_t* builder, const char* path)
+{
+    if (!builder || !path)
+    {
+        return false;
+    }
+
+    // Paths are stored sorted so queries can binary-search them; entries follow the new numbering
+    PathOrder_t* order = (PathOrder_t*)malloc((builder->path_count + 1) * sizeof(PathOrder_t));
+    uint32_t* renumber = (uint32_t*)malloc((builder->path_count + 1) * sizeof(uint32_t));
+    BejIndexPath_t* sorted = (BejIndexPath_t*)malloc((builder->path_count + 1) * sizeof(BejIndexPath_t));
+    if (!order || !renumber || !sorted)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index paths");
+        free(order);
+        free(renumber);
+        free(sorted);
+        return false;
+    }
+    for (uint32_t i = 0; i < builder->path_count; i++)
+    {
+        order[i].name = builder->strings + builder->paths[i].name;
+        order[i].number = i;
+    }
+    qsort(order, builder->path_count, sizeof(PathOrder_t), compare_path_order);
+    for (uint32_t i = 0; i < builder->path_count; i++)
+    {
+        renumber[order[i].number] = i;
+        sorted[i] = builder->paths[order[i].number];
+    }
+
+    // The stored entries are renumbered in a copy, so the builder can keep adding payloads
+    BejIndexEntry_t* entries = (BejIndexEntry_t*)malloc((size_t)(builder->entry_count + 1) * sizeof(BejIndexEntry_t));
+    if (!entries)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index entries");
+        free(order);
+        free(renumber);
+        free(sorted);
+        return false;
+    }
+    for (uint64_t i = 0; i < builder->entry_count; i++)
+    {
+        entries[i] = builder->entries[i];
+        entries[i].path = renumber[entries[i].path];
+    }
+    for (uint64_t i = 0; i < builder->payload_count; i++)
+    {
+        const BejIndexPayload_t* payload = &builder->payloads[i];
+        qsort(entries + payload->first_entry, payload->entry_count, sizeof(BejIndexEntry_t), compare_entries);
+    }
+
+    BejIndexHeader_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BEJ_INDEX_MAGIC, 4);
+    header.version = BEJ_INDEX_VERSION;
+    header.schema_version = builder->schema_dict->schema_version;
+    header.schema_size = builder->schema_dict->dictionary_size;
+    header.anno_size = builder->anno_dict ? builder->anno_dict->dictionary_size : 0;
+    header.path_count = builder->path_count;
+    header.payload_count = builder->payload_count;
+    header.entry_count = builder->entry_count;
+    header.paths_offset = sizeof(header);
+    header.payloads_offset = header.paths_offset + header.path_count * sizeof(BejIndexPath_t);
+    header.entries_offset = header.payloads_offset + header.payload_count * sizeof(BejIndexPayload_t);
+    header.strings_offset = header.entries_offset + header.entry_count * sizeof(BejIndexEntry_t);
+    header.strings_size = builder->strings_size;
+
+    FILE* file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (!ok)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Cannot create index file %s", path);
+    }
+    ok = ok && write_section(file, &header, sizeof(header), 1)
+            && write_section(file, sorted, sizeof(BejIndexPath_t), header.path_count)
+            && write_section(file, builder->payloads, sizeof(BejIndexPayload_t), header.payload_count)
+            && write_section(file, entries, sizeof(BejIndexEntry_t), header.entry_count)
+            && write_section(file, builder->strings, 1, header.strings_size);
+    if (file && fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (file && !ok)
+    {
+        bej_diagnose(&builder->diagnostics, BEJ_DIAG_ERROR, "Failed to write index file %s", path);
+    }
+
+    free(order);
+    free(renumber);
+    free(sorted);
+    free(entries);
+    return ok;
+}
+
+void bej_index_builder_free(BejIndexBuilder_t* builder)
+{
+    if (!builder) return;
+
+    free(builder->strings);
+    free(builder->paths);
+    free(builder->path_slots);
+    free(builder->payloads);
+    free(builder->entries);
+    free(builder);
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+/// Whether count items of item_size fit in the file from offset on
+static bool section_fits(const BejIndex_t* index, uint64_t offset, uint64_t count, size_t item_size)
+{
+    return offset <= index->size && count <= (index->size - offset) / item_size && offset % 8 == 0;
+}
+
+/// Check everything a query relies on, once, so queries need no bounds checks of their own
+static bool validate_index(BejIndex_t* index)
+{
+    const BejIndexHeader_t* header = (const BejIndexHeader_t*)index->data;
+    if (index->size < sizeof(BejIndexHeader_t) || memcmp(header->magic, BEJ_INDEX_MAGIC, 4) != 0)
+    {
+        bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Not a BEJ index file");
+        return false;
+    }
+    if (header->version != BEJ_INDEX_VERSION)
+    {
+        bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Unsupported index version %u", header->version);
+        return false;
+    }
+    if (!section_fits(index, header->paths_offset, header->path_count, sizeof(BejIndexPath_t))
+        || !section_fits(index, header->payloads_offset, header->payload_count, sizeof(BejIndexPayload_t))
+        || !section_fits(index, header->entries_offset, header->entry_count, sizeof(BejIndexEntry_t))
+        || !section_fits(index, header->strings_offset, header->strings_size, 1)
+        || header->strings_size == 0 || index->data[header->strings_offset + header->strings_size - 1] != '\0')
+    {
+        bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Index file is truncated or corrupt");
+        return false;
+    }
+
+    index->header = header;
+    index->paths = (const BejIndexPath_t*)(index->data + header->paths_offset);
+    index->payloads = (const BejIndexPayload_t*)(index->data + header->payloads_offset);
+    index->entries = (const BejIndexEntry_t*)(index->data + header->entries_offset);
+    index->strings = (const char*)(index->data + header->strings_offset);
+
+    for (uint32_t i = 0; i < header->path_count; i++)
+    {
+        if (index->paths[i].name >= header->strings_size)
+        {
+            bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Index path %u is corrupt", i);
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header->payload_count; i++)
+    {
+        const BejIndexPayload_t* payload = &index->payloads[i];
+        if (payload->name >= header->strings_size || payload->first_entry > header->entry_count
+            || payload->entry_count > header->entry_count - payload->first_entry)
+        {
+            bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Index payload %llu is corrupt", (unsigned long long)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+BejIndex_t* bej_index_open(const char* path, const BejDiagnostics_t* diagnostics)
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    BejIndex_t* index = (BejIndex_t*)calloc(1, sizeof(BejIndex_t));
+    if (!index)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to allocate index");
+        return NULL;
+    }
+    if (diagnostics)
+    {
+        index->diagnostics = *diagnostics;
+    }
+    else
+    {
+        init_diagnostics(&index->diagnostics);
+    }
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open index file %s", path);
+        if (fd >= 0) close(fd);
+        free(index);
+        return NULL;
+    }
+    index->size = (uint64_t)info.st_size;
+    void* mapping = index->size > 0 ? mmap(NULL, (size_t)index->size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot map index file %s", path);
+        free(index);
+        return NULL;
+    }
+    index->data = (uint8_t*)mapping;
+    index->mapped = true;
+#else
+    size_t capacity = 0;
+    if (!read_file_into_buffer(path, &index->data, &capacity, &index->size, diagnostics))
+    {
+        free(index);
+        return NULL;
+    }
+#endif
+
+    if (!validate_index(index))
+    {
+        bej_index_close(index);
+        return NULL;
+    }
+    return index;
+}
+
+void bej_index_close(BejIndex_t* index)
+{
+    if (!index) return;
+
+#ifndef _WIN32
+    if (index->mapped)
+    {
+        munmap(index->data, (size_t)index->size);
+        index->data = NULL;
+    }
+#endif
+    free(index->data);
+    free(index);
+}
+
+uint64_t bej_index_payload_count(const BejIndex_t* index)
+{
+    return index ? index->header->payload_count : 0;
+}
+
+const char* bej_index_payload_name(const BejIndex_t* index, uint64_t payload)
+{
+    if (!index || payload >= index->header->payload_count)
+    {
+        return NULL;
+    }
+    return index->strings + index->payloads[payload].name;
+}
+
+bool bej_index_find_path(const BejIndex_t* index, const char* pointer, uint32_t* path)
+{
+    if (!index || !pointer || !path)
+    {
+        return false;
+    }
+
+    uint32_t low = 0;
+    uint32_t high = index->header->path_count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        int order = strcmp(index->strings + index->paths[middle].name, pointer);
+        if (order == 0)
+        {
+            *path = middle;
+            return true;
+        }
+        if (order < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+const BejIndexEntry_t* bej_index_lookup(const BejIndex_t* index, uint64_t payload, uint32_t path)
+{
+    if (!index || payload >= index->header->payload_count)
+    {
+        return NULL;
+    }
+
+    const BejIndexEntry_t* entries = index->entries + index->payloads[payload].first_entry;
+    uint32_t low = 0;
+    uint32_t high = index->payloads[payload].entry_count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (entries[middle].path == path)
+        {
+            return &entries[middle];
+        }
+        if (entries[middle].path < path)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+/// Read length bytes at offset of a payload file whose size must still be expected_size
+static bool read_payload_range(const char* name, uint64_t expected_size, uint64_t offset, uint64_t length,
+                               uint8_t* buffer, const BejDiagnostics_t* diagnostics)
+{
+    bool ok = false;
+#ifndef _WIN32
+    int fd = open(name, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open %s", name);
+    }
+    else if ((uint64_t)info.st_size != expected_size)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "%s changed since it was indexed", name);
+    }
+    else
+    {
+        uint64_t done = 0;
+        while (done < length)
+        {
+            ssize_t got = pread(fd, buffer + done, (size_t)(length - done), (off_t)(offset + done));
+            if (got <= 0)
+            {
+                break;
+            }
+            done += (uint64_t)got;
+        }
+        ok = done == length;
+        if (!ok)
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read %s", name);
+        }
+    }
+    if (fd >= 0) close(fd);
+#else
+    FILE* file = fopen(name, "rb");
+    if (!file)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Cannot open %s", name);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    if ((uint64_t)ftell(file) != expected_size)
+    {
+        bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "%s changed since it was indexed", name);
+    }
+    else
+    {
+        ok = fseek(file, (long)offset, SEEK_SET) == 0 && fread(buffer, 1, (size_t)length, file) == length;
+        if (!ok)
+        {
+            bej_diagnose(diagnostics, BEJ_DIAG_ERROR, "Failed to read %s", name);
+        }
+    }
+    fclose(file);
+#endif
+    return ok;
+}
+
+bool bej_index_read(const BejIndex_t* index, uint64_t payload, uint32_t path,
+                    Dictionary_t* schema_dict, Dictionary_t* anno_dict,
+                    uint8_t** buffer, size_t* capacity, BejValue_t* value)
+{
+    if (!index || !schema_dict || !buffer || !capacity || !value)
+    {
+        return false;
+    }
+
+    // Dictionary entry numbers are only meaningful for the dictionaries the index was built with
+    const BejIndexHeader_t* header = index->header;
+    if (schema_dict->schema_version != header->schema_version || schema_dict->dictionary_size != header->schema_size
+        || (anno_dict ? anno_dict->dictionary_size : 0) != header->anno_size)
+    {
+        bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Index was built with different dictionaries");
+        return false;
+    }
+
+    const BejIndexEntry_t* entry = bej_index_lookup(index, payload, path);
+    if (!entry)
+    {
+        return false;
+    }
+    if ((size_t)entry->length != entry->length)
+    {
+        return false;
+    }
+    if (entry->length > *capacity || !*buffer)
+    {
+        size_t grown_capacity = entry->length > 0 ? (size_t)entry->length : 1;
+        uint8_t* grown = (uint8_t*)realloc(*buffer, grown_capacity);
+        if (!grown)
+        {
+            bej_diagnose(&index->diagnostics, BEJ_DIAG_ERROR, "Failed to allocate read buffer");
+            return false;
+        }
+        *buffer = grown;
+        *capacity = grown_capacity;
+    }
+
+    const BejIndexPayload_t* record = &index->payloads[payload];
+    if (!read_payload_range(index->strings + record->name, record->size, entry->offset, entry->length,
+                            *buffer, &index->diagnostics))
+    {
+        return false;
+    }
+
+    Dictionary_t* dict = entry->dict_selector ? anno_dict : schema_dict;
+    DictionaryEntry_t* dict_entry = NULL;
+    if (dict && entry->dict_entry != BEJ_INDEX_NO_ENTRY && entry->dict_entry < dict->entry_count)
+    {
+        dict_entry = &dict->entries[entry->dict_entry];
+    }
+    SFLV_t sflv = {0, entry->dict_selector, entry->format, entry->length, entry->length ? *buffer : NULL};
+    return bej_value_from_sflv(&sflv, dict, dict_entry, value, &index->diagnostics);
+}
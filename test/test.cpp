@@ -9,9 +9,34 @@
  * 
  */
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
 extern "C" {
 #include "decode.h"
+#include "batch.h"
+#include "batch_io.h"
+#include "pipeline.h"
+#include "server.h"
+#include "sidecar.h"
+#include "filter.h"
+#include "aggregate.h"
+#include "plan.h"
+#include "encode.h"
 }
+#include "bej_async.hpp"
+#include "bej_pmr.hpp"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 // -------------------------
 // Utility Function Tests
@@ -52,18 +77,45 @@ TEST(NNINTTests, ReadNNINTFromBuffer_ValidCases)
     BufferReader_t reader;
     init_buffer_reader(&reader, buf, sizeof(buf));
 
-    uint32_t val = 0;
+    uint64_t val = 0;
+    EXPECT_TRUE(read_nnint_from_buffer(&reader, &val));
+    EXPECT_EQ(val, 0x3412u);
+}
+
+TEST(NNINTTests, ReadNNINTFromBuffer_WideValues) 
+{
+    // 5 and 8 byte NNINTs, each read once with trailing bytes (8-byte load)
+    // and once at the very end of the buffer
+    uint8_t five[] = {5, 0x01, 0x02, 0x03, 0x04, 0x05, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE, 0xEE};
+    uint8_t eight[] = {8, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x88};
+    uint64_t val = 0;
+
+    BufferReader_t reader;
+    init_buffer_reader(&reader, five, sizeof(five));
+    EXPECT_TRUE(read_nnint_from_buffer(&reader, &val));
+    EXPECT_EQ(val, 0x0504030201ull);
+    EXPECT_EQ(reader.position, 6u);
+
+    init_buffer_reader(&reader, five, 6);
+    EXPECT_TRUE(read_nnint_from_buffer(&reader, &val));
+    EXPECT_EQ(val, 0x0504030201ull);
+    EXPECT_TRUE(buffer_eof(&reader));
+
+    init_buffer_reader(&reader, eight, sizeof(eight));
     EXPECT_TRUE(read_nnint_from_buffer(&reader, &val));
-    EXPECT_EQ(val, 0x3412);
+    EXPECT_EQ(val, 0x8807060504030201ull);
+
+    init_buffer_reader(&reader, eight, sizeof(eight) - 1);
+    EXPECT_FALSE(read_nnint_from_buffer(&reader, &val));
 }
 
 TEST(NNINTTests, ReadNNINTFromBuffer_InvalidLength) 
 {
-    uint8_t buf[] = {5, 0xAA}; // invalid length (5 > 4)
+    uint8_t buf[] = {9, 0xAA, 0, 0, 0, 0, 0, 0, 0, 0}; // invalid length (9 > 8)
     BufferReader_t reader;
     init_buffer_reader(&reader, buf, sizeof(buf));
 
-    uint32_t val;
+    uint64_t val;
     EXPECT_FALSE(read_nnint_from_buffer(&reader, &val));
 }
 
@@ -91,6 +143,27 @@ TEST(SFLVTests, ReadSFLVFromBuffer_Basic)
     free_sflv(&sflv);
 }
 
+TEST(SFLVTests, ReadSFLVHeaderFromBuffer_WideFields) 
+{
+    // A 5-byte length is accepted but must still fit the buffer
+    uint8_t overrun[] = {1, 0x04, 0x30, 5, 0x00, 0x00, 0x00, 0x00, 0x01, 0xAA};
+    BufferReader_t reader;
+    init_buffer_reader(&reader, overrun, sizeof(overrun));
+    SFLV_t sflv;
+    EXPECT_FALSE(read_sflv_header_from_buffer(&reader, &sflv));
+
+    // Sequence numbers wider than 32 bits are rejected
+    uint8_t wide_sequence[] = {5, 0x00, 0x00, 0x00, 0x00, 0x02, 0x30, 1, 0x01, 0xAA};
+    init_buffer_reader(&reader, wide_sequence, sizeof(wide_sequence));
+    EXPECT_FALSE(read_sflv_header_from_buffer(&reader, &sflv));
+
+    uint8_t five_byte_length[] = {1, 0x04, 0x30, 5, 0x01, 0x00, 0x00, 0x00, 0x00, 0xAA};
+    init_buffer_reader(&reader, five_byte_length, sizeof(five_byte_length));
+    ASSERT_TRUE(read_sflv_header_from_buffer(&reader, &sflv));
+    EXPECT_EQ(sflv.length, 1u);
+    EXPECT_EQ(sflv.value[0], 0xAA);
+}
+
 // -------------------------
 // Decode Logic Tests
 // -------------------------
@@ -154,12 +227,53 @@ TEST(DecodeTests, DecodeString_Basic)
 }
 
 // -------------------------
-// Decode Dispatcher Test
+// Base64 Tests
 // -------------------------
 
-TEST(DecodeTests, DecodeValue_DispatchInteger) 
+TEST(Base64Tests, Encode_RFC4648Vectors) 
 {
-    SFLV_t sflv = {0, 0, BEJ_FORMAT_INTEGER, 1, new uint8_t[1]{0x2A}};
+    const char* inputs[]   = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* expected[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) 
+    {
+        char out[16] = {0};
+        size_t written = base64_encode((const uint8_t*)inputs[i], strlen(inputs[i]), out);
+        EXPECT_EQ(written, strlen(expected[i]));
+        EXPECT_STREQ(out, expected[i]);
+    }
+}
+
+TEST(Base64Tests, Encode_LargeBufferMatchesBlockwise) 
+{
+    // Long enough to exercise the vector path and every tail length
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++) 
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    for (size_t length = 0; length <= data.size(); length += 37) 
+    {
+        std::string whole(4 * ((length + 2) / 3), '\0');
+        EXPECT_EQ(base64_encode(data.data(), length, &whole[0]), whole.size());
+
+        // Encoding 3-byte groups one at a time must give the same text
+        std::string pieces;
+        for (size_t i = 0; i < length; i += 3) 
+        {
+            char out[4];
+            size_t n = base64_encode(data.data() + i, std::min<size_t>(3, length - i), out);
+            pieces.append(out, n);
+        }
+        EXPECT_EQ(whole, pieces);
+    }
+}
+
+TEST(DecodeTests, DecodeByteString_Base64) 
+{
+    uint8_t bytes[] = {0xDE, 0xAD, 0xBE, 0xEF};
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_BYTE_STRING, 4, bytes};
     DecoderContext_t ctx;
     FILE* out = tmpfile();
     init_decoder_context(&ctx, nullptr, nullptr, nullptr, out);
@@ -167,10 +281,2621 @@ TEST(DecodeTests, DecodeValue_DispatchInteger)
     EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
     rewind(out);
 
-    char buf[32];
-    fread(buf, 1, sizeof(buf), out);
+    char buf[32] = {0};
+    fread(buf, 1, sizeof(buf) - 1, out);
     fclose(out);
-    delete[] sflv.value;
+    EXPECT_STREQ(buf, "\"3q2+7w==\"");
+}
 
-    EXPECT_NE(strstr(buf, "42"), nullptr);
-}
\ No newline at end of file
+// -------------------------
+// Transcoder Tests
+// -------------------------
+
+// SET { seq 0: INTEGER 42, seq 1: STRING "Hi" } with no dictionaries attached
+static uint8_t g_small_set[] = {
+    1, 2,                         // member count
+    1, 0x00, 0x30, 1, 1, 0x2A,    // seq 0, INTEGER, length 1, 42
+    1, 0x02, 0x50, 1, 2, 'H', 'i' // seq 1, STRING, length 2, "Hi"
+};
+
+static std::vector<uint8_t> transcode_small_set(BejOutputFormat_t format)
+{
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_SET, sizeof(g_small_set), g_small_set};
+    DecoderContext_t ctx;
+    FILE* out = tmpfile();
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, out);
+    ctx.output_format = format;
+
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    long size = ftell(out);
+    rewind(out);
+
+    std::vector<uint8_t> bytes(size);
+    fread(bytes.data(), 1, bytes.size(), out);
+    fclose(out);
+    return bytes;
+}
+
+TEST(TranscodeTests, SetToCBOR) 
+{
+    std::vector<uint8_t> expected = {
+        0xA2,
+        0x65, 's', 'e', 'q', '_', '0', 0x18, 0x2A,
+        0x65, 's', 'e', 'q', '_', '1', 0x62, 'H', 'i'
+    };
+    EXPECT_EQ(transcode_small_set(BEJ_OUTPUT_CBOR), expected);
+}
+
+TEST(TranscodeTests, SetToMessagePack) 
+{
+    std::vector<uint8_t> expected = {
+        0x82,
+        0xA5, 's', 'e', 'q', '_', '0', 0x2A,
+        0xA5, 's', 'e', 'q', '_', '1', 0xA2, 'H', 'i'
+    };
+    EXPECT_EQ(transcode_small_set(BEJ_OUTPUT_MSGPACK), expected);
+}
+
+TEST(TranscodeTests, NegativeIntegers) 
+{
+    uint8_t bytes[] = {0x18, 0xFC}; // -1000
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_INTEGER, 2, bytes};
+    DecoderContext_t ctx;
+    FILE* out = tmpfile();
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, out);
+
+    ctx.output_format = BEJ_OUTPUT_CBOR;
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    ctx.output_format = BEJ_OUTPUT_MSGPACK;
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    rewind(out);
+
+    uint8_t buf[6] = {0};
+    EXPECT_EQ(fread(buf, 1, sizeof(buf), out), 6u);
+    fclose(out);
+
+    const uint8_t expected[] = {0x39, 0x03, 0xE7, 0xD1, 0xFC, 0x18};
+    EXPECT_EQ(memcmp(buf, expected, sizeof(expected)), 0);
+}
+
+TEST(TranscodeTests, EmptyStringValue) 
+{
+    // A zero-length STRING tuple has no value bytes to point at
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 7,
+        1, 1,
+        1, 0x00, 0x50, 1, 0
+    };
+    const BejOutputFormat_t formats[] = {BEJ_OUTPUT_CBOR, BEJ_OUTPUT_MSGPACK};
+    const std::vector<uint8_t> expected[] = {
+        {0xA1, 0x65, 's', 'e', 'q', '_', '0', 0x60},
+        {0x81, 0xA5, 's', 'e', 'q', '_', '0', 0xA0}
+    };
+    for (size_t i = 0; i < 2; i++) 
+    {
+        BejDecodeOptions_t options;
+        init_decode_options(&options);
+        options.format = formats[i];
+        uint8_t* output = nullptr;
+        size_t output_size = 0;
+        ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                         &options, &output, &output_size));
+        EXPECT_EQ(std::vector<uint8_t>(output, output + output_size), expected[i]);
+        free(output);
+    }
+}
+
+// -------------------------
+// Sizing / In-Memory Decode Tests
+// -------------------------
+
+/// Header (version 1.0.0, no flags, major schema class) + root SET holding g_small_set
+static std::vector<uint8_t> small_set_document()
+{
+    std::vector<uint8_t> document = {0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00};
+    const uint8_t root[] = {1, 0x00, 0x00, 1, sizeof(g_small_set)};
+    document.insert(document.end(), root, root + sizeof(root));
+    document.insert(document.end(), g_small_set, g_small_set + sizeof(g_small_set));
+    return document;
+}
+
+
+TEST(MeasureTests, MeasureMatchesDecodedSize) 
+{
+    // Escapes and base64 change the output length relative to the input
+    uint8_t text[] = {'a', '"', '\n', 0x01, 'z'};
+    uint8_t blob[] = {1, 2, 3, 4, 5, 6, 7};
+    SFLV_t values[] = {
+        {0, 0, BEJ_FORMAT_SET, sizeof(g_small_set), g_small_set},
+        {0, 0, BEJ_FORMAT_STRING, sizeof(text), text},
+        {0, 0, BEJ_FORMAT_BYTE_STRING, sizeof(blob), blob},
+    };
+    const BejOutputFormat_t formats[] = {BEJ_OUTPUT_JSON, BEJ_OUTPUT_CBOR, BEJ_OUTPUT_MSGPACK};
+
+    for (BejOutputFormat_t format : formats) 
+    {
+        for (SFLV_t& sflv : values) 
+        {
+            DecoderContext_t ctx;
+            init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+            ctx.output_format = format;
+
+            size_t measured = 0;
+            EXPECT_TRUE(measure_value(&ctx, &sflv, nullptr, &measured));
+
+            set_output_buffer(&ctx, nullptr, 0);
+            EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+            EXPECT_EQ(measured, ctx.output_length);
+            free(ctx.output_buffer);
+        }
+    }
+}
+
+TEST(MeasureTests, DecodeToMemory_NulTerminated) 
+{
+    std::vector<uint8_t> document = small_set_document();
+
+    uint8_t* output = nullptr;
+    size_t output_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     nullptr, &output, &output_size));
+
+    EXPECT_STREQ((const char*)output, "{\n\t\"seq_0\": 42,\n\t\"seq_1\": \"Hi\"\n}");
+    EXPECT_EQ(output_size, strlen((const char*)output));
+    free(output);
+}
+
+// -------------------------
+// NDJSON Tests
+// -------------------------
+
+TEST(NDJSONTests, CompactSet) 
+{
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_SET, sizeof(g_small_set), g_small_set};
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.compact = true;
+    set_output_buffer(&ctx, nullptr, 0);
+
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    EXPECT_EQ(std::string((const char*)ctx.output_buffer, ctx.output_length),
+              "{\"seq_0\":42,\"seq_1\":\"Hi\"}");
+    free(ctx.output_buffer);
+}
+
+TEST(NDJSONTests, OneLinePerRecordAndBadFilesSkipped) 
+{
+    const char* good_path = "ndjson_test_record.bin";
+    std::vector<uint8_t> document = small_set_document();
+    FILE* fp = fopen(good_path, "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(document.data(), 1, document.size(), fp);
+    fclose(fp);
+
+    const char* inputs[] = {good_path, "ndjson_test_missing.bin", good_path};
+    FILE* out = tmpfile();
+    size_t decoded = 0;
+    EXPECT_FALSE(bej_decode_files_ndjson(inputs, 3, out, nullptr, nullptr, &decoded, nullptr));
+    EXPECT_EQ(decoded, 2u);
+
+    rewind(out);
+    char buf[128] = {0};
+    fread(buf, 1, sizeof(buf) - 1, out);
+    fclose(out);
+    remove(good_path);
+
+    EXPECT_STREQ(buf, "{\"seq_0\":42,\"seq_1\":\"Hi\"}\n{\"seq_0\":42,\"seq_1\":\"Hi\"}\n");
+}
+
+// -------------------------
+// Batch Decode Tests
+// -------------------------
+
+TEST(BatchTests, MakeOutputPath) 
+{
+    char out[128];
+    EXPECT_TRUE(make_output_path("dir.v1/record.bin", nullptr, BEJ_OUTPUT_JSON, out, sizeof(out)));
+    EXPECT_STREQ(out, "dir.v1/record.json");
+    EXPECT_TRUE(make_output_path("dir.v1/record", nullptr, BEJ_OUTPUT_CBOR, out, sizeof(out)));
+    EXPECT_STREQ(out, "dir.v1/record.cbor");
+    EXPECT_TRUE(make_output_path("in/record.bin", "out", BEJ_OUTPUT_MSGPACK, out, sizeof(out)));
+    EXPECT_STREQ(out, "out/record.msgpack");
+    EXPECT_FALSE(make_output_path("record.bin", nullptr, BEJ_OUTPUT_JSON, out, 8));
+}
+
+TEST(BatchTests, MultiThreadedNDJSON) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    BatchFileList_t files;
+    init_file_list(&files);
+
+    for (int i = 0; i < 16; i++) 
+    {
+        std::string path = "batch_test_record_" + std::to_string(i) + ".bin";
+        FILE* fp = fopen(path.c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        fwrite(document.data(), 1, document.size(), fp);
+        fclose(fp);
+        ASSERT_TRUE(file_list_add(&files, path.c_str()));
+    }
+    ASSERT_TRUE(file_list_add(&files, "batch_test_missing.bin"));
+
+    FILE* out = tmpfile();
+    BatchOptions_t options = {nullptr, nullptr, BEJ_OUTPUT_JSON, nullptr, out, 4, {}, BATCH_IO_AUTO, 0};
+    BatchStats_t stats;
+    EXPECT_FALSE(bej_decode_batch(&files, &options, &stats));
+    EXPECT_EQ(stats.files_total, 17u);
+    EXPECT_EQ(stats.files_ok, 16u);
+    EXPECT_EQ(stats.files_failed, 1u);
+    EXPECT_EQ(stats.bytes_in, 16u * document.size());
+
+    // Every record is written whole, one per line
+    rewind(out);
+    char line[128];
+    int lines = 0;
+    while (fgets(line, sizeof(line), out)) 
+    {
+        EXPECT_STREQ(line, "{\"seq_0\":42,\"seq_1\":\"Hi\"}\n");
+        lines++;
+    }
+    fclose(out);
+    EXPECT_EQ(lines, 16);
+
+    for (size_t i = 0; i + 1 < files.count; i++) 
+    {
+        remove(files.paths[i]);
+    }
+    free_file_list(&files);
+}
+
+/// Decode `count` copies of the small document with the given I/O backend; returns the outputs read back
+static std::vector<std::string> decode_with_backend(BatchIoBackend_t backend, int count, BatchStats_t* stats, bool* ok)
+{
+    std::vector<uint8_t> document = small_set_document();
+    BatchFileList_t files;
+    init_file_list(&files);
+    for (int i = 0; i < count; i++) 
+    {
+        std::string path = "batch_io_record_" + std::to_string(i) + ".bin";
+        FILE* fp = fopen(path.c_str(), "wb");
+        fwrite(document.data(), 1, document.size(), fp);
+        fclose(fp);
+        file_list_add(&files, path.c_str());
+    }
+    file_list_add(&files, "batch_io_missing.bin");
+
+    // A shallow queue forces several submission windows
+    BatchOptions_t options = {nullptr, nullptr, BEJ_OUTPUT_CBOR, nullptr, nullptr, 2, {}, backend, 4};
+    *ok = bej_decode_batch(&files, &options, stats);
+
+    std::vector<std::string> outputs;
+    for (int i = 0; i < count; i++) 
+    {
+        std::string path = "batch_io_record_" + std::to_string(i) + ".cbor";
+        std::string content;
+        FILE* fp = fopen(path.c_str(), "rb");
+        if (fp) 
+        {
+            char buf[256];
+            size_t length = fread(buf, 1, sizeof(buf), fp);
+            content.assign(buf, length);
+            fclose(fp);
+        }
+        outputs.push_back(content);
+        remove(path.c_str());
+        remove(files.paths[i]);
+    }
+    free_file_list(&files);
+    return outputs;
+}
+
+TEST(BatchTests, UringBackendKeepsNdjsonOrderAcrossWindows) 
+{
+    if (!batch_io_uring_supported()) 
+    {
+        GTEST_SKIP() << "io_uring not available";
+    }
+
+    // Each file holds a different integer, so any reordering shows
+    BatchFileList_t files;
+    init_file_list(&files);
+    const int count = 37;
+    for (int i = 0; i < count; i++) 
+    {
+        std::vector<uint8_t> document = small_set_document();
+        document[19] = (uint8_t)i;
+        std::string path = "batch_uring_order_" + std::to_string(i) + ".bin";
+        FILE* fp = fopen(path.c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        fwrite(document.data(), 1, document.size(), fp);
+        fclose(fp);
+        ASSERT_TRUE(file_list_add(&files, path.c_str()));
+    }
+
+    FILE* out = tmpfile();
+    BatchOptions_t options = {nullptr, nullptr, BEJ_OUTPUT_JSON, nullptr, out, 4, {}, BATCH_IO_URING, 3};
+    BatchStats_t stats;
+    EXPECT_TRUE(bej_decode_batch(&files, &options, &stats));
+    EXPECT_EQ(stats.files_ok, (size_t)count);
+
+    rewind(out);
+    char line[128];
+    int lines = 0;
+    while (fgets(line, sizeof(line), out)) 
+    {
+        EXPECT_EQ(std::string(line), "{\"seq_0\":" + std::to_string(lines) + ",\"seq_1\":\"Hi\"}\n");
+        lines++;
+    }
+    fclose(out);
+    EXPECT_EQ(lines, count);
+
+    for (size_t i = 0; i < files.count; i++) 
+    {
+        remove(files.paths[i]);
+    }
+    free_file_list(&files);
+}
+
+TEST(BatchTests, PreadBackendWritesEveryFile) 
+{
+    BatchStats_t stats;
+    bool ok = true;
+    std::vector<std::string> outputs = decode_with_backend(BATCH_IO_PREAD, 10, &stats, &ok);
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(stats.files_ok, 10u);
+    EXPECT_EQ(stats.files_failed, 1u);
+
+    std::vector<uint8_t> expected = transcode_small_set(BEJ_OUTPUT_CBOR);
+    for (const std::string& output : outputs) 
+    {
+        EXPECT_EQ(output, std::string(expected.begin(), expected.end()));
+    }
+}
+
+TEST(BatchTests, UringBackendMatchesPread) 
+{
+    if (!batch_io_uring_supported()) 
+    {
+        GTEST_SKIP() << "io_uring not available";
+    }
+
+    BatchStats_t pread_stats;
+    BatchStats_t uring_stats;
+    bool pread_ok = true;
+    bool uring_ok = true;
+    std::vector<std::string> pread_outputs = decode_with_backend(BATCH_IO_PREAD, 10, &pread_stats, &pread_ok);
+    std::vector<std::string> uring_outputs = decode_with_backend(BATCH_IO_URING, 10, &uring_stats, &uring_ok);
+    EXPECT_FALSE(uring_ok);
+    EXPECT_EQ(uring_stats.files_ok, pread_stats.files_ok);
+    EXPECT_EQ(uring_stats.bytes_in, pread_stats.bytes_in);
+    EXPECT_EQ(uring_stats.bytes_out, pread_stats.bytes_out);
+    EXPECT_EQ(uring_outputs, pread_outputs);
+}
+
+// -------------------------
+// Parallel Decode Tests
+// -------------------------
+
+/// SET of `count` members: even sequences hold INTEGERs, odd ones hold an ARRAY of two STRINGs
+static std::vector<uint8_t> large_set_value(uint32_t count)
+{
+    std::vector<uint8_t> value = {2, (uint8_t)count, (uint8_t)(count >> 8)};
+    for (uint32_t i = 0; i < count; i++) 
+    {
+        uint32_t sequence = i << 1;
+        value.insert(value.end(), {2, (uint8_t)sequence, (uint8_t)(sequence >> 8)});
+        if (i % 2 == 0) 
+        {
+            value.insert(value.end(), {0x30, 1, 2, (uint8_t)i, (uint8_t)(i >> 8)});
+        }
+        else 
+        {
+            value.insert(value.end(), {0x10, 1, 14, 1, 2,
+                                       1, 0x00, 0x50, 1, 2, 'a', '"',
+                                       1, 0x02, 0x50, 1, 0});
+        }
+    }
+    return value;
+}
+
+static std::string decode_with_threads(std::vector<uint8_t>& value, BejOutputFormat_t format,
+                                       bool compact, int threads)
+{
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_SET, (uint32_t)value.size(), value.data()};
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.output_format = format;
+    ctx.compact = compact;
+    ctx.parallel_threads = threads;
+    ctx.parallel_min_members = 64;
+
+    size_t measured = 0;
+    EXPECT_TRUE(measure_value(&ctx, &sflv, nullptr, &measured));
+
+    set_output_buffer(&ctx, nullptr, 0);
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    EXPECT_EQ(measured, ctx.output_length);
+
+    std::string out((const char*)ctx.output_buffer, ctx.output_length);
+    free(ctx.output_buffer);
+    return out;
+}
+
+TEST(ParallelTests, MatchesSerialOutput) 
+{
+    std::vector<uint8_t> value = large_set_value(3000);
+    const BejOutputFormat_t formats[] = {BEJ_OUTPUT_JSON, BEJ_OUTPUT_CBOR, BEJ_OUTPUT_MSGPACK};
+
+    for (BejOutputFormat_t format : formats) 
+    {
+        for (bool compact : {false, true}) 
+        {
+            std::string serial = decode_with_threads(value, format, compact, 0);
+            EXPECT_EQ(decode_with_threads(value, format, compact, 4), serial);
+            EXPECT_EQ(decode_with_threads(value, format, compact, 3), serial);
+        }
+    }
+}
+
+TEST(ParallelTests, TruncatedMemberFails) 
+{
+    std::vector<uint8_t> value = large_set_value(200);
+    value.resize(value.size() - 3);
+
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_SET, (uint32_t)value.size(), value.data()};
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.parallel_threads = 4;
+    ctx.parallel_min_members = 64;
+    set_output_buffer(&ctx, nullptr, 0);
+
+    EXPECT_FALSE(decode_value(&ctx, &sflv, nullptr));
+    free(ctx.output_buffer);
+}
+
+// -------------------------
+// Push Parser Tests
+// -------------------------
+
+/// Header + root SET holding `value`, with a 2-byte root length
+static std::vector<uint8_t> document_with_root_set(const std::vector<uint8_t>& value)
+{
+    std::vector<uint8_t> document = {0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+                                     1, 0x00, 0x00, 2, (uint8_t)value.size(), (uint8_t)(value.size() >> 8)};
+    document.insert(document.end(), value.begin(), value.end());
+    return document;
+}
+
+/// Push `document` through a parser in chunks of `chunk_size` bytes
+static std::string push_decode(const std::vector<uint8_t>& document, size_t chunk_size,
+                               BejOutputFormat_t format, bool* ok)
+{
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.output_format = format;
+    set_output_buffer(&ctx, nullptr, 0);
+
+    BejPushParser_t* parser = bej_push_create(&ctx);
+    *ok = parser != nullptr;
+    for (size_t position = 0; *ok && position < document.size(); position += chunk_size) 
+    {
+        size_t count = std::min(chunk_size, document.size() - position);
+        *ok = bej_feed(parser, document.data() + position, count);
+    }
+    *ok = *ok && bej_finish(parser);
+    bej_push_free(parser);
+
+    std::string out((const char*)ctx.output_buffer, ctx.output_length);
+    free(ctx.output_buffer);
+    return out;
+}
+
+TEST(PushParserTests, AnyChunkingMatchesBufferDecode) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(100));
+    const BejOutputFormat_t formats[] = {BEJ_OUTPUT_JSON, BEJ_OUTPUT_CBOR, BEJ_OUTPUT_MSGPACK};
+
+    for (BejOutputFormat_t format : formats) 
+    {
+        DecoderContext_t ctx;
+        init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+        ctx.output_format = format;
+        set_output_buffer(&ctx, nullptr, 0);
+        ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), (uint32_t)document.size()));
+        std::string expected((const char*)ctx.output_buffer, ctx.output_length);
+        free(ctx.output_buffer);
+
+        for (size_t chunk_size : {(size_t)1, (size_t)3, (size_t)64, document.size()}) 
+        {
+            bool ok = false;
+            EXPECT_EQ(push_decode(document, chunk_size, format, &ok), expected);
+            EXPECT_TRUE(ok);
+        }
+    }
+}
+
+TEST(PushParserTests, EmitsOutputBeforeDocumentIsComplete) 
+{
+    std::vector<uint8_t> document = small_set_document();
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    set_output_buffer(&ctx, nullptr, 0);
+    BejPushParser_t* parser = bej_push_create(&ctx);
+    ASSERT_NE(parser, nullptr);
+
+    // Everything but the last byte: the first member and the second's name are out already
+    EXPECT_TRUE(bej_feed(parser, document.data(), document.size() - 1));
+    EXPECT_EQ(std::string((const char*)ctx.output_buffer, ctx.output_length),
+              "{\n\t\"seq_0\": 42,\n\t\"seq_1\": ");
+
+    EXPECT_TRUE(bej_feed(parser, document.data() + document.size() - 1, 1));
+    EXPECT_TRUE(bej_finish(parser));
+    EXPECT_EQ(std::string((const char*)ctx.output_buffer, ctx.output_length),
+              "{\n\t\"seq_0\": 42,\n\t\"seq_1\": \"Hi\"\n}");
+
+    bej_push_free(parser);
+    free(ctx.output_buffer);
+}
+
+TEST(PushParserTests, TruncatedAndMalformedDocumentsFail) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(10));
+    bool ok = true;
+
+    std::vector<uint8_t> truncated(document.begin(), document.end() - 5);
+    push_decode(truncated, 7, BEJ_OUTPUT_JSON, &ok);
+    EXPECT_FALSE(ok);
+
+    // Member length running past the end of the root SET
+    std::vector<uint8_t> overrun = document;
+    overrun[BEJ_HEADER_SIZE + 6 + 3 + 3 + 2] = 0xF0;
+    push_decode(overrun, 7, BEJ_OUTPUT_JSON, &ok);
+    EXPECT_FALSE(ok);
+}
+
+/// decode_bej_to_json() on `document` served from a temporary file
+static bool stream_decode(const std::vector<uint8_t>& document, uint32_t max_value_length, std::string* out)
+{
+    FILE* input = tmpfile();
+    fwrite(document.data(), 1, document.size(), input);
+    rewind(input);
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, input, nullptr);
+    ctx.max_value_length = max_value_length;
+    set_output_buffer(&ctx, nullptr, 0);
+    bool ok = decode_bej_to_json(&ctx);
+    fclose(input);
+
+    *out = std::string((const char*)ctx.output_buffer, ctx.output_length);
+    free(ctx.output_buffer);
+    return ok;
+}
+
+TEST(PushParserTests, StreamDecodeMatchesBufferDecode) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    set_output_buffer(&ctx, nullptr, 0);
+    ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), (uint32_t)document.size()));
+    std::string expected((const char*)ctx.output_buffer, ctx.output_length);
+    free(ctx.output_buffer);
+
+    std::string streamed;
+    EXPECT_TRUE(stream_decode(document, 0, &streamed));
+    EXPECT_EQ(streamed, expected);
+}
+
+TEST(PushParserTests, StreamDecodeEnforcesValueCap) 
+{
+    // The longest leaf is the 2-byte "Hi"
+    std::vector<uint8_t> document = small_set_document();
+    std::string out;
+    EXPECT_TRUE(stream_decode(document, 2, &out));
+    EXPECT_FALSE(stream_decode(document, 1, &out));
+}
+
+// -------------------------
+// Arena Tests
+// -------------------------
+
+TEST(ArenaTests, ResetReusesBlocks) 
+{
+    BejArena_t arena;
+    init_arena(&arena, 256);
+
+    void* small = arena_alloc(&arena, 100);
+    void* large = arena_alloc(&arena, 1000);    // bigger than a block: gets its own
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ((uintptr_t)small % alignof(max_align_t), 0u);
+    EXPECT_EQ((uintptr_t)large % alignof(max_align_t), 0u);
+    BejArenaBlock_t* last = arena.last;
+
+    arena_reset(&arena);
+    EXPECT_EQ(arena_alloc(&arena, 100), small);
+    EXPECT_EQ(arena_alloc(&arena, 1000), large);
+    EXPECT_EQ(arena.last, last);
+
+    free_arena(&arena);
+    EXPECT_EQ(arena.first, nullptr);
+}
+
+TEST(ArenaTests, ParallelDecodeAllocatesOnlyOnce) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+
+    DecoderContext_t heap_ctx;
+    init_decoder_context(&heap_ctx, nullptr, nullptr, nullptr, nullptr);
+    set_output_buffer(&heap_ctx, nullptr, 0);
+    ASSERT_TRUE(decode_bej_buffer(&heap_ctx, document.data(), (uint32_t)document.size()));
+    std::string expected((const char*)heap_ctx.output_buffer, heap_ctx.output_length);
+    free(heap_ctx.output_buffer);
+
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.parallel_threads = 4;
+    ctx.parallel_min_members = 64;
+    ctx.arena = &arena;
+
+    BejArenaBlock_t* last = nullptr;
+    for (int pass = 0; pass < 3; pass++) 
+    {
+        set_output_buffer(&ctx, ctx.output_buffer, ctx.output_capacity);
+        ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), (uint32_t)document.size()));
+        EXPECT_EQ(std::string((const char*)ctx.output_buffer, ctx.output_length), expected);
+        if (pass > 0) 
+        {
+            EXPECT_EQ(arena.last, last);    // steady state: no new blocks
+        }
+        last = arena.last;
+    }
+    EXPECT_NE(last, nullptr);
+
+    free(ctx.output_buffer);
+    free_arena(&arena);
+}
+
+// -------------------------
+// Allocator Tests
+// -------------------------
+
+struct CountingHeap
+{
+    std::atomic<int> allocs{0};
+    std::atomic<int> reallocs{0};
+    std::atomic<int> frees{0};
+};
+
+static BejAllocator_t counting_allocator(CountingHeap* heap)
+{
+    BejAllocator_t allocator;
+    allocator.alloc = [](void* user, size_t size) -> void* {
+        ((CountingHeap*)user)->allocs++;
+        return malloc(size);
+    };
+    allocator.realloc = [](void* user, void* memory, size_t size) -> void* {
+        CountingHeap* heap = (CountingHeap*)user;
+        (memory ? heap->reallocs : heap->allocs)++;
+        return realloc(memory, size);
+    };
+    allocator.free = [](void* user, void* memory) {
+        ((CountingHeap*)user)->frees++;
+        free(memory);
+    };
+    allocator.user = heap;
+    return allocator;
+}
+
+/// One-entry dictionary: a SET named "Root"
+static void write_test_dictionary(const char* path)
+{
+    const uint8_t dictionary[] = {
+        0x00, 0x00, 1, 0, 0, 0, 0, 0, 27, 0, 0, 0,   // header: 1 entry, 27 bytes
+        0x00, 0, 0, 0, 0, 0, 0, 5, 22, 0,           // SET, seq 0, no children, name at 22
+        'R', 'o', 'o', 't', 0
+    };
+    FILE* file = fopen(path, "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(dictionary, 1, sizeof(dictionary), file);
+    fclose(file);
+}
+
+TEST(AllocatorTests, CountsEveryAllocation) 
+{
+    CountingHeap heap;
+    BejAllocator_t allocator = counting_allocator(&heap);
+
+    // Dictionary, file buffer, entries and names; the file buffer is freed while loading
+    const char* path = "allocator_test_dictionary.bin";
+    write_test_dictionary(path);
+    Dictionary_t* dict = load_dictionary_with_allocator(path, nullptr, &allocator);
+    ASSERT_NE(dict, nullptr);
+    EXPECT_STREQ(dict->entries[0].name, "Root");
+    EXPECT_EQ(heap.allocs, 4);
+    EXPECT_EQ(heap.frees, 1);
+    free_dictionary(dict);
+    EXPECT_EQ(heap.frees, 4);
+    remove(path);
+
+    // A serial in-memory decode allocates its output and nothing else
+    std::vector<uint8_t> document = small_set_document();
+    BejDecodeOptions_t options;
+    init_decode_options(&options);
+    options.allocator = &allocator;
+    uint8_t* output = nullptr;
+    size_t output_size = 0;
+    heap.allocs = heap.frees = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &options, &output, &output_size));
+    EXPECT_EQ(heap.allocs, 1);
+    EXPECT_EQ(heap.reallocs, 0);
+    bej_free(&allocator, output);
+
+    // The parallel path also balances; its workers keep to the C heap
+    document = document_with_root_set(large_set_value(3000));
+    options.threads = 4;
+    heap.allocs = heap.frees = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &options, &output, &output_size));
+    bej_free(&allocator, output);
+    EXPECT_GT(heap.allocs, 0);
+    EXPECT_EQ(heap.allocs, heap.frees);
+}
+
+/// Allocator that is only safe on the thread that created it
+struct SingleThreadHeap
+{
+    std::thread::id owner = std::this_thread::get_id();
+    std::atomic<int> foreign_calls{0};
+    int live = 0;
+
+    void check()
+    {
+        if (std::this_thread::get_id() != owner) foreign_calls++;
+    }
+};
+
+TEST(AllocatorTests, ParallelWorkersNeverCallTheAllocator) 
+{
+    SingleThreadHeap heap;
+    BejAllocator_t allocator;
+    allocator.alloc = [](void* user, size_t size) -> void* {
+        SingleThreadHeap* heap = (SingleThreadHeap*)user;
+        heap->check();
+        heap->live++;
+        return malloc(size);
+    };
+    allocator.realloc = [](void* user, void* memory, size_t size) -> void* {
+        SingleThreadHeap* heap = (SingleThreadHeap*)user;
+        heap->check();
+        heap->live += memory ? 0 : 1;
+        return realloc(memory, size);
+    };
+    allocator.free = [](void* user, void* memory) {
+        SingleThreadHeap* heap = (SingleThreadHeap*)user;
+        heap->check();
+        heap->live -= memory ? 1 : 0;
+        free(memory);
+    };
+    allocator.user = &heap;
+
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+    uint8_t* expected = nullptr;
+    size_t expected_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     nullptr, &expected, &expected_size));
+
+    // Both the allocator and an arena on top of it are used by the calling thread only
+    BejArena_t arena;
+    init_arena(&arena, 0);
+    arena.allocator = &allocator;
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+    ctx.parallel_threads = 4;
+    ctx.parallel_min_members = 64;
+    ctx.allocator = &allocator;
+    ctx.arena = &arena;
+    for (int pass = 0; pass < 3; pass++) 
+    {
+        set_output_buffer(&ctx, ctx.output_buffer, ctx.output_capacity);
+        ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), document.size()));
+        EXPECT_EQ(std::string_view((const char*)ctx.output_buffer, ctx.output_length),
+                  std::string_view((const char*)expected, expected_size));
+    }
+    bej_free(&allocator, ctx.output_buffer);
+    free_arena(&arena);
+
+    EXPECT_EQ(heap.foreign_calls, 0);
+    EXPECT_EQ(heap.live, 0);
+    free(expected);
+}
+
+/// Fixed static heap, as on firmware: bump allocation, frees are only counted
+struct StaticPool
+{
+    alignas(max_align_t) uint8_t memory[256 * 1024];
+    size_t used = 0;
+    int live = 0;
+
+    static constexpr size_t HEADER = alignof(max_align_t);
+
+    void* take(size_t size)
+    {
+        size_t total = HEADER + ((size + HEADER - 1) & ~(HEADER - 1));
+        if (total > sizeof(memory) - used) return nullptr;
+        uint8_t* block = memory + used;
+        memcpy(block, &size, sizeof(size));
+        used += total;
+        live++;
+        return block + HEADER;
+    }
+
+    bool owns(const void* pointer) const
+    {
+        return pointer >= memory && pointer < memory + sizeof(memory);
+    }
+};
+
+static BejAllocator_t pool_allocator(StaticPool* pool)
+{
+    BejAllocator_t allocator;
+    allocator.alloc = [](void* user, size_t size) { return ((StaticPool*)user)->take(size); };
+    allocator.realloc = [](void* user, void* memory, size_t size) -> void* {
+        StaticPool* pool = (StaticPool*)user;
+        void* grown = pool->take(size);
+        if (grown && memory) 
+        {
+            size_t old_size;
+            memcpy(&old_size, (uint8_t*)memory - StaticPool::HEADER, sizeof(old_size));
+            memcpy(grown, memory, std::min(old_size, size));
+            pool->live--;
+        }
+        return grown;
+    };
+    allocator.free = [](void* user, void*) { ((StaticPool*)user)->live--; };
+    allocator.user = pool;
+    return allocator;
+}
+
+TEST(AllocatorTests, StaticPoolAllocator) 
+{
+    static StaticPool pool;
+    BejAllocator_t allocator = pool_allocator(&pool);
+
+    const char* path = "allocator_pool_dictionary.bin";
+    write_test_dictionary(path);
+    Dictionary_t* dict = load_dictionary_with_allocator(path, nullptr, &allocator);
+    remove(path);
+    ASSERT_NE(dict, nullptr);
+    EXPECT_TRUE(pool.owns(dict));
+    EXPECT_TRUE(pool.owns(dict->entries[0].name));
+
+    // Growing output buffer and push parser state all come from the pool
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(200));
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, dict, nullptr, nullptr, nullptr);
+    ctx.allocator = &allocator;
+    set_output_buffer(&ctx, nullptr, 0);
+    BejPushParser_t* parser = bej_push_create(&ctx);
+    ASSERT_NE(parser, nullptr);
+    EXPECT_TRUE(pool.owns(parser));
+    EXPECT_TRUE(bej_feed(parser, document.data(), document.size()));
+    EXPECT_TRUE(bej_finish(parser));
+    bej_push_free(parser);
+    EXPECT_TRUE(pool.owns(ctx.output_buffer));
+
+    bool ok = false;
+    EXPECT_EQ(std::string((const char*)ctx.output_buffer, ctx.output_length),
+              push_decode(document, document.size(), BEJ_OUTPUT_JSON, &ok));
+
+    bej_free(&allocator, ctx.output_buffer);
+    free_dictionary(dict);
+    EXPECT_EQ(pool.live, 0);
+}
+
+// -------------------------
+// Statistics Tests
+// -------------------------
+
+TEST(StatsTests, SerialAndParallelDecodeAgree) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+    BejDecodeStats_t stats[2];
+
+    for (int threads : {0, 4}) 
+    {
+        DecoderContext_t ctx;
+        init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+        ctx.parallel_threads = threads;
+        set_output_buffer(&ctx, nullptr, 0);
+        ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), document.size()));
+
+        // Root SET holding ARRAYs of strings; integers and the longest string are 2 bytes
+        BejDecodeStats_t& current = stats[threads ? 1 : 0];
+        current = ctx.stats;
+        EXPECT_EQ(current.max_depth, 2u);
+        EXPECT_EQ(current.largest_value, 2u);
+        EXPECT_GE(current.peak_live_bytes, ctx.output_capacity);
+        EXPECT_EQ(current.live_bytes, ctx.output_capacity);    // only the output is still held
+        free(ctx.output_buffer);
+    }
+    // Workers add a member index and one buffer per chunk
+    EXPECT_GT(stats[1].allocations, stats[0].allocations);
+}
+
+TEST(StatsTests, ReportedByHighLevelDecodes) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    BejDecodeStats_t stats;
+    BejDecodeOptions_t options;
+    init_decode_options(&options);
+    options.stats = &stats;
+
+    uint8_t* output = nullptr;
+    size_t output_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &options, &output, &output_size));
+    // The output buffer sized from the input is the only allocation
+    EXPECT_EQ(stats.allocations, 1u);
+    EXPECT_GE(stats.bytes_allocated, output_size + 1);
+    EXPECT_EQ(stats.max_depth, 1u);
+    EXPECT_EQ(stats.largest_value, 2u);
+    free(output);
+
+    // Streaming decode: everything it took is given back once the document is done
+    FILE* input = tmpfile();
+    FILE* out = tmpfile();
+    fwrite(document.data(), 1, document.size(), input);
+    rewind(input);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, nullptr, nullptr, input, out);
+    ASSERT_TRUE(decode_bej_to_json(&ctx));
+    EXPECT_EQ(ctx.stats.max_depth, 1u);
+    EXPECT_EQ(ctx.stats.largest_value, 2u);
+    EXPECT_GE(ctx.stats.peak_live_bytes, (uint64_t)BEJ_STREAM_CHUNK_SIZE);
+    EXPECT_EQ(ctx.stats.live_bytes, 0u);
+    fclose(input);
+    fclose(out);
+}
+
+// -------------------------
+// Projection Tests
+// -------------------------
+
+/// Root { Id: INTEGER, Status: { Health, State }, Name } with string leaves
+static Dictionary_t* load_projection_dictionary()
+{
+    const uint8_t dictionary[] = {
+        0x00, 0x00, 6, 0, 0, 0, 0, 0, 105, 0, 0, 0,  // header: 6 entries, 105 bytes
+        0x00, 0, 0, 22, 0, 3, 0, 5, 72, 0,           // SET Root, children at entry 1
+        0x30, 0, 0, 0, 0, 0, 0, 3, 77, 0,            // INTEGER Id, seq 0
+        0x00, 1, 0, 52, 0, 2, 0, 7, 80, 0,           // SET Status, seq 1, children at entry 4
+        0x50, 2, 0, 0, 0, 0, 0, 5, 87, 0,            // STRING Name, seq 2
+        0x50, 0, 0, 0, 0, 0, 0, 7, 92, 0,            // STRING Health, seq 0
+        0x50, 1, 0, 0, 0, 0, 0, 6, 99, 0,            // STRING State, seq 1
+        'R', 'o', 'o', 't', 0, 'I', 'd', 0, 'S', 't', 'a', 't', 'u', 's', 0,
+        'N', 'a', 'm', 'e', 0, 'H', 'e', 'a', 'l', 't', 'h', 0, 'S', 't', 'a', 't', 'e', 0
+    };
+    const char* path = "projection_test_dictionary.bin";
+    FILE* file = fopen(path, "wb");
+    if (!file) return nullptr;
+    fwrite(dictionary, 1, sizeof(dictionary), file);
+    fclose(file);
+    Dictionary_t* dict = load_dictionary(path);
+    remove(path);
+    return dict;
+}
+
+/// Annotation root whose only child is the STRING "@odata.etag" (seq 0)
+static Dictionary_t* load_annotation_dictionary()
+{
+    const uint8_t dictionary[] = {
+        0x00, 0x00, 2, 0, 0, 0, 0, 0, 49, 0, 0, 0,   // header: 2 entries, 49 bytes
+        0x00, 0, 0, 22, 0, 1, 0, 5, 32, 0,           // SET Anno, children at entry 1
+        0x50, 0, 0, 0, 0, 0, 0, 12, 37, 0,           // STRING @odata.etag, seq 0
+        'A', 'n', 'n', 'o', 0, '@', 'o', 'd', 'a', 't', 'a', '.', 'e', 't', 'a', 'g', 0
+    };
+    const char* path = "annotation_test_dictionary.bin";
+    FILE* file = fopen(path, "wb");
+    if (!file) return nullptr;
+    fwrite(dictionary, 1, sizeof(dictionary), file);
+    fclose(file);
+    Dictionary_t* dict = load_dictionary(path);
+    remove(path);
+    return dict;
+}
+
+/// Annotation (seq 0), Id 7, Status { Health "OK", State "Enabled" }, Name "n"
+static std::vector<uint8_t> projection_document()
+{
+    return {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 46, 1, 4,
+        1, 0x01, 0x50, 1, 1, 'x',
+        1, 0x00, 0x30, 1, 1, 7,
+        1, 0x02, 0x00, 1, 21, 1, 2,
+            1, 0x00, 0x50, 1, 2, 'O', 'K',
+            1, 0x02, 0x50, 1, 7, 'E', 'n', 'a', 'b', 'l', 'e', 'd',
+        1, 0x04, 0x50, 1, 1, 'n'
+    };
+}
+
+TEST(ProjectionTests, KeepsSelectedPathsAndAnnotations) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    BejProjection_t* projection = bej_compile_projection(dict, "Name,Status/Health", nullptr, nullptr);
+    ASSERT_NE(projection, nullptr);
+    EXPECT_EQ(projection->node_count, 4u);
+
+    std::vector<uint8_t> document = projection_document();
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, dict, nullptr, nullptr, nullptr);
+    ctx.compact = 1;
+    ctx.projection = projection;
+    set_output_buffer(&ctx, nullptr, 0);
+    ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), document.size()));
+    EXPECT_EQ(std::string((char*)ctx.output_buffer, ctx.output_length),
+              "{\"seq_0\":\"x\",\"Status\":{\"Health\":\"OK\"},\"Name\":\"n\"}");
+    free(ctx.output_buffer);
+
+    // Map headers count only the kept members
+    ctx.output_format = BEJ_OUTPUT_CBOR;
+    set_output_buffer(&ctx, nullptr, 0);
+    ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), document.size()));
+    ASSERT_GT(ctx.output_length, 0u);
+    EXPECT_EQ(ctx.output_buffer[0], 0xA3);
+    free(ctx.output_buffer);
+
+    // A wholly selected object keeps all of its members
+    bej_free_projection(projection);
+    projection = bej_compile_projection(dict, "Status", nullptr, nullptr);
+    ASSERT_NE(projection, nullptr);
+    ctx.output_format = BEJ_OUTPUT_JSON;
+    ctx.projection = projection;
+    set_output_buffer(&ctx, nullptr, 0);
+    ASSERT_TRUE(decode_bej_buffer(&ctx, document.data(), document.size()));
+    EXPECT_EQ(std::string((char*)ctx.output_buffer, ctx.output_length),
+              "{\"seq_0\":\"x\",\"Status\":{\"Health\":\"OK\",\"State\":\"Enabled\"}}");
+    free(ctx.output_buffer);
+
+    bej_free_projection(projection);
+    free_dictionary(dict);
+}
+
+TEST(ProjectionTests, RejectsUnknownPathsAndPushParsing) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    EXPECT_EQ(bej_compile_projection(dict, "Status/Bogus", nullptr, nullptr), nullptr);
+    EXPECT_EQ(bej_compile_projection(dict, "Name/Health", nullptr, nullptr), nullptr);
+    EXPECT_EQ(bej_compile_projection(dict, "Name,,Id", nullptr, nullptr), nullptr);
+
+    BejProjection_t* projection = bej_compile_projection(dict, "Id", nullptr, nullptr);
+    ASSERT_NE(projection, nullptr);
+    DecoderContext_t ctx;
+    init_decoder_context(&ctx, dict, nullptr, nullptr, nullptr);
+    set_output_buffer(&ctx, nullptr, 0);
+    ctx.projection = projection;
+    EXPECT_EQ(bej_push_create(&ctx), nullptr);
+
+    bej_free_projection(projection);
+    free_dictionary(dict);
+}
+
+// -------------------------
+// Random Access Tests
+// -------------------------
+
+TEST(GetTests, ReadsValuesByJsonPointer) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<uint8_t> document = projection_document();
+    BejValue_t value;
+
+    ASSERT_TRUE(bej_get(document.data(), document.size(), dict, nullptr, "/Status/Health", &value, nullptr));
+    EXPECT_EQ(value.format, BEJ_FORMAT_STRING);
+    EXPECT_EQ(std::string(value.string, value.string_length), "OK");
+    EXPECT_STREQ(value.entry->name, "Health");
+
+    ASSERT_TRUE(bej_get(document.data(), document.size(), dict, nullptr, "/Id", &value, nullptr));
+    EXPECT_EQ(value.format, BEJ_FORMAT_INTEGER);
+    EXPECT_EQ(value.integer, 7);
+
+    // Containers come back as their encoded members
+    ASSERT_TRUE(bej_get(document.data(), document.size(), dict, nullptr, "/Status", &value, nullptr));
+    EXPECT_EQ(value.format, BEJ_FORMAT_SET);
+    EXPECT_EQ(value.length, 21u);
+    ASSERT_TRUE(bej_get(document.data(), document.size(), dict, nullptr, "", &value, nullptr));
+    EXPECT_EQ(value.length, 46u);
+
+    free_dictionary(dict);
+}
+
+TEST(GetTests, RejectsUnknownAndMalformedPointers) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<uint8_t> document = projection_document();
+    BejValue_t value;
+
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "Status", &value, nullptr));
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "/Status/Bogus", &value, nullptr));
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "/Id/0", &value, nullptr));
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "/Status~2", &value, nullptr));
+
+    // Truncated documents fail instead of reading past the end
+    EXPECT_FALSE(bej_get(document.data(), document.size() - 1, dict, nullptr, "/Name", &value, nullptr));
+
+    free_dictionary(dict);
+}
+
+TEST(GetTests, IndexesArrayElements) 
+{
+    // Root ARRAY of STRINGs "a", "bc", "d"
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x10, 1, 21, 1, 3,
+        1, 0x00, 0x50, 1, 1, 'a',
+        1, 0x02, 0x50, 1, 2, 'b', 'c',
+        1, 0x04, 0x50, 1, 1, 'd'
+    };
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    BejValue_t value;
+
+    ASSERT_TRUE(bej_get(document.data(), document.size(), dict, nullptr, "/1", &value, nullptr));
+    EXPECT_EQ(std::string(value.string, value.string_length), "bc");
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "/3", &value, nullptr));
+    EXPECT_FALSE(bej_get(document.data(), document.size(), dict, nullptr, "/01", &value, nullptr));
+
+    free_dictionary(dict);
+}
+
+// -------------------------
+// Sidecar Index Tests
+// -------------------------
+
+TEST(SidecarTests, IndexesEveryPathAndReadsOneValue) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<uint8_t> document = projection_document();
+    const char* payload_path = "sidecar_test_payload.bin";
+    const char* index_path = "sidecar_test.bidx";
+    FILE* file = fopen(payload_path, "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(document.data(), 1, document.size(), file);
+    fclose(file);
+
+    BejIndexBuilder_t* builder = bej_index_builder_create(dict, nullptr, nullptr);
+    ASSERT_NE(builder, nullptr);
+    ASSERT_TRUE(bej_index_add(builder, payload_path, document.data(), document.size()));
+    EXPECT_FALSE(bej_index_add(builder, "truncated", document.data(), 9));
+    ASSERT_TRUE(bej_index_write(builder, index_path));
+    bej_index_builder_free(builder);
+
+    BejIndex_t* index = bej_index_open(index_path, nullptr);
+    ASSERT_NE(index, nullptr);
+    ASSERT_EQ(bej_index_payload_count(index), 1u);
+    EXPECT_STREQ(bej_index_payload_name(index, 0), payload_path);
+
+    // The root, Id, Status and both members, Name; the annotation has no dictionary here
+    uint32_t path;
+    for (const char* pointer : {"", "/Id", "/Status", "/Status/Health", "/Status/State", "/Name"}) 
+    {
+        EXPECT_TRUE(bej_index_find_path(index, pointer, &path)) << pointer;
+    }
+    EXPECT_FALSE(bej_index_find_path(index, "/seq_0", &path));
+
+    ASSERT_TRUE(bej_index_find_path(index, "/Status/Health", &path));
+    const BejIndexEntry_t* entry = bej_index_lookup(index, 0, path);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->format, BEJ_FORMAT_STRING);
+    EXPECT_EQ(memcmp(document.data() + entry->offset, "OK", 2), 0);
+
+    uint8_t* buffer = nullptr;
+    size_t capacity = 0;
+    BejValue_t value;
+    ASSERT_TRUE(bej_index_read(index, 0, path, dict, nullptr, &buffer, &capacity, &value));
+    EXPECT_EQ(std::string(value.string, value.string_length), "OK");
+    EXPECT_STREQ(value.entry->name, "Health");
+
+    // A payload that changed after indexing is not trusted
+    file = fopen(payload_path, "ab");
+    fputc(0, file);
+    fclose(file);
+    EXPECT_FALSE(bej_index_read(index, 0, path, dict, nullptr, &buffer, &capacity, &value));
+
+    free(buffer);
+    bej_index_close(index);
+    remove(payload_path);
+    remove(index_path);
+    free_dictionary(dict);
+}
+
+TEST(SidecarTests, IndexesNullMembers) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+
+    // Id 7, Status { State null }: a NULL tuple names a STRING entry
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 20, 1, 2,
+        1, 0x00, 0x30, 1, 1, 7,
+        1, 0x02, 0x00, 1, 7, 1, 1,
+            1, 0x02, 0x20, 1, 0
+    };
+    const char* payload_path = "sidecar_null_payload.bin";
+    const char* index_path = "sidecar_null.bidx";
+    FILE* file = fopen(payload_path, "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(document.data(), 1, document.size(), file);
+    fclose(file);
+
+    BejIndexBuilder_t* builder = bej_index_builder_create(dict, nullptr, nullptr);
+    ASSERT_NE(builder, nullptr);
+    ASSERT_TRUE(bej_index_add(builder, payload_path, document.data(), document.size()));
+    ASSERT_TRUE(bej_index_write(builder, index_path));
+    bej_index_builder_free(builder);
+
+    BejIndex_t* index = bej_index_open(index_path, nullptr);
+    ASSERT_NE(index, nullptr);
+    uint32_t path;
+    ASSERT_TRUE(bej_index_find_path(index, "/Status/State", &path));
+    const BejIndexEntry_t* entry = bej_index_lookup(index, 0, path);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->format, BEJ_FORMAT_NULL);
+
+    uint8_t* buffer = nullptr;
+    size_t capacity = 0;
+    BejValue_t value;
+    ASSERT_TRUE(bej_index_read(index, 0, path, dict, nullptr, &buffer, &capacity, &value));
+    EXPECT_EQ(value.format, BEJ_FORMAT_NULL);
+    EXPECT_STREQ(value.entry->name, "State");
+
+    free(buffer);
+    bej_index_close(index);
+    remove(payload_path);
+    remove(index_path);
+    free_dictionary(dict);
+}
+
+TEST(SidecarTests, RejectsCorruptFiles) 
+{
+    const char* index_path = "sidecar_corrupt.bidx";
+    BejIndexHeader_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BEJ_INDEX_MAGIC, 4);
+    header.version = BEJ_INDEX_VERSION;
+    header.path_count = 1000;               // more paths than the file holds
+    header.paths_offset = sizeof(header);
+
+    FILE* file = fopen(index_path, "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+    EXPECT_EQ(bej_index_open(index_path, nullptr), nullptr);
+    EXPECT_EQ(bej_index_open("sidecar_missing.bidx", nullptr), nullptr);
+    remove(index_path);
+}
+
+// -------------------------
+// Filter Tests
+// -------------------------
+
+/// Compile expression against the projection dictionary and match it on document
+static bool filter_matches(Dictionary_t* dict, const std::vector<uint8_t>& document, const char* expression)
+{
+    BejFilter_t* filter = bej_filter_compile(dict, nullptr, expression, nullptr);
+    EXPECT_NE(filter, nullptr) << expression;
+    bool matched = false;
+    if (filter) 
+    {
+        EXPECT_TRUE(bej_filter_match(filter, document.data(), document.size(), &matched)) << expression;
+        bej_filter_free(filter);
+    }
+    return matched;
+}
+
+TEST(FilterTests, ComparesTypedValues) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<uint8_t> document = projection_document();
+
+    EXPECT_TRUE(filter_matches(dict, document, "Status/Health == \"OK\""));
+    EXPECT_TRUE(filter_matches(dict, document, "/Status/State != \"Disabled\""));
+    EXPECT_TRUE(filter_matches(dict, document, "Id >= 7 and Id < 8"));
+    EXPECT_TRUE(filter_matches(dict, document, "Id == 7.0"));
+    EXPECT_FALSE(filter_matches(dict, document, "Id >= 7 and Name != \"n\""));
+    EXPECT_TRUE(filter_matches(dict, document, "Id > 7 || Name == \"n\""));
+    EXPECT_FALSE(filter_matches(dict, document, "(Id > 7 or Name == \"n\") && Status/Health == \"Critical\""));
+    EXPECT_TRUE(filter_matches(dict, document, "Name < \"o\""));
+
+    free_dictionary(dict);
+}
+
+TEST(FilterTests, MissingPropertiesAndMalformedInput) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+
+    // Status without Health: only != holds
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 9, 1, 1,
+        1, 0x02, 0x00, 1, 2, 1, 0,
+    };
+    EXPECT_FALSE(filter_matches(dict, document, "Status/Health == \"OK\""));
+    EXPECT_FALSE(filter_matches(dict, document, "Status/Health != \"OK\""));
+    EXPECT_FALSE(filter_matches(dict, document, "Id < 0 or Id >= 0"));
+
+    // Unknown names, mistyped literals and syntax errors fail to compile
+    for (const char* expression : {"Bogus == 1", "Status/Bogus == \"OK\"", "Id == \"7\"", "Id == true",
+                                   "Id = 7", "Id == 7 and", "(Id == 7", "Id == 7 Name == \"n\"", ""}) 
+    {
+        BejFilter_t* filter = bej_filter_compile(dict, nullptr, expression, nullptr);
+        EXPECT_EQ(filter, nullptr) << expression;
+        bej_filter_free(filter);
+    }
+
+    // A truncated payload is an error, not a mismatch
+    BejFilter_t* filter = bej_filter_compile(dict, nullptr, "Name == \"n\"", nullptr);
+    ASSERT_NE(filter, nullptr);
+    std::vector<uint8_t> whole = projection_document();
+    bool matched = true;
+    EXPECT_FALSE(bej_filter_match(filter, whole.data(), whole.size() - 3, &matched));
+    bej_filter_free(filter);
+
+    free_dictionary(dict);
+}
+
+// -------------------------
+// Aggregate Tests
+// -------------------------
+
+/// Root { Id: id } in the projection dictionary's layout
+static std::vector<uint8_t> id_document(uint8_t id)
+{
+    return {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 8, 1, 1,
+        1, 0x00, 0x30, 1, 1, id
+    };
+}
+
+TEST(AggregateTests, FoldsAndMergesAccumulators) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    const char* paths[] = {"Id"};
+    BejAggregate_t* aggregate = bej_aggregate_compile(dict, nullptr, paths, 1, nullptr);
+    ASSERT_NE(aggregate, nullptr);
+
+    // Ids 1..100 split over two accumulators, as two workers would
+    BejAccumulator_t* first = bej_accumulator_create(aggregate);
+    BejAccumulator_t* second = bej_accumulator_create(aggregate);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    for (uint8_t id = 1; id <= 100; id++) 
+    {
+        std::vector<uint8_t> document = id_document(id);
+        ASSERT_TRUE(bej_accumulator_add(id % 3 ? first : second, document.data(), document.size()));
+    }
+
+    // A payload without Id, and one where it is null, count as missing
+    std::vector<uint8_t> document = projection_document();
+    document.erase(document.begin() + 20, document.begin() + 26);
+    document[11] = 40;
+    document[13] = 3;
+    ASSERT_TRUE(bej_accumulator_add(first, document.data(), document.size()));
+    std::vector<uint8_t> null_id = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 7, 1, 1,
+        1, 0x00, 0x20, 1, 0
+    };
+    ASSERT_TRUE(bej_accumulator_add(second, null_id.data(), null_id.size()));
+
+    // A malformed payload changes nothing
+    std::vector<uint8_t> truncated = id_document(200);
+    EXPECT_FALSE(bej_accumulator_add(first, truncated.data(), truncated.size() - 1));
+
+    ASSERT_TRUE(bej_accumulator_merge(first, second));
+    BejAggregateResult_t result;
+    ASSERT_TRUE(bej_accumulator_result(first, 0, &result));
+    EXPECT_EQ(result.count, 100u);
+    EXPECT_EQ(result.missing, 2u);
+    EXPECT_DOUBLE_EQ(result.min, 1);
+    EXPECT_DOUBLE_EQ(result.max, 100);
+    EXPECT_DOUBLE_EQ(result.sum, 5050);
+    EXPECT_DOUBLE_EQ(result.mean, 50.5);
+    EXPECT_NEAR(result.p50, 50, 50 * 0.008);
+    EXPECT_NEAR(result.p90, 90, 90 * 0.008);
+    EXPECT_NEAR(result.p99, 99, 99 * 0.008);
+    EXPECT_FALSE(bej_accumulator_result(first, 1, &result));
+
+    bej_accumulator_free(first);
+    bej_accumulator_free(second);
+    bej_aggregate_free(aggregate);
+
+    // Only integer and real properties can be aggregated
+    for (const char* path : {"Name", "Status", "Bogus"}) 
+    {
+        EXPECT_EQ(bej_aggregate_compile(dict, nullptr, &path, 1, nullptr), nullptr) << path;
+    }
+    free_dictionary(dict);
+}
+
+TEST(AggregateTests, PercentilesStayWithinSketchAccuracy) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    const char* paths[] = {"Id"};
+    BejAggregate_t* aggregate = bej_aggregate_compile(dict, nullptr, paths, 1, nullptr);
+    ASSERT_NE(aggregate, nullptr);
+    BejAccumulator_t* accumulator = bej_accumulator_create(aggregate);
+    ASSERT_NE(accumulator, nullptr);
+
+    // Ids -50000 .. 49999 as 4-byte integers, in an order unrelated to their rank
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 11, 1, 1,
+        1, 0x00, 0x30, 1, 4, 0, 0, 0, 0
+    };
+    for (int32_t i = 0; i < 100000; i++) 
+    {
+        int32_t id = (int32_t)((i * 7919) % 100000) - 50000;
+        memcpy(&document[19], &id, sizeof(id));
+        ASSERT_TRUE(bej_accumulator_add(accumulator, document.data(), document.size()));
+    }
+
+    BejAggregateResult_t result;
+    ASSERT_TRUE(bej_accumulator_result(accumulator, 0, &result));
+    EXPECT_EQ(result.count, 100000u);
+    EXPECT_DOUBLE_EQ(result.min, -50000);
+    EXPECT_DOUBLE_EQ(result.max, 49999);
+    EXPECT_NEAR(result.p50, -1, 1);
+    EXPECT_NEAR(result.p90, 39999, 39999 * 0.008);
+    EXPECT_NEAR(result.p99, 48999, 48999 * 0.008);
+
+    bej_accumulator_free(accumulator);
+    bej_aggregate_free(aggregate);
+    free_dictionary(dict);
+}
+
+TEST(AggregateTests, AggregatesFilesOnWorkerThreads) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    const char* paths[] = {"Id"};
+    BejAggregate_t* aggregate = bej_aggregate_compile(dict, nullptr, paths, 1, nullptr);
+    ASSERT_NE(aggregate, nullptr);
+
+    BatchFileList_t files;
+    init_file_list(&files);
+    for (uint8_t id = 0; id < 20; id++) 
+    {
+        std::string path = "aggregate_test_" + std::to_string(id) + ".bin";
+        std::vector<uint8_t> document = id_document(id);
+        FILE* file = fopen(path.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        fwrite(document.data(), 1, document.size(), file);
+        fclose(file);
+        ASSERT_TRUE(file_list_add(&files, path.c_str()));
+    }
+    ASSERT_TRUE(file_list_add(&files, "aggregate_test_missing.bin"));
+
+    for (int threads : {1, 4}) 
+    {
+        BejAccumulator_t* total = bej_accumulator_create(aggregate);
+        ASSERT_NE(total, nullptr);
+        BatchStats_t stats;
+        EXPECT_FALSE(bej_aggregate_files(aggregate, &files, threads, nullptr, total, &stats));
+        EXPECT_EQ(stats.files_ok, 20u);
+        EXPECT_EQ(stats.files_failed, 1u);
+
+        BejAggregateResult_t result;
+        ASSERT_TRUE(bej_accumulator_result(total, 0, &result));
+        EXPECT_EQ(result.count, 20u);
+        EXPECT_DOUBLE_EQ(result.min, 0);
+        EXPECT_DOUBLE_EQ(result.max, 19);
+        EXPECT_DOUBLE_EQ(result.sum, 190);
+        EXPECT_NEAR(result.p50, 9, 9 * 0.008);
+        bej_accumulator_free(total);
+    }
+
+    for (size_t i = 0; i + 1 < files.count; i++) 
+    {
+        remove(files.paths[i]);
+    }
+    free_file_list(&files);
+    bej_aggregate_free(aggregate);
+    free_dictionary(dict);
+}
+
+// -------------------------
+// Query Plan Tests
+// -------------------------
+
+TEST(PlanTests, ReadsEveryPathInOneWalk) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<uint8_t> document = projection_document();
+    const char* paths[] = {"Status/Health", "Id", "Status/State", "Id", "Name"};
+    BejPlan_t* plan = bej_plan_compile(dict, nullptr, paths, 5, "Status/Health == \"OK\"", nullptr);
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(bej_plan_path_count(plan), 5u);
+
+    BejValue_t values[5];
+    bool found[5];
+    bool matched = false;
+    ASSERT_TRUE(bej_plan_execute(plan, dict, nullptr, document.data(), document.size(), &matched, values, found));
+    EXPECT_TRUE(matched);
+    for (bool one : found) EXPECT_TRUE(one);
+    EXPECT_EQ(std::string(values[0].string, values[0].string_length), "OK");
+    EXPECT_EQ(values[1].integer, 7);
+    EXPECT_EQ(std::string(values[2].string, values[2].string_length), "Enabled");
+    EXPECT_EQ(values[3].integer, 7);
+    EXPECT_EQ(std::string(values[4].string, values[4].string_length), "n");
+    EXPECT_STREQ(values[2].entry->name, "State");
+
+    // Missing members are reported per path; truncation is an error
+    std::vector<uint8_t> no_name(document.begin(), document.end() - 6);
+    no_name[11] = 40;
+    no_name[13] = 3;
+    ASSERT_TRUE(bej_plan_execute(plan, dict, nullptr, no_name.data(), no_name.size(), &matched, values, found));
+    EXPECT_TRUE(found[0]);
+    EXPECT_FALSE(found[4]);
+    EXPECT_FALSE(bej_plan_execute(plan, dict, nullptr, document.data(), document.size() - 2, &matched, values, found));
+    bej_plan_free(plan);
+
+    // A document the filter rejects is not read further
+    plan = bej_plan_compile(dict, nullptr, paths, 2, "Id != 7", nullptr);
+    ASSERT_NE(plan, nullptr);
+    ASSERT_TRUE(bej_plan_execute(plan, dict, nullptr, document.data(), document.size(), &matched, values, found));
+    EXPECT_FALSE(matched);
+    EXPECT_FALSE(found[0]);
+    bej_plan_free(plan);
+
+    EXPECT_EQ(bej_plan_compile(dict, nullptr, paths, 2, "Id ==", nullptr), nullptr);
+    free_dictionary(dict);
+}
+
+TEST(PlanTests, CacheKeysByDictionaryRevision) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    Dictionary_t* reloaded = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    ASSERT_NE(reloaded, nullptr);
+    EXPECT_EQ(dict->content_hash, reloaded->content_hash);
+    BejPlanCache_t* cache = bej_plan_cache_create();
+    ASSERT_NE(cache, nullptr);
+    const char* paths[] = {"Id", "Status/State"};
+
+    const BejPlan_t* plan = bej_plan_cache_get(cache, dict, nullptr, paths, 2, "Id > 1", nullptr);
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(bej_plan_cache_get(cache, reloaded, nullptr, paths, 2, "Id > 1", nullptr), plan);
+    EXPECT_NE(bej_plan_cache_get(cache, dict, nullptr, paths, 2, nullptr, nullptr), plan);
+    EXPECT_NE(bej_plan_cache_get(cache, dict, nullptr, paths, 1, "Id > 1", nullptr), plan);
+    EXPECT_EQ(bej_plan_cache_get(cache, dict, nullptr, paths, 2, "Bogus > 1", nullptr), nullptr);
+    EXPECT_EQ(bej_plan_cache_size(cache), 3u);
+
+    // A plan from the cache runs on any copy of its dictionaries, and on no other revision
+    std::vector<uint8_t> document = projection_document();
+    BejValue_t values[2];
+    bool found[2];
+    bool matched = false;
+    ASSERT_TRUE(bej_plan_execute(plan, reloaded, nullptr, document.data(), document.size(), &matched, values, found));
+    EXPECT_TRUE(matched);
+    EXPECT_EQ(values[0].integer, 7);
+    reloaded->content_hash ^= 1;
+    EXPECT_FALSE(bej_plan_execute(plan, reloaded, nullptr, document.data(), document.size(), &matched, values, found));
+    EXPECT_NE(bej_plan_cache_get(cache, reloaded, nullptr, paths, 2, "Id > 1", nullptr), plan);
+
+    // Many threads asking for one query get one plan
+    std::vector<std::thread> threads;
+    std::vector<const BejPlan_t*> plans(8);
+    const char* shared[] = {"Name"};
+    for (size_t i = 0; i < plans.size(); i++) 
+    {
+        threads.emplace_back([&, i] { plans[i] = bej_plan_cache_get(cache, dict, nullptr, shared, 1, nullptr, nullptr); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const BejPlan_t* one : plans) EXPECT_EQ(one, plans[0]);
+    EXPECT_EQ(bej_plan_cache_size(cache), 5u);
+
+    // Growing the table keeps every plan
+    for (int i = 0; i < 40; i++) 
+    {
+        std::string where = "Id > " + std::to_string(i);
+        ASSERT_NE(bej_plan_cache_get(cache, dict, nullptr, paths, 2, where.c_str(), nullptr), nullptr);
+    }
+    EXPECT_EQ(bej_plan_cache_get(cache, dict, nullptr, paths, 2, "Id > 1", nullptr), plan);
+    EXPECT_EQ(bej_plan_cache_size(cache), 44u);
+
+    bej_plan_cache_free(cache);
+    free_dictionary(dict);
+    free_dictionary(reloaded);
+}
+
+// -------------------------
+// Encoder Tests
+// -------------------------
+
+/// Encode json with the projection dictionary and decode it back to compact JSON
+static bool encode_round_trip(BejEncoder_t* encoder, Dictionary_t* dict, const std::string& json,
+                              std::vector<uint8_t>* bej, std::string* decoded)
+{
+    uint8_t* output = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+    bool ok = bej_encode_json(encoder, json.data(), json.size(), &output, &capacity, &size);
+    if (ok) 
+    {
+        bej->assign(output, output + size);
+        DecoderContext_t ctx;
+        init_decoder_context(&ctx, dict, nullptr, nullptr, nullptr);
+        ctx.compact = 1;
+        set_output_buffer(&ctx, nullptr, 0);
+        ok = decode_bej_buffer(&ctx, bej->data(), bej->size());
+        decoded->assign((char*)ctx.output_buffer, ctx.output_length);
+        free(ctx.output_buffer);
+    }
+    free(output);
+    return ok;
+}
+
+TEST(EncoderTests, NameIndexFindsChildrenOfParent) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    BejNameIndex_t* index = bej_name_index_create(dict);
+    ASSERT_NE(index, nullptr);
+
+    const DictionaryEntry_t* status = bej_name_index_find(index, &dict->entries[0], "Status", 6);
+    ASSERT_NE(status, nullptr);
+    EXPECT_EQ(status->sequence_number, 1u);
+    const DictionaryEntry_t* state = bej_name_index_find(index, status, "State!", 5);
+    ASSERT_NE(state, nullptr);
+    EXPECT_STREQ(state->name, "State");
+
+    // Names resolve only under their own parent, and only whole
+    EXPECT_EQ(bej_name_index_find(index, &dict->entries[0], "State", 5), nullptr);
+    EXPECT_EQ(bej_name_index_find(index, status, "Stat", 4), nullptr);
+    EXPECT_EQ(bej_name_index_find(index, state, "State", 5), nullptr);
+
+    bej_name_index_free(index);
+    free_dictionary(dict);
+}
+
+TEST(EncoderTests, RoundTripsThroughTheDecoder) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    BejEncoder_t* encoder = bej_encoder_create(dict, nullptr, nullptr);
+    ASSERT_NE(encoder, nullptr);
+
+    std::vector<uint8_t> bej;
+    std::string decoded;
+    ASSERT_TRUE(encode_round_trip(encoder, dict, "{\"Id\": 7, \"Status\": {\"Health\": \"OK\"}, \"Name\": \"n\"}",
+                                  &bej, &decoded));
+    EXPECT_EQ(decoded, "{\"Id\":7,\"Status\":{\"Health\":\"OK\"},\"Name\":\"n\"}");
+
+    // Every length is exact: strings carry their NUL, integers their shortest form
+    std::vector<uint8_t> expected = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 30, 1, 3,
+        1, 0x00, 0x30, 1, 1, 7,
+        1, 0x02, 0x00, 1, 10, 1, 1,
+            1, 0x00, 0x50, 1, 3, 'O', 'K', 0,
+        1, 0x04, 0x50, 1, 2, 'n', 0
+    };
+    EXPECT_EQ(bej, expected);
+
+    // Escapes are resolved, nulls keep their property, integers take up to 8 bytes
+    ASSERT_TRUE(encode_round_trip(encoder, dict,
+                                  "{\"Name\":\"a\\\"b\\u00e9\\n\",\"Status\":{\"State\":null},\"Id\":-9223372036854775808}",
+                                  &bej, &decoded));
+    EXPECT_EQ(decoded, "{\"Name\":\"a\\\"b\xC3\xA9\\n\",\"Status\":{\"State\":null},\"Id\":-9223372036854775808}");
+    ASSERT_TRUE(encode_round_trip(encoder, dict, "{\"Id\":-129}", &bej, &decoded));
+    EXPECT_EQ(bej[18], 2u);
+    EXPECT_EQ(decoded, "{\"Id\":-129}");
+    ASSERT_TRUE(encode_round_trip(encoder, dict, "{}", &bej, &decoded));
+    EXPECT_EQ(decoded, "{}");
+
+    bej_encoder_free(encoder);
+    free_dictionary(dict);
+}
+
+TEST(EncoderTests, RejectsJsonTheDictionaryDoesNotDescribe) 
+{
+    Dictionary_t* dict = load_projection_dictionary();
+    ASSERT_NE(dict, nullptr);
+    std::vector<std::string> messages;
+    BejDiagnostics_t diagnostics;
+    init_diagnostics(&diagnostics);
+    diagnostics.user = &messages;
+    diagnostics.callback = [](void* user, BejDiagLevel_t, const char* message) 
+    {
+        static_cast<std::vector<std::string>*>(user)->push_back(message);
+    };
+    BejEncoder_t* encoder = bej_encoder_create(dict, nullptr, &diagnostics);
+    ASSERT_NE(encoder, nullptr);
+
+    const char* invalid[] = {
+        "{\"Id\": 1, \"Bogus\": 2}",        // unknown property
+        "{\"Status\": {\"Id\": 1}}",        // known name, wrong parent
+        "{\"Id\": \"7\"}",                  // type mismatch
+        "{\"Id\": 1.5}",                    // not an integer
+        "{\"Id\": 99999999999999999999}",   // out of range
+        "{\"Id\": 1,}",                     // malformed
+        "{\"Name\": \"\\x\"}",              // bad escape
+        "{\"Id\": 1} 2",                    // trailing text
+        "[1]",                              // not an object
+        "{\"Id\": 1"                        // truncated
+    };
+    uint8_t* output = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+    for (const char* json : invalid) 
+    {
+        EXPECT_FALSE(bej_encode_json(encoder, json, strlen(json), &output, &capacity, &size)) << json;
+    }
+    ASSERT_EQ(messages.size(), std::size(invalid));
+    EXPECT_NE(messages[0].find("unknown property 'Bogus'"), std::string::npos);
+    EXPECT_NE(messages[1].find("unknown property 'Id'"), std::string::npos);
+
+    // A failure leaves the encoder ready for the next document
+    const char* valid = "{\"Id\": 1}";
+    EXPECT_TRUE(bej_encode_json(encoder, valid, strlen(valid), &output, &capacity, &size));
+    EXPECT_EQ(size, 20u);
+
+    free(output);
+    bej_encoder_free(encoder);
+    free_dictionary(dict);
+}
+
+// -------------------------
+// Decode Dispatcher Test
+// -------------------------
+
+TEST(DecodeTests, DecodeValue_DispatchInteger) 
+{
+    SFLV_t sflv = {0, 0, BEJ_FORMAT_INTEGER, 1, new uint8_t[1]{0x2A}};
+    DecoderContext_t ctx;
+    FILE* out = tmpfile();
+    init_decoder_context(&ctx, nullptr, nullptr, nullptr, out);
+
+    EXPECT_TRUE(decode_value(&ctx, &sflv, nullptr));
+    rewind(out);
+
+    char buf[32];
+    fread(buf, 1, sizeof(buf), out);
+    fclose(out);
+    delete[] sflv.value;
+
+    EXPECT_NE(strstr(buf, "42"), nullptr);
+}
+// -------------------------
+// Pipeline Tests
+// -------------------------
+
+TEST(PipelineTests, SpscRingPreservesOrder) 
+{
+    SpscRing_t* ring = spsc_create(3);
+    ASSERT_NE(ring, nullptr);
+    EXPECT_EQ(spsc_capacity(ring), 4u);
+
+    const uintptr_t total = 100000;
+    std::thread producer([ring, total]() {
+        for (uintptr_t i = 1; i <= total; i++) 
+        {
+            while (!spsc_try_push(ring, (void*)i)) 
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uintptr_t expected = 1;
+    while (expected <= total) 
+    {
+        void* item;
+        if (spsc_try_pop(ring, &item)) 
+        {
+            ASSERT_EQ((uintptr_t)item, expected);
+            expected++;
+        }
+        else 
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    void* item;
+    EXPECT_FALSE(spsc_try_pop(ring, &item));
+    spsc_free(ring);
+}
+
+static void append_frame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& record)
+{
+    uint32_t size = (uint32_t)record.size();
+    stream.insert(stream.end(), {(uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)});
+    stream.insert(stream.end(), record.begin(), record.end());
+}
+
+static std::string run_pipeline(const std::vector<uint8_t>& stream, size_t ring_capacity,
+                                PipelineStats_t* stats, bool* ok)
+{
+    FILE* in = tmpfile();
+    FILE* out = tmpfile();
+    fwrite(stream.data(), 1, stream.size(), in);
+    rewind(in);
+
+    PipelineOptions_t options = {nullptr, nullptr, in, out, ring_capacity, 0, {}};
+    *ok = bej_decode_stream_pipeline(&options, stats);
+
+    std::string text;
+    rewind(out);
+    char buf[256];
+    size_t count;
+    while ((count = fread(buf, 1, sizeof(buf), out)) > 0) 
+    {
+        text.append(buf, count);
+    }
+    fclose(in);
+    fclose(out);
+    return text;
+}
+
+TEST(PipelineTests, DecodesFramedRecordsInOrder) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    std::vector<uint8_t> stream;
+    for (int i = 0; i < 50; i++) 
+    {
+        append_frame(stream, document);
+    }
+
+    // A ring smaller than the record count makes buffers circulate
+    PipelineStats_t stats;
+    bool ok = false;
+    std::string text = run_pipeline(stream, 4, &stats, &ok);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(stats.records_in, 50u);
+    EXPECT_EQ(stats.records_out, 50u);
+    EXPECT_EQ(stats.records_failed, 0u);
+    EXPECT_EQ(stats.bytes_in, stream.size());
+
+    std::string expected;
+    for (int i = 0; i < 50; i++) 
+    {
+        expected += "{\"seq_0\":42,\"seq_1\":\"Hi\"}\n";
+    }
+    EXPECT_EQ(text, expected);
+    EXPECT_EQ(stats.bytes_out, expected.size());
+}
+
+TEST(PipelineTests, SkipsBadRecordsAndStopsAtTruncation) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    std::vector<uint8_t> stream;
+    append_frame(stream, document);
+    append_frame(stream, {0x00, 0xF0, 0xF0});       // header only, no root tuple
+    append_frame(stream, document);
+    stream.insert(stream.end(), {0x40, 0, 0, 0, 1, 2});  // frame cut short
+
+    PipelineStats_t stats;
+    bool ok = true;
+    std::string text = run_pipeline(stream, 0, &stats, &ok);
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(stats.records_in, 3u);
+    EXPECT_EQ(stats.records_out, 2u);
+    EXPECT_EQ(stats.records_failed, 1u);
+    EXPECT_EQ(text, "{\"seq_0\":42,\"seq_1\":\"Hi\"}\n{\"seq_0\":42,\"seq_1\":\"Hi\"}\n");
+}
+
+TEST(PipelineTests, IdleInputDoesNotSpin) 
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    FILE* in = fdopen(fds[0], "rb");
+    FILE* out = tmpfile();
+    ASSERT_NE(in, nullptr);
+
+    // The stream stays open but silent for a while before its only record arrives
+    std::vector<uint8_t> stream;
+    append_frame(stream, small_set_document());
+    std::thread feeder([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        EXPECT_EQ(write(fds[1], stream.data(), stream.size()), (ssize_t)stream.size());
+        close(fds[1]);
+    });
+
+    clock_t cpu_start = clock();
+    auto wall_start = std::chrono::steady_clock::now();
+    PipelineOptions_t options = {nullptr, nullptr, in, out, 0, 0, {}};
+    PipelineStats_t stats;
+    EXPECT_TRUE(bej_decode_stream_pipeline(&options, &stats));
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    feeder.join();
+
+    // Spinning decode and write stages would each burn the whole idle period
+    EXPECT_GE(wall, 0.35);
+    EXPECT_LT(cpu, 0.1);
+    EXPECT_EQ(stats.records_out, 1u);
+    fclose(in);
+    fclose(out);
+}
+
+// -------------------------
+// Diagnostics / Reentrancy Tests
+// -------------------------
+
+/// Collects messages into the std::vector<std::string> passed as user
+static void collect_diagnostic(void* user, BejDiagLevel_t level, const char* message)
+{
+    std::vector<std::string>* messages = static_cast<std::vector<std::string>*>(user);
+    messages->push_back(std::to_string((int)level) + ":" + message);
+}
+
+TEST(DiagnosticsTests, SilentByDefault) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    document.resize(document.size() - 3);   // root tuple runs past the end
+
+    testing::internal::CaptureStdout();
+    testing::internal::CaptureStderr();
+    uint8_t* output = nullptr;
+    size_t output_size = 0;
+    EXPECT_FALSE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                      nullptr, &output, &output_size));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+}
+
+TEST(DiagnosticsTests, CallbackReceivesMessagesUpToLevel) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    std::vector<std::string> messages;
+
+    BejDecodeOptions_t options;
+    init_decode_options(&options);
+    options.diagnostics.callback = collect_diagnostic;
+    options.diagnostics.user = &messages;
+
+    // Errors only: a good document reports nothing
+    uint8_t* output = nullptr;
+    size_t output_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &options, &output, &output_size));
+    free(output);
+    EXPECT_TRUE(messages.empty());
+
+    // Trace: the header fields plus one line per tuple (root SET and two members)
+    options.diagnostics.level = BEJ_DIAG_TRACE;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &options, &output, &output_size));
+    free(output);
+    ASSERT_EQ(messages.size(), 6u);
+    EXPECT_EQ(messages[0], "3:BEJ Version: 0xF1F0F000");
+    EXPECT_EQ(messages[3], "3:SFLV: seq=0, format=0x00, length=15, dict_selector=0");
+
+    messages.clear();
+    options.diagnostics.level = BEJ_DIAG_ERROR;
+    document.resize(document.size() - 3);
+    EXPECT_FALSE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                      &options, &output, &output_size));
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0], "0:Failed to read SFLV tuple");
+}
+
+/// Decode `iterations` documents on each of `threads` threads; returns documents per second
+static double stress_decode(int threads, int iterations, const std::vector<uint8_t>& good,
+                            const std::vector<uint8_t>& bad, bool* ok)
+{
+    std::vector<std::vector<std::string>> messages(threads);
+    std::vector<int> failures(threads, 0);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) 
+    {
+        workers.emplace_back([&, t]() {
+            // Every thread owns its context, output buffer and diagnostics sink
+            DecoderContext_t ctx;
+            init_decoder_context(&ctx, nullptr, nullptr, nullptr, nullptr);
+            ctx.compact = true;
+            ctx.diagnostics.callback = collect_diagnostic;
+            ctx.diagnostics.user = &messages[t];
+            set_output_buffer(&ctx, nullptr, 0);
+
+            for (int i = 0; i < iterations; i++) 
+            {
+                // Every 16th document is broken, so errors are reported concurrently
+                const std::vector<uint8_t>& document = (i % 16 == 15) ? bad : good;
+                ctx.output_length = 0;
+                ctx.output_failed = false;
+                ctx.indent_level = 0;
+                bool decoded = decode_bej_buffer(&ctx, (uint8_t*)document.data(), (uint32_t)document.size());
+                if (decoded != (&document == &good) 
+                    || (decoded && std::string((char*)ctx.output_buffer, ctx.output_length)
+                                   != "{\"seq_0\":42,\"seq_1\":\"Hi\"}")) 
+                {
+                    failures[t]++;
+                }
+            }
+            free(ctx.output_buffer);
+        });
+    }
+    for (std::thread& worker : workers) 
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Each thread saw exactly its own errors, nobody else's
+    *ok = true;
+    for (int t = 0; t < threads; t++) 
+    {
+        *ok = *ok && failures[t] == 0 && messages[t].size() == (size_t)(iterations / 16);
+    }
+    return (double)threads * iterations / (seconds > 0 ? seconds : 1e-9);
+}
+
+TEST(DiagnosticsTests, ConcurrentDecodesStayIsolated) 
+{
+    std::vector<uint8_t> good = small_set_document();
+    std::vector<uint8_t> bad = good;
+    bad.resize(bad.size() - 3);
+
+    const int iterations = 20000;
+    bool ok = false;
+    double baseline = stress_decode(1, iterations, good, bad, &ok);
+    ASSERT_TRUE(ok);
+
+    // Timings depend on the machine, so the speedup is reported, not asserted
+    for (int threads : {2, 4, 8}) 
+    {
+        double rate = stress_decode(threads, iterations, good, bad, &ok);
+        EXPECT_TRUE(ok) << threads << " threads";
+        RecordProperty("speedup_" + std::to_string(threads), std::to_string(rate / baseline));
+    }
+}
+
+// -------------------------
+// Coroutine API Tests
+// -------------------------
+
+/// Source whose data arrives later: read_some suspends until the test pushes a chunk
+struct ManualSource
+{
+    std::deque<std::vector<uint8_t>> chunks;
+    bool finished = false;
+    std::coroutine_handle<> waiting;
+    int suspensions = 0;
+
+    auto read_some(std::span<uint8_t> buffer)
+    {
+        struct Awaiter
+        {
+            ManualSource* source;
+            std::span<uint8_t> buffer;
+
+            bool await_ready() { return !source->chunks.empty() || source->finished; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                source->waiting = handle;
+                source->suspensions++;
+            }
+            size_t await_resume()
+            {
+                if (source->chunks.empty()) return 0;
+                std::vector<uint8_t>& front = source->chunks.front();
+                size_t count = std::min(front.size(), buffer.size());
+                std::copy(front.begin(), front.begin() + count, buffer.begin());
+                front.erase(front.begin(), front.begin() + count);
+                if (front.empty()) source->chunks.pop_front();
+                return count;
+            }
+        };
+        return Awaiter{this, buffer};
+    }
+
+    void push(std::vector<uint8_t> chunk, bool last)
+    {
+        if (!chunk.empty()) chunks.push_back(std::move(chunk));
+        finished = last;
+        if (waiting) std::exchange(waiting, nullptr).resume();
+    }
+};
+
+/// Sink that is always "full": every write suspends until the test drains it
+struct ManualSink
+{
+    std::string text;
+    std::coroutine_handle<> waiting;
+    int writes = 0;
+
+    auto write(std::span<const uint8_t> data)
+    {
+        struct Awaiter
+        {
+            ManualSink* sink;
+            std::span<const uint8_t> data;
+
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { sink->waiting = handle; }
+            bool await_resume()
+            {
+                sink->text.append((const char*)data.data(), data.size());
+                sink->writes++;
+                return true;
+            }
+        };
+        return Awaiter{this, data};
+    }
+
+    void drain()
+    {
+        if (waiting) std::exchange(waiting, nullptr).resume();
+    }
+};
+
+TEST(AsyncTests, SuspendsOnInputAndOutput) 
+{
+    ManualSource source;
+    ManualSink sink;
+    BejDecodeOptions_t decode;
+    init_decode_options(&decode);
+    decode.compact = true;
+
+    bej::AsyncDecodeOptions options;
+    options.decode = &decode;
+    options.chunk_size = 4;
+    bej::Task<bool> task = bej::decode_async(source, sink, options);
+    task.start();
+    EXPECT_FALSE(task.done());
+
+    // Feed the document a few bytes at a time; the decode waits in between
+    std::vector<uint8_t> document = small_set_document();
+    for (size_t offset = 0; offset < document.size(); offset += 5) 
+    {
+        size_t end = std::min(document.size(), offset + 5);
+        source.push(std::vector<uint8_t>(document.begin() + offset, document.begin() + end), false);
+        EXPECT_FALSE(task.done());
+    }
+    source.push({}, true);
+
+    while (!task.done()) 
+    {
+        sink.drain();
+    }
+    EXPECT_TRUE(task.result());
+    EXPECT_GE(source.suspensions, 4);
+    EXPECT_EQ(sink.text, "{\"seq_0\":42,\"seq_1\":\"Hi\"}");
+    EXPECT_EQ(sink.writes, (int)(sink.text.size() + 3) / 4);
+}
+
+TEST(AsyncTests, MemoryStaysBoundedByChunkSize) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+    BejDecodeStats_t stats;
+    BejDecodeOptions_t decode;
+    init_decode_options(&decode);
+    decode.stats = &stats;
+    uint8_t* expected = nullptr;
+    size_t expected_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     &decode, &expected, &expected_size));
+
+    ManualSource source;
+    source.push(document, true);
+    ManualSink sink;
+    bej::AsyncDecodeOptions options;
+    options.decode = &decode;
+    options.chunk_size = 256;
+    bej::Task<bool> task = bej::decode_async(source, sink, options);
+    task.start();
+    while (!task.done()) 
+    {
+        sink.drain();
+    }
+    EXPECT_TRUE(task.result());
+    EXPECT_EQ(sink.text, std::string((const char*)expected, expected_size));
+
+    // Neither the document nor its output is ever held whole
+    ASSERT_GT(expected_size, 100u * options.chunk_size);
+    EXPECT_LT(stats.peak_live_bytes, 16u * options.chunk_size);
+    free(expected);
+}
+
+static bej::Task<int> decode_many(int count, const std::vector<uint8_t>& document, std::string* all)
+{
+    int decoded = 0;
+    for (int i = 0; i < count; i++) 
+    {
+        ManualSource source;
+        source.push(document, true);
+        ManualSink sink;
+        bej::Task<bool> task = bej::decode_async(source, sink);
+        task.start();
+        while (!task.done()) 
+        {
+            sink.drain();
+        }
+        if (task.result()) 
+        {
+            decoded++;
+            *all += sink.text;
+        }
+    }
+    co_return decoded;
+}
+
+static bej::Task<bool> awaits_nested(const std::vector<uint8_t>& document, int* decoded, std::string* all)
+{
+    *decoded = co_await decode_many(3, document, all);
+
+    // A bad document fails without throwing
+    std::vector<uint8_t> truncated(document.begin(), document.end() - 3);
+    ManualSource source;
+    source.push(truncated, true);
+    ManualSink sink;
+    co_return !co_await bej::decode_async(source, sink);
+}
+
+TEST(AsyncTests, TasksComposeWithCoAwait) 
+{
+    std::vector<uint8_t> document = small_set_document();
+    int decoded = 0;
+    std::string all;
+    bej::Task<bool> task = awaits_nested(document, &decoded, &all);
+    task.start();
+    ASSERT_TRUE(task.done());
+    EXPECT_TRUE(task.result());
+    EXPECT_EQ(decoded, 3);
+    EXPECT_NE(all.find("\"seq_1\": \"Hi\""), std::string::npos);
+}
+
+// -------------------------
+// PMR API Tests
+// -------------------------
+
+/// Resource that counts what passes through to its upstream
+struct CountingResource : std::pmr::memory_resource
+{
+    std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+    size_t allocations = 0;
+    size_t live_bytes = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations++;
+        live_bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* memory, size_t bytes, size_t alignment) override
+    {
+        live_bytes -= bytes;
+        upstream->deallocate(memory, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+TEST(PmrTests, DecodeFromStackBuffer) 
+{
+    std::vector<uint8_t> document = small_set_document();
+
+    // Anything beyond the stack buffer would throw from null_memory_resource
+    std::byte stack[1024];
+    std::pmr::monotonic_buffer_resource resource(stack, sizeof(stack), std::pmr::null_memory_resource());
+    std::pmr::string output(&resource);
+
+    bej::pmr::Options options;
+    options.compact = true;
+    ASSERT_TRUE(bej::pmr::decode(document.data(), document.size(), options, output));
+    EXPECT_EQ(output, "{\"seq_0\":42,\"seq_1\":\"Hi\"}");
+
+    bej::pmr::Value root(&resource);
+    ASSERT_TRUE(bej::pmr::parse(document.data(), document.size(), options, root));
+    ASSERT_EQ(root.kind, bej::pmr::Kind::Object);
+    ASSERT_EQ(root.members.size(), 2u);
+    EXPECT_EQ(root.members[0].sequence, 0u);
+    EXPECT_EQ(root.members[0].value.kind, bej::pmr::Kind::Integer);
+    EXPECT_EQ(root.members[0].value.integer, 42);
+    EXPECT_EQ(root.members[1].value.kind, bej::pmr::Kind::String);
+    EXPECT_EQ(root.members[1].value.text, "Hi");
+    EXPECT_EQ(root.members[1].value.text.get_allocator().resource(), &resource);
+
+    // Truncated documents fail without leaving a partial result
+    EXPECT_FALSE(bej::pmr::parse(document.data(), document.size() - 1, options, root));
+    EXPECT_TRUE(root.members.empty());
+    EXPECT_FALSE(bej::pmr::decode(document.data(), document.size() - 1, options, output));
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(PmrTests, ParseNamesAnnotationAndNullMembers) 
+{
+    Dictionary_t* schema = load_projection_dictionary();
+    Dictionary_t* anno = load_annotation_dictionary();
+    ASSERT_NE(schema, nullptr);
+    ASSERT_NE(anno, nullptr);
+
+    // Status { Health "OK", @odata.etag "y", State null }: the annotation sits in a nested schema SET
+    std::vector<uint8_t> document = {
+        0x00, 0xF0, 0xF0, 0xF1, 0x00, 0x00, 0x00,
+        1, 0x00, 0x00, 1, 27, 1, 1,
+        1, 0x02, 0x00, 1, 20, 1, 3,
+            1, 0x00, 0x50, 1, 2, 'O', 'K',
+            1, 0x01, 0x50, 1, 1, 'y',
+            1, 0x02, 0x20, 1, 0
+    };
+    bej::pmr::Options options;
+    options.schema_dict = schema;
+    options.anno_dict = anno;
+    bej::pmr::Value root;
+    ASSERT_TRUE(bej::pmr::parse(document.data(), document.size(), options, root));
+    ASSERT_EQ(root.members.size(), 1u);
+    EXPECT_EQ(root.members[0].name, "Status");
+
+    const bej::pmr::Value& status = root.members[0].value;
+    ASSERT_EQ(status.members.size(), 3u);
+    EXPECT_EQ(status.members[0].name, "Health");
+    EXPECT_EQ(status.members[1].name, "@odata.etag");
+    EXPECT_EQ(status.members[1].value.text, "y");
+    EXPECT_EQ(status.members[2].name, "State");
+    EXPECT_EQ(status.members[2].value.kind, bej::pmr::Kind::Null);
+
+    free_dictionary(schema);
+    free_dictionary(anno);
+}
+
+TEST(PmrTests, ParallelDecodeAllocatesFromResource) 
+{
+    std::vector<uint8_t> document = document_with_root_set(large_set_value(3000));
+    uint8_t* expected = nullptr;
+    size_t expected_size = 0;
+    ASSERT_TRUE(bej_decode_to_memory(document.data(), document.size(), nullptr, nullptr,
+                                     nullptr, &expected, &expected_size));
+
+    CountingResource resource;
+    {
+        // The member index of the C core comes from the resource too; worker buffers do not
+        bej::pmr::Options options;
+        options.threads = 4;
+        std::pmr::string output(&resource);
+        ASSERT_TRUE(bej::pmr::decode(document.data(), document.size(), options, output));
+        EXPECT_EQ(std::string_view(output), std::string_view((const char*)expected, expected_size));
+        EXPECT_GT(resource.allocations, 1u);
+
+        bej::pmr::Value root(&resource);
+        ASSERT_TRUE(bej::pmr::parse(document.data(), document.size(), options, root));
+        ASSERT_EQ(root.members.size(), 3000u);
+        EXPECT_EQ(root.members[2].value.integer, 2);
+        EXPECT_EQ(root.members[1].value.kind, bej::pmr::Kind::Array);
+        EXPECT_EQ(root.members[1].value.members[0].value.text, "a\"");
+    }
+    EXPECT_EQ(resource.live_bytes, 0u);
+    free(expected);
+}
+
+// -------------------------
+// Server Tests
+// -------------------------
+
+#ifdef __linux__
+
+static int connect_to_server(const std::string& path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    for (int attempt = 0; attempt < 100; attempt++) 
+    {
+        if (connect(fd, (sockaddr*)&address, sizeof(address)) == 0) 
+        {
+            return fd;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    close(fd);
+    return -1;
+}
+
+static void append_request(std::vector<uint8_t>& stream, const std::string& key, const std::vector<uint8_t>& document)
+{
+    std::vector<uint8_t> body;
+    body.push_back((uint8_t)key.size());
+    body.insert(body.end(), key.begin(), key.end());
+    body.insert(body.end(), document.begin(), document.end());
+    append_frame(stream, body);
+}
+
+static bool read_exact(int fd, uint8_t* data, size_t size)
+{
+    while (size > 0) 
+    {
+        ssize_t count = recv(fd, data, size, 0);
+        if (count <= 0) 
+        {
+            return false;
+        }
+        data += count;
+        size -= (size_t)count;
+    }
+    return true;
+}
+
+/// Read one response; returns false on EOF
+static bool read_response(int fd, uint8_t* status, std::string* payload)
+{
+    uint8_t header[4];
+    if (!read_exact(fd, header, 4)) 
+    {
+        return false;
+    }
+    uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+    std::vector<uint8_t> body(length);
+    if (length == 0 || !read_exact(fd, body.data(), length)) 
+    {
+        return false;
+    }
+    *status = body[0];
+    payload->assign(body.begin() + 1, body.end());
+    return true;
+}
+
+TEST(ServerTests, SocketIsPrivateAndNeverReplacesOtherFiles) 
+{
+    std::string path = "/tmp/bej_server_file_" + std::to_string(getpid()) + ".sock";
+    ServerDictionary_t dictionary = {"k", nullptr, nullptr};
+    ServerOptions_t options = {path.c_str(), &dictionary, 1, 1, 0, {}};
+
+    // A mistyped path must not cost the user their file
+    FILE* fp = fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    fputs("data", fp);
+    fclose(fp);
+    EXPECT_EQ(server_create(&options), nullptr);
+    struct stat info;
+    ASSERT_EQ(stat(path.c_str(), &info), 0);
+    EXPECT_TRUE(S_ISREG(info.st_mode));
+    EXPECT_EQ(info.st_size, 4);
+    remove(path.c_str());
+
+    // A socket left behind by an earlier run is replaced
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    ASSERT_EQ(bind(stale, (struct sockaddr*)&address, sizeof(address)), 0);
+    close(stale);
+
+    // Only the owner may connect, and the socket is removed on destroy
+    BejServer_t* server = server_create(&options);
+    ASSERT_NE(server, nullptr);
+    ASSERT_EQ(lstat(path.c_str(), &info), 0);
+    EXPECT_TRUE(S_ISSOCK(info.st_mode));
+    EXPECT_EQ(info.st_mode & 0777, 0600u);
+    server_destroy(server);
+    EXPECT_NE(lstat(path.c_str(), &info), 0);
+}
+
+TEST(ServerTests, AnswersPipelinedRequestsInOrder) 
+{
+    std::string path = "/tmp/bej_server_test_" + std::to_string(getpid()) + ".sock";
+    ServerDictionary_t dictionary = {"k", nullptr, nullptr};
+    ServerOptions_t options = {path.c_str(), &dictionary, 1, 2, 0, {}};
+    BejServer_t* server = server_create(&options);
+    ASSERT_NE(server, nullptr);
+    bool run_ok = false;
+    std::thread loop([&]() { run_ok = server_run(server); });
+
+    std::vector<uint8_t> document = small_set_document();
+    std::vector<uint8_t> truncated(document.begin(), document.end() - 3);
+    std::vector<uint8_t> stream;
+    append_request(stream, "k", document);
+    append_request(stream, "nope", document);
+    append_request(stream, "k", truncated);
+    append_request(stream, "k", document);
+
+    int fd = connect_to_server(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(send(fd, stream.data(), stream.size(), 0), (ssize_t)stream.size());
+
+    const uint8_t expected_status[] = {SERVER_STATUS_OK, SERVER_STATUS_UNKNOWN_KEY,
+                                       SERVER_STATUS_DECODE_ERROR, SERVER_STATUS_OK};
+    for (uint8_t expected : expected_status) 
+    {
+        uint8_t status = 0xFF;
+        std::string payload;
+        ASSERT_TRUE(read_response(fd, &status, &payload));
+        EXPECT_EQ(status, expected);
+        if (expected == SERVER_STATUS_OK) 
+        {
+            EXPECT_EQ(payload, "{\"seq_0\":42,\"seq_1\":\"Hi\"}");
+        }
+    }
+
+    // An oversized frame cannot be skipped: answered, then the connection closes
+    const uint8_t oversized[] = {0xFF, 0xFF, 0xFF, 0xFF};
+    ASSERT_EQ(send(fd, oversized, sizeof(oversized), 0), (ssize_t)sizeof(oversized));
+    uint8_t status = 0xFF;
+    std::string payload;
+    ASSERT_TRUE(read_response(fd, &status, &payload));
+    EXPECT_EQ(status, SERVER_STATUS_BAD_REQUEST);
+    EXPECT_FALSE(read_response(fd, &status, &payload));
+    close(fd);
+
+    server_stop(server);
+    loop.join();
+    EXPECT_TRUE(run_ok);
+    server_destroy(server);
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+TEST(ServerTests, ServesConcurrentClients) 
+{
+    std::string path = "/tmp/bej_server_test_multi_" + std::to_string(getpid()) + ".sock";
+    ServerDictionary_t dictionary = {"k", nullptr, nullptr};
+    ServerOptions_t options = {path.c_str(), &dictionary, 1, 4, 0, {}};
+    BejServer_t* server = server_create(&options);
+    ASSERT_NE(server, nullptr);
+    std::thread loop([&]() { server_run(server); });
+
+    std::vector<uint8_t> stream;
+    append_request(stream, "k", small_set_document());
+    std::vector<int> answered(8, 0);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 8; c++) 
+    {
+        clients.emplace_back([&, c]() {
+            int fd = connect_to_server(path);
+            if (fd < 0) return;
+            for (int i = 0; i < 50; i++) 
+            {
+                uint8_t status = 0xFF;
+                std::string payload;
+                if (send(fd, stream.data(), stream.size(), 0) != (ssize_t)stream.size()
+                    || !read_response(fd, &status, &payload) || status != SERVER_STATUS_OK) 
+                {
+                    break;
+                }
+                answered[c]++;
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& client : clients) 
+    {
+        client.join();
+    }
+    server_stop(server);
+    loop.join();
+    server_destroy(server);
+
+    for (int c = 0; c < 8; c++) 
+    {
+        EXPECT_EQ(answered[c], 50) << "client " << c;
+    }
+}
+
+#endif